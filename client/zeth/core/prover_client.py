@@ -127,6 +127,38 @@ class ProverClient:
             public_data = [int(x, 16) for x in extproof_and_pub_data.public_data]
             return extproof, public_data
 
+    def get_proofs_batch(
+            self,
+            proof_inputs: List[ProofInputs]
+    ) -> List[Tuple[ExtendedProof, List[int]]]:
+        """
+        Request the generation of a batch of proofs in a single call. The
+        results are returned in the same order as `proof_inputs`. Raises an
+        exception if any of the proofs could not be generated.
+        """
+        batch = prover_pb2.ProofInputsBatch()  # type: ignore
+        batch.proof_inputs.extend(proof_inputs)
+        results: List[Optional[Tuple[ExtendedProof, List[int]]]] = \
+            [None] * len(proof_inputs)
+        with grpc.insecure_channel(self.endpoint) as channel:
+            stub = prover_pb2_grpc.ProverStub(channel)  # type: ignore
+            print("-------------- Get the proof batch --------------")
+            zksnark = self.get_zksnark_provider()
+            for result in stub.ProveBatch(batch):
+                if result.error:
+                    raise Exception(
+                        f"proof {result.index} failed: {result.error}")
+                extproof_and_pub_data = result.extended_proof_and_public_data
+                extproof = zksnark.extended_proof_from_proto(
+                    extproof_and_pub_data.extended_proof)
+                public_data = \
+                    [int(x, 16) for x in extproof_and_pub_data.public_data]
+                results[result.index] = (extproof, public_data)
+
+        if any(result is None for result in results):
+            raise Exception("incomplete batch response from prover server")
+        return [result for result in results if result is not None]
+
 
 def _make_empty_message() -> empty_pb2.Empty:
     return empty_pb2.Empty()
@@ -6,6 +6,7 @@
 #define __ZETH_CIRCUITS_BINARY_OPERATION_HPP__
 
 #include "libzeth/circuits/circuit_utils.hpp"
+#include "libzeth/circuits/witness_tape.hpp"
 #include "libzeth/core/bits.hpp"
 #include "math.h"
 
@@ -37,6 +38,7 @@ public:
 
     void generate_r1cs_constraints();
     void generate_r1cs_witness();
+    void record_witness(witness_tape<FieldT> &tape);
 };
 
 /// xor_constant_gadget computes res = a XOR b XOR c with c constant
@@ -63,6 +65,7 @@ public:
 
     void generate_r1cs_constraints();
     void generate_r1cs_witness();
+    void record_witness(witness_tape<FieldT> &tape);
 };
 
 /// xor_rot_gadget computes a XOR b and rotate it by shift
@@ -89,6 +92,7 @@ public:
 
     void generate_r1cs_constraints();
     void generate_r1cs_witness();
+    void record_witness(witness_tape<FieldT> &tape);
 };
 
 /// double_bit32_sum_eq_gadget checks that res = a + b % 2**32
@@ -115,6 +119,7 @@ public:
 
     void generate_r1cs_constraints(bool enforce_boolean = true);
     void generate_r1cs_witness();
+    void record_witness(witness_tape<FieldT> &tape);
 };
 
 } // namespace libzeth
@@ -51,6 +51,12 @@ template<typename FieldT> void xor_gadget<FieldT>::generate_r1cs_witness()
     }
 }
 
+template<typename FieldT>
+void xor_gadget<FieldT>::record_witness(witness_tape<FieldT> &tape)
+{
+    tape.xor_bits(a, b, res);
+}
+
 template<typename FieldT>
 xor_constant_gadget<FieldT>::xor_constant_gadget(
     libsnark::protoboard<FieldT> &pb,
@@ -118,6 +124,12 @@ void xor_constant_gadget<FieldT>::generate_r1cs_witness()
     }
 }
 
+template<typename FieldT>
+void xor_constant_gadget<FieldT>::record_witness(witness_tape<FieldT> &tape)
+{
+    tape.xor_constant_bits(a, b, c, res);
+}
+
 template<typename FieldT>
 xor_rot_gadget<FieldT>::xor_rot_gadget(
     libsnark::protoboard<FieldT> &pb,
@@ -162,6 +174,12 @@ template<typename FieldT> void xor_rot_gadget<FieldT>::generate_r1cs_witness()
     }
 }
 
+template<typename FieldT>
+void xor_rot_gadget<FieldT>::record_witness(witness_tape<FieldT> &tape)
+{
+    tape.xor_bits(a, b, res, shift);
+}
+
 template<typename FieldT>
 double_bit32_sum_eq_gadget<FieldT>::double_bit32_sum_eq_gadget(
     libsnark::protoboard<FieldT> &pb,
@@ -257,6 +275,13 @@ void double_bit32_sum_eq_gadget<FieldT>::generate_r1cs_witness()
     left_side_acc.fill_variable_array(this->pb, res);
 }
 
+template<typename FieldT>
+void double_bit32_sum_eq_gadget<FieldT>::record_witness(
+    witness_tape<FieldT> &tape)
+{
+    tape.add_bits32(a, b, res);
+}
+
 } // namespace libzeth
 
 #endif // __ZETH_CIRCUITS_BINARY_OPERATION_TCC__
@@ -9,6 +9,7 @@
 #include "libzeth/circuits/blake2s/blake2s_comp.hpp"
 #include "libzeth/circuits/circuit_utils.hpp"
 #include "libzeth/core/bits.hpp"
+#include "libzeth/core/blake2s.hpp"
 #include "libzeth/core/utils.hpp"
 
 #include <libsnark/gadgetlib1/gadget.hpp>
@@ -157,11 +158,20 @@ public:
     // This gadget ensures automatically the booleaness of the digest output
     void generate_r1cs_constraints(const bool ensure_output_bitness = true);
     void generate_r1cs_witness();
+    void record_witness(witness_tape<FieldT> &tape);
 
     static constexpr size_t get_block_len();
     static constexpr size_t get_digest_len();
+    /// Compute the hash natively (see libzeth/core/blake2s.hpp). Input bits
+    /// are packed into bytes most significant bit first, with any final
+    /// partial byte padded with zero bits, as in the gadget.
     static libff::bit_vector get_hash(const libff::bit_vector &input);
 
+    /// Compute the hashes of several inputs natively, using the multi-buffer
+    /// implementation where possible.
+    static std::vector<libff::bit_vector> get_hash_batch(
+        const std::vector<libff::bit_vector> &inputs);
+
     static size_t expected_constraints(const bool ensure_output_bitness);
 };
 
@@ -114,6 +114,51 @@ template<typename FieldT> void BLAKE2s_256<FieldT>::generate_r1cs_witness()
         libff::div_ceil(input_size, BYTE_LEN), true);
 };
 
+template<typename FieldT>
+void BLAKE2s_256<FieldT>::record_witness(witness_tape<FieldT> &tape)
+{
+    // Copy the input to the blocks, padding the last block with zeroes as in
+    // generate_r1cs_witness.
+    const size_t input_size = input.bits.size();
+    const size_t nb_blocks = libff::div_ceil(input_size, BLAKE2s_block_size);
+    for (size_t i = 0; i < nb_blocks; i++) {
+        const size_t block_start = BLAKE2s_block_size * i;
+        const size_t num_input_bits =
+            std::min(BLAKE2s_block_size, input_size - block_start);
+        tape.copy(
+            libsnark::pb_variable_array<FieldT>(
+                input.bits.begin() + block_start,
+                input.bits.begin() + block_start + num_input_bits),
+            libsnark::pb_variable_array<FieldT>(
+                block[i].bits.begin(),
+                block[i].bits.begin() + num_input_bits));
+        if (num_input_bits < BLAKE2s_block_size) {
+            tape.constant_bits(
+                std::vector<bool>(BLAKE2s_block_size - num_input_bits, false),
+                libsnark::pb_variable_array<FieldT>(
+                    block[i].bits.begin() + num_input_bits,
+                    block[i].bits.end()));
+        }
+    }
+
+    std::vector<bool> h_bits;
+    for (size_t i = 0; i < 8; i++) {
+        std::vector<bool> h_part =
+            bits_xor(parameter_block[i], BLAKE2s_IV[i]).to_vector();
+        h_bits.insert(h_bits.end(), h_part.begin(), h_part.end());
+    }
+    tape.constant_bits(h_bits, h[0].bits);
+
+    for (size_t i = 0; i < nb_blocks - 1; i++) {
+        BLAKE2sC_vector[i].record_witness(
+            tape,
+            libff::div_ceil((i + 1) * BLAKE2s_block_size, BYTE_LEN),
+            false);
+    }
+    BLAKE2sC_vector[nb_blocks - 1].record_witness(
+        tape, libff::div_ceil(input_size, BYTE_LEN), true);
+}
+
 template<typename FieldT> constexpr size_t BLAKE2s_256<FieldT>::get_digest_len()
 {
     return BLAKE2s_digest_size;
@@ -137,22 +182,76 @@ size_t BLAKE2s_256<FieldT>::expected_constraints(
     return 21472;
 }
 
+namespace internal
+{
+
+// Pack bits into bytes, most significant bit first. A final partial byte is
+// padded with zero bits.
+inline std::vector<uint8_t> blake2s_bits_to_bytes(
+    const libff::bit_vector &bits)
+{
+    std::vector<uint8_t> bytes(libff::div_ceil(bits.size(), BYTE_LEN), 0);
+    for (size_t i = 0; i < bits.size(); ++i) {
+        if (bits[i]) {
+            bytes[i / BYTE_LEN] |= (uint8_t)(0x80 >> (i % BYTE_LEN));
+        }
+    }
+    return bytes;
+}
+
+// Unpack a digest into bits, most significant bit of each byte first.
+inline libff::bit_vector blake2s_digest_to_bits(const uint8_t *digest)
+{
+    libff::bit_vector bits;
+    bits.reserve(BLAKE2s_digest_size);
+    for (size_t i = 0; i < BLAKE2S_256_DIGEST_SIZE_BYTES; ++i) {
+        for (size_t j = 0; j < BYTE_LEN; ++j) {
+            bits.push_back(((digest[i] << j) & 0x80) != 0);
+        }
+    }
+    return bits;
+}
+
+} // namespace internal
+
 template<typename FieldT>
 libff::bit_vector BLAKE2s_256<FieldT>::get_hash(const libff::bit_vector &input)
 {
-    libsnark::protoboard<FieldT> pb;
+    const std::vector<uint8_t> input_bytes =
+        internal::blake2s_bits_to_bytes(input);
+    uint8_t digest[BLAKE2S_256_DIGEST_SIZE_BYTES];
+    blake2s_256(input_bytes.data(), input_bytes.size(), digest);
+    return internal::blake2s_digest_to_bits(digest);
+}
 
-    libsnark::block_variable<FieldT> input_block(
-        pb, input.size(), "input_block");
-    libsnark::digest_variable<FieldT> output_variable(
-        pb, BLAKE2s_digest_size, "output_variable");
-    BLAKE2s_256<FieldT> blake2s_hasher(
-        pb, input_block, output_variable, "blake2s_hasher_gadget");
+template<typename FieldT>
+std::vector<libff::bit_vector> BLAKE2s_256<FieldT>::get_hash_batch(
+    const std::vector<libff::bit_vector> &inputs)
+{
+    const size_t num_inputs = inputs.size();
+    std::vector<std::vector<uint8_t>> input_bytes;
+    std::vector<const uint8_t *> messages;
+    std::vector<size_t> message_sizes;
+    input_bytes.reserve(num_inputs);
+    messages.reserve(num_inputs);
+    message_sizes.reserve(num_inputs);
+    for (const libff::bit_vector &input : inputs) {
+        input_bytes.push_back(internal::blake2s_bits_to_bytes(input));
+        messages.push_back(input_bytes.back().data());
+        message_sizes.push_back(input_bytes.back().size());
+    }
 
-    input_block.generate_r1cs_witness(input);
-    blake2s_hasher.generate_r1cs_witness();
+    std::vector<uint8_t> digests(num_inputs * BLAKE2S_256_DIGEST_SIZE_BYTES);
+    blake2s_256_batch(
+        messages.data(), message_sizes.data(), num_inputs, digests.data());
 
-    return output_variable.get_digest();
+    std::vector<libff::bit_vector> hashes;
+    hashes.reserve(num_inputs);
+    for (size_t i = 0; i < num_inputs; ++i) {
+        hashes.push_back(internal::blake2s_digest_to_bits(
+            digests.data() + i * BLAKE2S_256_DIGEST_SIZE_BYTES));
+    }
+    return hashes;
 }
 
 } // namespace libzeth
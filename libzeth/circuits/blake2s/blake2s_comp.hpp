@@ -86,6 +86,10 @@ public:
     // function with full block length input
     void generate_r1cs_witness(
         size_t len_byte_total = 32, bool is_last_block = true);
+    void record_witness(
+        witness_tape<FieldT> &tape,
+        size_t len_byte_total = 32,
+        bool is_last_block = true);
 
     static size_t get_block_len();
     static size_t get_digest_len();
@@ -98,6 +102,18 @@ public:
     void setup_counter(size_t len_byte_total);
     void setup_v(bool is_last_block);
     void setup_mixing_gadgets();
+
+    // Word-level witness helpers (see generate_r1cs_witness)
+    void setup_state_words(
+        size_t len_byte_total,
+        bool is_last_block,
+        std::array<uint32_t, BLAKE2s_word_number> &state);
+    void mix_words(
+        const std::array<uint32_t, BLAKE2s_word_number> &message,
+        std::array<uint32_t, BLAKE2s_word_number> &state);
+
+    void record_setup(
+        witness_tape<FieldT> &tape, size_t len_byte_total, bool is_last_block);
 };
 
 } // namespace libzeth
@@ -7,9 +7,23 @@
 
 #include "libzeth/circuits/blake2s/blake2s_comp.hpp"
 
+#include <algorithm>
+
 namespace libzeth
 {
 
+namespace
+{
+
+// Native counterpart of swap_byte_endianness for a 32-bit word.
+inline uint32_t blake2s_swap_word_byte_endianness(const uint32_t w)
+{
+    return (w >> 24) | ((w >> 8) & 0x0000ff00) | ((w << 8) & 0x00ff0000) |
+           (w << 24);
+}
+
+} // namespace
+
 /// This gadget implements the interface of the HashT template
 template<typename FieldT>
 BLAKE2s_256_comp<FieldT>::BLAKE2s_256_comp(
@@ -93,70 +107,113 @@ template<typename FieldT>
 void BLAKE2s_256_comp<FieldT>::generate_r1cs_witness(
     size_t len_byte_total, bool is_last_block)
 {
-    // Format two 256-bit long big endian inputs into one 512 long little endian
-    // input (with padding if necessary)
-    size_t input_size = input_block.bits.size();
+    // The compression function is evaluated on native 32-bit words, and the
+    // bits of each word variable are assigned from the resulting values (see
+    // g_primitive::generate_r1cs_witness_words).
+
+    // Format the input (padded with zeroes if input_size < BLAKE2s_block_size)
+    // into 16 little endian words.
+    //
     // We do not use block_size because the value might not be entered
     // (c.f. block_variable<FieldT>::block_variable(
     //     protoboard<FieldT> &pb,
     //     const std::vector<pb_variable_array<FieldT>> &parts,
     //     const std::string &annotation_prefix))
-
-    // Push the block variable in local to be swapped
-    std::vector<FieldT> padded_input;
-    for (size_t i = 0; i < input_size; i++) {
-        padded_input.push_back(this->pb.val(input_block.bits[i]));
+    const size_t input_size = input_block.bits.size();
+    std::array<uint32_t, BLAKE2s_word_number> message;
+    for (size_t i = 0; i < BLAKE2s_word_number; i++) {
+        uint32_t word = 0;
+        for (size_t j = 0; j < BLAKE2s_word_size; j++) {
+            const size_t bit_idx = BLAKE2s_word_size * i + j;
+            const bool bit = (bit_idx < input_size) &&
+                             !this->pb.val(input_block.bits[bit_idx]).is_zero();
+            word = (word << 1) | (bit ? 1 : 0);
+        }
+        message[i] = blake2s_swap_word_byte_endianness(word);
+        fill_variable_array_from_uint32(this->pb, block[i], message[i]);
     }
 
-    // [SANITY CHECK] Pad if necessary (if input_size < BLAKE2s_block_size)
-    for (size_t i = 0; i < BLAKE2s_block_size - input_size; i++) {
-        padded_input.push_back(FieldT("0"));
+    std::array<uint32_t, BLAKE2s_word_number> state;
+    setup_state_words(len_byte_total, is_last_block, state);
+    std::array<uint32_t, 8> h_words;
+    std::copy(state.begin(), state.begin() + 8, h_words.begin());
+
+    mix_words(message, state);
+
+    // Witness of the xor_vector gadgets, and final output in which the
+    // endianness of each word is swapped to big endian if it is the last call.
+    for (size_t i = 0; i < 8; i++) {
+        const uint32_t out_temp_word = state[i] ^ state[8 + i];
+        const uint32_t output_word = out_temp_word ^ h_words[i];
+        fill_variable_array_from_uint32(this->pb, out_temp[i], out_temp_word);
+        fill_variable_array_from_uint32(
+            this->pb, output_bytes[i], output_word);
+        fill_variable_array_from_uint32(
+            this->pb,
+            libsnark::pb_variable_array<FieldT>(
+                output.bits.begin() + BLAKE2s_word_size * i,
+                output.bits.begin() + BLAKE2s_word_size * (i + 1)),
+            is_last_block ? blake2s_swap_word_byte_endianness(output_word)
+                          : output_word);
     }
+};
 
-    // Allocate and format the 16 input block variable
+template<typename FieldT>
+void BLAKE2s_256_comp<FieldT>::record_witness(
+    witness_tape<FieldT> &tape, size_t len_byte_total, bool is_last_block)
+{
+    // As in generate_r1cs_witness, each word of the (padded) input block is
+    // copied to `block` with its byte endianness swapped. The swap is its own
+    // inverse, so it is applied to the destination variables here.
+    const size_t input_size = input_block.bits.size();
     for (size_t i = 0; i < BLAKE2s_word_number; i++) {
-        std::vector<FieldT> temp_vector(
-            padded_input.begin() + BLAKE2s_word_size * i,
-            padded_input.begin() + BLAKE2s_word_size * (i + 1));
-        temp_vector = swap_byte_endianness(temp_vector);
-        block[i].fill_with_field_elements(this->pb, temp_vector);
+        const libsnark::pb_variable_array<FieldT> swapped_block =
+            swap_byte_endianness(block[i]);
+        const size_t word_start = std::min(BLAKE2s_word_size * i, input_size);
+        const size_t num_input_bits =
+            std::min(BLAKE2s_word_size, input_size - word_start);
+        if (num_input_bits > 0) {
+            tape.copy(
+                libsnark::pb_variable_array<FieldT>(
+                    input_block.bits.begin() + word_start,
+                    input_block.bits.begin() + word_start + num_input_bits),
+                libsnark::pb_variable_array<FieldT>(
+                    swapped_block.begin(),
+                    swapped_block.begin() + num_input_bits));
+        }
+        if (num_input_bits < BLAKE2s_word_size) {
+            tape.constant_bits(
+                std::vector<bool>(BLAKE2s_word_size - num_input_bits, false),
+                libsnark::pb_variable_array<FieldT>(
+                    swapped_block.begin() + num_input_bits,
+                    swapped_block.end()));
+        }
     }
 
-    BLAKE2s_256_comp<FieldT>::setup_h();
-    BLAKE2s_256_comp<FieldT>::setup_counter(len_byte_total);
-    BLAKE2s_256_comp<FieldT>::setup_v(is_last_block);
+    record_setup(tape, len_byte_total, is_last_block);
 
     for (size_t i = 0; i < rounds; i++) {
         for (auto &gadget : g_arrays[i]) {
-            gadget.generate_r1cs_witness();
+            gadget.record_witness(tape);
         }
     }
 
-    // TODO: batch equality constraints (should save ~200 constraints (~1%))
-
     for (auto &gadget : xor_vector) {
-        gadget.generate_r1cs_witness();
+        gadget.record_witness(tape);
     }
 
-    // Retrieve values, swap endiannes of each bit32 and append them to get
-    // final output
-    std::vector<FieldT> output_conversion;
     for (size_t i = 0; i < 8; i++) {
-        std::vector<FieldT> output_byte_value =
-            output_bytes[i].get_vals(this->pb);
-
-        // We swap to big endian if it is the last call.
+        libsnark::pb_variable_array<FieldT> output_word = output_bytes[i];
         if (is_last_block) {
-            output_byte_value = swap_byte_endianness(output_byte_value);
+            output_word = swap_byte_endianness(output_word);
         }
-        output_conversion.insert(
-            output_conversion.end(),
-            output_byte_value.begin(),
-            output_byte_value.end());
+        tape.copy(
+            output_word,
+            libsnark::pb_variable_array<FieldT>(
+                output.bits.begin() + BLAKE2s_word_size * i,
+                output.bits.begin() + BLAKE2s_word_size * (i + 1)));
     }
-
-    output.bits.fill_with_field_elements(this->pb, output_conversion);
-};
+}
 
 template<typename FieldT> size_t BLAKE2s_256_comp<FieldT>::get_digest_len()
 {
@@ -43,6 +43,16 @@ static const std::array<std::array<uint8_t, 16>, 10> sigma = {{
     {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0},
 }};
 
+// Value of a 32-bit string, where the first bit is the most significant.
+inline uint32_t blake2s_word_from_bits(const bits<BLAKE2s_word_size> &b)
+{
+    uint32_t word = 0;
+    for (const bool bit : b) {
+        word = (word << 1) | (bit ? 1 : 0);
+    }
+    return word;
+}
+
 } // namespace
 
 template<typename FieldT>
@@ -183,6 +193,117 @@ void BLAKE2s_256_comp<FieldT>::setup_v(bool is_last_block)
     temp_xored.fill_variable_array(this->pb, v[0][15]);
 }
 
+/// setup_state_words assigns h_array and the initial state matrix v[0] as
+/// setup_h, setup_counter and setup_v do, and returns the values of the words
+/// of v[0] in `state`.
+template<typename FieldT>
+void BLAKE2s_256_comp<FieldT>::setup_state_words(
+    size_t len_byte_total,
+    bool is_last_block,
+    std::array<uint32_t, BLAKE2s_word_number> &state)
+{
+    // [v_0, ..., v_7] = [h_0, ..., h_7]
+    for (size_t i = 0; i < 8; i++) {
+        state[i] = uint32_from_variable_array(
+            this->pb,
+            libsnark::pb_variable_array<FieldT>(
+                h.bits.begin() + BLAKE2s_word_size * i,
+                h.bits.begin() + BLAKE2s_word_size * (i + 1)));
+        fill_variable_array_from_uint32(this->pb, h_array[i], state[i]);
+    }
+
+    // [v_8, v_9, v_10, v_11] = [IV_0, IV_1, IV_2, IV_3]
+    for (size_t i = 8; i < 12; i++) {
+        state[i] = blake2s_word_from_bits(BLAKE2s_IV[i - 8]);
+    }
+
+    // v_12 = t0 XOR IV_4, v_13 = t1 XOR IV_5
+    setup_counter(len_byte_total);
+    state[12] =
+        blake2s_word_from_bits(BLAKE2s_IV[4]) ^ blake2s_word_from_bits(t[0]);
+    state[13] =
+        blake2s_word_from_bits(BLAKE2s_IV[5]) ^ blake2s_word_from_bits(t[1]);
+
+    // v_14 = f0 XOR IV_6, v_15 = f1 XOR IV_7
+    state[14] = blake2s_word_from_bits(BLAKE2s_IV[6]);
+    if (is_last_block) {
+        state[14] = ~state[14];
+    }
+    state[15] = blake2s_word_from_bits(BLAKE2s_IV[7]);
+
+    for (size_t i = 0; i < BLAKE2s_word_number; i++) {
+        fill_variable_array_from_uint32(this->pb, v[0][i], state[i]);
+    }
+}
+
+/// mix_words assigns the witness of the mixing gadgets created by
+/// setup_mixing_gadgets, given the words of the message block and of the
+/// initial state. On return, `state` holds the words of v[rounds].
+template<typename FieldT>
+void BLAKE2s_256_comp<FieldT>::mix_words(
+    const std::array<uint32_t, BLAKE2s_word_number> &message,
+    std::array<uint32_t, BLAKE2s_word_number> &state)
+{
+    // Indices in the state of the (a, b, c, d) words of each g_primitive of a
+    // round, in the order of g_arrays[i]. See: Section 3.2 of
+    // https://tools.ietf.org/html/rfc7693
+    static const size_t g_state_indices[8][4] = {
+        {0, 4, 8, 12},
+        {1, 5, 9, 13},
+        {2, 6, 10, 14},
+        {3, 7, 11, 15},
+        {0, 5, 10, 15},
+        {1, 6, 11, 12},
+        {2, 7, 8, 13},
+        {3, 4, 9, 14},
+    };
+
+    for (size_t i = 0; i < rounds; i++) {
+        const std::array<uint8_t, 16> &s = sigma[i % rounds];
+        for (size_t j = 0; j < 8; j++) {
+            const size_t *idx = g_state_indices[j];
+            g_arrays[i][j].generate_r1cs_witness_words(
+                state[idx[0]],
+                state[idx[1]],
+                state[idx[2]],
+                state[idx[3]],
+                message[s[2 * j]],
+                message[s[2 * j + 1]]);
+        }
+    }
+}
+
+/// record_setup records the initialization of h_array and of the internal
+/// state matrix (see setup_h, setup_counter and setup_v) in a witness tape
+template<typename FieldT>
+void BLAKE2s_256_comp<FieldT>::record_setup(
+    witness_tape<FieldT> &tape, size_t len_byte_total, bool is_last_block)
+{
+    for (size_t i = 0; i < 8; i++) {
+        tape.copy(
+            libsnark::pb_variable_array<FieldT>(
+                h.bits.begin() + BLAKE2s_word_size * i,
+                h.bits.begin() + BLAKE2s_word_size * (i + 1)),
+            h_array[i]);
+    }
+
+    for (size_t i = 0; i < 8; i++) {
+        tape.copy(h_array[i], v[0][i]);
+    }
+
+    for (size_t i = 8; i < 12; i++) {
+        tape.constant_bits(BLAKE2s_IV[i - 8].to_vector(), v[0][i]);
+    }
+
+    setup_counter(len_byte_total);
+    tape.constant_bits(bits_xor(BLAKE2s_IV[4], t[0]).to_vector(), v[0][12]);
+    tape.constant_bits(bits_xor(BLAKE2s_IV[5], t[1]).to_vector(), v[0][13]);
+    const bits32 v_14 =
+        is_last_block ? bits_xor(BLAKE2s_IV[6], flag_to_1) : BLAKE2s_IV[6];
+    tape.constant_bits(v_14.to_vector(), v[0][14]);
+    tape.constant_bits(BLAKE2s_IV[7].to_vector(), v[0][15]);
+}
+
 template<typename FieldT> void BLAKE2s_256_comp<FieldT>::setup_mixing_gadgets()
 {
     // See: Section 3.2 of https://tools.ietf.org/html/rfc7693
@@ -66,6 +66,20 @@ public:
 
     void generate_r1cs_constraints();
     void generate_r1cs_witness();
+
+    /// Generate the witness from the values of the input words a, b, c, d, x
+    /// and y, computing G on native words and assigning the bits of each
+    /// intermediate and output word in one pass. On return, a, b, c and d
+    /// hold the values of the output words a2, b2, c2 and d2.
+    void generate_r1cs_witness_words(
+        uint32_t &a,
+        uint32_t &b,
+        uint32_t &c,
+        uint32_t &d,
+        const uint32_t x,
+        const uint32_t y);
+
+    void record_witness(witness_tape<FieldT> &tape);
 };
 
 } // namespace libzeth
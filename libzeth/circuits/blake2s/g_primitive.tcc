@@ -8,6 +8,16 @@
 namespace libzeth
 {
 
+namespace
+{
+
+inline uint32_t g_primitive_rotr32(const uint32_t w, const int c)
+{
+    return (w >> c) | (w << (32 - c));
+}
+
+} // namespace
+
 // See: Section 3.1 of https://tools.ietf.org/html/rfc7693
 template<typename FieldT>
 g_primitive<FieldT>::g_primitive(
@@ -98,6 +108,59 @@ template<typename FieldT> void g_primitive<FieldT>::generate_r1cs_witness()
     b2_xor_gadget->generate_r1cs_witness();
 };
 
+template<typename FieldT>
+void g_primitive<FieldT>::generate_r1cs_witness_words(
+    uint32_t &a,
+    uint32_t &b,
+    uint32_t &c,
+    uint32_t &d,
+    const uint32_t x,
+    const uint32_t y)
+{
+    // The xor_rot_gadget rotates towards the least significant bit (the end
+    // of the bit string), i.e. it computes a right rotation of the word.
+    const uint32_t a1_temp_val = a + b;
+    const uint32_t a1_val = a1_temp_val + x;
+    const uint32_t d1_val =
+        g_primitive_rotr32(d ^ a1_val, rotation_constant_r1);
+    const uint32_t c1_val = c + d1_val;
+    const uint32_t b1_val =
+        g_primitive_rotr32(b ^ c1_val, rotation_constant_r2);
+
+    const uint32_t a2_temp_val = a1_val + b1_val;
+    a = a2_temp_val + y;
+    d = g_primitive_rotr32(d1_val ^ a, rotation_constant_r3);
+    c = c1_val + d;
+    b = g_primitive_rotr32(b1_val ^ c, rotation_constant_r4);
+
+    fill_variable_array_from_uint32(this->pb, a1_temp, a1_temp_val);
+    fill_variable_array_from_uint32(this->pb, a1, a1_val);
+    fill_variable_array_from_uint32(this->pb, d1, d1_val);
+    fill_variable_array_from_uint32(this->pb, c1, c1_val);
+    fill_variable_array_from_uint32(this->pb, b1, b1_val);
+    fill_variable_array_from_uint32(this->pb, a2_temp, a2_temp_val);
+    fill_variable_array_from_uint32(this->pb, a2, a);
+    fill_variable_array_from_uint32(this->pb, d2, d);
+    fill_variable_array_from_uint32(this->pb, c2, c);
+    fill_variable_array_from_uint32(this->pb, b2, b);
+}
+
+template<typename FieldT>
+void g_primitive<FieldT>::record_witness(witness_tape<FieldT> &tape)
+{
+    a1_1_sum_gadget->record_witness(tape);
+    a1_2_sum_gadget->record_witness(tape);
+    d1_xor_gadget->record_witness(tape);
+    c1_sum_gadget->record_witness(tape);
+    b1_xor_gadget->record_witness(tape);
+
+    a2_1_sum_gadget->record_witness(tape);
+    a2_2_sum_gadget->record_witness(tape);
+    d2_xor_gadget->record_witness(tape);
+    c2_sum_gadget->record_witness(tape);
+    b2_xor_gadget->record_witness(tape);
+};
+
 } // namespace libzeth
 
 #endif // __ZETH_CIRCUITS_G_PRIMITIVE_TCC__
@@ -7,7 +7,9 @@
 
 #include "libzeth/core/bits.hpp"
 
+#include <cstdint>
 #include <libsnark/gadgetlib1/pb_variable.hpp>
+#include <libsnark/gadgetlib1/protoboard.hpp>
 
 namespace libzeth
 {
@@ -19,6 +21,21 @@ template<typename FieldT>
 libsnark::pb_variable_array<FieldT> variable_array_from_bit_vector(
     const std::vector<bool> &bits, const libsnark::pb_variable<FieldT> &ZERO);
 
+/// Read the value of a 32-bit string of boolean variables, where the first
+/// variable holds the most significant bit.
+template<typename FieldT>
+uint32_t uint32_from_variable_array(
+    const libsnark::protoboard<FieldT> &pb,
+    const libsnark::pb_variable_array<FieldT> &var_array);
+
+/// Assign a 32-bit string of variables with the bits of `word`, most
+/// significant bit first.
+template<typename FieldT>
+void fill_variable_array_from_uint32(
+    libsnark::protoboard<FieldT> &pb,
+    const libsnark::pb_variable_array<FieldT> &var_array,
+    const uint32_t word);
+
 } // namespace libzeth
 
 #include "libzeth/circuits/circuit_utils.tcc"
@@ -5,7 +5,9 @@
 #ifndef __ZETH_CIRCUITS_CIRCUITS_UTILS_TCC__
 #define __ZETH_CIRCUITS_CIRCUITS_UTILS_TCC__
 
+#include <cassert>
 #include <libsnark/gadgetlib1/pb_variable.hpp>
+#include <libsnark/gadgetlib1/protoboard.hpp>
 #include <vector>
 
 namespace libzeth
@@ -63,6 +65,32 @@ libsnark::pb_variable_array<FieldT> variable_array_from_bit_vector(
     return acc;
 };
 
+template<typename FieldT>
+uint32_t uint32_from_variable_array(
+    const libsnark::protoboard<FieldT> &pb,
+    const libsnark::pb_variable_array<FieldT> &var_array)
+{
+    assert(var_array.size() == 32);
+    uint32_t word = 0;
+    for (const libsnark::pb_variable<FieldT> &var : var_array) {
+        word = (word << 1) | (pb.val(var).is_zero() ? 0 : 1);
+    }
+    return word;
+}
+
+template<typename FieldT>
+void fill_variable_array_from_uint32(
+    libsnark::protoboard<FieldT> &pb,
+    const libsnark::pb_variable_array<FieldT> &var_array,
+    const uint32_t word)
+{
+    assert(var_array.size() == 32);
+    const FieldT bit_values[2] = {FieldT::zero(), FieldT::one()};
+    for (size_t i = 0; i < 32; ++i) {
+        pb.val(var_array[i]) = bit_values[(word >> (31 - i)) & 1];
+    }
+}
+
 } // namespace libzeth
 
 #endif // __ZETH_CIRCUITS_CIRCUITS_UTILS_TCC__
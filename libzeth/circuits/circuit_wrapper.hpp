@@ -9,6 +9,8 @@
 #include "libzeth/circuits/mimc/mimc_input_hasher.hpp"
 #include "libzeth/core/extended_proof.hpp"
 #include "libzeth/core/note.hpp"
+#include "libzeth/core/r1cs_optimizer.hpp"
+#include "libzeth/serialization/r1cs_cache.hpp"
 #include "libzeth/zeth_constants.hpp"
 
 namespace libzeth
@@ -40,16 +42,40 @@ public:
     using input_hasher_type = mimc_input_hasher<Field, HashTreeT>;
 
     circuit_wrapper();
+
+    // Construct the circuit from a constraint system generated previously
+    // (e.g. loaded with r1cs_cache_read, using parameters_hash() as the key).
+    // The gadgets are allocated, since they are required to generate the
+    // witness, but their constraints are not generated. The variable layout
+    // is therefore not cached: it is recomputed by allocating the gadgets,
+    // which remains a significant part of the construction time. Throws
+    // std::invalid_argument if the variables of the constraint system do not
+    // match those allocated by the gadgets.
+    explicit circuit_wrapper(
+        std::shared_ptr<const libsnark::r1cs_constraint_system<Field>>
+            constraint_system);
+
     circuit_wrapper(const circuit_wrapper &) = delete;
     circuit_wrapper &operator=(const circuit_wrapper &) = delete;
 
+    // Identifies the constraint system generated by this circuit (see
+    // circuit_parameters_hash).
+    static std::string parameters_hash();
+
     // Generate the trusted setup
     typename snarkT::keypair generate_trusted_setup() const;
 
-    // Retrieve the constraint system (intended for debugging purposes).
+    // Retrieve the constraint system (e.g. for debugging purposes, or to be
+    // written with r1cs_cache_write).
     const libsnark::r1cs_constraint_system<Field> &get_constraint_system()
         const;
 
+    // Retrieve the constraint system used for the trusted setup and for
+    // proofs. This is the optimized constraint system if set (see
+    // set_r1cs_optimization), and get_constraint_system() otherwise.
+    const libsnark::r1cs_constraint_system<Field> &
+    get_proving_constraint_system() const;
+
     // Generate a proof and returns an extended proof
     extended_proof<ppT, snarkT> prove(
         const Field &root,
@@ -62,14 +88,98 @@ public:
         const typename snarkT::proving_key &proving_key,
         std::vector<Field> &out_public_data) const;
 
+    // Generate a proof and returns an extended proof, using precomputed data
+    // for the proving key (e.g. groth16_precomputed_bases, for snarks which
+    // support it).
+    template<typename PrecomputedT>
+    extended_proof<ppT, snarkT> prove(
+        const Field &root,
+        const std::array<joinsplit_input<Field, TreeDepth>, NumInputs> &inputs,
+        const std::array<zeth_note, NumOutputs> &outputs,
+        const bits64 &vpub_in,
+        const bits64 &vpub_out,
+        const bits256 &h_sig_in,
+        const bits256 &phi_in,
+        const typename snarkT::proving_key &proving_key,
+        const PrecomputedT &precomputed,
+        std::vector<Field> &out_public_data) const;
+
+    // Generate the witness, without generating a proof, and output the
+    // primary and auxiliary inputs for the proving constraint system (see
+    // get_proving_constraint_system). Used to generate several proofs at once
+    // (e.g. with groth16_snark::generate_proofs).
+    void generate_assignment(
+        const Field &root,
+        const std::array<joinsplit_input<Field, TreeDepth>, NumInputs> &inputs,
+        const std::array<zeth_note, NumOutputs> &outputs,
+        const bits64 &vpub_in,
+        const bits64 &vpub_out,
+        const bits256 &h_sig_in,
+        const bits256 &phi_in,
+        std::vector<Field> &out_public_data,
+        libsnark::r1cs_primary_input<Field> &out_primary_input,
+        libsnark::r1cs_auxiliary_input<Field> &out_auxiliary_input) const;
+
     const std::vector<Field> &get_last_assignment() const;
 
+    // Enable or disable the concurrent generation of the witnesses of the
+    // input and output notes (see joinsplit_gadget::generate_r1cs_witness).
+    // Disabled by default.
+    void set_parallel_witness(const bool parallel);
+
+    // Enable or disable the generation of witnesses by replaying a
+    // witness_tape, recorded once from the joinsplit and input hasher gadgets
+    // (see joinsplit_gadget::record_witness), instead of traversing the
+    // gadgets for each proof. When enabled, this takes precedence over
+    // set_parallel_witness. Disabled by default.
+    void set_witness_tape(const bool enabled);
+
+    // Use an optimized constraint system (see r1cs_optimize), computed from
+    // get_constraint_system(), for the trusted setup and for proofs. The
+    // witness is still generated by the gadgets, and is then mapped to the
+    // variables of the optimized system. Keys generated with and without the
+    // optimization are not interchangeable. A null pointer (the default)
+    // disables the optimization.
+    void set_r1cs_optimization(
+        std::shared_ptr<const r1cs_optimization<Field>> optimization);
+
 private:
-    libsnark::protoboard<Field> pb;
+    // Allocate the variables and gadgets of the circuit, without generating
+    // constraints.
+    void allocate_gadgets();
+
+    // Check the joinsplit balance, generate the witness and fill out the
+    // public data vector.
+    void generate_witness(
+        const Field &root,
+        const std::array<joinsplit_input<Field, TreeDepth>, NumInputs> &inputs,
+        const std::array<zeth_note, NumOutputs> &outputs,
+        const bits64 &vpub_in,
+        const bits64 &vpub_out,
+        const bits256 &h_sig_in,
+        const bits256 &phi_in,
+        std::vector<Field> &out_public_data) const;
+
+    // The auxiliary input for the proving constraint system (see
+    // get_proving_constraint_system), from the assignment of `pb`.
+    libsnark::r1cs_auxiliary_input<Field> proving_auxiliary_input() const;
+
+    // Mutable, since the witness is assigned by the (const) prove methods.
+    mutable libsnark::protoboard<Field> pb;
     libsnark::pb_variable<Field> public_data_hash;
     libsnark::pb_variable_array<Field> public_data;
     std::shared_ptr<joinsplit_type> joinsplit;
     std::shared_ptr<input_hasher_type> input_hasher;
+    // If set, the constraint system used in place of the (empty) constraint
+    // system of `pb`.
+    std::shared_ptr<const libsnark::r1cs_constraint_system<Field>>
+        cached_constraint_system;
+    std::shared_ptr<const r1cs_optimization<Field>> optimization;
+    bool parallel_witness;
+    bool use_witness_tape;
+    witness_tape<Field> tape;
+    // Buffer holding the full assignment while the tape is replayed
+    mutable std::vector<Field> tape_assignment;
 };
 
 } // namespace libzeth
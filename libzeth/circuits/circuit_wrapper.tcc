@@ -26,6 +26,91 @@ circuit_wrapper<
     NumInputs,
     NumOutputs,
     TreeDepth>::circuit_wrapper()
+    : parallel_witness(false)
+    , use_witness_tape(false)
+{
+    allocate_gadgets();
+
+    // Generate constraints
+    joinsplit->generate_r1cs_constraints();
+    input_hasher->generate_r1cs_constraints();
+}
+
+template<
+    typename HashT,
+    typename HashTreeT,
+    typename ppT,
+    typename snarkT,
+    size_t NumInputs,
+    size_t NumOutputs,
+    size_t TreeDepth>
+circuit_wrapper<
+    HashT,
+    HashTreeT,
+    ppT,
+    snarkT,
+    NumInputs,
+    NumOutputs,
+    TreeDepth>::circuit_wrapper(
+    std::shared_ptr<const libsnark::r1cs_constraint_system<Field>>
+        constraint_system)
+    : cached_constraint_system(constraint_system)
+    , parallel_witness(false)
+    , use_witness_tape(false)
+{
+    allocate_gadgets();
+
+    // The witness is assigned to the variables allocated by the gadgets, and
+    // checked against the cached constraints, so both must agree.
+    if (cached_constraint_system->primary_input_size != pb.num_inputs() ||
+        cached_constraint_system->num_variables() != pb.num_variables()) {
+        throw std::invalid_argument(
+            "constraint system does not match circuit variables");
+    }
+}
+
+template<
+    typename HashT,
+    typename HashTreeT,
+    typename ppT,
+    typename snarkT,
+    size_t NumInputs,
+    size_t NumOutputs,
+    size_t TreeDepth>
+std::string circuit_wrapper<
+    HashT,
+    HashTreeT,
+    ppT,
+    snarkT,
+    NumInputs,
+    NumOutputs,
+    TreeDepth>::parameters_hash()
+{
+    return circuit_parameters_hash<
+        HashT,
+        HashTreeT,
+        ppT,
+        NumInputs,
+        NumOutputs,
+        TreeDepth>("circuit_wrapper");
+}
+
+template<
+    typename HashT,
+    typename HashTreeT,
+    typename ppT,
+    typename snarkT,
+    size_t NumInputs,
+    size_t NumOutputs,
+    size_t TreeDepth>
+void circuit_wrapper<
+    HashT,
+    HashTreeT,
+    ppT,
+    snarkT,
+    NumInputs,
+    NumOutputs,
+    TreeDepth>::allocate_gadgets()
 {
     // Allocate a single public variable to hold the hash of the public
     // joinsplit inputs. The public joinsplit inputs are then allocated
@@ -50,10 +135,6 @@ circuit_wrapper<
     // Initialize the input hasher gadget
     input_hasher = std::make_shared<input_hasher_type>(
         pb, public_data, public_data_hash, "input_hasher");
-
-    // Generate constraints
-    joinsplit->generate_r1cs_constraints();
-    input_hasher->generate_r1cs_constraints();
 }
 
 template<
@@ -75,7 +156,7 @@ typename snarkT::keypair circuit_wrapper<
 {
     // Generate a verification and proving key (trusted setup) and write them
     // in a file
-    return snarkT::generate_setup(pb);
+    return snarkT::generate_setup(get_proving_constraint_system());
 }
 
 template<
@@ -95,9 +176,35 @@ const libsnark::r1cs_constraint_system<libff::Fr<ppT>> &circuit_wrapper<
     NumOutputs,
     TreeDepth>::get_constraint_system() const
 {
+    if (cached_constraint_system) {
+        return *cached_constraint_system;
+    }
     return pb.get_constraint_system();
 }
 
+template<
+    typename HashT,
+    typename HashTreeT,
+    typename ppT,
+    typename snarkT,
+    size_t NumInputs,
+    size_t NumOutputs,
+    size_t TreeDepth>
+const libsnark::r1cs_constraint_system<libff::Fr<ppT>> &circuit_wrapper<
+    HashT,
+    HashTreeT,
+    ppT,
+    snarkT,
+    NumInputs,
+    NumOutputs,
+    TreeDepth>::get_proving_constraint_system() const
+{
+    if (optimization) {
+        return optimization->constraint_system;
+    }
+    return get_constraint_system();
+}
+
 template<
     typename HashT,
     typename HashTreeT,
@@ -124,6 +231,139 @@ extended_proof<ppT, snarkT> circuit_wrapper<
         const bits256 &phi_in,
         const typename snarkT::proving_key &proving_key,
         std::vector<Field> &out_public_data) const
+{
+    generate_witness(
+        root,
+        inputs,
+        outputs,
+        vpub_in,
+        vpub_out,
+        h_sig_in,
+        phi_in,
+        out_public_data);
+
+    // Instantiate an extended_proof from the proof we generated and the given
+    // primary_input
+    return extended_proof<ppT, snarkT>(
+        snarkT::generate_proof(
+            proving_key, pb.primary_input(), proving_auxiliary_input()),
+        pb.primary_input());
+}
+
+template<
+    typename HashT,
+    typename HashTreeT,
+    typename ppT,
+    typename snarkT,
+    size_t NumInputs,
+    size_t NumOutputs,
+    size_t TreeDepth>
+template<typename PrecomputedT>
+extended_proof<ppT, snarkT> circuit_wrapper<
+    HashT,
+    HashTreeT,
+    ppT,
+    snarkT,
+    NumInputs,
+    NumOutputs,
+    TreeDepth>::
+    prove(
+        const Field &root,
+        const std::array<joinsplit_input<Field, TreeDepth>, NumInputs> &inputs,
+        const std::array<zeth_note, NumOutputs> &outputs,
+        const bits64 &vpub_in,
+        const bits64 &vpub_out,
+        const bits256 &h_sig_in,
+        const bits256 &phi_in,
+        const typename snarkT::proving_key &proving_key,
+        const PrecomputedT &precomputed,
+        std::vector<Field> &out_public_data) const
+{
+    generate_witness(
+        root,
+        inputs,
+        outputs,
+        vpub_in,
+        vpub_out,
+        h_sig_in,
+        phi_in,
+        out_public_data);
+
+    return extended_proof<ppT, snarkT>(
+        snarkT::generate_proof(
+            proving_key,
+            precomputed,
+            pb.primary_input(),
+            proving_auxiliary_input()),
+        pb.primary_input());
+}
+
+template<
+    typename HashT,
+    typename HashTreeT,
+    typename ppT,
+    typename snarkT,
+    size_t NumInputs,
+    size_t NumOutputs,
+    size_t TreeDepth>
+void circuit_wrapper<
+    HashT,
+    HashTreeT,
+    ppT,
+    snarkT,
+    NumInputs,
+    NumOutputs,
+    TreeDepth>::
+    generate_assignment(
+        const Field &root,
+        const std::array<joinsplit_input<Field, TreeDepth>, NumInputs> &inputs,
+        const std::array<zeth_note, NumOutputs> &outputs,
+        const bits64 &vpub_in,
+        const bits64 &vpub_out,
+        const bits256 &h_sig_in,
+        const bits256 &phi_in,
+        std::vector<Field> &out_public_data,
+        libsnark::r1cs_primary_input<Field> &out_primary_input,
+        libsnark::r1cs_auxiliary_input<Field> &out_auxiliary_input) const
+{
+    generate_witness(
+        root,
+        inputs,
+        outputs,
+        vpub_in,
+        vpub_out,
+        h_sig_in,
+        phi_in,
+        out_public_data);
+    out_primary_input = pb.primary_input();
+    out_auxiliary_input = proving_auxiliary_input();
+}
+
+template<
+    typename HashT,
+    typename HashTreeT,
+    typename ppT,
+    typename snarkT,
+    size_t NumInputs,
+    size_t NumOutputs,
+    size_t TreeDepth>
+void circuit_wrapper<
+    HashT,
+    HashTreeT,
+    ppT,
+    snarkT,
+    NumInputs,
+    NumOutputs,
+    TreeDepth>::
+    generate_witness(
+        const Field &root,
+        const std::array<joinsplit_input<Field, TreeDepth>, NumInputs> &inputs,
+        const std::array<zeth_note, NumOutputs> &outputs,
+        const bits64 &vpub_in,
+        const bits64 &vpub_out,
+        const bits256 &h_sig_in,
+        const bits256 &phi_in,
+        std::vector<Field> &out_public_data) const
 {
     // left hand side and right hand side of the joinsplit
     bits64 lhs_value = vpub_in;
@@ -147,11 +387,25 @@ extended_proof<ppT, snarkT> circuit_wrapper<
         throw std::invalid_argument("invalid joinsplit balance");
     }
 
-    joinsplit->generate_r1cs_witness(
-        root, inputs, outputs, vpub_in, vpub_out, h_sig_in, phi_in);
-    input_hasher->generate_r1cs_witness();
+    if (use_witness_tape) {
+        joinsplit->generate_r1cs_witness_inputs(
+            root, inputs, outputs, vpub_in, vpub_out, h_sig_in, phi_in);
+        tape.execute(pb, tape_assignment);
+    } else {
+        joinsplit->generate_r1cs_witness(
+            root,
+            inputs,
+            outputs,
+            vpub_in,
+            vpub_out,
+            h_sig_in,
+            phi_in,
+            parallel_witness);
+        input_hasher->generate_r1cs_witness();
+    }
 
-    bool is_valid_witness = pb.is_satisfied();
+    bool is_valid_witness = get_constraint_system().is_satisfied(
+        pb.primary_input(), pb.auxiliary_input());
     std::cout << "******* [DEBUG] Satisfiability result: " << is_valid_witness
               << " *******" << std::endl;
 
@@ -163,11 +417,6 @@ extended_proof<ppT, snarkT> circuit_wrapper<
     for (size_t i = 0; i < num_public_elements; ++i) {
         out_public_data.push_back(pb.val(public_data[i]));
     }
-
-    // Instantiate an extended_proof from the proof we generated and the given
-    // primary_input
-    return extended_proof<ppT, snarkT>(
-        snarkT::generate_proof(proving_key, pb), pb.primary_input());
 }
 
 template<
@@ -190,6 +439,100 @@ const std::vector<libff::Fr<ppT>> &circuit_wrapper<
     return pb.full_variable_assignment();
 }
 
+template<
+    typename HashT,
+    typename HashTreeT,
+    typename ppT,
+    typename snarkT,
+    size_t NumInputs,
+    size_t NumOutputs,
+    size_t TreeDepth>
+void circuit_wrapper<
+    HashT,
+    HashTreeT,
+    ppT,
+    snarkT,
+    NumInputs,
+    NumOutputs,
+    TreeDepth>::set_parallel_witness(const bool parallel)
+{
+    parallel_witness = parallel;
+}
+
+template<
+    typename HashT,
+    typename HashTreeT,
+    typename ppT,
+    typename snarkT,
+    size_t NumInputs,
+    size_t NumOutputs,
+    size_t TreeDepth>
+void circuit_wrapper<
+    HashT,
+    HashTreeT,
+    ppT,
+    snarkT,
+    NumInputs,
+    NumOutputs,
+    TreeDepth>::set_witness_tape(const bool enabled)
+{
+    tape.clear();
+    if (enabled) {
+        joinsplit->record_witness(tape);
+        input_hasher->record_witness(tape);
+    }
+    use_witness_tape = enabled;
+}
+
+template<
+    typename HashT,
+    typename HashTreeT,
+    typename ppT,
+    typename snarkT,
+    size_t NumInputs,
+    size_t NumOutputs,
+    size_t TreeDepth>
+void circuit_wrapper<
+    HashT,
+    HashTreeT,
+    ppT,
+    snarkT,
+    NumInputs,
+    NumOutputs,
+    TreeDepth>::set_r1cs_optimization(
+    std::shared_ptr<const r1cs_optimization<Field>> optimization)
+{
+    if (optimization && optimization->constraint_system.primary_input_size !=
+                            pb.num_inputs()) {
+        throw std::invalid_argument(
+            "optimized constraint system does not match circuit inputs");
+    }
+    this->optimization = optimization;
+}
+
+template<
+    typename HashT,
+    typename HashTreeT,
+    typename ppT,
+    typename snarkT,
+    size_t NumInputs,
+    size_t NumOutputs,
+    size_t TreeDepth>
+libsnark::r1cs_auxiliary_input<libff::Fr<ppT>> circuit_wrapper<
+    HashT,
+    HashTreeT,
+    ppT,
+    snarkT,
+    NumInputs,
+    NumOutputs,
+    TreeDepth>::proving_auxiliary_input() const
+{
+    if (optimization) {
+        return optimization->map_auxiliary_input(pb.auxiliary_input());
+    }
+    return pb.auxiliary_input();
+}
+
 } // namespace libzeth
 
 #endif // __ZETH_CIRCUITS_CIRCUIT_WRAPPER_TCC__
@@ -5,6 +5,7 @@
 // Content Taken and adapted from Zcash
 // https://github.com/zcash/zcash/blob/master/src/zcash/circuit/commitment.tcc
 
+#include "libzeth/circuits/witness_tape.hpp"
 #include "libzeth/zeth_constants.hpp"
 
 #include <libsnark/gadgetlib1/gadget.hpp>
@@ -35,6 +36,7 @@ public:
         const std::string &annotation_prefix = "COMM_gadget");
     void generate_r1cs_constraints();
     void generate_r1cs_witness();
+    void record_witness(witness_tape<FieldT> &tape);
 };
 
 // See Zerocash extended paper, page 22
@@ -51,6 +53,7 @@ private:
     libsnark::pb_variable_array<FieldT> rho;
     libsnark::pb_variable_array<FieldT> trap_r;
     libsnark::pb_variable_array<FieldT> value_v;
+    libsnark::pb_variable<FieldT> result;
     std::shared_ptr<libsnark::digest_variable<FieldT>> temp_result;
 
     // Hash gadgets used as inner, outer and final commitments
@@ -75,6 +78,7 @@ public:
 
     void generate_r1cs_constraints();
     void generate_r1cs_witness();
+    void record_witness(witness_tape<FieldT> &tape);
 };
 
 } // namespace libzeth
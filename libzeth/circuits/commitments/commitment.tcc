@@ -37,6 +37,12 @@ void COMM_gadget<FieldT, HashT>::generate_r1cs_witness()
     hasher->generate_r1cs_witness();
 }
 
+template<typename FieldT, typename HashT>
+void COMM_gadget<FieldT, HashT>::record_witness(witness_tape<FieldT> &tape)
+{
+    hasher->record_witness(tape);
+}
+
 // See Zerocash extended paper, page 22
 // The commitment cm is computed as
 // HashT(HashT( trap_r || [HashT(a_pk, rho)]_[128]) || "0"*192 || v)
@@ -55,6 +61,7 @@ COMM_cm_gadget<FieldT, HashT>::COMM_cm_gadget(
     , rho(rho)
     , trap_r(trap_r)
     , value_v(value_v)
+    , result(result)
 {
     // Allocate temporary variable
     input.allocate(
@@ -107,6 +114,21 @@ void COMM_cm_gadget<FieldT, HashT>::generate_r1cs_witness()
     bits_to_field->generate_r1cs_witness_from_bits();
 }
 
+template<typename FieldT, typename HashT>
+void COMM_cm_gadget<FieldT, HashT>::record_witness(witness_tape<FieldT> &tape)
+{
+    libsnark::pb_variable_array<FieldT> cm_input_parts;
+    cm_input_parts.insert(cm_input_parts.end(), a_pk.begin(), a_pk.end());
+    cm_input_parts.insert(cm_input_parts.end(), rho.begin(), rho.end());
+    cm_input_parts.insert(cm_input_parts.end(), value_v.begin(), value_v.end());
+    tape.copy(cm_input_parts, input);
+    com_gadget->record_witness(tape);
+    tape.pack(
+        libsnark::pb_variable_array<FieldT>(
+            temp_result->bits.rbegin(), temp_result->bits.rend()),
+        result);
+}
+
 } // namespace libzeth
 
 #endif // __ZETH_CIRCUITS_COMMITMENT_TCC__
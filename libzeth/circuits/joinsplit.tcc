@@ -449,7 +449,59 @@ public:
         }
     }
 
+    // If `parallel` is set (and the code is built with MULTICORE), the
+    // witnesses of the gadgets for each input note (and its h_i) and each
+    // output note (and its rho_i) are generated concurrently. These gadgets
+    // write disjoint variables of the protoboard, and depend only on the
+    // given inputs and on variables assigned before they are run.
     void generate_r1cs_witness(
+        const FieldT &rt,
+        const std::array<joinsplit_input<FieldT, TreeDepth>, NumInputs> &inputs,
+        const std::array<zeth_note, NumOutputs> &outputs,
+        bits64 vpub_in,
+        bits64 vpub_out,
+        const bits256 h_sig_in,
+        const bits256 phi_in,
+        const bool parallel = false)
+    {
+        generate_r1cs_witness_public_inputs(
+            rt, inputs, vpub_in, vpub_out, h_sig_in, phi_in);
+
+        // Witness the JoinSplit inputs and the h_is, followed by the
+        // JoinSplit outputs (and their rho_is).
+#ifdef MULTICORE
+#pragma omp parallel for if (parallel)
+#else
+        (void)parallel;
+#endif
+        for (size_t j = 0; j < NumInputs + NumOutputs; j++) {
+            if (j < NumInputs) {
+                input_notes[j]->generate_r1cs_witness(
+                    inputs[j].witness_merkle_path,
+                    inputs[j].address_bits,
+                    inputs[j].note);
+
+                h_i_gadgets[j]->generate_r1cs_witness();
+            } else {
+                const size_t i = j - NumInputs;
+                rho_i_gadgets[i]->generate_r1cs_witness();
+                output_notes[i]->generate_r1cs_witness(outputs[i]);
+            }
+        }
+
+        // This happens last, because only by now are all the
+        // verifier inputs resolved.
+        for (size_t i = 0; i < packers.size(); i++) {
+            packers[i]->generate_r1cs_witness_from_bits();
+        }
+    }
+
+    // Assign only the variables set directly from the given data, namely
+    // those of the joinsplit gadget itself and the note inputs (see
+    // input_note_gadget::generate_r1cs_witness_inputs). All remaining
+    // variables are then assigned by replaying the tape produced by
+    // record_witness.
+    void generate_r1cs_witness_inputs(
         const FieldT &rt,
         const std::array<joinsplit_input<FieldT, TreeDepth>, NumInputs> &inputs,
         const std::array<zeth_note, NumOutputs> &outputs,
@@ -457,6 +509,60 @@ public:
         bits64 vpub_out,
         const bits256 h_sig_in,
         const bits256 phi_in)
+    {
+        generate_r1cs_witness_public_inputs(
+            rt, inputs, vpub_in, vpub_out, h_sig_in, phi_in);
+
+        for (size_t i = 0; i < NumInputs; i++) {
+            input_notes[i]->generate_r1cs_witness_inputs(
+                inputs[i].witness_merkle_path,
+                inputs[i].address_bits,
+                inputs[i].note);
+        }
+        for (size_t i = 0; i < NumOutputs; i++) {
+            output_notes[i]->generate_r1cs_witness_inputs(outputs[i]);
+        }
+    }
+
+    // Record the witness computation of all sub-gadgets, in the order used
+    // by generate_r1cs_witness.
+    void record_witness(witness_tape<FieldT> &tape)
+    {
+        for (size_t i = 0; i < NumInputs; i++) {
+            input_notes[i]->record_witness(tape);
+            h_i_gadgets[i]->record_witness(tape);
+        }
+        for (size_t i = 0; i < NumOutputs; i++) {
+            rho_i_gadgets[i]->record_witness(tape);
+            output_notes[i]->record_witness(tape);
+        }
+
+        // Each multipacking_gadget packs consecutive chunks of (at most)
+        // FieldT::capacity() bits into each of its packed variables.
+        const size_t chunk_size = FieldT::capacity();
+        for (size_t i = 0; i < packers.size(); i++) {
+            const libsnark::pb_variable_array<FieldT> &bits =
+                unpacked_inputs[i];
+            for (size_t j = 0; j < packed_inputs[i].size(); j++) {
+                const size_t begin = j * chunk_size;
+                const size_t end = std::min(begin + chunk_size, bits.size());
+                tape.pack(
+                    libsnark::pb_variable_array<FieldT>(
+                        bits.begin() + begin, bits.begin() + end),
+                    packed_inputs[i][j]);
+            }
+        }
+    }
+
+    // Assign the variables of this gadget which are set directly from the
+    // given data, excluding the note gadgets.
+    void generate_r1cs_witness_public_inputs(
+        const FieldT &rt,
+        const std::array<joinsplit_input<FieldT, TreeDepth>, NumInputs> &inputs,
+        bits64 vpub_in,
+        bits64 vpub_out,
+        const bits256 h_sig_in,
+        const bits256 phi_in)
     {
         // Witness `zero`
         this->pb.val(ZERO) = FieldT::zero();
@@ -497,28 +603,6 @@ public:
 
             left_side_acc.fill_variable_array(this->pb, zk_total_uint64);
         }
-
-        // Witness the JoinSplit inputs and the h_is
-        for (size_t i = 0; i < NumInputs; i++) {
-            input_notes[i]->generate_r1cs_witness(
-                inputs[i].witness_merkle_path,
-                inputs[i].address_bits,
-                inputs[i].note);
-
-            h_i_gadgets[i]->generate_r1cs_witness();
-        }
-
-        // Witness the JoinSplit outputs
-        for (size_t i = 0; i < NumOutputs; i++) {
-            rho_i_gadgets[i]->generate_r1cs_witness();
-            output_notes[i]->generate_r1cs_witness(outputs[i]);
-        }
-
-        // This happens last, because only by now are all the
-        // verifier inputs resolved.
-        for (size_t i = 0; i < packers.size(); i++) {
-            packers[i]->generate_r1cs_witness_from_bits();
-        }
     }
 
     // Given a digest variable, assign to an unpacked field element
@@ -42,6 +42,7 @@ public:
 
     void generate_r1cs_constraints();
     void generate_r1cs_witness();
+    void record_witness(witness_tape<FieldT> &tape);
 
     // Returns boolean saying whether the expected and computed MT roots are
     // equal
@@ -46,6 +46,13 @@ void merkle_path_authenticator<FieldT, HashTreeT>::generate_r1cs_witness()
     merkle_path_compute<FieldT, HashTreeT>::generate_r1cs_witness();
 }
 
+template<typename FieldT, typename HashTreeT>
+void merkle_path_authenticator<FieldT, HashTreeT>::record_witness(
+    witness_tape<FieldT> &tape)
+{
+    merkle_path_compute<FieldT, HashTreeT>::record_witness(tape);
+}
+
 template<typename FieldT, typename HashTreeT>
 bool merkle_path_authenticator<FieldT, HashTreeT>::is_valid()
 {
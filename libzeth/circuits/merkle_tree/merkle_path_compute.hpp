@@ -45,6 +45,7 @@ public:
 
     void generate_r1cs_constraints();
     void generate_r1cs_witness();
+    void record_witness(witness_tape<FieldT> &tape);
 
     // Returns the computed root
     const libsnark::pb_variable<FieldT> result();
@@ -89,6 +89,16 @@ void merkle_path_compute<FieldT, HashTreeT>::generate_r1cs_witness()
     }
 };
 
+template<typename FieldT, typename HashTreeT>
+void merkle_path_compute<FieldT, HashTreeT>::record_witness(
+    witness_tape<FieldT> &tape)
+{
+    for (size_t i = 0; i < hashers.size(); i++) {
+        selectors[i].record_witness(tape);
+        hashers[i].record_witness(tape);
+    }
+};
+
 template<typename FieldT, typename HashTreeT>
 const libsnark::pb_variable<FieldT> merkle_path_compute<FieldT, HashTreeT>::
     result()
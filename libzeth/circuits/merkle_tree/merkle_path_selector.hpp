@@ -6,6 +6,8 @@
 #ifndef __ZETH_CIRCUITS_MERKLE_PATH_SELECTOR_HPP___
 #define __ZETH_CIRCUITS_MERKLE_PATH_SELECTOR_HPP___
 
+#include "libzeth/circuits/witness_tape.hpp"
+
 #include <libsnark/gadgetlib1/gadgets/basic_gadgets.hpp>
 
 // Depending on the address bit, output the correct left/right inputs
@@ -60,6 +62,7 @@ public:
 
     void generate_r1cs_constraints();
     void generate_r1cs_witness();
+    void record_witness(witness_tape<FieldT> &tape);
 
     // Returns the first input (left) of the next hash to compute
     const libsnark::pb_variable<FieldT> &get_left();
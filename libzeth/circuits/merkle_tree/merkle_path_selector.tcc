@@ -63,6 +63,12 @@ void merkle_path_selector<FieldT>::generate_r1cs_witness()
         this->pb.val(is_right) * (this->pb.val(input) - this->pb.val(pathvar));
 };
 
+template<typename FieldT>
+void merkle_path_selector<FieldT>::record_witness(witness_tape<FieldT> &tape)
+{
+    tape.select(input, pathvar, is_right, left, right);
+};
+
 template<typename FieldT>
 const libsnark::pb_variable<FieldT> &merkle_path_selector<FieldT>::get_left()
 {
@@ -5,6 +5,8 @@
 #ifndef __ZETH_CIRCUITS_MIMC_MIMC_INPUT_HASHER_HPP__
 #define __ZETH_CIRCUITS_MIMC_MIMC_INPUT_HASHER_HPP__
 
+#include "libzeth/circuits/witness_tape.hpp"
+
 #include <libsnark/gadgetlib1/gadget.hpp>
 
 namespace libzeth
@@ -34,6 +36,7 @@ public:
 
     void generate_r1cs_constraints();
     void generate_r1cs_witness() const;
+    void record_witness(witness_tape<FieldT> &tape) const;
 
     static FieldT get_iv();
     static FieldT compute_hash(const std::vector<FieldT> &values);
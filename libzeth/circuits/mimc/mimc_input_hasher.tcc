@@ -85,6 +85,15 @@ void mimc_input_hasher<FieldT, compFnT>::generate_r1cs_witness() const
     }
 }
 
+template<typename FieldT, typename compFnT>
+void mimc_input_hasher<FieldT, compFnT>::record_witness(
+    witness_tape<FieldT> &tape) const
+{
+    for (const std::shared_ptr<compFnT> &cf : _compression_functions) {
+        cf->record_witness(tape);
+    }
+}
+
 template<typename FieldT, typename compFnT>
 FieldT mimc_input_hasher<FieldT, compFnT>::get_iv()
 {
@@ -42,9 +42,18 @@ public:
 
     void generate_r1cs_constraints();
     void generate_r1cs_witness() const;
+    void record_witness(witness_tape<FieldT> &tape) const;
 
     // Returns the hash (field element)
     static FieldT get_hash(const FieldT x, FieldT y);
+
+    /// Compute the hashes of the pairs (x[i], y[i]) using native field
+    /// arithmetic, writing the results to out (which is resized as
+    /// necessary). Pairs are hashed in parallel when built with MULTICORE.
+    static void get_hash_batch(
+        const std::vector<FieldT> &x,
+        const std::vector<FieldT> &y,
+        std::vector<FieldT> &out);
 };
 
 } // namespace libzeth
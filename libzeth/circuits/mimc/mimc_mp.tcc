@@ -7,6 +7,8 @@
 
 #include "mimc_mp.hpp"
 
+#include <stdexcept>
+
 namespace libzeth
 {
 
@@ -41,35 +43,45 @@ void MiMC_mp_gadget<FieldT, PermutationT>::generate_r1cs_witness() const
     permutation_gadget->generate_r1cs_witness();
 }
 
-// Returns the hash of two elements
 template<typename FieldT, typename PermutationT>
-FieldT MiMC_mp_gadget<FieldT, PermutationT>::get_hash(const FieldT x, FieldT y)
+void MiMC_mp_gadget<FieldT, PermutationT>::record_witness(
+    witness_tape<FieldT> &tape) const
 {
-    libsnark::protoboard<FieldT> pb;
-
-    libsnark::pb_variable<FieldT> pb_x;
-    libsnark::pb_variable<FieldT> pb_y;
-    libsnark::pb_variable<FieldT> result;
-
-    // Allocates and fill with the x and y
-    pb_x.allocate(pb, "x");
-    pb.val(pb_x) = x;
-
-    pb_y.allocate(pb, "y");
-    pb.val(pb_y) = y;
-
-    result.allocate(pb, "result");
-
-    // Initialize the Hash
-    MiMC_mp_gadget<FieldT, PermutationT> mimc_hasher(
-        pb, pb_x, pb_y, result, " mimc_hash");
+    permutation_gadget->record_witness(tape);
+}
 
-    // Computes the hash
-    mimc_hasher.generate_r1cs_constraints();
-    mimc_hasher.generate_r1cs_witness();
+// Returns the hash of two elements. Computed natively, giving the same
+// result as the gadget:
+//
+//   result = permutation(x, y) + x + y
+template<typename FieldT, typename PermutationT>
+FieldT MiMC_mp_gadget<FieldT, PermutationT>::get_hash(const FieldT x, FieldT y)
+{
+    return PermutationT::get_permutation(x, y) + x + y;
+}
 
-    // Returns the hash
-    return pb.val(result);
+template<typename FieldT, typename PermutationT>
+void MiMC_mp_gadget<FieldT, PermutationT>::get_hash_batch(
+    const std::vector<FieldT> &x,
+    const std::vector<FieldT> &y,
+    std::vector<FieldT> &out)
+{
+    if (x.size() != y.size()) {
+        throw std::invalid_argument("mismatched MiMC batch input sizes");
+    }
+
+    // Ensure the round constants are computed before entering the parallel
+    // region.
+    PermutationT::setup_sha3_constants();
+
+    const size_t num_pairs = x.size();
+    out.resize(num_pairs);
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < num_pairs; ++i) {
+        out[i] = PermutationT::get_permutation(x[i], y[i]) + x[i] + y[i];
+    }
 }
 
 } // namespace libzeth
@@ -7,6 +7,8 @@
 
 #include "libzeth/circuits/mimc/mimc_round.hpp"
 
+#include <mutex>
+
 namespace libzeth
 {
 
@@ -28,9 +30,9 @@ private:
     // Instantiate round gadget with exponent = Exponent
     using RoundT = MiMC_round_gadget<FieldT, Exponent>;
 
-    // Vector of round constants
+    // Vector of round constants, computed once per FieldT
     static std::vector<FieldT> round_constants;
-    static bool round_constants_initialized;
+    static std::once_flag round_constants_flag;
 
     // Vector of intermediate result values
     std::array<libsnark::pb_variable<FieldT>, NumRounds> round_results;
@@ -48,6 +50,9 @@ private:
         const bool add_to_result_is_valid,
         const std::string &annotation_prefix);
 
+    // Populate round_constants (called exactly once)
+    static void compute_sha3_constants();
+
 public:
     MiMC_permutation_gadget(
         libsnark::protoboard<FieldT> &pb,
@@ -66,9 +71,16 @@ public:
 
     void generate_r1cs_constraints();
     void generate_r1cs_witness() const;
+    void record_witness(witness_tape<FieldT> &tape) const;
+
+    /// Native evaluation of the permutation (including the addition of
+    /// `key` in the final round), using plain field arithmetic. Equal to the
+    /// value of `result` computed by the gadget with no `add_to_result`.
+    static FieldT get_permutation(const FieldT &msg, const FieldT &key);
 
-    // Constants vector initialization
-    void setup_sha3_constants();
+    /// Constants vector initialization. Safe to call concurrently from
+    /// several threads.
+    static void setup_sha3_constants();
 };
 
 } // namespace libzeth
@@ -15,8 +15,8 @@ std::vector<FieldT>
     MiMC_permutation_gadget<FieldT, Exponent, NumRounds>::round_constants;
 
 template<typename FieldT, size_t Exponent, size_t NumRounds>
-bool MiMC_permutation_gadget<FieldT, Exponent, NumRounds>::
-    round_constants_initialized = false;
+std::once_flag
+    MiMC_permutation_gadget<FieldT, Exponent, NumRounds>::round_constants_flag;
 
 template<typename FieldT, size_t Exponent, size_t NumRounds>
 MiMC_permutation_gadget<FieldT, Exponent, NumRounds>::MiMC_permutation_gadget(
@@ -144,17 +144,43 @@ void MiMC_permutation_gadget<FieldT, Exponent, NumRounds>::
     }
 }
 
+template<typename FieldT, size_t Exponent, size_t NumRounds>
+void MiMC_permutation_gadget<FieldT, Exponent, NumRounds>::record_witness(
+    witness_tape<FieldT> &tape) const
+{
+    for (auto &gadget : round_gadgets) {
+        gadget.record_witness(tape);
+    }
+}
+
+template<typename FieldT, size_t Exponent, size_t NumRounds>
+FieldT MiMC_permutation_gadget<FieldT, Exponent, NumRounds>::get_permutation(
+    const FieldT &msg, const FieldT &key)
+{
+    setup_sha3_constants();
+
+    FieldT t = msg;
+    for (size_t i = 0; i < NumRounds; ++i) {
+        t = RoundT::get_round_value(t, key, round_constants[i]);
+    }
+
+    return t + key;
+}
+
+template<typename FieldT, size_t Exponent, size_t NumRounds>
+void MiMC_permutation_gadget<FieldT, Exponent, NumRounds>::
+    setup_sha3_constants()
+{
+    std::call_once(round_constants_flag, compute_sha3_constants);
+}
+
 // The following constants correspond to the iterative computation of sha3_256
 // hash function over the initial seed "clearmatics_mt_seed". See:
 // client/zethCodeConstantsGeneration.py for more details
 template<typename FieldT, size_t Exponent, size_t NumRounds>
 void MiMC_permutation_gadget<FieldT, Exponent, NumRounds>::
-    setup_sha3_constants()
+    compute_sha3_constants()
 {
-    if (round_constants_initialized) {
-        return;
-    }
-
     // For simplicity, always generate constants for MaxRounds.
     round_constants.reserve(MaxRounds);
 
@@ -297,7 +323,6 @@ void MiMC_permutation_gadget<FieldT, Exponent, NumRounds>::
     // clang-format on
 
     assert(round_constants.size() == MaxRounds);
-    round_constants_initialized = true;
 }
 
 } // namespace libzeth
@@ -6,6 +6,7 @@
 #define __ZETH_CIRCUITS_MIMC_ROUND_HPP__
 
 #include "libzeth/circuits/circuit_utils.hpp"
+#include "libzeth/circuits/witness_tape.hpp"
 #include "libzeth/core/utils.hpp"
 
 #include <libsnark/gadgetlib1/gadget.hpp>
@@ -70,6 +71,12 @@ public:
 
     void generate_r1cs_constraints();
     void generate_r1cs_witness() const;
+    void record_witness(witness_tape<FieldT> &tape) const;
+
+    /// Native evaluation of the round (outside of any protoboard), returning
+    /// (msg + key + round_const)^Exponent.
+    static FieldT get_round_value(
+        const FieldT &msg, const FieldT &key, const FieldT &round_const);
 };
 
 } // namespace libzeth
@@ -161,6 +161,58 @@ void MiMC_round_gadget<FieldT, Exponent>::generate_r1cs_witness() const
     this->pb.val(result) = v;
 }
 
+template<typename FieldT, size_t Exponent>
+void MiMC_round_gadget<FieldT, Exponent>::record_witness(
+    witness_tape<FieldT> &tape) const
+{
+    // Record the square-and-multiply sequence of generate_r1cs_constraints,
+    // where each intermediate value is either last * t or last * last.
+    constexpr size_t mask = 1 << (EXPONENT_NUM_BITS - 1);
+    size_t exp = Exponent << 1;
+    std::vector<bool> multiply_by_t;
+    multiply_by_t.reserve(exponents.size());
+    multiply_by_t.push_back(false);
+    for (size_t i = 1; i < EXPONENT_NUM_BITS - 1; ++i) {
+        if (exp & mask) {
+            multiply_by_t.push_back(true);
+        }
+        multiply_by_t.push_back(false);
+        exp = exp << 1;
+    }
+    assert(multiply_by_t.size() == exponents.size());
+
+    tape.mimc_round(
+        msg + key + round_const,
+        exponents,
+        multiply_by_t,
+        result,
+        add_to_result_is_valid ? libsnark::linear_combination<FieldT>(
+                                     add_to_result)
+                               : libsnark::linear_combination<FieldT>());
+}
+
+template<typename FieldT, size_t Exponent>
+FieldT MiMC_round_gadget<FieldT, Exponent>::get_round_value(
+    const FieldT &msg, const FieldT &key, const FieldT &round_const)
+{
+    // Same square-and-multiply sequence as generate_r1cs_witness, without
+    // storing the intermediate values.
+    constexpr size_t mask = 1 << (EXPONENT_NUM_BITS - 1);
+    const FieldT t = msg + key + round_const;
+
+    size_t exp = Exponent << 1;
+    FieldT v = t.squared();
+    for (size_t i = 1; i < EXPONENT_NUM_BITS - 1; ++i) {
+        if (exp & mask) {
+            v *= t;
+        }
+        v = v.squared();
+        exp = exp << 1;
+    }
+
+    return v * t;
+}
+
 } // namespace libzeth
 
 #endif // __ZETH_CIRCUITS_MIMC_ROUND_TCC__
@@ -91,6 +91,17 @@ public:
         const std::vector<FieldT> &merkle_path,
         const bits_addr<TreeDepth> &address_bits,
         const zeth_note &note);
+
+    // Assign only the variables set directly from the note data and merkle
+    // path (i.e. not computed by sub-gadgets)
+    void generate_r1cs_witness_inputs(
+        const std::vector<FieldT> &merkle_path,
+        const bits_addr<TreeDepth> &address_bits,
+        const zeth_note &note);
+
+    // Record the witness computation of the sub-gadgets, assuming the
+    // variables set by generate_r1cs_witness_inputs are assigned
+    void record_witness(witness_tape<FieldT> &tape);
 };
 
 /// Commit to the output notes of the Joinsplit
@@ -113,6 +124,10 @@ public:
     void generate_r1cs_constraints();
 
     void generate_r1cs_witness(const zeth_note &note);
+
+    // See input_note_gadget
+    void generate_r1cs_witness_inputs(const zeth_note &note);
+    void record_witness(witness_tape<FieldT> &tape);
 };
 
 } // namespace libzeth
@@ -168,20 +168,33 @@ void input_note_gadget<FieldT, HashT, HashTreeT, TreeDepth>::
         const bits_addr<TreeDepth> &address_bits,
         const zeth_note &note)
 {
-    // Generate witness of parent gadget
-    note_gadget<FieldT>::generate_r1cs_witness(note);
+    generate_r1cs_witness_inputs(merkle_path, address_bits, note);
 
     // Witness a_pk for a_sk with PRF_addr
     spend_authority->generate_r1cs_witness();
 
-    // Witness rho for the input note
-    note.rho.fill_variable_array(this->pb, rho);
     // Witness the nullifier for the input note
     expose_nullifiers->generate_r1cs_witness();
 
     // Witness the commitment of the input note
     commit_to_inputs_cm->generate_r1cs_witness();
 
+    check_membership->generate_r1cs_witness();
+}
+
+template<typename FieldT, typename HashT, typename HashTreeT, size_t TreeDepth>
+void input_note_gadget<FieldT, HashT, HashTreeT, TreeDepth>::
+    generate_r1cs_witness_inputs(
+        const std::vector<FieldT> &merkle_path,
+        const bits_addr<TreeDepth> &address_bits,
+        const zeth_note &note)
+{
+    // Generate witness of parent gadget
+    note_gadget<FieldT>::generate_r1cs_witness(note);
+
+    // Witness rho for the input note
+    note.rho.fill_variable_array(this->pb, rho);
+
     // Set enforce flag for nonzero input value
     // Set the enforce flag according to the value of the note
     // Remember that if the note has a value of 0, we do not enforce the
@@ -262,8 +275,16 @@ void input_note_gadget<FieldT, HashT, HashTreeT, TreeDepth>::
 
     // Set auth_path values
     auth_path->fill_with_field_elements(this->pb, merkle_path);
+}
 
-    check_membership->generate_r1cs_witness();
+template<typename FieldT, typename HashT, typename HashTreeT, size_t TreeDepth>
+void input_note_gadget<FieldT, HashT, HashTreeT, TreeDepth>::record_witness(
+    witness_tape<FieldT> &tape)
+{
+    spend_authority->record_witness(tape);
+    expose_nullifiers->record_witness(tape);
+    commit_to_inputs_cm->record_witness(tape);
+    check_membership->record_witness(tape);
 }
 
 // Commit to the output notes of the JS
@@ -296,14 +317,27 @@ void output_note_gadget<FieldT, HashT>::generate_r1cs_constraints()
 template<typename FieldT, typename HashT>
 void output_note_gadget<FieldT, HashT>::generate_r1cs_witness(
     const zeth_note &note)
+{
+    generate_r1cs_witness_inputs(note);
+    commit_to_outputs_cm->generate_r1cs_witness();
+}
+
+template<typename FieldT, typename HashT>
+void output_note_gadget<FieldT, HashT>::generate_r1cs_witness_inputs(
+    const zeth_note &note)
 {
     // Generate witness of the parent gadget
     note_gadget<FieldT>::generate_r1cs_witness(note);
 
     // Witness a_pk with note information
     note.a_pk.fill_variable_array(this->pb, a_pk->bits);
+}
 
-    commit_to_outputs_cm->generate_r1cs_witness();
+template<typename FieldT, typename HashT>
+void output_note_gadget<FieldT, HashT>::record_witness(
+    witness_tape<FieldT> &tape)
+{
+    commit_to_outputs_cm->record_witness(tape);
 }
 
 } // namespace libzeth
@@ -10,6 +10,7 @@
 // https://github.com/zcash/zcash/blob/master/src/zcash/circuit/prfs.tcc
 
 #include "libzeth/circuits/circuit_utils.hpp"
+#include "libzeth/circuits/witness_tape.hpp"
 
 #include <libsnark/gadgetlib1/gadget.hpp>
 #include <libsnark/gadgetlib1/gadgets/hashes/hash_io.hpp>
@@ -36,6 +37,7 @@ public:
 
     void generate_r1cs_constraints();
     void generate_r1cs_witness();
+    void record_witness(witness_tape<FieldT> &tape);
 };
 
 // This function is useful as the generation of a_pk is done via a_pk =
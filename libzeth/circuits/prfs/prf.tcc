@@ -40,6 +40,12 @@ void PRF_gadget<FieldT, HashT>::generate_r1cs_witness()
     hasher.generate_r1cs_witness();
 }
 
+template<typename FieldT, typename HashT>
+void PRF_gadget<FieldT, HashT>::record_witness(witness_tape<FieldT> &tape)
+{
+    hasher.record_witness(tape);
+}
+
 template<typename FieldT, typename HashT>
 libsnark::pb_variable_array<FieldT> gen_256_zeroes(
     const libsnark::pb_variable<FieldT> &ZERO)
@@ -0,0 +1,132 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CIRCUITS_WITNESS_TAPE_HPP__
+#define __ZETH_CIRCUITS_WITNESS_TAPE_HPP__
+
+#include <cstdint>
+#include <libsnark/gadgetlib1/pb_variable.hpp>
+#include <libsnark/gadgetlib1/protoboard.hpp>
+#include <vector>
+
+namespace libzeth
+{
+
+/// A flat sequence of typed operations over variable indices, recording the
+/// witness computation of a tree of gadgets (see the `record_witness` methods
+/// of the gadgets). Once the "input" variables (those assigned directly from
+/// the prover's data, see e.g. joinsplit_gadget::generate_r1cs_witness_inputs)
+/// are set, replaying the tape assigns every variable that the recorded
+/// gadgets would assign, in the same order, without traversing the gadget
+/// objects.
+///
+/// Bit-string operations expect (and produce) variables holding
+/// FieldT::zero() or FieldT::one().
+template<typename FieldT> class witness_tape
+{
+public:
+    using variable_array = libsnark::pb_variable_array<FieldT>;
+
+    /// dst[i] = src[i]
+    void copy(const variable_array &src, const variable_array &dst);
+
+    /// dst[i] = bits[i]
+    void constant_bits(const std::vector<bool> &bits, const variable_array &dst);
+
+    /// res[(i + shift) % n] = a[i] XOR b[i] (see xor_gadget and
+    /// xor_rot_gadget)
+    void xor_bits(
+        const variable_array &a,
+        const variable_array &b,
+        const variable_array &res,
+        const size_t shift = 0);
+
+    /// res[i] = a[i] XOR b[i] XOR c[i], for constant bits c (see
+    /// xor_constant_gadget)
+    void xor_constant_bits(
+        const variable_array &a,
+        const variable_array &b,
+        const std::vector<FieldT> &c,
+        const variable_array &res);
+
+    /// res = (a + b) mod 2^32, where each 32-bit string holds the most
+    /// significant bit first (see double_bit32_sum_eq_gadget)
+    void add_bits32(
+        const variable_array &a,
+        const variable_array &b,
+        const variable_array &res);
+
+    /// result = sum_i bits[i] * 2^i (see libsnark::packing_gadget)
+    void pack(
+        const variable_array &bits, const libsnark::pb_variable<FieldT> &result);
+
+    /// left = input + is_right * (pathvar - input),
+    /// right = pathvar + is_right * (input - pathvar)
+    /// (see merkle_path_selector)
+    void select(
+        const libsnark::pb_variable<FieldT> &input,
+        const libsnark::pb_variable<FieldT> &pathvar,
+        const libsnark::pb_variable<FieldT> &is_right,
+        const libsnark::pb_variable<FieldT> &left,
+        const libsnark::pb_variable<FieldT> &right);
+
+    /// A MiMC round (see MiMC_round_gadget). With v initially equal to t,
+    /// intermediates[j] = v <- (multiply_by_t[j] ? v * t : v * v), and
+    /// finally result = v * t + add_to_result.
+    void mimc_round(
+        const libsnark::linear_combination<FieldT> &t,
+        const std::vector<libsnark::pb_variable<FieldT>> &intermediates,
+        const std::vector<bool> &multiply_by_t,
+        const libsnark::pb_variable<FieldT> &result,
+        const libsnark::linear_combination<FieldT> &add_to_result);
+
+    size_t num_instructions() const;
+
+    void clear();
+
+    /// Replay the tape over a full assignment, in which entry i holds the
+    /// value of variable i (and in particular entry 0 holds FieldT::one()).
+    void execute(std::vector<FieldT> &assignment) const;
+
+    /// Replay the tape over the assignment of `pb`, using `assignment` as a
+    /// buffer (whose capacity can be reused for subsequent calls).
+    void execute(
+        libsnark::protoboard<FieldT> &pb, std::vector<FieldT> &assignment) const;
+
+private:
+    enum class opcode : uint8_t {
+        copy,
+        constant_bits,
+        xor_bits,
+        xor_constant_bits,
+        add_bits32,
+        pack,
+        select,
+        mimc_round,
+    };
+
+    // Each instruction reads its variable indices (and other integer
+    // operands) from `operands`, and its field constants from
+    // `coefficients`, starting at the given offsets.
+    struct instruction {
+        opcode code;
+        size_t size;
+        size_t operands_offset;
+        size_t coefficients_offset;
+    };
+
+    void push_instruction(const opcode code, const size_t size);
+    void push_variables(const variable_array &variables);
+    void push_terms(const libsnark::linear_combination<FieldT> &lc);
+
+    std::vector<instruction> instructions;
+    std::vector<size_t> operands;
+    std::vector<FieldT> coefficients;
+};
+
+} // namespace libzeth
+
+#include "libzeth/circuits/witness_tape.tcc"
+
+#endif // __ZETH_CIRCUITS_WITNESS_TAPE_HPP__
@@ -0,0 +1,327 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CIRCUITS_WITNESS_TAPE_TCC__
+#define __ZETH_CIRCUITS_WITNESS_TAPE_TCC__
+
+#include "libzeth/circuits/witness_tape.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace libzeth
+{
+
+namespace internal
+{
+
+template<typename FieldT>
+inline bool witness_tape_bit(const FieldT *values, const size_t var)
+{
+    return !values[var].is_zero();
+}
+
+// Read a 32-bit word from bit variables, most significant bit first.
+template<typename FieldT>
+uint32_t witness_tape_read_word(const FieldT *values, const size_t *vars)
+{
+    uint32_t word = 0;
+    for (size_t i = 0; i < 32; ++i) {
+        word = (word << 1) | (witness_tape_bit(values, vars[i]) ? 1 : 0);
+    }
+    return word;
+}
+
+template<typename FieldT>
+FieldT witness_tape_evaluate(
+    const FieldT *values,
+    const size_t *vars,
+    const FieldT *coefficients,
+    const size_t num_terms)
+{
+    FieldT sum = FieldT::zero();
+    for (size_t i = 0; i < num_terms; ++i) {
+        sum += coefficients[i] * values[vars[i]];
+    }
+    return sum;
+}
+
+} // namespace internal
+
+template<typename FieldT>
+void witness_tape<FieldT>::copy(
+    const variable_array &src, const variable_array &dst)
+{
+    assert(src.size() == dst.size());
+    push_instruction(opcode::copy, src.size());
+    push_variables(src);
+    push_variables(dst);
+}
+
+template<typename FieldT>
+void witness_tape<FieldT>::constant_bits(
+    const std::vector<bool> &bits, const variable_array &dst)
+{
+    assert(bits.size() == dst.size());
+    push_instruction(opcode::constant_bits, bits.size());
+    push_variables(dst);
+    operands.insert(operands.end(), bits.begin(), bits.end());
+}
+
+template<typename FieldT>
+void witness_tape<FieldT>::xor_bits(
+    const variable_array &a,
+    const variable_array &b,
+    const variable_array &res,
+    const size_t shift)
+{
+    assert(a.size() == b.size());
+    assert(b.size() == res.size());
+    const size_t n = a.size();
+    push_instruction(opcode::xor_bits, n);
+    push_variables(a);
+    push_variables(b);
+    // The rotation is applied to the destination indices when recording.
+    for (size_t i = 0; i < n; ++i) {
+        operands.push_back(res[(i + shift) % n].index);
+    }
+}
+
+template<typename FieldT>
+void witness_tape<FieldT>::xor_constant_bits(
+    const variable_array &a,
+    const variable_array &b,
+    const std::vector<FieldT> &c,
+    const variable_array &res)
+{
+    assert(a.size() == b.size());
+    assert(b.size() == c.size());
+    assert(c.size() == res.size());
+    push_instruction(opcode::xor_constant_bits, a.size());
+    push_variables(a);
+    push_variables(b);
+    for (const FieldT &c_i : c) {
+        operands.push_back(c_i == FieldT::one() ? 1 : 0);
+    }
+    push_variables(res);
+}
+
+template<typename FieldT>
+void witness_tape<FieldT>::add_bits32(
+    const variable_array &a, const variable_array &b, const variable_array &res)
+{
+    assert(a.size() == 32);
+    assert(b.size() == 32);
+    assert(res.size() == 32);
+    push_instruction(opcode::add_bits32, 32);
+    push_variables(a);
+    push_variables(b);
+    push_variables(res);
+}
+
+template<typename FieldT>
+void witness_tape<FieldT>::pack(
+    const variable_array &bits, const libsnark::pb_variable<FieldT> &result)
+{
+    push_instruction(opcode::pack, bits.size());
+    push_variables(bits);
+    operands.push_back(result.index);
+}
+
+template<typename FieldT>
+void witness_tape<FieldT>::select(
+    const libsnark::pb_variable<FieldT> &input,
+    const libsnark::pb_variable<FieldT> &pathvar,
+    const libsnark::pb_variable<FieldT> &is_right,
+    const libsnark::pb_variable<FieldT> &left,
+    const libsnark::pb_variable<FieldT> &right)
+{
+    push_instruction(opcode::select, 5);
+    operands.push_back(input.index);
+    operands.push_back(pathvar.index);
+    operands.push_back(is_right.index);
+    operands.push_back(left.index);
+    operands.push_back(right.index);
+}
+
+template<typename FieldT>
+void witness_tape<FieldT>::mimc_round(
+    const libsnark::linear_combination<FieldT> &t,
+    const std::vector<libsnark::pb_variable<FieldT>> &intermediates,
+    const std::vector<bool> &multiply_by_t,
+    const libsnark::pb_variable<FieldT> &result,
+    const libsnark::linear_combination<FieldT> &add_to_result)
+{
+    assert(intermediates.size() == multiply_by_t.size());
+    push_instruction(opcode::mimc_round, intermediates.size());
+    push_terms(t);
+    push_terms(add_to_result);
+    for (const libsnark::pb_variable<FieldT> &var : intermediates) {
+        operands.push_back(var.index);
+    }
+    operands.insert(operands.end(), multiply_by_t.begin(), multiply_by_t.end());
+    operands.push_back(result.index);
+}
+
+template<typename FieldT> size_t witness_tape<FieldT>::num_instructions() const
+{
+    return instructions.size();
+}
+
+template<typename FieldT> void witness_tape<FieldT>::clear()
+{
+    instructions.clear();
+    operands.clear();
+    coefficients.clear();
+}
+
+template<typename FieldT>
+void witness_tape<FieldT>::execute(std::vector<FieldT> &assignment) const
+{
+    const FieldT zero = FieldT::zero();
+    const FieldT one = FieldT::one();
+    FieldT *const values = assignment.data();
+
+    for (const instruction &instr : instructions) {
+        const size_t n = instr.size;
+        const size_t *ops = operands.data() + instr.operands_offset;
+        const FieldT *coeffs = coefficients.data() + instr.coefficients_offset;
+
+        switch (instr.code) {
+        case opcode::copy:
+            for (size_t i = 0; i < n; ++i) {
+                values[ops[n + i]] = values[ops[i]];
+            }
+            break;
+
+        case opcode::constant_bits:
+            for (size_t i = 0; i < n; ++i) {
+                values[ops[i]] = ops[n + i] ? one : zero;
+            }
+            break;
+
+        case opcode::xor_bits:
+            for (size_t i = 0; i < n; ++i) {
+                const bool a = internal::witness_tape_bit(values, ops[i]);
+                const bool b = internal::witness_tape_bit(values, ops[n + i]);
+                values[ops[2 * n + i]] = (a != b) ? one : zero;
+            }
+            break;
+
+        case opcode::xor_constant_bits:
+            for (size_t i = 0; i < n; ++i) {
+                const bool a = internal::witness_tape_bit(values, ops[i]);
+                const bool b = internal::witness_tape_bit(values, ops[n + i]);
+                const bool c = ops[2 * n + i] != 0;
+                values[ops[3 * n + i]] = ((a != b) != c) ? one : zero;
+            }
+            break;
+
+        case opcode::add_bits32: {
+            const uint32_t sum =
+                internal::witness_tape_read_word(values, ops) +
+                internal::witness_tape_read_word(values, ops + 32);
+            for (size_t i = 0; i < 32; ++i) {
+                values[ops[64 + i]] = ((sum >> (31 - i)) & 1) ? one : zero;
+            }
+            break;
+        }
+
+        case opcode::pack: {
+            FieldT packed = zero;
+            for (size_t i = n; i > 0;) {
+                --i;
+                packed += packed;
+                if (internal::witness_tape_bit(values, ops[i])) {
+                    packed += one;
+                }
+            }
+            values[ops[n]] = packed;
+            break;
+        }
+
+        case opcode::select: {
+            const FieldT &input = values[ops[0]];
+            const FieldT &pathvar = values[ops[1]];
+            const FieldT &is_right = values[ops[2]];
+            const FieldT left = input + is_right * (pathvar - input);
+            const FieldT right = pathvar + is_right * (input - pathvar);
+            values[ops[3]] = left;
+            values[ops[4]] = right;
+            break;
+        }
+
+        case opcode::mimc_round: {
+            const size_t num_t_terms = *ops++;
+            const FieldT t = internal::witness_tape_evaluate(
+                values, ops, coeffs, num_t_terms);
+            ops += num_t_terms;
+            coeffs += num_t_terms;
+            const size_t num_add_terms = *ops++;
+            const size_t *add_vars = ops;
+            const FieldT *add_coeffs = coeffs;
+            ops += num_add_terms;
+
+            FieldT v = t;
+            for (size_t j = 0; j < n; ++j) {
+                v = ops[n + j] ? v * t : v.squared();
+                values[ops[j]] = v;
+            }
+            values[ops[2 * n]] =
+                v * t + internal::witness_tape_evaluate(
+                            values, add_vars, add_coeffs, num_add_terms);
+            break;
+        }
+        }
+    }
+}
+
+template<typename FieldT>
+void witness_tape<FieldT>::execute(
+    libsnark::protoboard<FieldT> &pb, std::vector<FieldT> &assignment) const
+{
+    {
+        const libsnark::r1cs_variable_assignment<FieldT> &values =
+            pb.full_variable_assignment();
+        assignment.resize(values.size() + 1);
+        assignment[0] = FieldT::one();
+        std::copy(values.begin(), values.end(), assignment.begin() + 1);
+    }
+
+    execute(assignment);
+
+    for (size_t i = 1; i < assignment.size(); ++i) {
+        pb.val(libsnark::pb_variable<FieldT>(i)) = assignment[i];
+    }
+}
+
+template<typename FieldT>
+void witness_tape<FieldT>::push_instruction(
+    const opcode code, const size_t size)
+{
+    instructions.push_back({code, size, operands.size(), coefficients.size()});
+}
+
+template<typename FieldT>
+void witness_tape<FieldT>::push_variables(const variable_array &variables)
+{
+    for (const libsnark::pb_variable<FieldT> &var : variables) {
+        operands.push_back(var.index);
+    }
+}
+
+template<typename FieldT>
+void witness_tape<FieldT>::push_terms(
+    const libsnark::linear_combination<FieldT> &lc)
+{
+    operands.push_back(lc.terms.size());
+    for (const libsnark::linear_term<FieldT> &term : lc.terms) {
+        operands.push_back(term.index);
+        coefficients.push_back(term.coeff);
+    }
+}
+
+} // namespace libzeth
+
+#endif // __ZETH_CIRCUITS_WITNESS_TAPE_TCC__
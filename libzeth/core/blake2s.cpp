@@ -0,0 +1,367 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "libzeth/core/blake2s.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace libzeth
+{
+
+// See: Appendix A.2 of https://blake2.net/blake2.pdf
+static const uint32_t BLAKE2S_IV[8] = {
+    0x6A09E667,
+    0xBB67AE85,
+    0x3C6EF372,
+    0xA54FF53A,
+    0x510E527F,
+    0x9B05688C,
+    0x1F83D9AB,
+    0x5BE0CD19,
+};
+
+// Message word permutations (Section 2.7 of https://blake2.net/blake2.pdf)
+static const uint8_t BLAKE2S_SIGMA[10][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+    {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4},
+    {7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
+    {9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13},
+    {2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
+    {12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11},
+    {13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
+    {6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5},
+    {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0},
+};
+
+static const size_t BLAKE2S_ROUNDS = 10;
+
+// Parameter block word 0: digest length 32, no key, fanout 1, depth 1.
+static const uint32_t BLAKE2S_256_PARAM_0 = 0x01010000 | 32;
+
+static uint32_t load32_le(const uint8_t *src)
+{
+    return (uint32_t)src[0] | ((uint32_t)src[1] << 8) |
+           ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+static void store32_le(uint8_t *dest, uint32_t w)
+{
+    dest[0] = (uint8_t)w;
+    dest[1] = (uint8_t)(w >> 8);
+    dest[2] = (uint8_t)(w >> 16);
+    dest[3] = (uint8_t)(w >> 24);
+}
+
+static uint32_t rotr32(uint32_t w, unsigned c)
+{
+    return (w >> c) | (w << (32 - c));
+}
+
+// Number of compression function calls for a message of the given size. The
+// empty message is processed as a single (all zero) final block.
+static size_t blake2s_num_blocks(size_t data_size)
+{
+    const size_t num_blocks =
+        (data_size + BLAKE2S_BLOCK_SIZE_BYTES - 1) / BLAKE2S_BLOCK_SIZE_BYTES;
+    return std::max<size_t>(1, num_blocks);
+}
+
+// Copy the block_idx-th (zero-padded) block of a message to block.
+static void blake2s_read_block(
+    const uint8_t *data,
+    size_t data_size,
+    size_t block_idx,
+    uint8_t block[BLAKE2S_BLOCK_SIZE_BYTES])
+{
+    const size_t offset = block_idx * BLAKE2S_BLOCK_SIZE_BYTES;
+    const size_t num_bytes =
+        std::min(BLAKE2S_BLOCK_SIZE_BYTES, data_size - offset);
+    if (num_bytes != 0) {
+        memcpy(block, data + offset, num_bytes);
+    }
+    memset(block + num_bytes, 0, BLAKE2S_BLOCK_SIZE_BYTES - num_bytes);
+}
+
+#define BLAKE2S_G(a, b, c, d, x, y)                                            \
+    do {                                                                       \
+        a = a + b + (x);                                                       \
+        d = rotr32(d ^ a, 16);                                                 \
+        c = c + d;                                                             \
+        b = rotr32(b ^ c, 12);                                                 \
+        a = a + b + (y);                                                       \
+        d = rotr32(d ^ a, 8);                                                  \
+        c = c + d;                                                             \
+        b = rotr32(b ^ c, 7);                                                  \
+    } while (0)
+
+static void blake2s_compress(
+    uint32_t h[8],
+    const uint8_t block[BLAKE2S_BLOCK_SIZE_BYTES],
+    uint64_t counter,
+    bool is_last_block)
+{
+    uint32_t m[16];
+    for (size_t i = 0; i < 16; ++i) {
+        m[i] = load32_le(block + 4 * i);
+    }
+
+    uint32_t v[16];
+    for (size_t i = 0; i < 8; ++i) {
+        v[i] = h[i];
+        v[i + 8] = BLAKE2S_IV[i];
+    }
+    v[12] ^= (uint32_t)counter;
+    v[13] ^= (uint32_t)(counter >> 32);
+    if (is_last_block) {
+        v[14] = ~v[14];
+    }
+
+    for (size_t r = 0; r < BLAKE2S_ROUNDS; ++r) {
+        const uint8_t *s = BLAKE2S_SIGMA[r];
+        BLAKE2S_G(v[0], v[4], v[8], v[12], m[s[0]], m[s[1]]);
+        BLAKE2S_G(v[1], v[5], v[9], v[13], m[s[2]], m[s[3]]);
+        BLAKE2S_G(v[2], v[6], v[10], v[14], m[s[4]], m[s[5]]);
+        BLAKE2S_G(v[3], v[7], v[11], v[15], m[s[6]], m[s[7]]);
+        BLAKE2S_G(v[0], v[5], v[10], v[15], m[s[8]], m[s[9]]);
+        BLAKE2S_G(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]);
+        BLAKE2S_G(v[2], v[7], v[8], v[13], m[s[12]], m[s[13]]);
+        BLAKE2S_G(v[3], v[4], v[9], v[14], m[s[14]], m[s[15]]);
+    }
+
+    for (size_t i = 0; i < 8; ++i) {
+        h[i] ^= v[i] ^ v[i + 8];
+    }
+}
+
+#undef BLAKE2S_G
+
+void blake2s_256(
+    const void *data,
+    size_t data_size,
+    uint8_t out_digest[BLAKE2S_256_DIGEST_SIZE_BYTES])
+{
+    uint32_t h[8];
+    memcpy(h, BLAKE2S_IV, sizeof(h));
+    h[0] ^= BLAKE2S_256_PARAM_0;
+
+    const uint8_t *bytes = (const uint8_t *)data;
+    const size_t num_blocks = blake2s_num_blocks(data_size);
+    uint8_t block[BLAKE2S_BLOCK_SIZE_BYTES];
+    for (size_t i = 0; i < num_blocks - 1; ++i) {
+        blake2s_compress(
+            h,
+            bytes + i * BLAKE2S_BLOCK_SIZE_BYTES,
+            (i + 1) * BLAKE2S_BLOCK_SIZE_BYTES,
+            false);
+    }
+    blake2s_read_block(bytes, data_size, num_blocks - 1, block);
+    blake2s_compress(h, block, data_size, true);
+
+    for (size_t i = 0; i < 8; ++i) {
+        store32_le(out_digest + 4 * i, h[i]);
+    }
+}
+
+#ifdef __AVX2__
+
+// Multi-buffer implementation: each __m256i holds the same state word for 8
+// independent messages (one per 32-bit lane), so that the G function operates
+// on 8 messages at once.
+
+static inline __m256i blake2s_x8_rotr16(__m256i w)
+{
+    const __m256i shuffle = _mm256_setr_epi8(
+        2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+        2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    return _mm256_shuffle_epi8(w, shuffle);
+}
+
+static inline __m256i blake2s_x8_rotr8(__m256i w)
+{
+    const __m256i shuffle = _mm256_setr_epi8(
+        1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12,
+        1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12);
+    return _mm256_shuffle_epi8(w, shuffle);
+}
+
+#define BLAKE2S_X8_ROTR(w, c)                                                  \
+    _mm256_or_si256(                                                           \
+        _mm256_srli_epi32((w), (c)), _mm256_slli_epi32((w), 32 - (c)))
+
+#define BLAKE2S_X8_G(a, b, c, d, x, y)                                         \
+    do {                                                                       \
+        a = _mm256_add_epi32(_mm256_add_epi32(a, b), (x));                     \
+        d = blake2s_x8_rotr16(_mm256_xor_si256(d, a));                         \
+        c = _mm256_add_epi32(c, d);                                            \
+        b = BLAKE2S_X8_ROTR(_mm256_xor_si256(b, c), 12);                       \
+        a = _mm256_add_epi32(_mm256_add_epi32(a, b), (y));                     \
+        d = blake2s_x8_rotr8(_mm256_xor_si256(d, a));                          \
+        c = _mm256_add_epi32(c, d);                                            \
+        b = BLAKE2S_X8_ROTR(_mm256_xor_si256(b, c), 7);                        \
+    } while (0)
+
+static void blake2s_compress_x8(
+    __m256i h[8],
+    const uint8_t *const blocks[BLAKE2S_256_BATCH_LANES],
+    uint64_t counter,
+    bool is_last_block)
+{
+    // Transpose the message words, so that m[i] holds word i of each block.
+    __m256i m[16];
+    for (size_t i = 0; i < 16; ++i) {
+        m[i] = _mm256_setr_epi32(
+            (int)load32_le(blocks[0] + 4 * i),
+            (int)load32_le(blocks[1] + 4 * i),
+            (int)load32_le(blocks[2] + 4 * i),
+            (int)load32_le(blocks[3] + 4 * i),
+            (int)load32_le(blocks[4] + 4 * i),
+            (int)load32_le(blocks[5] + 4 * i),
+            (int)load32_le(blocks[6] + 4 * i),
+            (int)load32_le(blocks[7] + 4 * i));
+    }
+
+    __m256i v[16];
+    for (size_t i = 0; i < 8; ++i) {
+        v[i] = h[i];
+        v[i + 8] = _mm256_set1_epi32((int)BLAKE2S_IV[i]);
+    }
+    v[12] = _mm256_xor_si256(v[12], _mm256_set1_epi32((int)(uint32_t)counter));
+    v[13] = _mm256_xor_si256(
+        v[13], _mm256_set1_epi32((int)(uint32_t)(counter >> 32)));
+    if (is_last_block) {
+        v[14] = _mm256_xor_si256(v[14], _mm256_set1_epi32(-1));
+    }
+
+    for (size_t r = 0; r < BLAKE2S_ROUNDS; ++r) {
+        const uint8_t *s = BLAKE2S_SIGMA[r];
+        BLAKE2S_X8_G(v[0], v[4], v[8], v[12], m[s[0]], m[s[1]]);
+        BLAKE2S_X8_G(v[1], v[5], v[9], v[13], m[s[2]], m[s[3]]);
+        BLAKE2S_X8_G(v[2], v[6], v[10], v[14], m[s[4]], m[s[5]]);
+        BLAKE2S_X8_G(v[3], v[7], v[11], v[15], m[s[6]], m[s[7]]);
+        BLAKE2S_X8_G(v[0], v[5], v[10], v[15], m[s[8]], m[s[9]]);
+        BLAKE2S_X8_G(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]);
+        BLAKE2S_X8_G(v[2], v[7], v[8], v[13], m[s[12]], m[s[13]]);
+        BLAKE2S_X8_G(v[3], v[4], v[9], v[14], m[s[14]], m[s[15]]);
+    }
+
+    for (size_t i = 0; i < 8; ++i) {
+        h[i] = _mm256_xor_si256(h[i], _mm256_xor_si256(v[i], v[i + 8]));
+    }
+}
+
+#undef BLAKE2S_X8_G
+#undef BLAKE2S_X8_ROTR
+
+// Hash BLAKE2S_256_BATCH_LANES messages, all of length data_size.
+static void blake2s_256_x8(
+    const uint8_t *const messages[BLAKE2S_256_BATCH_LANES],
+    size_t data_size,
+    uint8_t *const out_digests[BLAKE2S_256_BATCH_LANES])
+{
+    __m256i h[8];
+    for (size_t i = 0; i < 8; ++i) {
+        h[i] = _mm256_set1_epi32((int)BLAKE2S_IV[i]);
+    }
+    h[0] = _mm256_xor_si256(h[0], _mm256_set1_epi32(BLAKE2S_256_PARAM_0));
+
+    const size_t num_blocks = blake2s_num_blocks(data_size);
+    const uint8_t *blocks[BLAKE2S_256_BATCH_LANES];
+    for (size_t i = 0; i < num_blocks - 1; ++i) {
+        for (size_t lane = 0; lane < BLAKE2S_256_BATCH_LANES; ++lane) {
+            blocks[lane] = messages[lane] + i * BLAKE2S_BLOCK_SIZE_BYTES;
+        }
+        blake2s_compress_x8(
+            h, blocks, (i + 1) * BLAKE2S_BLOCK_SIZE_BYTES, false);
+    }
+
+    uint8_t last_blocks[BLAKE2S_256_BATCH_LANES][BLAKE2S_BLOCK_SIZE_BYTES];
+    for (size_t lane = 0; lane < BLAKE2S_256_BATCH_LANES; ++lane) {
+        blake2s_read_block(
+            messages[lane], data_size, num_blocks - 1, last_blocks[lane]);
+        blocks[lane] = last_blocks[lane];
+    }
+    blake2s_compress_x8(h, blocks, data_size, true);
+
+    // Transpose the chaining values back to per-message digests.
+    uint32_t h_words[8][BLAKE2S_256_BATCH_LANES];
+    for (size_t i = 0; i < 8; ++i) {
+        _mm256_storeu_si256((__m256i *)h_words[i], h[i]);
+    }
+    for (size_t lane = 0; lane < BLAKE2S_256_BATCH_LANES; ++lane) {
+        for (size_t i = 0; i < 8; ++i) {
+            store32_le(out_digests[lane] + 4 * i, h_words[i][lane]);
+        }
+    }
+}
+
+#endif // __AVX2__
+
+void blake2s_256_batch(
+    const uint8_t *const *messages,
+    const size_t *message_sizes,
+    size_t num_messages,
+    uint8_t *out_digests)
+{
+    size_t num_hashed = 0;
+    std::vector<size_t> order(num_messages);
+    std::iota(order.begin(), order.end(), 0);
+
+#ifdef __AVX2__
+    // Group messages by length, and hash each full group of
+    // BLAKE2S_256_BATCH_LANES equal-length messages with the multi-buffer
+    // implementation. Remaining messages are moved to the end of `order`.
+    std::stable_sort(
+        order.begin(), order.end(), [message_sizes](size_t a, size_t b) {
+            return message_sizes[a] < message_sizes[b];
+        });
+
+    std::vector<size_t> remaining;
+    size_t group_begin = 0;
+    while (group_begin < num_messages) {
+        const size_t size = message_sizes[order[group_begin]];
+        size_t group_end = group_begin + 1;
+        while (group_end < num_messages &&
+               message_sizes[order[group_end]] == size) {
+            ++group_end;
+        }
+
+        size_t i = group_begin;
+        for (; i + BLAKE2S_256_BATCH_LANES <= group_end;
+             i += BLAKE2S_256_BATCH_LANES) {
+            const uint8_t *lane_messages[BLAKE2S_256_BATCH_LANES];
+            uint8_t *lane_digests[BLAKE2S_256_BATCH_LANES];
+            for (size_t lane = 0; lane < BLAKE2S_256_BATCH_LANES; ++lane) {
+                const size_t idx = order[i + lane];
+                lane_messages[lane] = messages[idx];
+                lane_digests[lane] =
+                    out_digests + idx * BLAKE2S_256_DIGEST_SIZE_BYTES;
+            }
+            blake2s_256_x8(lane_messages, size, lane_digests);
+            num_hashed += BLAKE2S_256_BATCH_LANES;
+        }
+        remaining.insert(
+            remaining.end(), order.begin() + i, order.begin() + group_end);
+        group_begin = group_end;
+    }
+    std::copy(remaining.begin(), remaining.end(), order.begin() + num_hashed);
+#endif
+
+    for (size_t i = num_hashed; i < num_messages; ++i) {
+        const size_t idx = order[i];
+        blake2s_256(
+            messages[idx],
+            message_sizes[idx],
+            out_digests + idx * BLAKE2S_256_DIGEST_SIZE_BYTES);
+    }
+}
+
+} // namespace libzeth
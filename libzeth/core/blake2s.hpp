@@ -0,0 +1,43 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CORE_BLAKE2S_HPP__
+#define __ZETH_CORE_BLAKE2S_HPP__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace libzeth
+{
+
+// Native (byte-oriented) BLAKE2s with 32-byte digests and the default
+// parameter block (no key, salt or personalization). This computes the same
+// function as the BLAKE2s_256 gadget, without the overhead of a protoboard.
+static const size_t BLAKE2S_256_DIGEST_SIZE_BYTES = 32;
+static const size_t BLAKE2S_BLOCK_SIZE_BYTES = 64;
+
+/// Number of messages hashed simultaneously by the multi-buffer
+/// implementation used in blake2s_256_batch (when built with AVX2 support).
+static const size_t BLAKE2S_256_BATCH_LANES = 8;
+
+/// Compute the BLAKE2s-256 digest of `data_size` bytes at `data`.
+void blake2s_256(
+    const void *data,
+    size_t data_size,
+    uint8_t out_digest[BLAKE2S_256_DIGEST_SIZE_BYTES]);
+
+/// Compute the BLAKE2s-256 digests of `num_messages` messages, where the i-th
+/// message is `message_sizes[i]` bytes at `messages[i]`. The i-th digest is
+/// written to `out_digests + i * BLAKE2S_256_DIGEST_SIZE_BYTES`. When built
+/// with AVX2 support, messages of equal length are hashed
+/// BLAKE2S_256_BATCH_LANES at a time, one message per 32-bit lane.
+void blake2s_256_batch(
+    const uint8_t *const *messages,
+    const size_t *message_sizes,
+    size_t num_messages,
+    uint8_t *out_digests);
+
+} // namespace libzeth
+
+#endif // __ZETH_CORE_BLAKE2S_HPP__
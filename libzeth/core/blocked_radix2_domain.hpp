@@ -0,0 +1,113 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CORE_BLOCKED_RADIX2_DOMAIN_HPP__
+#define __ZETH_CORE_BLOCKED_RADIX2_DOMAIN_HPP__
+
+#include "libzeth/core/include_libff.hpp"
+
+#include <libfqfft/evaluation_domain/evaluation_domain.hpp>
+#include <vector>
+
+namespace libzeth
+{
+
+/// Radix-2 evaluation domain (with the same elements, and hence the same
+/// results, as libfqfft::basic_radix2_domain), whose FFTs are designed for
+/// large domains. Transforms of size m = m_1 * m_2 are computed with the
+/// "four-step" algorithm: m_2 FFTs of size m_1, a multiplication by twiddle
+/// factors, and m_1 FFTs of size m_2, with blocked transpositions in between.
+/// Each of the smaller FFTs operates on contiguous data which fits in cache,
+/// and uses precomputed twiddle factors and the batch field kernels. The
+/// FFTs (and transpositions) of each step are distributed across threads.
+///
+/// The const members (which take a caller-provided scratch buffer in place
+/// of temporary allocations) do not modify the domain, so that a single
+/// domain, with its precomputed tables, can be shared by concurrent callers
+/// using distinct scratch buffers.
+template<typename FieldT>
+class blocked_radix2_domain : public libfqfft::evaluation_domain<FieldT>
+{
+public:
+    /// Domains of size up to 2^direct_log_size use a single radix-2 FFT.
+    static const size_t direct_log_size = 12;
+
+    FieldT omega;
+
+    /// Throws std::invalid_argument if m is not a power of 2 supported by
+    /// FieldT.
+    explicit blocked_radix2_domain(const size_t m);
+
+    void FFT(std::vector<FieldT> &a) override;
+    void iFFT(std::vector<FieldT> &a) override;
+    void cosetFFT(std::vector<FieldT> &a, const FieldT &g) override;
+    void icosetFFT(std::vector<FieldT> &a, const FieldT &g) override;
+    std::vector<FieldT> evaluate_all_lagrange_polynomials(
+        const FieldT &t) override;
+    FieldT get_domain_element(const size_t idx) override;
+    FieldT compute_vanishing_polynomial(const FieldT &t) override;
+    void add_poly_Z(const FieldT &coeff, std::vector<FieldT> &H) override;
+    void divide_by_Z_on_coset(std::vector<FieldT> &P) override;
+
+    /// Precompute the powers of g and g^{-1} for each element of the domain,
+    /// used by subsequent coset transforms with this g.
+    void precompute_coset(const FieldT &g);
+
+    /// Equivalent to the transforms above, using `scratch` (which is resized
+    /// as required) as temporary storage. The contents of `a` and `scratch`
+    /// may be exchanged, so that the scratch buffer can be reused for any
+    /// vector of the same size.
+    void FFT(std::vector<FieldT> &a, std::vector<FieldT> &scratch) const;
+    void iFFT(std::vector<FieldT> &a, std::vector<FieldT> &scratch) const;
+    void cosetFFT(
+        std::vector<FieldT> &a,
+        const FieldT &g,
+        std::vector<FieldT> &scratch) const;
+    void icosetFFT(
+        std::vector<FieldT> &a,
+        const FieldT &g,
+        std::vector<FieldT> &scratch) const;
+
+    /// Equivalent to divide_by_Z_on_coset, for const domains.
+    void divide_by_Z_on_coset(std::vector<FieldT> &P) const;
+
+private:
+    // Twiddle factors for each direction of the transforms.
+    struct twiddles {
+        // Radix-2 twiddle factors for FFTs of size num_rows and row_size
+        // (see internal::radix2_fft).
+        std::vector<FieldT> column_stages;
+        std::vector<FieldT> row_stages;
+        // omega^j (or its inverse) for j < row_size.
+        std::vector<FieldT> omega_powers;
+    };
+
+    void transform(
+        std::vector<FieldT> &a,
+        const twiddles &t,
+        std::vector<FieldT> &scratch) const;
+
+    // a[i] = a[i] * g^i (or g^{-i} if `invert` is set) for all i.
+    void mul_coset_powers(
+        std::vector<FieldT> &a, const FieldT &g, const bool invert) const;
+
+    // The data is viewed as a matrix of num_rows x row_size elements.
+    size_t num_rows;
+    size_t row_size;
+    FieldT m_inverse;
+    twiddles forward;
+    twiddles inverse;
+
+    // Powers of coset_generator and its inverse (empty if no coset has been
+    // precomputed).
+    FieldT coset_generator;
+    std::vector<FieldT> coset_powers;
+    std::vector<FieldT> coset_inverse_powers;
+};
+
+} // namespace libzeth
+
+#include "libzeth/core/blocked_radix2_domain.tcc"
+
+#endif // __ZETH_CORE_BLOCKED_RADIX2_DOMAIN_HPP__
@@ -0,0 +1,410 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CORE_BLOCKED_RADIX2_DOMAIN_TCC__
+#define __ZETH_CORE_BLOCKED_RADIX2_DOMAIN_TCC__
+
+#include "libzeth/core/blocked_radix2_domain.hpp"
+#include "libzeth/core/field_batch.hpp"
+
+#include <algorithm>
+#include <libfqfft/evaluation_domain/domains/basic_radix2_domain_aux.hpp>
+#include <stdexcept>
+
+namespace libzeth
+{
+
+namespace internal
+{
+
+// Twiddle factors for radix2_fft, for a transform of size n using the
+// primitive n-th root of unity `root`. The butterflies of half-size h use
+// the powers 0, ..., h - 1 of a primitive (2h)-th root of unity, held in
+// entries [h - 1, 2h - 1).
+template<typename FieldT>
+std::vector<FieldT> radix2_fft_twiddles(const size_t n, const FieldT &root)
+{
+    std::vector<FieldT> twiddles(n - 1);
+    FieldT w = root;
+    for (size_t h = n / 2; h > 0; h /= 2) {
+        FieldT power = FieldT::one();
+        for (size_t j = 0; j < h; ++j) {
+            twiddles[h - 1 + j] = power;
+            power = power * w;
+        }
+        w = w.squared();
+    }
+    return twiddles;
+}
+
+// In-place iterative radix-2 FFT of a[0..n). `scratch` must have room for
+// n / 2 elements.
+template<typename FieldT>
+void radix2_fft(
+    FieldT *a, const size_t n, const FieldT *twiddles, FieldT *scratch)
+{
+    const size_t log_n = libff::log2(n);
+    for (size_t i = 0; i < n; ++i) {
+        const size_t j = libff::bitreverse(i, log_n);
+        if (i < j) {
+            std::swap(a[i], a[j]);
+        }
+    }
+
+    for (size_t h = 1; h < n; h *= 2) {
+        const FieldT *w = twiddles + h - 1;
+        for (size_t start = 0; start < n; start += 2 * h) {
+            FieldT *x = a + start;
+            FieldT *y = x + h;
+            if (h < field_batch_num_chains) {
+                for (size_t j = 0; j < h; ++j) {
+                    const FieldT t = w[j] * y[j];
+                    y[j] = x[j] - t;
+                    x[j] = x[j] + t;
+                }
+            } else {
+                field_batch_mul(scratch, y, w, h);
+                field_batch_sub(y, x, scratch, h);
+                field_batch_add(x, x, scratch, h);
+            }
+        }
+    }
+}
+
+// Write the transpose of `in` (a matrix of rows x cols elements) to `out`,
+// one square tile at a time.
+template<typename FieldT>
+void blocked_transpose(
+    FieldT *out, const FieldT *in, const size_t rows, const size_t cols)
+{
+    const size_t tile = 16;
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for (size_t r0 = 0; r0 < rows; r0 += tile) {
+        const size_t r1 = std::min(r0 + tile, rows);
+        for (size_t c0 = 0; c0 < cols; c0 += tile) {
+            const size_t c1 = std::min(c0 + tile, cols);
+            for (size_t r = r0; r < r1; ++r) {
+                for (size_t c = c0; c < c1; ++c) {
+                    out[c * rows + r] = in[r * cols + c];
+                }
+            }
+        }
+    }
+}
+
+// Size of the chunks of elementwise operations distributed across threads.
+static const size_t blocked_radix2_chunk_size = 1024;
+
+// a[i] = a[i] * s for all i.
+template<typename FieldT>
+void blocked_radix2_mul_scalar(std::vector<FieldT> &a, const FieldT &s)
+{
+    const size_t chunk_size = blocked_radix2_chunk_size;
+    const size_t num_chunks = (a.size() + chunk_size - 1) / chunk_size;
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+        const size_t begin = chunk * chunk_size;
+        const size_t end = std::min(begin + chunk_size, a.size());
+        field_batch_mul_scalar(&a[begin], &a[begin], s, end - begin);
+    }
+}
+
+// a[i] = a[i] * g^i for all i.
+template<typename FieldT>
+void blocked_radix2_mul_powers(std::vector<FieldT> &a, const FieldT &g)
+{
+    const size_t chunk_size = blocked_radix2_chunk_size;
+    const size_t num_chunks = (a.size() + chunk_size - 1) / chunk_size;
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+        const size_t begin = chunk * chunk_size;
+        const size_t end = std::min(begin + chunk_size, a.size());
+        FieldT power = g ^ (unsigned long)begin;
+        for (size_t i = begin; i < end; ++i) {
+            a[i] = a[i] * power;
+            power = power * g;
+        }
+    }
+}
+
+// a[i] = a[i] * b[i] for all i.
+template<typename FieldT>
+void blocked_radix2_mul(std::vector<FieldT> &a, const std::vector<FieldT> &b)
+{
+    const size_t chunk_size = blocked_radix2_chunk_size;
+    const size_t num_chunks = (a.size() + chunk_size - 1) / chunk_size;
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+        const size_t begin = chunk * chunk_size;
+        const size_t end = std::min(begin + chunk_size, a.size());
+        field_batch_mul(&a[begin], &a[begin], &b[begin], end - begin);
+    }
+}
+
+} // namespace internal
+
+template<typename FieldT>
+blocked_radix2_domain<FieldT>::blocked_radix2_domain(const size_t m)
+    : libfqfft::evaluation_domain<FieldT>(m)
+{
+    const size_t log_m = libff::log2(m);
+    if (m <= 1 || m != 1ull << log_m || log_m > FieldT::s) {
+        throw std::invalid_argument("invalid domain size");
+    }
+
+    omega = libff::get_root_of_unity<FieldT>(m);
+    m_inverse = FieldT(m).inverse();
+    num_rows = (log_m > direct_log_size) ? (1ull << (log_m / 2)) : 1;
+    row_size = m / num_rows;
+
+    const auto init_twiddles = [this](twiddles &t, const FieldT &root) {
+        const FieldT row_root = root ^ (unsigned long)num_rows;
+        t.row_stages = internal::radix2_fft_twiddles(row_size, row_root);
+        if (num_rows == 1) {
+            return;
+        }
+        const FieldT column_root = root ^ (unsigned long)row_size;
+        t.column_stages = internal::radix2_fft_twiddles(num_rows, column_root);
+        t.omega_powers.resize(row_size);
+        FieldT power = FieldT::one();
+        for (size_t j = 0; j < row_size; ++j) {
+            t.omega_powers[j] = power;
+            power = power * root;
+        }
+    };
+    init_twiddles(forward, omega);
+    init_twiddles(inverse, omega.inverse());
+}
+
+template<typename FieldT>
+void blocked_radix2_domain<FieldT>::transform(
+    std::vector<FieldT> &a,
+    const twiddles &t,
+    std::vector<FieldT> &scratch) const
+{
+    if (a.size() != this->m) {
+        throw std::invalid_argument("unexpected vector size");
+    }
+
+    if (num_rows == 1) {
+        scratch.resize(row_size / 2);
+        internal::radix2_fft(
+            a.data(), row_size, t.row_stages.data(), scratch.data());
+        return;
+    }
+
+    // With a[j1 * row_size + j2] viewed as the entry (j1, j2) of a matrix,
+    // the result at k1 + num_rows * k2 is the FFT over j2 of the entries
+    // (k1, j2) of the matrix:
+    //
+    //   omega^(j2 * k1) * (FFT over j1 of the entries (j1, j2))
+    //
+    // The FFTs over j1 (columns) are performed on the rows of the transpose.
+    std::vector<FieldT> &b = scratch;
+    b.resize(this->m);
+    internal::blocked_transpose(b.data(), a.data(), num_rows, row_size);
+#ifdef MULTICORE
+#pragma omp parallel
+#endif
+    {
+        std::vector<FieldT> row_scratch(num_rows);
+#ifdef MULTICORE
+#pragma omp for
+#endif
+        for (size_t j2 = 0; j2 < row_size; ++j2) {
+            FieldT *row = &b[j2 * num_rows];
+            internal::radix2_fft(
+                row, num_rows, t.column_stages.data(), row_scratch.data());
+
+            const FieldT &step = t.omega_powers[j2];
+            FieldT power = FieldT::one();
+            for (size_t k1 = 0; k1 < num_rows; ++k1) {
+                row_scratch[k1] = power;
+                power = power * step;
+            }
+            field_batch_mul(row, row, row_scratch.data(), num_rows);
+        }
+    }
+
+    internal::blocked_transpose(a.data(), b.data(), row_size, num_rows);
+#ifdef MULTICORE
+#pragma omp parallel
+#endif
+    {
+        std::vector<FieldT> row_scratch(row_size / 2);
+#ifdef MULTICORE
+#pragma omp for
+#endif
+        for (size_t k1 = 0; k1 < num_rows; ++k1) {
+            internal::radix2_fft(
+                &a[k1 * row_size],
+                row_size,
+                t.row_stages.data(),
+                row_scratch.data());
+        }
+    }
+
+    // Entry (k1, k2) holds the result at k1 + num_rows * k2.
+    internal::blocked_transpose(b.data(), a.data(), num_rows, row_size);
+    a.swap(b);
+}
+
+template<typename FieldT>
+void blocked_radix2_domain<FieldT>::mul_coset_powers(
+    std::vector<FieldT> &a, const FieldT &g, const bool invert) const
+{
+    if (!coset_powers.empty() && g == coset_generator) {
+        internal::blocked_radix2_mul(
+            a, invert ? coset_inverse_powers : coset_powers);
+        return;
+    }
+    internal::blocked_radix2_mul_powers(a, invert ? g.inverse() : g);
+}
+
+template<typename FieldT>
+void blocked_radix2_domain<FieldT>::FFT(std::vector<FieldT> &a)
+{
+    std::vector<FieldT> scratch;
+    FFT(a, scratch);
+}
+
+template<typename FieldT>
+void blocked_radix2_domain<FieldT>::iFFT(std::vector<FieldT> &a)
+{
+    std::vector<FieldT> scratch;
+    iFFT(a, scratch);
+}
+
+template<typename FieldT>
+void blocked_radix2_domain<FieldT>::cosetFFT(
+    std::vector<FieldT> &a, const FieldT &g)
+{
+    std::vector<FieldT> scratch;
+    cosetFFT(a, g, scratch);
+}
+
+template<typename FieldT>
+void blocked_radix2_domain<FieldT>::icosetFFT(
+    std::vector<FieldT> &a, const FieldT &g)
+{
+    std::vector<FieldT> scratch;
+    icosetFFT(a, g, scratch);
+}
+
+template<typename FieldT>
+void blocked_radix2_domain<FieldT>::FFT(
+    std::vector<FieldT> &a, std::vector<FieldT> &scratch) const
+{
+    transform(a, forward, scratch);
+}
+
+template<typename FieldT>
+void blocked_radix2_domain<FieldT>::iFFT(
+    std::vector<FieldT> &a, std::vector<FieldT> &scratch) const
+{
+    transform(a, inverse, scratch);
+    internal::blocked_radix2_mul_scalar(a, m_inverse);
+}
+
+template<typename FieldT>
+void blocked_radix2_domain<FieldT>::cosetFFT(
+    std::vector<FieldT> &a,
+    const FieldT &g,
+    std::vector<FieldT> &scratch) const
+{
+    if (a.size() != this->m) {
+        throw std::invalid_argument("unexpected vector size");
+    }
+    mul_coset_powers(a, g, false);
+    FFT(a, scratch);
+}
+
+template<typename FieldT>
+void blocked_radix2_domain<FieldT>::icosetFFT(
+    std::vector<FieldT> &a,
+    const FieldT &g,
+    std::vector<FieldT> &scratch) const
+{
+    iFFT(a, scratch);
+    mul_coset_powers(a, g, true);
+}
+
+template<typename FieldT>
+void blocked_radix2_domain<FieldT>::precompute_coset(const FieldT &g)
+{
+    coset_generator = g;
+    coset_powers.resize(this->m);
+    coset_inverse_powers.resize(this->m);
+    const FieldT g_inverse = g.inverse();
+    FieldT power = FieldT::one();
+    FieldT inverse_power = FieldT::one();
+    for (size_t i = 0; i < this->m; ++i) {
+        coset_powers[i] = power;
+        coset_inverse_powers[i] = inverse_power;
+        power = power * g;
+        inverse_power = inverse_power * g_inverse;
+    }
+}
+
+template<typename FieldT>
+std::vector<FieldT> blocked_radix2_domain<
+    FieldT>::evaluate_all_lagrange_polynomials(const FieldT &t)
+{
+    return libfqfft::_basic_radix2_evaluate_all_lagrange_polynomials(
+        this->m, t);
+}
+
+template<typename FieldT>
+FieldT blocked_radix2_domain<FieldT>::get_domain_element(const size_t idx)
+{
+    return omega ^ (unsigned long)idx;
+}
+
+template<typename FieldT>
+FieldT blocked_radix2_domain<FieldT>::compute_vanishing_polynomial(
+    const FieldT &t)
+{
+    return (t ^ (unsigned long)this->m) - FieldT::one();
+}
+
+template<typename FieldT>
+void blocked_radix2_domain<FieldT>::add_poly_Z(
+    const FieldT &coeff, std::vector<FieldT> &H)
+{
+    if (H.size() != this->m + 1) {
+        throw std::invalid_argument("unexpected vector size");
+    }
+    H[this->m] = H[this->m] + coeff;
+    H[0] = H[0] - coeff;
+}
+
+template<typename FieldT>
+void blocked_radix2_domain<FieldT>::divide_by_Z_on_coset(std::vector<FieldT> &P)
+{
+    static_cast<const blocked_radix2_domain &>(*this).divide_by_Z_on_coset(P);
+}
+
+template<typename FieldT>
+void blocked_radix2_domain<FieldT>::divide_by_Z_on_coset(
+    std::vector<FieldT> &P) const
+{
+    // Z(t) = t^m - 1 is constant on the coset.
+    const FieldT Z_inverse_at_coset =
+        ((FieldT::multiplicative_generator ^ (unsigned long)this->m) -
+         FieldT::one())
+            .inverse();
+    internal::blocked_radix2_mul_scalar(P, Z_inverse_at_coset);
+}
+
+} // namespace libzeth
+
+#endif // __ZETH_CORE_BLOCKED_RADIX2_DOMAIN_TCC__
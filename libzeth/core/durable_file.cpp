@@ -0,0 +1,246 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "libzeth/core/durable_file.hpp"
+
+#include "libzeth/core/blake2s.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace libzeth
+{
+
+// Each record is stored as:
+//
+//   <size: 8 bytes, little-endian> <data: size bytes> <digest: 32 bytes>
+//
+// where the digest is the BLAKE2s-256 digest of the size and data.
+static const size_t APPEND_LOG_SIZE_BYTES = 8;
+static const size_t APPEND_LOG_OVERHEAD_BYTES =
+    APPEND_LOG_SIZE_BYTES + BLAKE2S_256_DIGEST_SIZE_BYTES;
+
+static std::runtime_error file_error(
+    const std::string &what, const std::string &file_path)
+{
+    return std::runtime_error(
+        what + " " + file_path + ": " + std::string(strerror(errno)));
+}
+
+static void write_all(
+    int fd, const void *data, size_t size, const std::string &file_path)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    while (size > 0) {
+        const ssize_t written = write(fd, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw file_error("failed to write", file_path);
+        }
+        bytes += written;
+        size -= (size_t)written;
+    }
+}
+
+static void sync_fd(int fd, const std::string &file_path)
+{
+    if (fdatasync(fd) != 0) {
+        throw file_error("failed to sync", file_path);
+    }
+}
+
+static std::string append_log_encode(const std::string &record)
+{
+    std::string encoded(APPEND_LOG_OVERHEAD_BYTES + record.size(), 0);
+    uint8_t *bytes = (uint8_t *)&encoded[0];
+    const uint64_t size = record.size();
+    for (size_t i = 0; i < APPEND_LOG_SIZE_BYTES; ++i) {
+        bytes[i] = (uint8_t)(size >> (8 * i));
+    }
+    memcpy(bytes + APPEND_LOG_SIZE_BYTES, record.data(), record.size());
+    blake2s_256(
+        bytes,
+        APPEND_LOG_SIZE_BYTES + record.size(),
+        bytes + APPEND_LOG_SIZE_BYTES + record.size());
+    return encoded;
+}
+
+append_log::append_log(const std::string &file_path)
+    : file_path(file_path), fd(-1)
+{
+    fd = open(file_path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        throw file_error("failed to open", file_path);
+    }
+
+    // The destructor does not run if the constructor throws, so the file
+    // must be closed here on error.
+    try {
+        // Read and validate all records
+        const std::string contents = read_file(file_path);
+        const uint8_t *bytes = (const uint8_t *)contents.data();
+        uint64_t offset = 0;
+        while (contents.size() - offset >= APPEND_LOG_OVERHEAD_BYTES) {
+            uint64_t size = 0;
+            for (size_t i = 0; i < APPEND_LOG_SIZE_BYTES; ++i) {
+                size |= ((uint64_t)bytes[offset + i]) << (8 * i);
+            }
+            if (size > contents.size() - offset - APPEND_LOG_OVERHEAD_BYTES) {
+                break;
+            }
+
+            uint8_t digest[BLAKE2S_256_DIGEST_SIZE_BYTES];
+            blake2s_256(bytes + offset, APPEND_LOG_SIZE_BYTES + size, digest);
+            const uint8_t *expect_digest =
+                bytes + offset + APPEND_LOG_SIZE_BYTES + size;
+            if (memcmp(digest, expect_digest, sizeof(digest)) != 0) {
+                break;
+            }
+
+            recovered.emplace_back(
+                contents.data() + offset + APPEND_LOG_SIZE_BYTES, size);
+            offset += APPEND_LOG_OVERHEAD_BYTES + size;
+            record_ends.push_back(offset);
+        }
+
+        // Discard any partial or corrupt data, so that new records directly
+        // follow the valid ones.
+        if (offset != contents.size()) {
+            truncate(record_ends.size());
+        }
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+}
+
+append_log::~append_log()
+{
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+const std::vector<std::string> &append_log::recovered_records() const
+{
+    return recovered;
+}
+
+void append_log::release_recovered_records()
+{
+    std::vector<std::string>().swap(recovered);
+}
+
+size_t append_log::num_records() const { return record_ends.size(); }
+
+void append_log::append(const std::string &record)
+{
+    const std::string encoded = append_log_encode(record);
+    const uint64_t end =
+        (record_ends.empty() ? 0 : record_ends.back()) + encoded.size();
+    write_all(fd, encoded.data(), encoded.size(), file_path);
+    record_ends.push_back(end);
+}
+
+void append_log::sync() { sync_fd(fd, file_path); }
+
+void append_log::truncate(size_t num_records)
+{
+    if (num_records > record_ends.size()) {
+        throw std::invalid_argument("invalid number of log records");
+    }
+
+    record_ends.resize(num_records);
+    const uint64_t end = record_ends.empty() ? 0 : record_ends.back();
+    if (ftruncate(fd, (off_t)end) != 0) {
+        throw file_error("failed to truncate", file_path);
+    }
+    sync_fd(fd, file_path);
+}
+
+bool file_exists(const std::string &file_path)
+{
+    struct stat st;
+    return stat(file_path.c_str(), &st) == 0;
+}
+
+void ensure_directory(const std::string &dir_path)
+{
+    if (mkdir(dir_path.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw file_error("failed to create directory", dir_path);
+    }
+}
+
+void write_file_atomic(const std::string &file_path, const std::string &data)
+{
+    const std::string tmp_path = file_path + ".tmp";
+    const int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw file_error("failed to open", tmp_path);
+    }
+    try {
+        write_all(fd, data.data(), data.size(), tmp_path);
+        if (fsync(fd) != 0) {
+            throw file_error("failed to sync", tmp_path);
+        }
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    close(fd);
+
+    if (rename(tmp_path.c_str(), file_path.c_str()) != 0) {
+        throw file_error("failed to rename", tmp_path);
+    }
+
+    // Sync the directory, so that the rename is durable.
+    const size_t separator = file_path.rfind('/');
+    const std::string dir_path =
+        (separator == std::string::npos) ? "." : file_path.substr(0, separator);
+    const int dir_fd = open(dir_path.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dir_fd < 0) {
+        throw file_error("failed to open", dir_path);
+    }
+    const int sync_result = fsync(dir_fd);
+    close(dir_fd);
+    if (sync_result != 0) {
+        throw file_error("failed to sync", dir_path);
+    }
+}
+
+std::string read_file(const std::string &file_path)
+{
+    const int fd = open(file_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw file_error("failed to open", file_path);
+    }
+
+    std::string contents;
+    char buffer[1 << 16];
+    for (;;) {
+        const ssize_t num_read = read(fd, buffer, sizeof(buffer));
+        if (num_read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            close(fd);
+            throw file_error("failed to read", file_path);
+        }
+        if (num_read == 0) {
+            break;
+        }
+        contents.append(buffer, (size_t)num_read);
+    }
+
+    close(fd);
+    return contents;
+}
+
+} // namespace libzeth
@@ -0,0 +1,71 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CORE_DURABLE_FILE_HPP__
+#define __ZETH_CORE_DURABLE_FILE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace libzeth
+{
+
+/// Log file of variable-length records, where each record is stored along
+/// with its length and a BLAKE2s digest. On opening, records are read up to
+/// the first incomplete or corrupt record (e.g. a record which was being
+/// written when the process crashed), and the file is truncated to the valid
+/// records. Records are only guaranteed to be on disk after `sync` returns.
+class append_log
+{
+public:
+    /// Open the log at the given path, creating it if necessary. Throws
+    /// std::runtime_error on failure.
+    explicit append_log(const std::string &file_path);
+    append_log(const append_log &) = delete;
+    append_log &operator=(const append_log &) = delete;
+    ~append_log();
+
+    /// The records present when the log was opened (see
+    /// release_recovered_records).
+    const std::vector<std::string> &recovered_records() const;
+
+    /// Free the memory used by recovered_records.
+    void release_recovered_records();
+
+    size_t num_records() const;
+    void append(const std::string &record);
+    void sync();
+
+    /// Discard all except the first `num_records` records.
+    void truncate(size_t num_records);
+
+private:
+    const std::string file_path;
+    int fd;
+    // End offset of each record in the file
+    std::vector<uint64_t> record_ends;
+    std::vector<std::string> recovered;
+};
+
+/// Returns true if a file (or directory) exists at the given path.
+bool file_exists(const std::string &file_path);
+
+/// Create the directory (but not its parents) if it does not exist. Throws
+/// std::runtime_error on failure.
+void ensure_directory(const std::string &dir_path);
+
+/// Replace the contents of a file, such that after a crash the file holds
+/// either its old or its new contents. The data is written to a temporary
+/// file which is synced to disk and renamed over the destination, and the
+/// containing directory is then synced.
+void write_file_atomic(const std::string &file_path, const std::string &data);
+
+/// Read the entire contents of a file. Throws std::runtime_error on failure.
+std::string read_file(const std::string &file_path);
+
+} // namespace libzeth
+
+#endif // __ZETH_CORE_DURABLE_FILE_HPP__
@@ -0,0 +1,516 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "libzeth/core/field_batch.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+// The vectorized kernels are written using the vector extensions of GCC and
+// clang, and compiled for each instruction set using target attributes (so
+// that the rest of the library does not depend on the flags used to build
+// it).
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ZETH_FIELD_BATCH_X86 1
+#endif
+
+// Helpers taking and returning vectors are always inlined into the kernels
+// for each instruction set, so the ABI warnings (which GCC reports at the end
+// of the translation unit) do not apply.
+#if defined(ZETH_FIELD_BATCH_X86) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+namespace libzeth
+{
+
+namespace
+{
+
+enum field_batch_isa_t {
+    isa_none = 0,
+    isa_avx512 = 1,
+};
+
+bool isa_supported(const field_batch_isa_t isa)
+{
+#if defined(ZETH_FIELD_BATCH_X86)
+    __builtin_cpu_init();
+    switch (isa) {
+    case isa_none:
+        return true;
+    case isa_avx512:
+        return __builtin_cpu_supports("avx512f");
+    }
+    return false;
+#else
+    return isa == isa_none;
+#endif
+}
+
+field_batch_isa_t detect_isa()
+{
+    // With 4 lanes of 32-bit limb products, an AVX2 kernel is slower than
+    // the scalar kernel using MULX, which is available on all CPUs with
+    // AVX2 in practice, so only AVX-512 is used.
+    if (isa_supported(isa_avx512)) {
+        return isa_avx512;
+    }
+    return isa_none;
+}
+
+std::atomic<int> &selected_isa()
+{
+    static std::atomic<int> isa(detect_isa());
+    return isa;
+}
+
+bool mulx_supported()
+{
+#if defined(ZETH_FIELD_BATCH_X86)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("bmi2");
+#else
+    return false;
+#endif
+}
+
+std::atomic<bool> &selected_mulx()
+{
+    static std::atomic<bool> mulx(mulx_supported());
+    return mulx;
+}
+
+#if defined(ZETH_FIELD_BATCH_X86)
+
+#define ZETH_INLINE inline __attribute__((always_inline))
+#define ZETH_UNROLL _Pragma("GCC unroll 16")
+
+// Elements are held as 2 * N 32-bit limbs, each in a vector of 64-bit lanes
+// (one lane per element), so that products of limbs (and the carries that
+// are added to them) fit in a lane. The Montgomery multiplication uses
+// R = 2^(32 * 2N) = 2^(64N), as in libff.
+typedef uint64_t v8u64 __attribute__((vector_size(64)));
+
+template<typename V> ZETH_INLINE V broadcast(const uint64_t x)
+{
+    V v = {};
+    return v + x;
+}
+
+// Product of the low 32 bits of each lane.
+template<typename V> ZETH_INLINE V mul32(const V &x, const V &y)
+{
+    const V mask = broadcast<V>(0xffffffff);
+    return (x & mask) * (y & mask);
+}
+
+// Transpose the limbs of `Lanes` consecutive elements (each `stride` words
+// apart) into vectors of 32-bit limbs.
+template<typename V, size_t Lanes, size_t N>
+ZETH_INLINE void load(V *x, const uint64_t *p, const size_t stride)
+{
+    const V mask = broadcast<V>(0xffffffff);
+    for (size_t j = 0; j < N; ++j) {
+        V v;
+        for (size_t l = 0; l < Lanes; ++l) {
+            v[l] = p[l * stride + j];
+        }
+        x[2 * j] = v & mask;
+        x[2 * j + 1] = v >> 32;
+    }
+}
+
+template<typename V, size_t Lanes, size_t N>
+ZETH_INLINE void store(uint64_t *p, const V *x)
+{
+    for (size_t j = 0; j < N; ++j) {
+        const V v = x[2 * j] | (x[2 * j + 1] << 32);
+        for (size_t l = 0; l < Lanes; ++l) {
+            p[l * N + j] = v[l];
+        }
+    }
+}
+
+// Given t = t[0..L] < 2p, set out to t mod p.
+template<typename V, size_t L>
+ZETH_INLINE void reduce_once(V *out, const V *t, const V *p)
+{
+    const V mask = broadcast<V>(0xffffffff);
+    const V one = broadcast<V>(1);
+    V d[L];
+    V borrow = {};
+    for (size_t j = 0; j < L; ++j) {
+        const V x = t[j] - p[j] - borrow;
+        borrow = x >> 63;
+        d[j] = x & mask;
+    }
+
+    // Keep t if t < p, that is if the subtraction borrowed (and t has no
+    // carry limb).
+    const V keep = -(borrow & (t[L] ^ one));
+    for (size_t j = 0; j < L; ++j) {
+        out[j] = (t[j] & keep) | (d[j] & ~keep);
+    }
+}
+
+// Montgomery multiplication (CIOS), with inv the low 32 bits of
+// -p^{-1} mod 2^64.
+template<typename V, size_t L>
+ZETH_INLINE void mont_mul(
+    V *out, const V *a, const V *b, const V *p, const V &inv)
+{
+    const V mask = broadcast<V>(0xffffffff);
+    V t[L + 2] = {};
+    ZETH_UNROLL
+    for (size_t i = 0; i < L; ++i) {
+        V c = {};
+        ZETH_UNROLL
+        for (size_t j = 0; j < L; ++j) {
+            const V x = t[j] + mul32(a[j], b[i]) + c;
+            t[j] = x & mask;
+            c = x >> 32;
+        }
+        V x = t[L] + c;
+        t[L] = x & mask;
+        t[L + 1] = x >> 32;
+
+        const V m = mul32(t[0], inv) & mask;
+        x = t[0] + mul32(m, p[0]);
+        c = x >> 32;
+        ZETH_UNROLL
+        for (size_t j = 1; j < L; ++j) {
+            x = t[j] + mul32(m, p[j]) + c;
+            t[j - 1] = x & mask;
+            c = x >> 32;
+        }
+        x = t[L] + c;
+        t[L - 1] = x & mask;
+        t[L] = t[L + 1] + (x >> 32);
+    }
+
+    reduce_once<V, L>(out, t, p);
+}
+
+template<typename V, size_t L>
+ZETH_INLINE void mod_add(V *out, const V *a, const V *b, const V *p)
+{
+    const V mask = broadcast<V>(0xffffffff);
+    V t[L + 1];
+    V c = {};
+    for (size_t j = 0; j < L; ++j) {
+        const V x = a[j] + b[j] + c;
+        t[j] = x & mask;
+        c = x >> 32;
+    }
+    t[L] = c;
+    reduce_once<V, L>(out, t, p);
+}
+
+template<typename V, size_t L>
+ZETH_INLINE void mod_sub(V *out, const V *a, const V *b, const V *p)
+{
+    const V mask = broadcast<V>(0xffffffff);
+    V t[L];
+    V borrow = {};
+    for (size_t j = 0; j < L; ++j) {
+        const V x = a[j] - b[j] - borrow;
+        borrow = x >> 63;
+        t[j] = x & mask;
+    }
+
+    // Add p back if the subtraction borrowed.
+    const V add = -borrow;
+    V c = {};
+    for (size_t j = 0; j < L; ++j) {
+        const V x = t[j] + (p[j] & add) + c;
+        out[j] = x & mask;
+        c = x >> 32;
+    }
+}
+
+template<typename V, size_t Lanes, size_t N>
+ZETH_INLINE size_t kernel(
+    const internal::field_batch_op op,
+    uint64_t *out,
+    const uint64_t *a,
+    const uint64_t *b,
+    const size_t b_stride,
+    const size_t n,
+    const uint64_t *modulus,
+    const uint64_t inv)
+{
+    const size_t L = 2 * N;
+    V p[L];
+    for (size_t j = 0; j < N; ++j) {
+        p[2 * j] = broadcast<V>(modulus[j] & 0xffffffff);
+        p[2 * j + 1] = broadcast<V>(modulus[j] >> 32);
+    }
+    const V vinv = broadcast<V>(inv & 0xffffffff);
+
+    const size_t num_vectorized = n - n % Lanes;
+    for (size_t i = 0; i < num_vectorized; i += Lanes) {
+        V x[L];
+        V y[L];
+        V z[L];
+        load<V, Lanes, N>(x, a + i * N, N);
+        load<V, Lanes, N>(y, b + i * b_stride * N, b_stride * N);
+        switch (op) {
+        case internal::field_batch_op_mul:
+            mont_mul<V, L>(z, x, y, p, vinv);
+            break;
+        case internal::field_batch_op_add:
+            mod_add<V, L>(z, x, y, p);
+            break;
+        case internal::field_batch_op_sub:
+            mod_sub<V, L>(z, x, y, p);
+            break;
+        }
+        store<V, Lanes, N>(out + i * N, z);
+    }
+
+    return num_vectorized;
+}
+
+__attribute__((target("avx512f"))) size_t kernel_avx512(
+    const internal::field_batch_op op,
+    uint64_t *out,
+    const uint64_t *a,
+    const uint64_t *b,
+    const size_t b_stride,
+    const size_t n,
+    const size_t num_limbs,
+    const uint64_t *modulus,
+    const uint64_t inv)
+{
+    switch (num_limbs) {
+    case 4:
+        return kernel<v8u64, 8, 4>(op, out, a, b, b_stride, n, modulus, inv);
+    case 6:
+        return kernel<v8u64, 8, 6>(op, out, a, b, b_stride, n, modulus, inv);
+    }
+    return 0;
+}
+
+__extension__ typedef unsigned __int128 uint128_t;
+
+// Scalar Montgomery multiplication (CIOS) with 64-bit limbs, fully unrolled
+// for a given number of limbs. If the most significant limb of the modulus
+// is below 2^63 - 1, the intermediate result always fits in N limbs, and the
+// extra carry limbs (and their propagation) can be dropped.
+template<size_t N, bool NoCarry>
+ZETH_INLINE void mont_mul_scalar(
+    uint64_t *out,
+    const uint64_t *a,
+    const uint64_t *b,
+    const uint64_t *p,
+    const uint64_t inv)
+{
+    uint64_t t[N + 2] = {};
+    ZETH_UNROLL
+    for (size_t i = 0; i < N; ++i) {
+        if (NoCarry) {
+            uint128_t x = (uint128_t)a[0] * b[i] + t[0];
+            t[0] = (uint64_t)x;
+            uint64_t carry_a = (uint64_t)(x >> 64);
+            const uint64_t m = t[0] * inv;
+            uint128_t y = (uint128_t)m * p[0] + t[0];
+            uint64_t carry_m = (uint64_t)(y >> 64);
+            ZETH_UNROLL
+            for (size_t j = 1; j < N; ++j) {
+                x = (uint128_t)a[j] * b[i] + t[j] + carry_a;
+                carry_a = (uint64_t)(x >> 64);
+                y = (uint128_t)m * p[j] + (uint64_t)x + carry_m;
+                t[j - 1] = (uint64_t)y;
+                carry_m = (uint64_t)(y >> 64);
+            }
+            t[N - 1] = carry_a + carry_m;
+        } else {
+            uint128_t x = 0;
+            ZETH_UNROLL
+            for (size_t j = 0; j < N; ++j) {
+                x = (uint128_t)a[j] * b[i] + t[j] + (uint64_t)(x >> 64);
+                t[j] = (uint64_t)x;
+            }
+            x = (uint128_t)t[N] + (uint64_t)(x >> 64);
+            t[N] = (uint64_t)x;
+            t[N + 1] = (uint64_t)(x >> 64);
+
+            const uint64_t m = t[0] * inv;
+            x = (uint128_t)m * p[0] + t[0];
+            ZETH_UNROLL
+            for (size_t j = 1; j < N; ++j) {
+                x = (uint128_t)m * p[j] + t[j] + (uint64_t)(x >> 64);
+                t[j - 1] = (uint64_t)x;
+            }
+            x = (uint128_t)t[N] + (uint64_t)(x >> 64);
+            t[N - 1] = (uint64_t)x;
+            t[N] = t[N + 1] + (uint64_t)(x >> 64);
+        }
+    }
+
+    // The result is below 2p. Subtract p if t >= p (t[N] is always 0 in
+    // the NoCarry case).
+    uint64_t d[N];
+    uint64_t borrow = 0;
+    ZETH_UNROLL
+    for (size_t j = 0; j < N; ++j) {
+        const uint128_t x = (uint128_t)t[j] - p[j] - borrow;
+        d[j] = (uint64_t)x;
+        borrow = (uint64_t)(x >> 64) & 1;
+    }
+    const uint64_t keep = -(borrow & (t[N] ^ 1));
+    ZETH_UNROLL
+    for (size_t j = 0; j < N; ++j) {
+        out[j] = (t[j] & keep) | (d[j] & ~keep);
+    }
+}
+
+template<size_t N>
+ZETH_INLINE void kernel_scalar(
+    uint64_t *out,
+    const uint64_t *a,
+    const uint64_t *b,
+    const size_t b_stride,
+    const size_t n,
+    const uint64_t *modulus,
+    const uint64_t inv)
+{
+    uint64_t result[N];
+    if (modulus[N - 1] < 0x7fffffffffffffffull) {
+        for (size_t i = 0; i < n; ++i) {
+            mont_mul_scalar<N, true>(
+                result, a + i * N, b + i * b_stride * N, modulus, inv);
+            std::copy(result, result + N, out + i * N);
+        }
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            mont_mul_scalar<N, false>(
+                result, a + i * N, b + i * b_stride * N, modulus, inv);
+            std::copy(result, result + N, out + i * N);
+        }
+    }
+}
+
+// Compiled with BMI2, so that the compiler uses MULX (which leaves the
+// flags untouched) for the 64x64-bit products.
+__attribute__((target("bmi2"))) size_t kernel_mulx(
+    uint64_t *out,
+    const uint64_t *a,
+    const uint64_t *b,
+    const size_t b_stride,
+    const size_t n,
+    const size_t num_limbs,
+    const uint64_t *modulus,
+    const uint64_t inv)
+{
+    switch (num_limbs) {
+    case 4:
+        kernel_scalar<4>(out, a, b, b_stride, n, modulus, inv);
+        return n;
+    case 6:
+        kernel_scalar<6>(out, a, b, b_stride, n, modulus, inv);
+        return n;
+    }
+    return 0;
+}
+
+#undef ZETH_UNROLL
+#undef ZETH_INLINE
+
+#endif // defined(ZETH_FIELD_BATCH_X86)
+
+} // namespace
+
+std::string field_batch_isa()
+{
+    switch (selected_isa().load()) {
+    case isa_avx512:
+        return "avx512";
+    }
+    return "none";
+}
+
+bool field_batch_mulx() { return selected_mulx().load(); }
+
+namespace internal
+{
+
+size_t field_batch_kernel(
+    const field_batch_op op,
+    uint64_t *out,
+    const uint64_t *a,
+    const uint64_t *b,
+    const size_t b_stride,
+    const size_t n,
+    const size_t num_limbs,
+    const uint64_t *modulus,
+    const uint64_t inv)
+{
+#if defined(ZETH_FIELD_BATCH_X86)
+    size_t done = 0;
+    if (selected_isa().load() == isa_avx512) {
+        done = kernel_avx512(
+            op, out, a, b, b_stride, n, num_limbs, modulus, inv);
+    }
+
+    // Multiply any remaining elements with the scalar kernel. Additions and
+    // subtractions are left to libff.
+    if (op == field_batch_op_mul && done < n && selected_mulx().load()) {
+        const size_t offset = done * num_limbs;
+        done += kernel_mulx(
+            out + offset,
+            a + offset,
+            b + offset * b_stride,
+            b_stride,
+            n - done,
+            num_limbs,
+            modulus,
+            inv);
+    }
+    return done;
+#else
+    (void)op;
+    (void)out;
+    (void)a;
+    (void)b;
+    (void)b_stride;
+    (void)n;
+    (void)num_limbs;
+    (void)modulus;
+    (void)inv;
+    return 0;
+#endif
+}
+
+bool field_batch_select_isa(const std::string &isa)
+{
+    field_batch_isa_t value;
+    if (isa == "avx512") {
+        value = isa_avx512;
+    } else if (isa == "none") {
+        value = isa_none;
+    } else {
+        return false;
+    }
+
+    if (!isa_supported(value)) {
+        return false;
+    }
+    selected_isa().store(value);
+    return true;
+}
+
+bool field_batch_select_mulx(const bool enable)
+{
+    if (enable && !mulx_supported()) {
+        return false;
+    }
+    selected_mulx().store(enable);
+    return true;
+}
+
+} // namespace internal
+
+} // namespace libzeth
@@ -0,0 +1,113 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CORE_FIELD_BATCH_HPP__
+#define __ZETH_CORE_FIELD_BATCH_HPP__
+
+#include "libzeth/core/include_libff.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace libzeth
+{
+
+/// Arithmetic on arrays of field elements. For prime fields with 4 or 6
+/// limbs (which includes the scalar and base fields of alt_bn128 and
+/// bls12_377), elements are processed in groups of 8 lanes with AVX-512. The
+/// limbs of each group are transposed into a structure-of-arrays layout,
+/// with one vector of 32-bit limbs per limb position, and multiplied using a
+/// vectorized Montgomery multiplication (with the same Montgomery
+/// representation as libff). The instruction set is chosen at runtime, based
+/// on the features of the CPU. Remaining elements (and all elements on CPUs
+/// without AVX-512) are multiplied using a fully unrolled scalar Montgomery
+/// multiplication (using MULX on CPUs with BMI2). For other fields and CPUs,
+/// the operators of FieldT are used.
+///
+/// In all functions, `out` may be equal to (but must not otherwise overlap)
+/// the inputs.
+
+/// out[i] = a[i] * b[i] for 0 <= i < n.
+template<typename FieldT>
+void field_batch_mul(
+    FieldT *out, const FieldT *a, const FieldT *b, const size_t n);
+
+/// out[i] = a[i] * b for 0 <= i < n.
+template<typename FieldT>
+void field_batch_mul_scalar(
+    FieldT *out, const FieldT *a, const FieldT &b, const size_t n);
+
+/// out[i] = a[i]^2 for 0 <= i < n.
+template<typename FieldT>
+void field_batch_square(FieldT *out, const FieldT *a, const size_t n);
+
+/// out[i] = a[i] + b[i] for 0 <= i < n.
+template<typename FieldT>
+void field_batch_add(
+    FieldT *out, const FieldT *a, const FieldT *b, const size_t n);
+
+/// out[i] = a[i] - b[i] for 0 <= i < n.
+template<typename FieldT>
+void field_batch_sub(
+    FieldT *out, const FieldT *a, const FieldT *b, const size_t n);
+
+/// Replace each of values[0..n) by its inverse, using Montgomery's trick
+/// (a single field inversion per lane). The running products are computed
+/// in independent interleaved chains, so that they can use the vectorized
+/// multiplication. None of the values may be zero.
+template<typename FieldT> void field_batch_inverse(FieldT *values, size_t n);
+
+/// Name of the instruction set used by the vectorized kernels: "avx512" or
+/// "none".
+std::string field_batch_isa();
+
+/// True if the scalar kernel (using MULX) is used for multiplications.
+bool field_batch_mulx();
+
+namespace internal
+{
+
+enum field_batch_op {
+    field_batch_op_mul,
+    field_batch_op_add,
+    field_batch_op_sub,
+};
+
+/// Number of interleaved chains used by field_batch_inverse (a multiple of
+/// the number of lanes of every kernel).
+static const size_t field_batch_num_chains = 8;
+
+/// Apply `op` to elements of a prime field with the given modulus and
+/// Montgomery constant inv = -modulus^{-1} mod 2^64, each given as
+/// num_limbs 64-bit limbs. The i-th element of b is at b + i * b_stride *
+/// num_limbs (so that b_stride = 0 gives a single element). Elements are
+/// processed from the start of the arrays, and the number of elements
+/// processed is returned (0 if no kernel is available for the operation).
+size_t field_batch_kernel(
+    const field_batch_op op,
+    uint64_t *out,
+    const uint64_t *a,
+    const uint64_t *b,
+    const size_t b_stride,
+    const size_t n,
+    const size_t num_limbs,
+    const uint64_t *modulus,
+    const uint64_t inv);
+
+/// Select the instruction set used by the kernels (see field_batch_isa),
+/// returning false if it is not supported by the CPU. Intended for testing.
+bool field_batch_select_isa(const std::string &isa);
+
+/// Enable or disable the scalar kernel, returning false if it is not
+/// supported by the CPU. Intended for testing.
+bool field_batch_select_mulx(const bool enable);
+
+} // namespace internal
+
+} // namespace libzeth
+
+#include "libzeth/core/field_batch.tcc"
+
+#endif // __ZETH_CORE_FIELD_BATCH_HPP__
@@ -0,0 +1,229 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CORE_FIELD_BATCH_TCC__
+#define __ZETH_CORE_FIELD_BATCH_TCC__
+
+#include "libzeth/core/field_batch.hpp"
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+namespace libzeth
+{
+
+namespace internal
+{
+
+// Prime fields (libff::Fp_model) can use the vectorized kernels. Other
+// fields (such as extension fields) use their operators.
+template<typename FieldT> class field_batch_traits
+{
+public:
+    static const bool prime_field = false;
+};
+
+template<mp_size_t n, const libff::bigint<n> &modulus>
+class field_batch_traits<libff::Fp_model<n, modulus>>
+{
+public:
+    static const bool prime_field = true;
+    static const size_t num_limbs = n;
+};
+
+template<typename FieldT>
+size_t field_batch_apply(
+    const field_batch_op,
+    FieldT *,
+    const FieldT *,
+    const FieldT *,
+    const size_t,
+    const size_t,
+    std::false_type)
+{
+    return 0;
+}
+
+template<typename FieldT>
+size_t field_batch_apply(
+    const field_batch_op op,
+    FieldT *out,
+    const FieldT *a,
+    const FieldT *b,
+    const size_t b_stride,
+    const size_t n,
+    std::true_type)
+{
+    // Elements are used directly as arrays of 64-bit limbs.
+    const size_t num_limbs = field_batch_traits<FieldT>::num_limbs;
+    static_assert(
+        sizeof(mp_limb_t) == sizeof(uint64_t) &&
+            sizeof(FieldT) == num_limbs * sizeof(uint64_t),
+        "unexpected field element layout");
+    return field_batch_kernel(
+        op,
+        (uint64_t *)out,
+        (const uint64_t *)a,
+        (const uint64_t *)b,
+        b_stride,
+        n,
+        num_limbs,
+        (const uint64_t *)FieldT::mod.data,
+        FieldT::inv);
+}
+
+// Apply op to the first elements using the kernels, where available,
+// returning the number of elements processed.
+template<typename FieldT>
+size_t field_batch_apply(
+    const field_batch_op op,
+    FieldT *out,
+    const FieldT *a,
+    const FieldT *b,
+    const size_t b_stride,
+    const size_t n)
+{
+    return field_batch_apply(
+        op,
+        out,
+        a,
+        b,
+        b_stride,
+        n,
+        std::integral_constant<
+            bool,
+            field_batch_traits<FieldT>::prime_field>());
+}
+
+// Montgomery's trick, with a single chain of running products.
+template<typename FieldT>
+void field_batch_inverse_serial(FieldT *values, const size_t n)
+{
+    if (n == 0) {
+        return;
+    }
+
+    std::vector<FieldT> products(n);
+    products[0] = values[0];
+    for (size_t i = 1; i < n; ++i) {
+        products[i] = products[i - 1] * values[i];
+    }
+
+    FieldT inverse = products[n - 1].inverse();
+    for (size_t i = n - 1; i > 0; --i) {
+        const FieldT value_inverse = inverse * products[i - 1];
+        inverse = inverse * values[i];
+        values[i] = value_inverse;
+    }
+    values[0] = inverse;
+}
+
+} // namespace internal
+
+template<typename FieldT>
+void field_batch_mul(
+    FieldT *out, const FieldT *a, const FieldT *b, const size_t n)
+{
+    const size_t done = internal::field_batch_apply(
+        internal::field_batch_op_mul, out, a, b, 1, n);
+    for (size_t i = done; i < n; ++i) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+template<typename FieldT>
+void field_batch_mul_scalar(
+    FieldT *out, const FieldT *a, const FieldT &b, const size_t n)
+{
+    const size_t done = internal::field_batch_apply(
+        internal::field_batch_op_mul, out, a, &b, 0, n);
+    for (size_t i = done; i < n; ++i) {
+        out[i] = a[i] * b;
+    }
+}
+
+template<typename FieldT>
+void field_batch_square(FieldT *out, const FieldT *a, const size_t n)
+{
+    const size_t done = internal::field_batch_apply(
+        internal::field_batch_op_mul, out, a, a, 1, n);
+    for (size_t i = done; i < n; ++i) {
+        out[i] = a[i].squared();
+    }
+}
+
+template<typename FieldT>
+void field_batch_add(
+    FieldT *out, const FieldT *a, const FieldT *b, const size_t n)
+{
+    const size_t done = internal::field_batch_apply(
+        internal::field_batch_op_add, out, a, b, 1, n);
+    for (size_t i = done; i < n; ++i) {
+        out[i] = a[i] + b[i];
+    }
+}
+
+template<typename FieldT>
+void field_batch_sub(
+    FieldT *out, const FieldT *a, const FieldT *b, const size_t n)
+{
+    const size_t done = internal::field_batch_apply(
+        internal::field_batch_op_sub, out, a, b, 1, n);
+    for (size_t i = done; i < n; ++i) {
+        out[i] = a[i] - b[i];
+    }
+}
+
+template<typename FieldT> void field_batch_inverse(FieldT *values, size_t n)
+{
+    const size_t w = internal::field_batch_num_chains;
+    if (n < 2 * w) {
+        internal::field_batch_inverse_serial(values, n);
+        return;
+    }
+
+    // Chain j holds the elements with index congruent to j mod w, so that
+    // products[i] = values[i] * products[i - w], and each w consecutive
+    // elements are independent.
+    std::vector<FieldT> products(values, values + n);
+    for (size_t i = w; i < n; i += w) {
+        field_batch_mul(
+            &products[i], &products[i - w], &values[i], std::min(w, n - i));
+    }
+
+    // The last w elements end each chain. inverses[j] holds the inverse of
+    // the running product of the chain of element n - w + j (shifted by w
+    // for each row below).
+    std::vector<FieldT> inverses(products.end() - w, products.end());
+    internal::field_batch_inverse_serial(inverses.data(), w);
+
+    // Process rows of w elements from the end, while a full row precedes
+    // them.
+    std::vector<FieldT> row_inverses(w);
+    size_t row = n - w;
+    for (; row >= w; row -= w) {
+        field_batch_mul(
+            row_inverses.data(), inverses.data(), &products[row - w], w);
+        field_batch_mul(inverses.data(), inverses.data(), &values[row], w);
+        std::copy(row_inverses.begin(), row_inverses.end(), values + row);
+    }
+
+    // The remaining (fewer than 2 * w) elements, the first of each chain
+    // having no predecessor.
+    for (size_t i = row + w; i-- > 0;) {
+        const size_t j = (i + w - row % w) % w;
+        if (i < w) {
+            values[i] = inverses[j];
+            continue;
+        }
+        const FieldT value_inverse = inverses[j] * products[i - w];
+        inverses[j] = inverses[j] * values[i];
+        values[i] = value_inverse;
+    }
+}
+
+} // namespace libzeth
+
+#endif // __ZETH_CORE_FIELD_BATCH_TCC__
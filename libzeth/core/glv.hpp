@@ -0,0 +1,138 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CORE_GLV_HPP__
+#define __ZETH_CORE_GLV_HPP__
+
+#include "libzeth/core/include_libff.hpp"
+
+#include <libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp>
+#include <libff/algebra/curves/bls12_377/bls12_377_pp.hpp>
+
+namespace libzeth
+{
+
+/// Parameters of the GLV endomorphism phi(x, y) = (beta * x, y) of a group
+/// of order r, which satisfies phi(P) = lambda * P. This allows a scalar k to
+/// be decomposed as k = k1 + lambda * k2 (mod r), where k1 and k2 have half
+/// the size of r, so that k * P = k1 * P + k2 * phi(P) can be computed with
+/// half the number of doublings.
+///
+/// The default has `enabled` set to false. Specializations are given for
+/// groups with such an endomorphism, providing (as decimal strings):
+///   - beta: a non-trivial cube root of unity in the coordinate field,
+///   - lambda: the corresponding cube root of unity in the scalar field,
+///   - minus_b1, minus_b2: -b1 and -b2 (mod r), where (a1, b1) and (a2, b2)
+///     are a reduced basis of the lattice { (x, y) : x + lambda * y = 0 },
+///     with b1 < 0 < b2 and a1 * b2 - a2 * b1 = r,
+///   - g1, g2: the values floor(2^256 * b2 / r) and floor(2^256 * -b1 / r),
+///     used to compute the decomposition without division.
+///
+/// Only G1 groups are supported. The endomorphism of G2 is of a different
+/// form (derived from the Frobenius map on the twist), so G2 keeps the
+/// default parameters, and G2 multi-exponentiations do not use GLV.
+template<typename GroupT> class glv_parameters
+{
+public:
+    static const bool enabled = false;
+};
+
+// For alt-bn128 G1 (y^2 = x^3 + 3)
+template<> class glv_parameters<libff::alt_bn128_G1>
+{
+public:
+    static const bool enabled = true;
+    using scalar_field = libff::alt_bn128_Fr;
+    using coordinate_field = libff::alt_bn128_Fq;
+
+    static const char *beta()
+    {
+        return "2188824287183927522004244526010915316727770741447206164171475"
+               "8635765020556616";
+    }
+    static const char *lambda()
+    {
+        return "2188824287183927521783848477496103124615499718540987825878173"
+               "4729429964517155";
+    }
+    static const char *minus_b1() { return "9931322734385697763"; }
+    static const char *minus_b2()
+    {
+        return "2188824287183927522224640574525727508840041764353424502468750"
+               "7833037619387126";
+    }
+    static const char *g1()
+    {
+        return "782660544089080853131326142527431468389";
+    }
+    static const char *g2() { return "52538187511802934231"; }
+};
+
+// For bls12-377 G1 (y^2 = x^3 + 1), where lambda = x^2 - 1 for the curve
+// parameter x.
+template<> class glv_parameters<libff::bls12_377_G1>
+{
+public:
+    static const bool enabled = true;
+    using scalar_field = libff::bls12_377_Fr;
+    using coordinate_field = libff::bls12_377_Fq;
+
+    static const char *beta()
+    {
+        return "8094964826491271940855836314063747726484529472071049947813728"
+               "7262712535938301461879813459410945";
+    }
+    static const char *lambda()
+    {
+        return "91893752504881257701523279626832445440";
+    }
+    static const char *minus_b1() { return "1"; }
+    static const char *minus_b2()
+    {
+        return "8444461749428370424248824938781546531284005582649182570233710"
+               "176290576793600";
+    }
+    static const char *g1()
+    {
+        return "1260064869275694167304791240164355610668";
+    }
+    static const char *g2() { return "13"; }
+};
+
+/// A scalar k decomposed as k = k1 + lambda * k2 (mod r), where k1 and k2
+/// are represented by their absolute values and signs.
+template<typename GroupT> class glv_scalar
+{
+public:
+    using scalar_field = typename glv_parameters<GroupT>::scalar_field;
+    using bigint_type = libff::bigint<scalar_field::num_limbs>;
+
+    bigint_type k1;
+    bigint_type k2;
+    bool k1_negative;
+    bool k2_negative;
+};
+
+/// Decompose a scalar (given as the bigint representation of an element of
+/// the scalar field) for the GLV endomorphism of GroupT.
+template<typename GroupT>
+glv_scalar<GroupT> glv_decompose(
+    const typename glv_scalar<GroupT>::bigint_type &scalar);
+
+/// The endomorphism phi(x, y) = (beta * x, y), which preserves the Z
+/// coordinate (so that elements in affine form remain in affine form).
+template<typename GroupT> GroupT glv_endomorphism(const GroupT &point);
+
+/// Compute scalar * point. For groups with a GLV endomorphism (see
+/// glv_parameters), the scalar is decomposed and the two half-size products
+/// are computed together using interleaved wNAF representations. Otherwise,
+/// this is equivalent to `scalar * point`.
+template<typename FieldT, typename GroupT>
+GroupT scalar_mul(const FieldT &scalar, const GroupT &point);
+
+} // namespace libzeth
+
+#include "libzeth/core/glv.tcc"
+
+#endif // __ZETH_CORE_GLV_HPP__
@@ -0,0 +1,201 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CORE_GLV_TCC__
+#define __ZETH_CORE_GLV_TCC__
+
+#include "libzeth/core/glv.hpp"
+
+#include <algorithm>
+#include <libff/algebra/scalar_multiplication/wnaf.hpp>
+#include <type_traits>
+#include <vector>
+
+namespace libzeth
+{
+
+namespace internal
+{
+
+// Parameters of glv_parameters<GroupT> as field elements and bigints,
+// converted from their decimal strings on first use.
+template<typename GroupT> class glv_constants
+{
+public:
+    using params = glv_parameters<GroupT>;
+    using scalar_field = typename params::scalar_field;
+    using coordinate_field = typename params::coordinate_field;
+    using bigint_type = libff::bigint<scalar_field::num_limbs>;
+
+    // The decomposition uses products with g1 and g2, shifted right by
+    // 2^256 (an exact number of limbs).
+    static_assert(
+        scalar_field::num_limbs * GMP_NUMB_BITS == 256,
+        "unexpected scalar field size for GLV decomposition");
+
+    const coordinate_field beta;
+    const scalar_field lambda;
+    const scalar_field minus_b1;
+    const scalar_field minus_b2;
+    const bigint_type g1;
+    const bigint_type g2;
+
+    static const glv_constants &get()
+    {
+        static const glv_constants constants;
+        return constants;
+    }
+
+private:
+    glv_constants()
+        : beta(libff::bigint<coordinate_field::num_limbs>(params::beta()))
+        , lambda(bigint_type(params::lambda()))
+        , minus_b1(bigint_type(params::minus_b1()))
+        , minus_b2(bigint_type(params::minus_b2()))
+        , g1(params::g1())
+        , g2(params::g2())
+    {
+    }
+};
+
+// round(k * g / 2^256), where both values are less than 2^256.
+template<mp_size_t n>
+libff::bigint<n> glv_round_product(
+    const libff::bigint<n> &k, const libff::bigint<n> &g)
+{
+    mp_limb_t product[2 * n];
+    mpn_mul_n(product, k.data, g.data, n);
+
+    libff::bigint<n> result;
+    for (mp_size_t i = 0; i < n; ++i) {
+        result.data[i] = product[n + i];
+    }
+    const mp_limb_t top_bit = (mp_limb_t)1 << (GMP_NUMB_BITS - 1);
+    if (product[n - 1] & top_bit) {
+        mpn_add_1(result.data, result.data, n, 1);
+    }
+    return result;
+}
+
+// Write the absolute value of x (taken to be the smaller of x and -x) to
+// `abs`, returning true if x is negative.
+template<typename FieldT>
+bool glv_abs(const FieldT &x, libff::bigint<FieldT::num_limbs> &abs)
+{
+    const libff::bigint<FieldT::num_limbs> positive = x.as_bigint();
+    const libff::bigint<FieldT::num_limbs> negative = (-x).as_bigint();
+    if (negative.num_bits() < positive.num_bits()) {
+        abs = negative;
+        return true;
+    }
+    abs = positive;
+    return false;
+}
+
+template<typename FieldT, typename GroupT>
+GroupT scalar_mul(const FieldT &scalar, const GroupT &point, std::false_type)
+{
+    return scalar * point;
+}
+
+template<typename FieldT, typename GroupT>
+GroupT scalar_mul(const FieldT &scalar, const GroupT &point, std::true_type)
+{
+    const glv_scalar<GroupT> decomposed =
+        glv_decompose<GroupT>(scalar.as_bigint());
+    const size_t window_size = std::max<size_t>(
+        1,
+        libff::wnaf_opt_window_size<GroupT>(
+            std::max(decomposed.k1.num_bits(), decomposed.k2.num_bits())));
+    const std::vector<long> wnaf1 =
+        libff::find_wnaf(window_size, decomposed.k1);
+    const std::vector<long> wnaf2 =
+        libff::find_wnaf(window_size, decomposed.k2);
+
+    // Odd multiples of +/-point and +/-phi(point).
+    const size_t table_size = 1ul << (window_size - 1);
+    std::vector<GroupT> table1(table_size);
+    std::vector<GroupT> table2(table_size);
+    table1[0] = decomposed.k1_negative ? -point : point;
+    const GroupT double_point = table1[0].dbl();
+    for (size_t i = 1; i < table_size; ++i) {
+        table1[i] = table1[i - 1] + double_point;
+    }
+    for (size_t i = 0; i < table_size; ++i) {
+        table2[i] = glv_endomorphism(table1[i]);
+        if (decomposed.k1_negative != decomposed.k2_negative) {
+            table2[i] = -table2[i];
+        }
+    }
+
+    // Skip leading zeroes, and compute both products together.
+    size_t i = std::max(wnaf1.size(), wnaf2.size());
+    while (i > 0 && (i > wnaf1.size() || wnaf1[i - 1] == 0) &&
+           (i > wnaf2.size() || wnaf2[i - 1] == 0)) {
+        --i;
+    }
+
+    GroupT result = GroupT::zero();
+    for (; i > 0; --i) {
+        result = result.dbl();
+        const long digit1 = (i <= wnaf1.size()) ? wnaf1[i - 1] : 0;
+        const long digit2 = (i <= wnaf2.size()) ? wnaf2[i - 1] : 0;
+        if (digit1 > 0) {
+            result = result + table1[digit1 / 2];
+        } else if (digit1 < 0) {
+            result = result - table1[-digit1 / 2];
+        }
+        if (digit2 > 0) {
+            result = result + table2[digit2 / 2];
+        } else if (digit2 < 0) {
+            result = result - table2[-digit2 / 2];
+        }
+    }
+
+    return result;
+}
+
+} // namespace internal
+
+template<typename GroupT>
+glv_scalar<GroupT> glv_decompose(
+    const typename glv_scalar<GroupT>::bigint_type &scalar)
+{
+    using constants = internal::glv_constants<GroupT>;
+    using scalar_field = typename constants::scalar_field;
+    const constants &c = constants::get();
+
+    // With c1 = round(k * b2 / r) and c2 = round(-k * b1 / r), the vector
+    // (k, 0) - c1 * (a1, b1) - c2 * (a2, b2) is short, and its components
+    // give k1 and k2.
+    const scalar_field c1(internal::glv_round_product(scalar, c.g1));
+    const scalar_field c2(internal::glv_round_product(scalar, c.g2));
+    const scalar_field k2 = c1 * c.minus_b1 + c2 * c.minus_b2;
+    const scalar_field k1 = scalar_field(scalar) - c.lambda * k2;
+
+    glv_scalar<GroupT> decomposed;
+    decomposed.k1_negative = internal::glv_abs(k1, decomposed.k1);
+    decomposed.k2_negative = internal::glv_abs(k2, decomposed.k2);
+    return decomposed;
+}
+
+template<typename GroupT> GroupT glv_endomorphism(const GroupT &point)
+{
+    GroupT result = point;
+    result.X = internal::glv_constants<GroupT>::get().beta * point.X;
+    return result;
+}
+
+template<typename FieldT, typename GroupT>
+GroupT scalar_mul(const FieldT &scalar, const GroupT &point)
+{
+    return internal::scalar_mul(
+        scalar,
+        point,
+        std::integral_constant<bool, glv_parameters<GroupT>::enabled>());
+}
+
+} // namespace libzeth
+
+#endif // __ZETH_CORE_GLV_TCC__
@@ -0,0 +1,69 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CORE_GROUP_COORDINATES_HPP__
+#define __ZETH_CORE_GROUP_COORDINATES_HPP__
+
+#include "libzeth/core/include_libff.hpp"
+
+#include <libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp>
+#include <libff/algebra/curves/bls12_377/bls12_377_pp.hpp>
+#include <type_traits>
+
+namespace libzeth
+{
+
+/// Describes the representation of the elements of a group. `jacobian_a0`
+/// is true for groups of short Weierstrass curves y^2 = x^3 + b (with a = 0)
+/// whose elements (X, Y, Z) are in Jacobian coordinates (x = X / Z^2, y = Y
+/// / Z^3). For such groups, elements can be converted to affine form by
+/// operating directly on the coordinates (see batch_to_affine), and affine
+/// additions and doublings (see multi_exp_accumulation_batch_affine) can be
+/// computed with the formulas for a = 0.
+///
+/// The default has `jacobian_a0` set to false, and generic operations on
+/// group elements are used instead. This applies, for example, to MNT4 and
+/// MNT6 (which use projective coordinates, and have a != 0) and to Edwards
+/// curves.
+template<typename GroupT> class group_coordinates
+{
+public:
+    static const bool jacobian_a0 = false;
+};
+
+// For alt-bn128 G1 (y^2 = x^3 + 3) and G2 (over Fq2)
+template<> class group_coordinates<libff::alt_bn128_G1>
+{
+public:
+    static const bool jacobian_a0 = true;
+};
+
+template<> class group_coordinates<libff::alt_bn128_G2>
+{
+public:
+    static const bool jacobian_a0 = true;
+};
+
+// For bls12-377 G1 (y^2 = x^3 + 1) and G2 (over Fq2)
+template<> class group_coordinates<libff::bls12_377_G1>
+{
+public:
+    static const bool jacobian_a0 = true;
+};
+
+template<> class group_coordinates<libff::bls12_377_G2>
+{
+public:
+    static const bool jacobian_a0 = true;
+};
+
+/// std::true_type if group_coordinates<GroupT>::jacobian_a0 is set, and
+/// std::false_type otherwise, for use in tag dispatch.
+template<typename GroupT>
+using group_jacobian_a0_tag =
+    std::integral_constant<bool, group_coordinates<GroupT>::jacobian_a0>;
+
+} // namespace libzeth
+
+#endif // __ZETH_CORE_GROUP_COORDINATES_HPP__
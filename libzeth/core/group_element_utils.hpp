@@ -7,6 +7,8 @@
 
 #include "include_libff.hpp"
 
+#include <vector>
+
 namespace libzeth
 {
 
@@ -26,6 +28,17 @@ std::string group_element_to_json(const GroupT &point);
 template<typename GroupT>
 GroupT group_element_from_json(const std::string &json);
 
+/// Convert group elements to affine form (Z = 1, or the canonical
+/// representation of zero) in place. For groups in Jacobian coordinates (see
+/// group_coordinates), chunks of elements share a single field inversion
+/// (Montgomery's trick), making this significantly cheaper than calling
+/// to_affine_coordinates on each element, which is done for other groups.
+/// When built with MULTICORE, elements are processed in parallel.
+template<typename GroupT>
+void batch_to_affine(GroupT *points, const size_t num_points);
+
+template<typename GroupT> void batch_to_affine(std::vector<GroupT> &points);
+
 /// Write a group element as bytes to a stream. The elements are written as X
 /// and Y coordinates of the affine form, where each coordinate is written
 /// using field_element_write_bytes.
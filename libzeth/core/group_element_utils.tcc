@@ -5,9 +5,14 @@
 #ifndef __ZETH_CORE_GROUP_ELEMENT_UTILS_TCC__
 #define __ZETH_CORE_GROUP_ELEMENT_UTILS_TCC__
 
+#include "libzeth/core/field_batch.hpp"
 #include "libzeth/core/field_element_utils.hpp"
+#include "libzeth/core/group_coordinates.hpp"
 #include "libzeth/serialization/stream_utils.hpp"
 
+#include <algorithm>
+#include <type_traits>
+
 namespace libzeth
 {
 
@@ -28,8 +33,97 @@ template<typename FieldT> static bool coordinate_equals_one(const FieldT &f)
     return f == FieldT::one();
 }
 
+// Convert the points in [begin, end) to affine form, using a single
+// inversion. The coordinates of the points which require conversion are
+// gathered into contiguous arrays, so that the batch field kernels apply.
+template<typename GroupT, typename CoordinateT>
+void batch_to_affine_chunk(GroupT *points, const size_t begin, const size_t end)
+{
+    std::vector<size_t> indices;
+    std::vector<CoordinateT> x;
+    std::vector<CoordinateT> y;
+    std::vector<CoordinateT> z;
+    indices.reserve(end - begin);
+    x.reserve(end - begin);
+    y.reserve(end - begin);
+    z.reserve(end - begin);
+    for (size_t i = begin; i < end; ++i) {
+        GroupT &point = points[i];
+        if (point.is_zero()) {
+            point = GroupT::zero();
+        } else if (!point.is_special()) {
+            indices.push_back(i);
+            x.push_back(point.X);
+            y.push_back(point.Y);
+            z.push_back(point.Z);
+        }
+    }
+
+    // x / z^2 and y / z^3
+    const size_t n = indices.size();
+    std::vector<CoordinateT> z_inverse_squared(n);
+    field_batch_inverse(z.data(), n);
+    field_batch_square(z_inverse_squared.data(), z.data(), n);
+    field_batch_mul(x.data(), x.data(), z_inverse_squared.data(), n);
+    field_batch_mul(z.data(), z.data(), z_inverse_squared.data(), n);
+    field_batch_mul(y.data(), y.data(), z.data(), n);
+
+    for (size_t k = 0; k < n; ++k) {
+        GroupT &point = points[indices[k]];
+        point.X = x[k];
+        point.Y = y[k];
+        point.Z = CoordinateT::one();
+    }
+}
+
+// Jacobian coordinates (see group_coordinates), converted in chunks.
+template<typename GroupT>
+void batch_to_affine(
+    GroupT *points, const size_t num_points, std::true_type /* jacobian */)
+{
+    using coordinate_t = typename std::decay<decltype(points->X)>::type;
+
+    // Large enough for the inversion to be negligible.
+    const size_t chunk_size = 1024;
+    const size_t num_chunks = (num_points + chunk_size - 1) / chunk_size;
+
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+        const size_t begin = chunk * chunk_size;
+        batch_to_affine_chunk<GroupT, coordinate_t>(
+            points, begin, std::min(begin + chunk_size, num_points));
+    }
+}
+
+// Other representations, converted individually.
+template<typename GroupT>
+void batch_to_affine(
+    GroupT *points, const size_t num_points, std::false_type /* jacobian */)
+{
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < num_points; ++i) {
+        points[i].to_affine_coordinates();
+    }
+}
+
 } // namespace internal
 
+template<typename GroupT>
+void batch_to_affine(GroupT *points, const size_t num_points)
+{
+    internal::batch_to_affine(
+        points, num_points, group_jacobian_a0_tag<GroupT>());
+}
+
+template<typename GroupT> void batch_to_affine(std::vector<GroupT> &points)
+{
+    batch_to_affine(points.data(), points.size());
+}
+
 template<typename GroupT>
 void group_element_write_json(const GroupT &point, std::ostream &out_s)
 {
@@ -0,0 +1,178 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "libzeth/core/mapped_file.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace libzeth
+{
+
+mapped_file::mapped_file(const std::string &file_path)
+    : ptr(nullptr), length(0)
+{
+    const int fd = open(file_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(
+            "failed to open " + file_path + ": " + strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        const int err = errno;
+        close(fd);
+        throw std::runtime_error(
+            "failed to stat " + file_path + ": " + strerror(err));
+    }
+
+    length = (size_t)st.st_size;
+    if (length == 0) {
+        close(fd);
+        throw std::runtime_error("cannot map empty file " + file_path);
+    }
+
+    void *mapped = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    const int err = errno;
+    // The mapping remains valid after the descriptor is closed.
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        throw std::runtime_error(
+            "failed to map " + file_path + ": " + strerror(err));
+    }
+
+    ptr = (const uint8_t *)mapped;
+}
+
+mapped_file::mapped_file(mapped_file &&other)
+    : ptr(other.ptr), length(other.length)
+{
+    other.ptr = nullptr;
+    other.length = 0;
+}
+
+mapped_file::~mapped_file()
+{
+    if (ptr != nullptr) {
+        munmap((void *)ptr, length);
+    }
+}
+
+const uint8_t *mapped_file::data() const { return ptr; }
+
+size_t mapped_file::size() const { return length; }
+
+void mapped_file::will_need(size_t offset, size_t num_bytes) const
+{
+    // madvise requires a page-aligned start address.
+    const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t aligned_offset = offset - (offset % page_size);
+    madvise(
+        (void *)(ptr + aligned_offset),
+        num_bytes + (offset - aligned_offset),
+        MADV_WILLNEED);
+}
+
+writable_mapped_file::writable_mapped_file(
+    const std::string &file_path, size_t min_size)
+    : file_path(file_path), fd(-1), ptr(nullptr), length(0)
+{
+    fd = open(file_path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        throw std::runtime_error(
+            "failed to open " + file_path + ": " + strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        const int err = errno;
+        close(fd);
+        throw std::runtime_error(
+            "failed to stat " + file_path + ": " + strerror(err));
+    }
+
+    try {
+        map(std::max((size_t)st.st_size, std::max(min_size, (size_t)1)));
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+}
+
+writable_mapped_file::writable_mapped_file(writable_mapped_file &&other)
+    : file_path(std::move(other.file_path))
+    , fd(other.fd)
+    , ptr(other.ptr)
+    , length(other.length)
+{
+    other.fd = -1;
+    other.ptr = nullptr;
+    other.length = 0;
+}
+
+writable_mapped_file::~writable_mapped_file()
+{
+    unmap();
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+uint8_t *writable_mapped_file::data() { return ptr; }
+
+const uint8_t *writable_mapped_file::data() const { return ptr; }
+
+size_t writable_mapped_file::size() const { return length; }
+
+void writable_mapped_file::grow(size_t new_size)
+{
+    if (new_size <= length) {
+        return;
+    }
+    unmap();
+    map(new_size);
+}
+
+void writable_mapped_file::sync()
+{
+    if (msync(ptr, length, MS_SYNC) != 0 || fsync(fd) != 0) {
+        throw std::runtime_error(
+            "failed to sync " + file_path + ": " + strerror(errno));
+    }
+}
+
+void writable_mapped_file::map(size_t new_size)
+{
+    if (ftruncate(fd, (off_t)new_size) != 0) {
+        throw std::runtime_error(
+            "failed to resize " + file_path + ": " + strerror(errno));
+    }
+
+    void *mapped =
+        mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        throw std::runtime_error(
+            "failed to map " + file_path + ": " + strerror(errno));
+    }
+
+    ptr = (uint8_t *)mapped;
+    length = new_size;
+}
+
+void writable_mapped_file::unmap()
+{
+    if (ptr != nullptr) {
+        munmap(ptr, length);
+        ptr = nullptr;
+        length = 0;
+    }
+}
+
+} // namespace libzeth
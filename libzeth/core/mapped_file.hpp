@@ -0,0 +1,78 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CORE_MAPPED_FILE_HPP__
+#define __ZETH_CORE_MAPPED_FILE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace libzeth
+{
+
+/// Read-only memory mapping of an entire file. The mapping is shared, so
+/// that several processes mapping the same file use the same physical pages
+/// (from the page cache). Non-copyable, movable.
+class mapped_file
+{
+public:
+    /// Map the given file. Throws std::runtime_error on failure.
+    explicit mapped_file(const std::string &file_path);
+    mapped_file(mapped_file &&other);
+    mapped_file(const mapped_file &) = delete;
+    mapped_file &operator=(const mapped_file &) = delete;
+    ~mapped_file();
+
+    const uint8_t *data() const;
+    size_t size() const;
+
+    /// Hint to the kernel that the given range will be accessed soon (e.g.
+    /// before an MSM over a section of the file).
+    void will_need(size_t offset, size_t num_bytes) const;
+
+private:
+    const uint8_t *ptr;
+    size_t length;
+};
+
+/// Read-write shared memory mapping of an entire file, which is created (or
+/// extended with zeros) to the requested size if necessary. Writes become
+/// visible in the file immediately, and are guaranteed to be on disk after
+/// `sync` returns. Non-copyable, movable.
+class writable_mapped_file
+{
+public:
+    /// Map the given file, creating it or extending it to at least
+    /// `min_size` bytes. Throws std::runtime_error on failure.
+    writable_mapped_file(const std::string &file_path, size_t min_size);
+    writable_mapped_file(writable_mapped_file &&other);
+    writable_mapped_file(const writable_mapped_file &) = delete;
+    writable_mapped_file &operator=(const writable_mapped_file &) = delete;
+    ~writable_mapped_file();
+
+    uint8_t *data();
+    const uint8_t *data() const;
+    size_t size() const;
+
+    /// Extend the file and the mapping to `new_size` bytes. Invalidates any
+    /// pointers into the mapping.
+    void grow(size_t new_size);
+
+    /// Write all modified pages to disk.
+    void sync();
+
+private:
+    std::string file_path;
+    int fd;
+    uint8_t *ptr;
+    size_t length;
+
+    void map(size_t new_size);
+    void unmap();
+};
+
+} // namespace libzeth
+
+#endif // __ZETH_CORE_MAPPED_FILE_HPP__
@@ -6,6 +6,7 @@
 #define __ZETH_CORE_MERKLE_TREE_FIELD_HPP__
 
 #include "libzeth/core/include_libff.hpp"
+#include "libzeth/core/merkle_tree_storage.hpp"
 
 #include <libff/common/utils.hpp>
 #include <map>
@@ -16,24 +17,29 @@ namespace libzeth
 
 /// Merkle Tree whose nodes are field elements
 ///
-/// A Merkle tree is maintained as two maps:
-/// - `values` = Map from addresses to values, and
-/// - `hashes` = Map from addresses to hashes.
+/// The leaves (values) and intermediate hashes of the tree are held in a
+/// storage backend StorageT (see merkle_tree_storage.hpp), which implicitly
+/// holds the default value (`hash_defaults[layer]`) for any node that has not
+/// been set. Besides offering methods to load and store values, the class
+/// offers methods to retrieve the root of the Merkle tree and to obtain the
+/// authentication paths for (the value at) a given address.
 ///
-/// The second map maintains the intermediate hashes of a Merkle tree
-/// built atop the values currently stored in the tree (the
-/// implementation admits a very efficient support for sparse
-/// trees). Besides offering methods to load and store values, the
-/// class offers methods to retrieve the root of the Merkle tree and to
-/// obtain the authentication paths for (the value at) a given address.
-template<typename FieldT, typename HashTreeT> class merkle_tree_field
+/// The default backend stores each layer as a contiguous vector, which is
+/// efficient when leaves are populated from left to right. Sparse trees
+/// should use merkle_tree_map_storage.
+template<
+    typename FieldT,
+    typename HashTreeT,
+    typename StorageT = merkle_tree_layered_storage<FieldT>>
+class merkle_tree_field
 {
 
 public:
-    std::vector<FieldT> hash_defaults;
-    std::map<size_t, FieldT> values;
-    std::map<size_t, FieldT> hashes;
     size_t depth;
+    /// Default value of the nodes in each layer (0 for the root, depth for
+    /// the leaves)
+    std::vector<FieldT> hash_defaults;
+    StorageT nodes;
 
     merkle_tree_field(const size_t depth);
     merkle_tree_field(
@@ -44,10 +50,30 @@ public:
     FieldT get_value(const size_t address) const;
     void set_value(const size_t address, const FieldT &value);
 
+    /// Set the values of consecutive leaves, starting at `first_address`.
+    /// Each affected node is recomputed once, and the hashes in each layer
+    /// are computed in parallel (when built with MULTICORE).
+    void set_values(
+        const size_t first_address, const std::vector<FieldT> &values);
+
     FieldT get_root() const;
     std::vector<FieldT> get_path(const size_t address) const;
 
     void dump() const;
+
+    /// Compute the default value of the nodes in each layer of a tree of the
+    /// given depth, from the root (index 0) to the leaves (index depth).
+    static std::vector<FieldT> compute_hash_defaults(const size_t depth);
+
+private:
+    // Recompute all ancestors of the given (sorted) leaf addresses.
+    void update_ancestors(std::vector<size_t> &&addresses);
+
+    // Recompute num_nodes nodes in layer `layer - 1` from their children,
+    // where the i-th node to recompute has index parent_index(i).
+    template<typename IndexFnT>
+    void update_layer(
+        const size_t layer, const size_t num_nodes, IndexFnT parent_index);
 };
 
 } // namespace libzeth
@@ -0,0 +1,133 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CORE_MERKLE_TREE_FILE_HPP__
+#define __ZETH_CORE_MERKLE_TREE_FILE_HPP__
+
+#include "libzeth/core/durable_file.hpp"
+#include "libzeth/core/mapped_file.hpp"
+#include "libzeth/core/merkle_tree_field.hpp"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace libzeth
+{
+
+/// Append-only Merkle tree of field elements persisted in a directory,
+/// computing the same roots and paths as merkle_tree_field when leaves are
+/// populated from left to right.
+///
+/// Each layer of the tree is held in its own memory-mapped file (see
+/// writable_mapped_file), so that opening a tree does not require the tree
+/// to be read or recomputed. Updates are crash-consistent: each batch of
+/// leaves is written to a log (see append_log) and synced before the layer
+/// files are modified, and `checkpoint` atomically records the state of the
+/// (synced) layer files, after which the log is cleared. On opening, any log
+/// entries written since the last checkpoint are replayed, so the cost of
+/// opening is proportional to the data appended since that checkpoint.
+///
+/// The root after each batch is also recorded, and `get_snapshot` and
+/// `find_snapshot` give the root and authentication paths of the tree as it
+/// was after any earlier number of leaves.
+///
+/// Field elements are stored as raw in-memory images, and therefore the
+/// files can only be used by builds with the same field representation
+/// (this is checked, as far as possible, on opening).
+template<typename FieldT, typename HashTreeT> class merkle_tree_file
+{
+public:
+    /// Read-only view of the tree after a given number of leaves. The view
+    /// remains valid for the lifetime of the merkle_tree_file.
+    class snapshot
+    {
+    public:
+        size_t num_leaves() const;
+        FieldT get_root() const;
+        std::vector<FieldT> get_path(const size_t address) const;
+
+    private:
+        friend class merkle_tree_file;
+        snapshot(const merkle_tree_file &tree, const size_t num_leaves);
+
+        FieldT get_node(const size_t layer, const size_t index) const;
+
+        const merkle_tree_file &tree;
+        const size_t leaf_count;
+        // For each layer, the value of the node covering both leaves before
+        // and after leaf_count (if any).
+        std::vector<FieldT> partial_nodes;
+    };
+
+    /// Default value of the nodes in each layer (0 for the root, depth for
+    /// the leaves), as for merkle_tree_field.
+    const std::vector<FieldT> hash_defaults;
+
+    /// Open the tree in the given directory, creating it if necessary.
+    /// Throws std::invalid_argument if the directory holds a tree with
+    /// different parameters, and std::runtime_error on I/O errors.
+    merkle_tree_file(const std::string &dir_path, const size_t depth);
+    merkle_tree_file(const merkle_tree_file &) = delete;
+    merkle_tree_file &operator=(const merkle_tree_file &) = delete;
+
+    size_t depth() const;
+    size_t num_leaves() const;
+
+    FieldT get_value(const size_t address) const;
+    FieldT get_root() const;
+    std::vector<FieldT> get_path(const size_t address) const;
+
+    /// Append a batch of leaves. The batch is durable when this returns.
+    /// Throws if the tree does not have space for the batch.
+    void append(const std::vector<FieldT> &values);
+
+    /// Sync the layer files and record their state, so that the log can be
+    /// cleared.
+    void checkpoint();
+
+    /// View of the tree when it held the first `num_leaves` leaves.
+    snapshot get_snapshot(const size_t num_leaves) const;
+
+    /// View of the tree at the point (after some batch) where it had the
+    /// given root. Throws std::invalid_argument if there is no such point.
+    snapshot find_snapshot(const FieldT &root) const;
+
+private:
+    const std::string dir_path;
+    size_t leaf_count;
+
+    // Index 0 for the root, depth for the leaves
+    std::vector<writable_mapped_file> layers;
+
+    // Batches of leaves appended since the last checkpoint
+    std::unique_ptr<append_log> leaves_log;
+
+    // (num_leaves, root) after each batch
+    std::unique_ptr<append_log> roots_log;
+    std::vector<std::pair<size_t, FieldT>> roots;
+
+    std::string checkpoint_path() const;
+    void read_checkpoint(FieldT &root);
+    // Apply any batches in the log which are not in the checkpoint, returning
+    // true if there were any.
+    bool replay_log();
+
+    size_t layer_size(const size_t layer, const size_t num_leaves) const;
+    const FieldT &get_node(const size_t layer, const size_t index) const;
+    FieldT *layer_data(const size_t layer);
+    const FieldT *layer_data(const size_t layer) const;
+    void reserve(const size_t num_leaves);
+
+    // Write leaves to the layer files and recompute their ancestors.
+    void apply(
+        const size_t first_address, const FieldT *values, const size_t count);
+};
+
+} // namespace libzeth
+
+#include "libzeth/core/merkle_tree_file.tcc"
+
+#endif // __ZETH_CORE_MERKLE_TREE_FILE_HPP__
@@ -0,0 +1,475 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CORE_MERKLE_TREE_FILE_TCC__
+#define __ZETH_CORE_MERKLE_TREE_FILE_TCC__
+
+#include "libzeth/core/merkle_tree_file.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace libzeth
+{
+
+namespace internal
+{
+
+// Files in a merkle_tree_file directory:
+//
+//   layer_<L>.bin - the nodes of layer L, as raw FieldT images
+//   leaves.log    - append_log of leaf batches: <first_address> <leaves>
+//   roots.log     - append_log of <num_leaves> <root> after each batch
+//   checkpoint    - <magic> <version> <depth> <sizeof(FieldT)> <num_leaves>
+//                   <root>
+//
+// where integers are 8 bytes, little-endian.
+static const char MERKLE_TREE_FILE_MAGIC[] = "ZMTF";
+static const uint64_t MERKLE_TREE_FILE_VERSION = 1;
+
+inline void merkle_tree_file_write_u64(std::string &out, const uint64_t value)
+{
+    for (size_t i = 0; i < sizeof(uint64_t); ++i) {
+        out.push_back((char)(uint8_t)(value >> (8 * i)));
+    }
+}
+
+inline uint64_t merkle_tree_file_read_u64(
+    const std::string &in, size_t &offset)
+{
+    if (in.size() - offset < sizeof(uint64_t)) {
+        throw std::runtime_error("invalid merkle tree file data");
+    }
+    uint64_t value = 0;
+    for (size_t i = 0; i < sizeof(uint64_t); ++i) {
+        value |= ((uint64_t)(uint8_t)in[offset + i]) << (8 * i);
+    }
+    offset += sizeof(uint64_t);
+    return value;
+}
+
+template<typename FieldT>
+void merkle_tree_file_write_field(
+    std::string &out, const FieldT *values, const size_t count)
+{
+    out.append((const char *)values, count * sizeof(FieldT));
+}
+
+template<typename FieldT>
+void merkle_tree_file_read_field(
+    const std::string &in, size_t &offset, FieldT *values, const size_t count)
+{
+    if (in.size() - offset < count * sizeof(FieldT)) {
+        throw std::runtime_error("invalid merkle tree file data");
+    }
+    memcpy((void *)values, in.data() + offset, count * sizeof(FieldT));
+    offset += count * sizeof(FieldT);
+}
+
+template<typename FieldT>
+std::string merkle_tree_file_root_record(
+    const size_t num_leaves, const FieldT &root)
+{
+    std::string record;
+    merkle_tree_file_write_u64(record, num_leaves);
+    merkle_tree_file_write_field(record, &root, 1);
+    return record;
+}
+
+} // namespace internal
+
+template<typename FieldT, typename HashTreeT>
+merkle_tree_file<FieldT, HashTreeT>::merkle_tree_file(
+    const std::string &dir_path, const size_t depth)
+    : hash_defaults(
+          merkle_tree_field<FieldT, HashTreeT>::compute_hash_defaults(depth))
+    , dir_path(dir_path)
+    , leaf_count(0)
+{
+    ensure_directory(dir_path);
+
+    FieldT checkpoint_root = hash_defaults[0];
+    read_checkpoint(checkpoint_root);
+
+    // Map the layer files, which hold (at least) the state at the
+    // checkpoint.
+    layers.reserve(depth + 1);
+    for (size_t layer = 0; layer <= depth; ++layer) {
+        layers.emplace_back(
+            dir_path + "/layer_" + std::to_string(layer) + ".bin",
+            sizeof(FieldT));
+    }
+    reserve(leaf_count);
+
+    // Roots after the checkpoint are recomputed as the log is replayed.
+    roots_log.reset(new append_log(dir_path + "/roots.log"));
+    size_t num_roots = 0;
+    for (const std::string &record : roots_log->recovered_records()) {
+        size_t offset = 0;
+        const size_t num_leaves =
+            internal::merkle_tree_file_read_u64(record, offset);
+        if (num_leaves > leaf_count) {
+            break;
+        }
+        FieldT root;
+        internal::merkle_tree_file_read_field(record, offset, &root, 1);
+        roots.emplace_back(num_leaves, root);
+        ++num_roots;
+    }
+    roots_log->release_recovered_records();
+    if (num_roots != roots_log->num_records()) {
+        roots_log->truncate(num_roots);
+    }
+
+    // Layer nodes may have been written after the checkpoint, in which case
+    // they are recomputed from the log. Otherwise, they must match the
+    // checkpoint exactly.
+    leaves_log.reset(new append_log(dir_path + "/leaves.log"));
+    if (!replay_log() && get_root() != checkpoint_root) {
+        throw std::runtime_error(
+            "merkle tree in " + dir_path + " does not match checkpoint");
+    }
+}
+
+template<typename FieldT, typename HashTreeT>
+size_t merkle_tree_file<FieldT, HashTreeT>::depth() const
+{
+    return hash_defaults.size() - 1;
+}
+
+template<typename FieldT, typename HashTreeT>
+size_t merkle_tree_file<FieldT, HashTreeT>::num_leaves() const
+{
+    return leaf_count;
+}
+
+template<typename FieldT, typename HashTreeT>
+FieldT merkle_tree_file<FieldT, HashTreeT>::get_value(
+    const size_t address) const
+{
+    return get_node(depth(), address);
+}
+
+template<typename FieldT, typename HashTreeT>
+FieldT merkle_tree_file<FieldT, HashTreeT>::get_root() const
+{
+    return get_node(0, 0);
+}
+
+template<typename FieldT, typename HashTreeT>
+std::vector<FieldT> merkle_tree_file<FieldT, HashTreeT>::get_path(
+    const size_t address) const
+{
+    assert(address < (1ul << depth()));
+
+    // Sibling nodes from the leaf layer up to the layer below the root
+    std::vector<FieldT> result;
+    result.reserve(depth());
+    size_t idx = address;
+    for (size_t layer = depth(); layer > 0; --layer) {
+        result.push_back(get_node(layer, idx ^ 1));
+        idx = idx / 2;
+    }
+
+    return result;
+}
+
+template<typename FieldT, typename HashTreeT>
+void merkle_tree_file<FieldT, HashTreeT>::append(
+    const std::vector<FieldT> &values)
+{
+    if (values.empty()) {
+        return;
+    }
+    if (values.size() > (1ul << depth()) - leaf_count) {
+        throw std::runtime_error("merkle tree is full");
+    }
+
+    // The batch is durable in the log before any layer file is modified, so
+    // that partially written layers can always be recomputed.
+    std::string record;
+    internal::merkle_tree_file_write_u64(record, leaf_count);
+    internal::merkle_tree_file_write_field(
+        record, values.data(), values.size());
+    leaves_log->append(record);
+    leaves_log->sync();
+
+    apply(leaf_count, values.data(), values.size());
+}
+
+template<typename FieldT, typename HashTreeT>
+void merkle_tree_file<FieldT, HashTreeT>::checkpoint()
+{
+    for (writable_mapped_file &layer : layers) {
+        layer.sync();
+    }
+    roots_log->sync();
+
+    std::string data(internal::MERKLE_TREE_FILE_MAGIC);
+    internal::merkle_tree_file_write_u64(
+        data, internal::MERKLE_TREE_FILE_VERSION);
+    internal::merkle_tree_file_write_u64(data, depth());
+    internal::merkle_tree_file_write_u64(data, sizeof(FieldT));
+    internal::merkle_tree_file_write_u64(data, leaf_count);
+    const FieldT root = get_root();
+    internal::merkle_tree_file_write_field(data, &root, 1);
+    write_file_atomic(checkpoint_path(), data);
+
+    leaves_log->truncate(0);
+}
+
+template<typename FieldT, typename HashTreeT>
+typename merkle_tree_file<FieldT, HashTreeT>::snapshot merkle_tree_file<
+    FieldT,
+    HashTreeT>::get_snapshot(const size_t num_leaves) const
+{
+    if (num_leaves > leaf_count) {
+        throw std::invalid_argument("snapshot is beyond the end of the tree");
+    }
+    return snapshot(*this, num_leaves);
+}
+
+template<typename FieldT, typename HashTreeT>
+typename merkle_tree_file<FieldT, HashTreeT>::snapshot merkle_tree_file<
+    FieldT,
+    HashTreeT>::find_snapshot(const FieldT &root) const
+{
+    // Most lookups are expected to be for recent roots.
+    for (auto it = roots.rbegin(); it != roots.rend(); ++it) {
+        if (it->second == root) {
+            return snapshot(*this, it->first);
+        }
+    }
+    if (root == hash_defaults[0]) {
+        return snapshot(*this, 0);
+    }
+    throw std::invalid_argument("unknown merkle root");
+}
+
+template<typename FieldT, typename HashTreeT>
+std::string merkle_tree_file<FieldT, HashTreeT>::checkpoint_path() const
+{
+    return dir_path + "/checkpoint";
+}
+
+template<typename FieldT, typename HashTreeT>
+void merkle_tree_file<FieldT, HashTreeT>::read_checkpoint(FieldT &root)
+{
+    if (!file_exists(checkpoint_path())) {
+        return;
+    }
+
+    const std::string data = read_file(checkpoint_path());
+    const size_t magic_size = sizeof(internal::MERKLE_TREE_FILE_MAGIC) - 1;
+    if (data.compare(0, magic_size, internal::MERKLE_TREE_FILE_MAGIC) != 0) {
+        throw std::invalid_argument("invalid merkle tree checkpoint");
+    }
+
+    size_t offset = magic_size;
+    if (internal::merkle_tree_file_read_u64(data, offset) !=
+        internal::MERKLE_TREE_FILE_VERSION) {
+        throw std::invalid_argument("unsupported merkle tree version");
+    }
+    if (internal::merkle_tree_file_read_u64(data, offset) != depth()) {
+        throw std::invalid_argument("merkle tree depth mismatch");
+    }
+    if (internal::merkle_tree_file_read_u64(data, offset) != sizeof(FieldT)) {
+        throw std::invalid_argument("merkle tree field size mismatch");
+    }
+    leaf_count = internal::merkle_tree_file_read_u64(data, offset);
+    if (leaf_count > (1ul << depth())) {
+        throw std::invalid_argument("invalid merkle tree checkpoint");
+    }
+    internal::merkle_tree_file_read_field(data, offset, &root, 1);
+}
+
+template<typename FieldT, typename HashTreeT>
+bool merkle_tree_file<FieldT, HashTreeT>::replay_log()
+{
+    bool replayed = false;
+    std::vector<FieldT> values;
+    for (const std::string &record : leaves_log->recovered_records()) {
+        size_t offset = 0;
+        const size_t first_address =
+            internal::merkle_tree_file_read_u64(record, offset);
+        const size_t count = (record.size() - offset) / sizeof(FieldT);
+        if (first_address > leaf_count ||
+            count > (1ul << depth()) - first_address) {
+            throw std::runtime_error(
+                "merkle tree log in " + dir_path + " is inconsistent");
+        }
+
+        // Skip any leaves already included in the checkpoint (if the process
+        // stopped before the log was cleared).
+        if (first_address + count <= leaf_count) {
+            continue;
+        }
+        values.resize(count);
+        internal::merkle_tree_file_read_field(
+            record, offset, values.data(), count);
+        const size_t skip = leaf_count - first_address;
+        apply(leaf_count, values.data() + skip, count - skip);
+        replayed = true;
+    }
+    leaves_log->release_recovered_records();
+
+    if (replayed) {
+        checkpoint();
+    } else if (leaves_log->num_records() != 0) {
+        leaves_log->truncate(0);
+    }
+    return replayed;
+}
+
+template<typename FieldT, typename HashTreeT>
+size_t merkle_tree_file<FieldT, HashTreeT>::layer_size(
+    const size_t layer, const size_t num_leaves) const
+{
+    // Number of nodes in `layer` with at least one leaf below them.
+    const size_t height = depth() - layer;
+    return (num_leaves + (1ul << height) - 1) >> height;
+}
+
+template<typename FieldT, typename HashTreeT>
+const FieldT &merkle_tree_file<FieldT, HashTreeT>::get_node(
+    const size_t layer, const size_t index) const
+{
+    if (index < layer_size(layer, leaf_count)) {
+        return layer_data(layer)[index];
+    }
+    return hash_defaults[layer];
+}
+
+template<typename FieldT, typename HashTreeT>
+FieldT *merkle_tree_file<FieldT, HashTreeT>::layer_data(const size_t layer)
+{
+    return (FieldT *)layers[layer].data();
+}
+
+template<typename FieldT, typename HashTreeT>
+const FieldT *merkle_tree_file<FieldT, HashTreeT>::layer_data(
+    const size_t layer) const
+{
+    return (const FieldT *)layers[layer].data();
+}
+
+template<typename FieldT, typename HashTreeT>
+void merkle_tree_file<FieldT, HashTreeT>::reserve(const size_t num_leaves)
+{
+    // Layer files are grown by doubling, to amortize the cost of remapping.
+    for (size_t layer = 0; layer <= depth(); ++layer) {
+        const size_t required = layer_size(layer, num_leaves) * sizeof(FieldT);
+        size_t capacity = layers[layer].size();
+        if (capacity < required) {
+            while (capacity < required) {
+                capacity *= 2;
+            }
+            layers[layer].grow(capacity);
+        }
+    }
+}
+
+template<typename FieldT, typename HashTreeT>
+void merkle_tree_file<FieldT, HashTreeT>::apply(
+    const size_t first_address, const FieldT *values, const size_t count)
+{
+    assert(first_address == leaf_count);
+    reserve(first_address + count);
+    memcpy(
+        (void *)(layer_data(depth()) + first_address),
+        (const void *)values,
+        count * sizeof(FieldT));
+    leaf_count = first_address + count;
+
+    // [begin, end) is the range of dirty nodes in the current layer. The
+    // nodes of each layer are written directly to the mapped file, in
+    // parallel, since the mapping does not change during the update.
+    size_t begin = first_address;
+    size_t end = leaf_count;
+    for (size_t layer = depth(); layer > 0; --layer) {
+        begin = begin / 2;
+        end = (end + 1) / 2;
+        FieldT *parents = layer_data(layer - 1);
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+        for (size_t i = begin; i < end; ++i) {
+            parents[i] = HashTreeT::get_hash(
+                get_node(layer, 2 * i), get_node(layer, 2 * i + 1));
+        }
+    }
+
+    const FieldT root = get_root();
+    roots.emplace_back(leaf_count, root);
+    roots_log->append(internal::merkle_tree_file_root_record(leaf_count, root));
+}
+
+template<typename FieldT, typename HashTreeT>
+merkle_tree_file<FieldT, HashTreeT>::snapshot::snapshot(
+    const merkle_tree_file &tree, const size_t num_leaves)
+    : tree(tree), leaf_count(num_leaves), partial_nodes(tree.depth() + 1)
+{
+    // Nodes entirely to the left of leaf_count are unchanged since the
+    // snapshot, and are read from the tree. In each layer, at most one node
+    // has leaves on both sides of leaf_count. These are recomputed from the
+    // leaves upwards.
+    for (size_t layer = tree.depth(); layer-- > 0;) {
+        const size_t height = tree.depth() - layer;
+        const size_t index = leaf_count >> height;
+        if ((leaf_count & ((1ul << height) - 1)) != 0) {
+            partial_nodes[layer] = HashTreeT::get_hash(
+                get_node(layer + 1, 2 * index),
+                get_node(layer + 1, 2 * index + 1));
+        }
+    }
+}
+
+template<typename FieldT, typename HashTreeT>
+size_t merkle_tree_file<FieldT, HashTreeT>::snapshot::num_leaves() const
+{
+    return leaf_count;
+}
+
+template<typename FieldT, typename HashTreeT>
+FieldT merkle_tree_file<FieldT, HashTreeT>::snapshot::get_root() const
+{
+    return get_node(0, 0);
+}
+
+template<typename FieldT, typename HashTreeT>
+std::vector<FieldT> merkle_tree_file<FieldT, HashTreeT>::snapshot::get_path(
+    const size_t address) const
+{
+    assert(address < (1ul << tree.depth()));
+
+    std::vector<FieldT> result;
+    result.reserve(tree.depth());
+    size_t idx = address;
+    for (size_t layer = tree.depth(); layer > 0; --layer) {
+        result.push_back(get_node(layer, idx ^ 1));
+        idx = idx / 2;
+    }
+
+    return result;
+}
+
+template<typename FieldT, typename HashTreeT>
+FieldT merkle_tree_file<FieldT, HashTreeT>::snapshot::get_node(
+    const size_t layer, const size_t index) const
+{
+    const size_t height = tree.depth() - layer;
+    const size_t num_complete = leaf_count >> height;
+    if (index < num_complete) {
+        return tree.layer_data(layer)[index];
+    }
+    if (index == num_complete && (leaf_count & ((1ul << height) - 1)) != 0) {
+        return partial_nodes[layer];
+    }
+    return tree.hash_defaults[layer];
+}
+
+} // namespace libzeth
+
+#endif // __ZETH_CORE_MERKLE_TREE_FILE_TCC__
@@ -0,0 +1,70 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CORE_MERKLE_TREE_FRONTIER_HPP__
+#define __ZETH_CORE_MERKLE_TREE_FRONTIER_HPP__
+
+#include "libzeth/core/merkle_tree_field.hpp"
+
+#include <map>
+#include <vector>
+
+namespace libzeth
+{
+
+/// Append-only Merkle tree of field elements, computing the same roots and
+/// paths as merkle_tree_field when leaves are populated from left to right.
+///
+/// Only the frontier of the tree (for each layer, the last complete left
+/// node) is stored, so that memory is O(depth) regardless of the number of
+/// leaves, and each append costs `depth` hashes. Witnesses (authentication
+/// paths) can be tracked for selected leaves. These must be registered as the
+/// leaf is appended, and are updated as subsequent leaves are appended.
+template<typename FieldT, typename HashTreeT> class merkle_tree_frontier
+{
+public:
+    /// Default value of the nodes in each layer (0 for the root, depth for
+    /// the leaves), as for merkle_tree_field.
+    const std::vector<FieldT> hash_defaults;
+
+    explicit merkle_tree_frontier(const size_t depth);
+
+    size_t depth() const;
+    size_t num_leaves() const;
+    FieldT get_root() const;
+
+    /// Append a leaf, returning its address. If `track_witness` is true, the
+    /// authentication path of the leaf is maintained and can be queried with
+    /// get_path. Throws if the tree is full.
+    size_t append(const FieldT &value, bool track_witness = false);
+
+    bool is_tracked(const size_t address) const;
+
+    /// Stop maintaining the authentication path for a leaf.
+    void untrack(const size_t address);
+
+    /// Authentication path (siblings from the leaf layer upwards, as returned
+    /// by merkle_tree_field::get_path) of a tracked leaf. Throws if the leaf
+    /// is not tracked.
+    const std::vector<FieldT> &get_path(const size_t address) const;
+
+private:
+    // frontier[h] is the latest left node at height h (0 for the leaves).
+    // When the next leaf is a descendent of a right node at height h, this is
+    // the (complete) left sibling of that node.
+    std::vector<FieldT> frontier;
+    size_t next_address;
+    FieldT root;
+
+    // Paths of tracked leaves
+    std::map<size_t, std::vector<FieldT>> witnesses;
+
+    const FieldT &default_at_height(const size_t height) const;
+};
+
+} // namespace libzeth
+
+#include "libzeth/core/merkle_tree_frontier.tcc"
+
+#endif // __ZETH_CORE_MERKLE_TREE_FRONTIER_HPP__
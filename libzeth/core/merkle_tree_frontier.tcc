@@ -0,0 +1,132 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CORE_MERKLE_TREE_FRONTIER_TCC__
+#define __ZETH_CORE_MERKLE_TREE_FRONTIER_TCC__
+
+#include "libzeth/core/merkle_tree_frontier.hpp"
+
+#include <stdexcept>
+
+namespace libzeth
+{
+
+template<typename FieldT, typename HashTreeT>
+merkle_tree_frontier<FieldT, HashTreeT>::merkle_tree_frontier(
+    const size_t depth)
+    : hash_defaults(
+          merkle_tree_field<FieldT, HashTreeT>::compute_hash_defaults(depth))
+    , frontier(depth)
+    , next_address(0)
+    , root(hash_defaults[0])
+{
+    for (size_t height = 0; height < depth; ++height) {
+        frontier[height] = default_at_height(height);
+    }
+}
+
+template<typename FieldT, typename HashTreeT>
+size_t merkle_tree_frontier<FieldT, HashTreeT>::depth() const
+{
+    return frontier.size();
+}
+
+template<typename FieldT, typename HashTreeT>
+size_t merkle_tree_frontier<FieldT, HashTreeT>::num_leaves() const
+{
+    return next_address;
+}
+
+template<typename FieldT, typename HashTreeT>
+FieldT merkle_tree_frontier<FieldT, HashTreeT>::get_root() const
+{
+    return root;
+}
+
+template<typename FieldT, typename HashTreeT>
+size_t merkle_tree_frontier<FieldT, HashTreeT>::append(
+    const FieldT &value, bool track_witness)
+{
+    const size_t tree_depth = depth();
+    if (next_address >> tree_depth != 0) {
+        throw std::runtime_error("merkle tree is full");
+    }
+
+    const size_t address = next_address++;
+    std::vector<FieldT> *new_witness = nullptr;
+    if (track_witness) {
+        new_witness = &witnesses[address];
+        new_witness->reserve(tree_depth);
+    }
+
+    // Compute the ancestors of the new leaf, taking default values for all
+    // leaves to its right. Each ancestor at height h is the sibling (at
+    // height h) of any tracked leaf whose path it intersects.
+    FieldT node = value;
+    for (size_t height = 0; height < tree_depth; ++height) {
+        const size_t node_idx = address >> height;
+
+        // Tracked leaves to the left of `address` whose path intersects the
+        // path of `address` at this height, have `node` as their sibling.
+        for (auto &entry : witnesses) {
+            if (((entry.first >> height) ^ 1) == node_idx) {
+                entry.second[height] = node;
+            }
+        }
+
+        if (node_idx & 1) {
+            // Right child. The left sibling is complete.
+            if (new_witness) {
+                new_witness->push_back(frontier[height]);
+            }
+            node = HashTreeT::get_hash(frontier[height], node);
+        } else {
+            // Left child. Its right sibling has no leaves yet.
+            const FieldT &sibling = default_at_height(height);
+            if (new_witness) {
+                new_witness->push_back(sibling);
+            }
+            frontier[height] = node;
+            node = HashTreeT::get_hash(node, sibling);
+        }
+    }
+
+    root = node;
+    return address;
+}
+
+template<typename FieldT, typename HashTreeT>
+bool merkle_tree_frontier<FieldT, HashTreeT>::is_tracked(
+    const size_t address) const
+{
+    return witnesses.find(address) != witnesses.end();
+}
+
+template<typename FieldT, typename HashTreeT>
+void merkle_tree_frontier<FieldT, HashTreeT>::untrack(const size_t address)
+{
+    witnesses.erase(address);
+}
+
+template<typename FieldT, typename HashTreeT>
+const std::vector<FieldT> &merkle_tree_frontier<FieldT, HashTreeT>::get_path(
+    const size_t address) const
+{
+    const auto it = witnesses.find(address);
+    if (it == witnesses.end()) {
+        throw std::invalid_argument("leaf is not tracked");
+    }
+    return it->second;
+}
+
+template<typename FieldT, typename HashTreeT>
+const FieldT &merkle_tree_frontier<FieldT, HashTreeT>::default_at_height(
+    const size_t height) const
+{
+    return hash_defaults[depth() - height];
+}
+
+} // namespace libzeth
+
+#endif // __ZETH_CORE_MERKLE_TREE_FRONTIER_TCC__
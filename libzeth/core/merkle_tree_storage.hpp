@@ -0,0 +1,74 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CORE_MERKLE_TREE_STORAGE_HPP__
+#define __ZETH_CORE_MERKLE_TREE_STORAGE_HPP__
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+namespace libzeth
+{
+
+// Storage backends for merkle_tree_field. Nodes are addressed by layer (0 for
+// the root, `depth` for the leaves) and index within the layer. Any node which
+// has not been set holds the default value for its layer (the value of a node
+// whose leaves are all zero). Backends implement:
+//
+//   explicit StorageT(const std::vector<FieldT> &layer_defaults);
+//   const FieldT &get_node(size_t layer, size_t index) const;
+//   void set_node(size_t layer, size_t index, const FieldT &value);
+//   size_t layer_size(size_t layer) const;
+//
+// where `layer_defaults[layer]` is the default value for nodes in `layer`, and
+// layer_size returns an upper bound on the (index + 1) of set nodes in a layer.
+
+/// Stores each layer as a contiguous vector, holding all nodes up to the
+/// right-most populated node in the layer. Nodes beyond this frontier are
+/// implied by the layer defaults. This is compact and cache-friendly when
+/// leaves are populated from left to right (as for append-only trees), but
+/// unsuitable for sparse trees with large leaf addresses.
+template<typename FieldT> class merkle_tree_layered_storage
+{
+public:
+    explicit merkle_tree_layered_storage(
+        const std::vector<FieldT> &layer_defaults);
+
+    const FieldT &get_node(size_t layer, size_t index) const;
+    void set_node(size_t layer, size_t index, const FieldT &value);
+    size_t layer_size(size_t layer) const;
+
+    /// Reserve memory for the given number of leaves (and the nodes above
+    /// them).
+    void reserve(size_t num_leaves);
+
+private:
+    const std::vector<FieldT> layer_defaults;
+    std::vector<std::vector<FieldT>> layers;
+};
+
+/// Stores nodes in a map keyed by their index in the heap representation of
+/// the tree. Suitable for sparse trees.
+template<typename FieldT> class merkle_tree_map_storage
+{
+public:
+    explicit merkle_tree_map_storage(const std::vector<FieldT> &layer_defaults);
+
+    const FieldT &get_node(size_t layer, size_t index) const;
+    void set_node(size_t layer, size_t index, const FieldT &value);
+    size_t layer_size(size_t layer) const;
+
+private:
+    static size_t heap_index(size_t layer, size_t index);
+
+    const std::vector<FieldT> layer_defaults;
+    std::map<size_t, FieldT> nodes;
+};
+
+} // namespace libzeth
+
+#include "libzeth/core/merkle_tree_storage.tcc"
+
+#endif // __ZETH_CORE_MERKLE_TREE_STORAGE_HPP__
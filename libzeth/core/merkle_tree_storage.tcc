@@ -0,0 +1,103 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CORE_MERKLE_TREE_STORAGE_TCC__
+#define __ZETH_CORE_MERKLE_TREE_STORAGE_TCC__
+
+#include "libzeth/core/merkle_tree_storage.hpp"
+
+#include <cassert>
+
+namespace libzeth
+{
+
+template<typename FieldT>
+merkle_tree_layered_storage<FieldT>::merkle_tree_layered_storage(
+    const std::vector<FieldT> &layer_defaults)
+    : layer_defaults(layer_defaults), layers(layer_defaults.size())
+{
+}
+
+template<typename FieldT>
+const FieldT &merkle_tree_layered_storage<FieldT>::get_node(
+    size_t layer, size_t index) const
+{
+    const std::vector<FieldT> &nodes = layers[layer];
+    return (index < nodes.size()) ? nodes[index] : layer_defaults[layer];
+}
+
+template<typename FieldT>
+void merkle_tree_layered_storage<FieldT>::set_node(
+    size_t layer, size_t index, const FieldT &value)
+{
+    std::vector<FieldT> &nodes = layers[layer];
+    if (index >= nodes.size()) {
+        // Any gap between the previous frontier and `index` holds default
+        // values.
+        nodes.resize(index + 1, layer_defaults[layer]);
+    }
+    nodes[index] = value;
+}
+
+template<typename FieldT>
+size_t merkle_tree_layered_storage<FieldT>::layer_size(size_t layer) const
+{
+    return layers[layer].size();
+}
+
+template<typename FieldT>
+void merkle_tree_layered_storage<FieldT>::reserve(size_t num_leaves)
+{
+    for (size_t layer = layers.size(); layer > 0; --layer) {
+        layers[layer - 1].reserve(num_leaves);
+        num_leaves = (num_leaves + 1) / 2;
+    }
+}
+
+template<typename FieldT>
+merkle_tree_map_storage<FieldT>::merkle_tree_map_storage(
+    const std::vector<FieldT> &layer_defaults)
+    : layer_defaults(layer_defaults)
+{
+}
+
+template<typename FieldT>
+const FieldT &merkle_tree_map_storage<FieldT>::get_node(
+    size_t layer, size_t index) const
+{
+    const auto it = nodes.find(heap_index(layer, index));
+    return (it == nodes.end()) ? layer_defaults[layer] : it->second;
+}
+
+template<typename FieldT>
+void merkle_tree_map_storage<FieldT>::set_node(
+    size_t layer, size_t index, const FieldT &value)
+{
+    nodes[heap_index(layer, index)] = value;
+}
+
+template<typename FieldT>
+size_t merkle_tree_map_storage<FieldT>::layer_size(size_t layer) const
+{
+    // Find the last node (if any) with heap index below the start of the next
+    // layer.
+    auto it = nodes.lower_bound(heap_index(layer + 1, 0));
+    if (it == nodes.begin()) {
+        return 0;
+    }
+    --it;
+    const size_t layer_begin = heap_index(layer, 0);
+    return (it->first < layer_begin) ? 0 : it->first - layer_begin + 1;
+}
+
+template<typename FieldT>
+size_t merkle_tree_map_storage<FieldT>::heap_index(size_t layer, size_t index)
+{
+    assert(index < (1ul << layer));
+    return (1ul << layer) - 1 + index;
+}
+
+} // namespace libzeth
+
+#endif // __ZETH_CORE_MERKLE_TREE_STORAGE_TCC__
@@ -10,6 +10,104 @@
 namespace libzeth
 {
 
+/// Coordinates in which the bucket method accumulates the buckets.
+enum multi_exp_accumulation {
+    /// Choose based on the number of elements.
+    multi_exp_accumulation_auto,
+    /// Jacobian coordinates, adding each group element with a mixed addition.
+    multi_exp_accumulation_jacobian,
+    /// Affine coordinates. Additions to distinct buckets are collected into
+    /// batches, which share a single field inversion (Montgomery's trick).
+    /// Additions to a bucket which already has a pending addition in the
+    /// batch (and additions of elements not in affine form) fall back to
+    /// Jacobian coordinates. Only used for groups with
+    /// group_coordinates<GroupT>::jacobian_a0 set. Other groups always use
+    /// the group operations.
+    multi_exp_accumulation_batch_affine,
+};
+
+/// Multi-exponentiation (multi-scalar multiplication) engine, computing
+/// sum_i fs[i] * gs[i] using the bucket method (Pippenger's algorithm).
+///
+/// Scalars are recoded into signed digits (Booth encoding) of c bits, where
+/// the window size c is chosen from the number of elements, so that
+/// 2^(c-1) buckets are required per window. When built with MULTICORE, the
+/// windows, and chunks of the input within each window, are processed in
+/// parallel.
+///
+/// For groups with a GLV endomorphism phi (see glv_parameters), each term
+/// k * P is replaced by k1 * P + k2 * phi(P) for half-size scalars k1 and
+/// k2, halving the number of windows.
+///
+/// Group elements are accumulated into buckets as described by
+/// `accumulation`. Group elements in affine form (as is the case for proving
+/// keys) are cheaper to accumulate than elements in Jacobian form.
+template<typename FieldT, typename GroupT>
+GroupT multi_exp(
+    const GroupT *gs,
+    const FieldT *fs,
+    const size_t num_elements,
+    const multi_exp_accumulation accumulation = multi_exp_accumulation_auto);
+
+/// Multi-exponentiation for scalars of which many are 0, 1 or small (less
+/// than 2^64), as is the case for circuit assignments in which many
+/// variables are bits or 64-bit values. Scalars are sorted into these
+/// classes: elements with scalar 0 are skipped, elements with scalar 1 are
+/// summed directly, and small and full-size scalars are handled by the bucket
+/// method (see multi_exp) with a number of windows corresponding to their
+/// size.
+template<typename FieldT, typename GroupT>
+GroupT multi_exp_classified(
+    const GroupT *gs,
+    const FieldT *fs,
+    const size_t num_elements,
+    const multi_exp_accumulation accumulation = multi_exp_accumulation_auto);
+
+/// Multi-exponentiations of several vectors of scalars against the same
+/// group elements, computing sum_i fs[k][i] * gs[i] for each k. The group
+/// elements are read in a single pass, each element being accumulated for
+/// all vectors of scalars at once (rather than once per vector), so that the
+/// cost of reading large arrays of group elements from memory is shared.
+template<typename FieldT, typename GroupT>
+std::vector<GroupT> multi_exp_batch(
+    const GroupT *gs,
+    const std::vector<const FieldT *> &fs,
+    const size_t num_elements,
+    const multi_exp_accumulation accumulation = multi_exp_accumulation_auto);
+
+/// Number of windows of a table for multi_exp_precomputed, with the given
+/// window size, for scalars in FieldT.
+template<typename FieldT>
+size_t multi_exp_precomputed_num_windows(const size_t window_size);
+
+/// Precompute the table used by multi_exp_precomputed for the given bases.
+/// For each base P_i, the table holds 2^(j * window_size) * P_i (in affine
+/// form) at index i * num_windows + j, for 0 <= j < num_windows, so that
+/// `table` must have space for num_bases * num_windows elements.
+template<typename GroupT>
+void multi_exp_precompute(
+    const GroupT *bases,
+    const size_t num_bases,
+    const size_t window_size,
+    const size_t num_windows,
+    GroupT *table);
+
+/// Multi-exponentiation sum_i fs[i] * P_i, for bases P_i given by a table
+/// computed by multi_exp_precompute. Since the multiples of each base for
+/// every window are precomputed, all windows share a single set of buckets
+/// and no doublings are required to combine them. The window size is fixed
+/// when the table is computed: larger windows give smaller tables, at the
+/// cost of more buckets. Throws std::invalid_argument if the table does not
+/// have enough windows for scalars in FieldT.
+template<typename FieldT, typename GroupT>
+GroupT multi_exp_precomputed(
+    const GroupT *table,
+    const size_t window_size,
+    const size_t num_windows,
+    const FieldT *fs,
+    const size_t num_elements,
+    const multi_exp_accumulation accumulation = multi_exp_accumulation_auto);
+
 template<typename FieldT, typename GroupT>
 GroupT multi_exp(
     typename std::vector<GroupT>::const_iterator gs_start,
@@ -21,6 +119,61 @@ template<typename ppT, typename GroupT>
 GroupT multi_exp(
     const std::vector<GroupT> &gs, const libff::Fr_vector<ppT> &fs);
 
+namespace internal
+{
+
+/// Window size (in bits) used by the bucket method for the given number of
+/// elements.
+inline size_t multi_exp_window_size(const size_t num_elements);
+
+/// Core of the bucket method, where `points[i]` gives the i-th group element
+/// (allowing group elements to be read from structures other than arrays)
+/// and `scalars` are the bigint representations of the scalars, all of
+/// which are less than 2^scalar_bits.
+template<typename GroupT, typename PointsT, typename BigIntT>
+GroupT multi_exp_bucket(
+    const PointsT &points,
+    const BigIntT *scalars,
+    const size_t num_elements,
+    const size_t scalar_bits,
+    const multi_exp_accumulation accumulation = multi_exp_accumulation_auto);
+
+/// Core of multi_exp_batch, for (full-size) scalars of several sets, where
+/// scalars[s] gives the scalars of set s and the result for set s is written
+/// to results[s].
+template<typename GroupT, typename PointsT, typename BigIntT>
+void multi_exp_bucket_full_sets(
+    const PointsT &points,
+    const BigIntT *const *scalars,
+    const size_t num_sets,
+    const size_t num_elements,
+    const size_t scalar_bits,
+    const multi_exp_accumulation accumulation,
+    GroupT *results);
+
+/// Core of multi_exp_precomputed, where `table` is an accessor for the
+/// precomputed table, and scalars are given as for multi_exp_bucket.
+template<typename GroupT, typename PointsT, typename BigIntT>
+GroupT multi_exp_bucket_precomputed(
+    const PointsT &table,
+    const BigIntT *scalars,
+    const size_t num_elements,
+    const size_t c,
+    const size_t num_windows,
+    const multi_exp_accumulation accumulation = multi_exp_accumulation_auto);
+
+/// Core of multi_exp_classified, where points and scalars are given as for
+/// multi_exp_bucket.
+template<typename GroupT, typename PointsT, typename BigIntT>
+GroupT multi_exp_bucket_classified(
+    const PointsT &points,
+    const BigIntT *scalars,
+    const size_t num_elements,
+    const size_t scalar_bits,
+    const multi_exp_accumulation accumulation = multi_exp_accumulation_auto);
+
+} // namespace internal
+
 } // namespace libzeth
 
 #include "libzeth/core/multi_exp.tcc"
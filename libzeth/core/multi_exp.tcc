@@ -5,11 +5,883 @@
 #ifndef __ZETH_CORE_MULTI_EXP_TCC__
 #define __ZETH_CORE_MULTI_EXP_TCC__
 
+#include "libzeth/core/field_batch.hpp"
+#include "libzeth/core/glv.hpp"
+#include "libzeth/core/group_coordinates.hpp"
+#include "libzeth/core/group_element_utils.hpp"
 #include "libzeth/core/multi_exp.hpp"
 
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#ifdef MULTICORE
+#include <omp.h>
+#endif
+
 namespace libzeth
 {
 
+namespace internal
+{
+
+inline size_t multi_exp_window_size(const size_t num_elements)
+{
+    if (num_elements < 32) {
+        return 3;
+    }
+    // Approximately ln(num_elements) + 2, balancing the cost of adding each
+    // element to a bucket against the cost of summing the buckets.
+    return (libff::log2(num_elements) * 69) / 100 + 2;
+}
+
+// Bits [start, start + num_bits) of a bigint (num_bits < 64), where bits
+// beyond the most significant limb are zero.
+template<typename BigIntT>
+uint64_t multi_exp_get_bits(
+    const BigIntT &bigint, const size_t start, const size_t num_bits)
+{
+    const size_t limb_bits = 8 * sizeof(bigint.data[0]);
+    const size_t num_limbs = sizeof(bigint.data) / sizeof(bigint.data[0]);
+    const size_t limb = start / limb_bits;
+    const size_t shift = start % limb_bits;
+    if (limb >= num_limbs) {
+        return 0;
+    }
+
+    uint64_t bits = bigint.data[limb] >> shift;
+    if (shift + num_bits > limb_bits && limb + 1 < num_limbs) {
+        bits |= bigint.data[limb + 1] << (limb_bits - shift);
+    }
+    return bits & ((1ull << num_bits) - 1);
+}
+
+// Signed digit of a scalar for the given window, in the range
+// [-2^(c-1), 2^(c-1)]. Using Booth encoding, each digit is determined by the
+// c bits of the window and the most significant bit of the previous window:
+//
+//   d_w = (sum_{j<c} b_{wc+j} 2^j) + b_{wc-1} - 2^c b_{wc+c-1}
+//
+// so that the sum of d_w 2^(wc) telescopes to the scalar, and digits can be
+// computed independently for each window.
+template<typename BigIntT>
+int64_t multi_exp_booth_digit(
+    const BigIntT &scalar, const size_t window, const size_t c)
+{
+    const size_t start = window * c;
+    const uint64_t bits = (start == 0)
+                              ? multi_exp_get_bits(scalar, 0, c) << 1
+                              : multi_exp_get_bits(scalar, start - 1, c + 1);
+    return (int64_t)((bits + 1) >> 1) - (int64_t)((bits >> c) << c);
+}
+
+template<typename GroupT>
+void multi_exp_add_to_bucket(GroupT &bucket, const GroupT &point)
+{
+    // mixed_add requires its argument to be in affine form.
+    if (point.is_special()) {
+        bucket = bucket.mixed_add(point);
+    } else {
+        bucket = bucket + point;
+    }
+}
+
+// Sum each (k + 1) * buckets[s * num_buckets + k] into set_sums[s], computed
+// as a sum of running sums.
+template<typename GroupT>
+void multi_exp_sum_buckets(
+    const std::vector<GroupT> &buckets,
+    const size_t num_sets,
+    const size_t num_buckets,
+    GroupT *set_sums)
+{
+    for (size_t set = 0; set < num_sets; ++set) {
+        const GroupT *set_buckets = buckets.data() + set * num_buckets;
+        GroupT running_sum = GroupT::zero();
+        GroupT window_sum = GroupT::zero();
+        for (size_t k = num_buckets; k-- > 0;) {
+            running_sum = running_sum + set_buckets[k];
+            window_sum = window_sum + running_sum;
+        }
+        set_sums[set] = window_sum;
+    }
+}
+
+// Sums of digits(e) * points[e / num_sets] over the entries e in [begin,
+// end), where each digit is in the range [-2^(c-1), 2^(c-1)] (for example,
+// the digits of a single window). The entries of each set s (those with e %
+// num_sets == s) are summed separately, into set_sums[s]. Consecutive entries
+// share a point, so that each point is read once for all sets.
+template<typename GroupT, typename PointsT, typename DigitsT>
+void multi_exp_bucket_window(
+    const PointsT &points,
+    const DigitsT &digits,
+    const size_t num_sets,
+    const size_t begin,
+    const size_t end,
+    const size_t c,
+    GroupT *set_sums)
+{
+    // buckets[s * num_buckets + k] holds the sum of points of set s with
+    // digit +/-(k + 1)
+    const size_t num_buckets = 1ul << (c - 1);
+    std::vector<GroupT> buckets(num_sets * num_buckets, GroupT::zero());
+    for (size_t e = begin; e < end; ++e) {
+        const int64_t digit = digits(e);
+        const size_t i = e / num_sets;
+        const size_t set_offset = (e % num_sets) * num_buckets;
+        if (digit > 0) {
+            multi_exp_add_to_bucket(
+                buckets[set_offset + digit - 1], points[i]);
+        } else if (digit < 0) {
+            multi_exp_add_to_bucket(
+                buckets[set_offset - digit - 1], -points[i]);
+        }
+    }
+
+    multi_exp_sum_buckets(buckets, num_sets, num_buckets, set_sums);
+}
+
+// As multi_exp_bucket_window, accumulating buckets in affine coordinates.
+// Each bucket holds at most one pending addition in the current batch.
+// Further additions to such buckets (and additions of points not in affine
+// form) are accumulated in Jacobian "overflow" buckets instead. Only for
+// groups with group_coordinates<GroupT>::jacobian_a0 set, since the slope of
+// a doubling is computed as 3x^2 / 2y.
+template<typename GroupT, typename PointsT, typename DigitsT>
+void multi_exp_bucket_window_batch_affine(
+    const PointsT &points,
+    const DigitsT &digits,
+    const size_t num_sets,
+    const size_t begin,
+    const size_t end,
+    const size_t c,
+    GroupT *set_sums)
+{
+    using coordinate_t =
+        typename std::decay<decltype(std::declval<GroupT>().X)>::type;
+
+    const size_t set_buckets = 1ul << (c - 1);
+    const size_t num_buckets = num_sets * set_buckets;
+    std::vector<coordinate_t> bucket_x(num_buckets);
+    std::vector<coordinate_t> bucket_y(num_buckets);
+    std::vector<uint8_t> bucket_empty(num_buckets, 1);
+    std::vector<uint8_t> bucket_pending(num_buckets, 0);
+    std::vector<GroupT> overflow(num_buckets, GroupT::zero());
+
+    // Pending additions of (x, y) to bucket_x/y[bucket]
+    const size_t batch_size =
+        std::max<size_t>(1, std::min<size_t>(256, num_buckets / 8));
+    std::vector<size_t> batch_buckets;
+    std::vector<coordinate_t> batch_x;
+    std::vector<coordinate_t> batch_y;
+    std::vector<coordinate_t> denominators;
+    batch_buckets.reserve(batch_size);
+    batch_x.reserve(batch_size);
+    batch_y.reserve(batch_size);
+    denominators.reserve(batch_size);
+
+    const auto flush = [&]() {
+        // Compute the denominator of the slope for each addition (or
+        // doubling). Additions of a point to its negation give zero and
+        // require no inversion (a placeholder of 1 is used).
+        denominators.clear();
+        for (size_t j = 0; j < batch_buckets.size(); ++j) {
+            const size_t k = batch_buckets[j];
+            if (bucket_x[k] != batch_x[j]) {
+                denominators.push_back(batch_x[j] - bucket_x[k]);
+            } else if (bucket_y[k] == batch_y[j]) {
+                denominators.push_back(bucket_y[k] + bucket_y[k]);
+            } else {
+                denominators.push_back(coordinate_t::one());
+            }
+        }
+        field_batch_inverse(denominators.data(), denominators.size());
+
+        for (size_t j = 0; j < batch_buckets.size(); ++j) {
+            const size_t k = batch_buckets[j];
+            bucket_pending[k] = 0;
+            coordinate_t lambda;
+            if (bucket_x[k] != batch_x[j]) {
+                lambda = (batch_y[j] - bucket_y[k]) * denominators[j];
+            } else if (bucket_y[k] == batch_y[j]) {
+                const coordinate_t x_squared = bucket_x[k].squared();
+                lambda = (x_squared + x_squared + x_squared) * denominators[j];
+            } else {
+                bucket_empty[k] = 1;
+                continue;
+            }
+
+            const coordinate_t x = lambda.squared() - bucket_x[k] - batch_x[j];
+            bucket_y[k] = lambda * (bucket_x[k] - x) - bucket_y[k];
+            bucket_x[k] = x;
+        }
+
+        batch_buckets.clear();
+        batch_x.clear();
+        batch_y.clear();
+    };
+
+    for (size_t e = begin; e < end; ++e) {
+        const int64_t digit = digits(e);
+        if (digit == 0) {
+            continue;
+        }
+
+        const GroupT &point = points[e / num_sets];
+        const size_t k = (e % num_sets) * set_buckets +
+                         ((digit > 0) ? digit - 1 : -digit - 1);
+        if (point.is_zero()) {
+            continue;
+        }
+        if (bucket_pending[k] || !point.is_special()) {
+            multi_exp_add_to_bucket(overflow[k], (digit > 0) ? point : -point);
+            continue;
+        }
+
+        const coordinate_t y = (digit > 0) ? point.Y : -point.Y;
+        if (bucket_empty[k]) {
+            bucket_x[k] = point.X;
+            bucket_y[k] = y;
+            bucket_empty[k] = 0;
+            continue;
+        }
+
+        batch_buckets.push_back(k);
+        batch_x.push_back(point.X);
+        batch_y.push_back(y);
+        bucket_pending[k] = 1;
+        if (batch_buckets.size() == batch_size) {
+            flush();
+        }
+    }
+    flush();
+
+    // Merge the affine buckets into the overflow buckets.
+    for (size_t k = 0; k < num_buckets; ++k) {
+        if (!bucket_empty[k]) {
+            overflow[k] = overflow[k].mixed_add(
+                GroupT(bucket_x[k], bucket_y[k], coordinate_t::one()));
+        }
+    }
+    multi_exp_sum_buckets(overflow, num_sets, set_buckets, set_sums);
+}
+
+template<typename GroupT>
+bool multi_exp_use_batch_affine(
+    const multi_exp_accumulation accumulation, const size_t c)
+{
+    if (!group_coordinates<GroupT>::jacobian_a0) {
+        return false;
+    }
+
+    // With fewer buckets, batches are small (so that the cost of the
+    // inversion is not amortized) or conflicts are frequent.
+    return (accumulation == multi_exp_accumulation_batch_affine) ||
+           (accumulation == multi_exp_accumulation_auto && c >= 10);
+}
+
+// Call multi_exp_bucket_window_batch_affine if batch_affine is set (see
+// multi_exp_use_batch_affine), and multi_exp_bucket_window otherwise. The
+// former is only instantiated for groups which support it.
+template<typename GroupT, typename PointsT, typename DigitsT>
+void multi_exp_bucket_window_accumulate(
+    const bool batch_affine,
+    const PointsT &points,
+    const DigitsT &digits,
+    const size_t num_sets,
+    const size_t begin,
+    const size_t end,
+    const size_t c,
+    GroupT *set_sums,
+    std::true_type /* jacobian_a0 */)
+{
+    if (batch_affine) {
+        multi_exp_bucket_window_batch_affine<GroupT>(
+            points, digits, num_sets, begin, end, c, set_sums);
+    } else {
+        multi_exp_bucket_window<GroupT>(
+            points, digits, num_sets, begin, end, c, set_sums);
+    }
+}
+
+template<typename GroupT, typename PointsT, typename DigitsT>
+void multi_exp_bucket_window_accumulate(
+    const bool batch_affine,
+    const PointsT &points,
+    const DigitsT &digits,
+    const size_t num_sets,
+    const size_t begin,
+    const size_t end,
+    const size_t c,
+    GroupT *set_sums,
+    std::false_type /* jacobian_a0 */)
+{
+    assert(!batch_affine);
+    (void)batch_affine;
+    multi_exp_bucket_window<GroupT>(
+        points, digits, num_sets, begin, end, c, set_sums);
+}
+
+// Bucket method for several sets of scalars against the same points, where
+// scalars[s][i] is the i-th scalar of set s, and is negated if negate is not
+// null and negate[s][i] is set. The result for set s is written to
+// results[s].
+template<typename GroupT, typename PointsT, typename BigIntT>
+void multi_exp_bucket_sets(
+    const PointsT &points,
+    const BigIntT *const *scalars,
+    const uint8_t *const *negate,
+    const size_t num_sets,
+    const size_t num_elements,
+    const size_t scalar_bits,
+    const multi_exp_accumulation accumulation,
+    GroupT *results)
+{
+    if (num_elements == 0) {
+        std::fill(results, results + num_sets, GroupT::zero());
+        return;
+    }
+
+    // The most significant window must have a zero top bit, so that no carry
+    // is required beyond it.
+    const size_t c = multi_exp_window_size(num_elements);
+    const size_t num_windows = (scalar_bits + 1 + c - 1) / c;
+    const bool batch_affine =
+        multi_exp_use_batch_affine<GroupT>(accumulation, c);
+
+    // Each (window, chunk) pair is an independent task. Chunks are only used
+    // when there are fewer windows than threads, and are kept large enough
+    // to amortize the cost of summing the buckets.
+    size_t num_chunks = 1;
+#ifdef MULTICORE
+    const size_t num_threads = (size_t)omp_get_max_threads();
+    num_chunks = (num_threads + num_windows - 1) / num_windows;
+    num_chunks = std::min(
+        num_chunks, std::max<size_t>(1, num_elements >> (c - 1)));
+#endif
+    const size_t chunk_size = (num_elements + num_chunks - 1) / num_chunks;
+    const size_t num_tasks = num_windows * num_chunks;
+
+    // Within each task, the entries for each element (one per set) are
+    // consecutive.
+    std::vector<GroupT> task_sums(num_tasks * num_sets);
+#ifdef MULTICORE
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (size_t task = 0; task < num_tasks; ++task) {
+        const size_t window = task / num_chunks;
+        const size_t begin = (task % num_chunks) * chunk_size;
+        const size_t end = std::max(
+            begin, std::min(begin + chunk_size, num_elements));
+        const auto digits =
+            [scalars, negate, num_sets, window, c](const size_t e) {
+                const size_t set = e % num_sets;
+                const size_t i = e / num_sets;
+                const int64_t digit =
+                    multi_exp_booth_digit(scalars[set][i], window, c);
+                return (negate != nullptr && negate[set][i]) ? -digit : digit;
+            };
+        GroupT *const sums = task_sums.data() + task * num_sets;
+        multi_exp_bucket_window_accumulate<GroupT>(
+            batch_affine,
+            points,
+            digits,
+            num_sets,
+            begin * num_sets,
+            end * num_sets,
+            c,
+            sums,
+            group_jacobian_a0_tag<GroupT>());
+    }
+
+    // Combine the windows, from the most significant.
+    for (size_t set = 0; set < num_sets; ++set) {
+        GroupT result = GroupT::zero();
+        for (size_t window = num_windows; window-- > 0;) {
+            for (size_t i = 0; i < c; ++i) {
+                result = result.dbl();
+            }
+            for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+                const size_t task = window * num_chunks + chunk;
+                result = result + task_sums[task * num_sets + set];
+            }
+        }
+        results[set] = result;
+    }
+}
+
+template<typename GroupT, typename PointsT, typename BigIntT>
+GroupT multi_exp_bucket(
+    const PointsT &points,
+    const BigIntT *scalars,
+    const size_t num_elements,
+    const size_t scalar_bits,
+    const multi_exp_accumulation accumulation)
+{
+    GroupT result;
+    multi_exp_bucket_sets<GroupT>(
+        points,
+        &scalars,
+        nullptr,
+        1,
+        num_elements,
+        scalar_bits,
+        accumulation,
+        &result);
+    return result;
+}
+
+template<typename GroupT, typename PointsT, typename BigIntT>
+GroupT multi_exp_bucket_precomputed(
+    const PointsT &table,
+    const BigIntT *scalars,
+    const size_t num_elements,
+    const size_t c,
+    const size_t num_windows,
+    const multi_exp_accumulation accumulation)
+{
+    // Entry e of the table is 2^(jc) * P_i, for i = e / num_windows and j = e
+    // % num_windows, and is multiplied by the j-th digit of the i-th scalar.
+    // All entries are therefore summed into a single set of buckets.
+    const size_t num_entries = num_elements * num_windows;
+    const auto digits = [scalars, num_windows, c](const size_t e) {
+        return multi_exp_booth_digit(
+            scalars[e / num_windows], e % num_windows, c);
+    };
+    const bool batch_affine =
+        multi_exp_use_batch_affine<GroupT>(accumulation, c);
+
+    // Chunks are kept large enough to amortize the cost of summing the
+    // buckets.
+    size_t num_chunks = 1;
+#ifdef MULTICORE
+    num_chunks = std::min(
+        (size_t)omp_get_max_threads(),
+        std::max<size_t>(1, num_entries >> (c - 1)));
+#endif
+    const size_t chunk_size = (num_entries + num_chunks - 1) / num_chunks;
+
+    std::vector<GroupT> chunk_sums(num_chunks, GroupT::zero());
+#ifdef MULTICORE
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+        const size_t begin = std::min(chunk * chunk_size, num_entries);
+        const size_t end = std::min(begin + chunk_size, num_entries);
+        multi_exp_bucket_window_accumulate<GroupT>(
+            batch_affine,
+            table,
+            digits,
+            1,
+            begin,
+            end,
+            c,
+            &chunk_sums[chunk],
+            group_jacobian_a0_tag<GroupT>());
+    }
+
+    GroupT result = GroupT::zero();
+    for (const GroupT &chunk_sum : chunk_sums) {
+        result = result + chunk_sum;
+    }
+    return result;
+}
+
+// Accessor for a subset of the points of another accessor.
+template<typename GroupT, typename PointsT> class multi_exp_indexed_points
+{
+public:
+    multi_exp_indexed_points(
+        const PointsT &points, const std::vector<size_t> &indices)
+        : points(points), indices(indices)
+    {
+    }
+    const GroupT &operator[](const size_t i) const
+    {
+        return points[indices[i]];
+    }
+
+private:
+    const PointsT &points;
+    const std::vector<size_t> &indices;
+};
+
+// Points P_0, ..., P_{n-1}, phi(P_0), ..., phi(P_{n-1}) for the GLV
+// endomorphism phi. The images phi(P_i) are computed once, rather than on
+// each pass over the points (one per window).
+template<typename GroupT, typename PointsT> class multi_exp_glv_points
+{
+public:
+    multi_exp_glv_points(const PointsT &points, const size_t num_elements)
+        : points(points), images(num_elements)
+    {
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+        for (size_t i = 0; i < num_elements; ++i) {
+            images[i] = glv_endomorphism(points[i]);
+        }
+    }
+    const GroupT &operator[](const size_t i) const
+    {
+        return (i < images.size()) ? points[i] : images[i - images.size()];
+    }
+
+private:
+    const PointsT &points;
+    std::vector<GroupT> images;
+};
+
+// As multi_exp_bucket_sets, where each scalar k_i is decomposed as k1_i +
+// lambda * k2_i, and the sum of k1_i * P_i + k2_i * phi(P_i) is computed for
+// half-size scalars k1_i and k2_i (with signs applied to the digits).
+template<typename GroupT, typename PointsT, typename BigIntT>
+void multi_exp_bucket_glv_sets(
+    const PointsT &points,
+    const BigIntT *const *scalars,
+    const size_t num_sets,
+    const size_t num_elements,
+    const multi_exp_accumulation accumulation,
+    GroupT *results)
+{
+    std::vector<std::vector<BigIntT>> half_scalars(
+        num_sets, std::vector<BigIntT>(2 * num_elements));
+    std::vector<std::vector<uint8_t>> negate(
+        num_sets, std::vector<uint8_t>(2 * num_elements));
+
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < num_elements; ++i) {
+        for (size_t set = 0; set < num_sets; ++set) {
+            const glv_scalar<GroupT> decomposed =
+                glv_decompose<GroupT>(scalars[set][i]);
+            half_scalars[set][i] = decomposed.k1;
+            half_scalars[set][num_elements + i] = decomposed.k2;
+            negate[set][i] = decomposed.k1_negative;
+            negate[set][num_elements + i] = decomposed.k2_negative;
+        }
+    }
+
+    size_t half_scalar_bits = 0;
+    std::vector<const BigIntT *> half_scalar_ptrs(num_sets);
+    std::vector<const uint8_t *> negate_ptrs(num_sets);
+    for (size_t set = 0; set < num_sets; ++set) {
+        for (const BigIntT &half_scalar : half_scalars[set]) {
+            half_scalar_bits =
+                std::max(half_scalar_bits, half_scalar.num_bits());
+        }
+        half_scalar_ptrs[set] = half_scalars[set].data();
+        negate_ptrs[set] = negate[set].data();
+    }
+
+    const multi_exp_glv_points<GroupT, PointsT> glv_points(
+        points, num_elements);
+    multi_exp_bucket_sets<GroupT>(
+        glv_points,
+        half_scalar_ptrs.data(),
+        negate_ptrs.data(),
+        num_sets,
+        2 * num_elements,
+        half_scalar_bits,
+        accumulation,
+        results);
+}
+
+template<typename GroupT, typename PointsT, typename BigIntT>
+void multi_exp_bucket_full_sets(
+    const PointsT &points,
+    const BigIntT *const *scalars,
+    const size_t num_sets,
+    const size_t num_elements,
+    const size_t scalar_bits,
+    const multi_exp_accumulation accumulation,
+    GroupT *results,
+    std::false_type)
+{
+    multi_exp_bucket_sets<GroupT>(
+        points,
+        scalars,
+        nullptr,
+        num_sets,
+        num_elements,
+        scalar_bits,
+        accumulation,
+        results);
+}
+
+template<typename GroupT, typename PointsT, typename BigIntT>
+void multi_exp_bucket_full_sets(
+    const PointsT &points,
+    const BigIntT *const *scalars,
+    const size_t num_sets,
+    const size_t num_elements,
+    const size_t /* scalar_bits */,
+    const multi_exp_accumulation accumulation,
+    GroupT *results,
+    std::true_type)
+{
+    multi_exp_bucket_glv_sets<GroupT>(
+        points, scalars, num_sets, num_elements, accumulation, results);
+}
+
+template<typename GroupT, typename PointsT, typename BigIntT>
+void multi_exp_bucket_full_sets(
+    const PointsT &points,
+    const BigIntT *const *scalars,
+    const size_t num_sets,
+    const size_t num_elements,
+    const size_t scalar_bits,
+    const multi_exp_accumulation accumulation,
+    GroupT *results)
+{
+    multi_exp_bucket_full_sets<GroupT>(
+        points,
+        scalars,
+        num_sets,
+        num_elements,
+        scalar_bits,
+        accumulation,
+        results,
+        std::integral_constant<bool, glv_parameters<GroupT>::enabled>());
+}
+
+// Bucket method for (full-size) elements of the scalar field, using the GLV
+// endomorphism where GroupT has one.
+template<typename GroupT, typename PointsT, typename BigIntT>
+GroupT multi_exp_bucket_full(
+    const PointsT &points,
+    const BigIntT *scalars,
+    const size_t num_elements,
+    const size_t scalar_bits,
+    const multi_exp_accumulation accumulation)
+{
+    GroupT result;
+    multi_exp_bucket_full_sets<GroupT>(
+        points, &scalars, 1, num_elements, scalar_bits, accumulation, &result);
+    return result;
+}
+
+// Sum of the first num_elements points.
+template<typename GroupT, typename PointsT>
+GroupT multi_exp_sum(const PointsT &points, const size_t num_elements)
+{
+    size_t num_chunks = 1;
+#ifdef MULTICORE
+    num_chunks = (size_t)omp_get_max_threads();
+#endif
+    const size_t chunk_size = (num_elements + num_chunks - 1) / num_chunks;
+
+    std::vector<GroupT> chunk_sums(num_chunks, GroupT::zero());
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+        const size_t begin = chunk * chunk_size;
+        const size_t end = std::min(begin + chunk_size, num_elements);
+        for (size_t i = begin; i < end; ++i) {
+            multi_exp_add_to_bucket(chunk_sums[chunk], points[i]);
+        }
+    }
+
+    GroupT result = GroupT::zero();
+    for (const GroupT &chunk_sum : chunk_sums) {
+        result = result + chunk_sum;
+    }
+    return result;
+}
+
+template<typename GroupT, typename PointsT, typename BigIntT>
+GroupT multi_exp_bucket_classified(
+    const PointsT &points,
+    const BigIntT *scalars,
+    const size_t num_elements,
+    const size_t scalar_bits,
+    const multi_exp_accumulation accumulation)
+{
+    // Small scalars are those with a single (non-zero) limb.
+    const size_t limb_bits = 8 * sizeof(scalars[0].data[0]);
+    const size_t num_limbs =
+        sizeof(scalars[0].data) / sizeof(scalars[0].data[0]);
+    using small_bigint = libff::bigint<1>;
+
+    std::vector<size_t> one_indices;
+    std::vector<size_t> small_indices;
+    std::vector<small_bigint> small_scalars;
+    std::vector<size_t> full_indices;
+    std::vector<BigIntT> full_scalars;
+    for (size_t i = 0; i < num_elements; ++i) {
+        const BigIntT &scalar = scalars[i];
+        bool is_small = true;
+        for (size_t limb = 1; limb < num_limbs; ++limb) {
+            if (scalar.data[limb] != 0) {
+                is_small = false;
+                break;
+            }
+        }
+
+        if (!is_small) {
+            full_indices.push_back(i);
+            full_scalars.push_back(scalar);
+        } else if (scalar.data[0] == 1) {
+            one_indices.push_back(i);
+        } else if (scalar.data[0] != 0) {
+            small_indices.push_back(i);
+            small_scalars.emplace_back();
+            small_scalars.back().data[0] = scalar.data[0];
+        }
+    }
+
+    using indexed_points = multi_exp_indexed_points<GroupT, PointsT>;
+    const GroupT ones_sum = multi_exp_sum<GroupT>(
+        indexed_points(points, one_indices), one_indices.size());
+    const GroupT small_sum = multi_exp_bucket<GroupT>(
+        indexed_points(points, small_indices),
+        small_scalars.data(),
+        small_scalars.size(),
+        limb_bits,
+        accumulation);
+    const GroupT full_sum = multi_exp_bucket_full<GroupT>(
+        indexed_points(points, full_indices),
+        full_scalars.data(),
+        full_scalars.size(),
+        scalar_bits,
+        accumulation);
+    return ones_sum + small_sum + full_sum;
+}
+
+// Bigint representations of scalars, as required by multi_exp_bucket.
+template<typename FieldT>
+std::vector<libff::bigint<FieldT::num_limbs>> multi_exp_scalars(
+    const FieldT *fs, const size_t num_elements)
+{
+    std::vector<libff::bigint<FieldT::num_limbs>> scalars(num_elements);
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < num_elements; ++i) {
+        scalars[i] = fs[i].as_bigint();
+    }
+    return scalars;
+}
+
+} // namespace internal
+
+template<typename FieldT, typename GroupT>
+GroupT multi_exp(
+    const GroupT *gs,
+    const FieldT *fs,
+    const size_t num_elements,
+    const multi_exp_accumulation accumulation)
+{
+    const std::vector<libff::bigint<FieldT::num_limbs>> scalars =
+        internal::multi_exp_scalars(fs, num_elements);
+    return internal::multi_exp_bucket_full<GroupT>(
+        gs, scalars.data(), num_elements, FieldT::num_bits, accumulation);
+}
+
+template<typename FieldT, typename GroupT>
+GroupT multi_exp_classified(
+    const GroupT *gs,
+    const FieldT *fs,
+    const size_t num_elements,
+    const multi_exp_accumulation accumulation)
+{
+    const std::vector<libff::bigint<FieldT::num_limbs>> scalars =
+        internal::multi_exp_scalars(fs, num_elements);
+    return internal::multi_exp_bucket_classified<GroupT>(
+        gs, scalars.data(), num_elements, FieldT::num_bits, accumulation);
+}
+
+template<typename FieldT, typename GroupT>
+std::vector<GroupT> multi_exp_batch(
+    const GroupT *gs,
+    const std::vector<const FieldT *> &fs,
+    const size_t num_elements,
+    const multi_exp_accumulation accumulation)
+{
+    using bigint_type = libff::bigint<FieldT::num_limbs>;
+    const size_t num_sets = fs.size();
+    std::vector<std::vector<bigint_type>> scalars(num_sets);
+    std::vector<const bigint_type *> scalar_ptrs(num_sets);
+    for (size_t set = 0; set < num_sets; ++set) {
+        scalars[set] = internal::multi_exp_scalars(fs[set], num_elements);
+        scalar_ptrs[set] = scalars[set].data();
+    }
+
+    std::vector<GroupT> results(num_sets);
+    if (num_sets > 0) {
+        internal::multi_exp_bucket_full_sets<GroupT>(
+            gs,
+            scalar_ptrs.data(),
+            num_sets,
+            num_elements,
+            FieldT::num_bits,
+            accumulation,
+            results.data());
+    }
+    return results;
+}
+
+template<typename FieldT>
+size_t multi_exp_precomputed_num_windows(const size_t window_size)
+{
+    return (FieldT::num_bits + 1 + window_size - 1) / window_size;
+}
+
+template<typename GroupT>
+void multi_exp_precompute(
+    const GroupT *bases,
+    const size_t num_bases,
+    const size_t window_size,
+    const size_t num_windows,
+    GroupT *table)
+{
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < num_bases; ++i) {
+        GroupT *entries = table + i * num_windows;
+        entries[0] = bases[i];
+        for (size_t j = 1; j < num_windows; ++j) {
+            entries[j] = entries[j - 1];
+            for (size_t k = 0; k < window_size; ++k) {
+                entries[j] = entries[j].dbl();
+            }
+        }
+    }
+
+    batch_to_affine(table, num_bases * num_windows);
+}
+
+template<typename FieldT, typename GroupT>
+GroupT multi_exp_precomputed(
+    const GroupT *table,
+    const size_t window_size,
+    const size_t num_windows,
+    const FieldT *fs,
+    const size_t num_elements,
+    const multi_exp_accumulation accumulation)
+{
+    if (window_size < 2 || window_size > 30 ||
+        num_windows < multi_exp_precomputed_num_windows<FieldT>(window_size)) {
+        throw std::invalid_argument("invalid precomputed table dimensions");
+    }
+
+    const std::vector<libff::bigint<FieldT::num_limbs>> scalars =
+        internal::multi_exp_scalars(fs, num_elements);
+    return internal::multi_exp_bucket_precomputed<GroupT>(
+        table,
+        scalars.data(),
+        num_elements,
+        window_size,
+        num_windows,
+        accumulation);
+}
+
 template<typename FieldT, typename GroupT>
 GroupT multi_exp(
     typename std::vector<GroupT>::const_iterator gs_start,
@@ -17,9 +889,13 @@ GroupT multi_exp(
     typename std::vector<FieldT>::const_iterator fs_start,
     typename std::vector<FieldT>::const_iterator fs_end)
 {
-    const libff::multi_exp_method Method = libff::multi_exp_method_BDLO12;
-    return libff::multi_exp_with_mixed_addition<GroupT, FieldT, Method>(
-        gs_start, gs_end, fs_start, fs_end, 1);
+    const size_t num_elements = fs_end - fs_start;
+    assert((size_t)(gs_end - gs_start) >= num_elements);
+    (void)gs_end;
+    if (num_elements == 0) {
+        return GroupT::zero();
+    }
+    return multi_exp<FieldT, GroupT>(&*gs_start, &*fs_start, num_elements);
 }
 
 template<typename ppT, typename GroupT>
@@ -28,10 +904,7 @@ GroupT multi_exp(const std::vector<GroupT> &gs, const libff::Fr_vector<ppT> &fs)
     assert(gs.size() >= fs.size());
     assert(gs.size() > 0);
 
-    using Fr = libff::Fr<ppT>;
-    const libff::multi_exp_method Method = libff::multi_exp_method_BDLO12;
-    return libff::multi_exp_with_mixed_addition<GroupT, Fr, Method>(
-        gs.begin(), gs.begin() + fs.size(), fs.begin(), fs.end(), 1);
+    return multi_exp<libff::Fr<ppT>, GroupT>(gs.data(), fs.data(), fs.size());
 }
 
 } // namespace libzeth
@@ -0,0 +1,80 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CORE_QAP_WITNESS_MAP_HPP__
+#define __ZETH_CORE_QAP_WITNESS_MAP_HPP__
+
+#include "libzeth/core/blocked_radix2_domain.hpp"
+#include "libzeth/core/include_libsnark.hpp"
+
+#include <libsnark/relations/arithmetic_programs/qap/qap.hpp>
+#include <memory>
+
+namespace libzeth
+{
+
+/// Buffers used by qap_witness_map_H. Their capacity is retained between
+/// calls, so that a workspace reused across witnesses for the same
+/// constraint system avoids allocating domain-sized vectors.
+template<typename FieldT> class qap_witness_workspace
+{
+public:
+    /// Evaluations (and then coefficients) of the A, B and C polynomials.
+    std::vector<FieldT> aA;
+    std::vector<FieldT> aB;
+    std::vector<FieldT> aC;
+    /// Scratch space for the transforms.
+    std::vector<FieldT> fft_scratch;
+    /// Variable assignment (primary inputs followed by auxiliary inputs).
+    libsnark::r1cs_variable_assignment<FieldT> variable_assignment;
+
+    /// Reserve space for a domain of size m, and the given number of
+    /// variables.
+    void reserve(const size_t m, const size_t num_variables);
+};
+
+/// Size of the (radix-2) QAP domain of a constraint system: the smallest
+/// power of 2 with room for the constraints and the input consistency
+/// constraints.
+template<typename FieldT>
+size_t qap_domain_size(const libsnark::r1cs_constraint_system<FieldT> &cs);
+
+/// Create a blocked_radix2_domain of size m (the size of the QAP domain
+/// used to generate a proving key), or return nullptr if m is not a power
+/// of 2. Keys generated by libsnark without forcing a power of 2 domain use
+/// the domain chosen by libfqfft::get_evaluation_domain, which may have size
+/// 2^k + 2^j (a step_radix2_domain). For such keys the QAP witness must be
+/// computed using libsnark::r1cs_to_qap_witness_map.
+template<typename FieldT>
+std::unique_ptr<blocked_radix2_domain<FieldT>> qap_radix2_domain(
+    const size_t m);
+
+/// Compute the QAP witness of an R1CS assignment, as
+/// libsnark::r1cs_to_qap_witness_map (with no zero-knowledge terms, and a
+/// radix-2 domain), using a blocked_radix2_domain for the FFTs. The domain
+/// has the smallest power of 2 size with room for the constraints and the
+/// input consistency constraints.
+template<typename FieldT>
+libsnark::qap_witness<FieldT> qap_witness_map(
+    const libsnark::r1cs_constraint_system<FieldT> &cs,
+    const libsnark::r1cs_primary_input<FieldT> &primary_input,
+    const libsnark::r1cs_auxiliary_input<FieldT> &auxiliary_input);
+
+/// Compute the coefficients of H (as in qap_witness_map) for the variable
+/// assignment held in workspace.variable_assignment, using the given domain
+/// (of size qap_domain_size(cs)) and the buffers of the workspace. The
+/// domain.m + 1 coefficients are written to coefficients_for_H, whose
+/// buffer may be exchanged with one of the workspace.
+template<typename FieldT>
+void qap_witness_map_H(
+    const blocked_radix2_domain<FieldT> &domain,
+    const libsnark::r1cs_constraint_system<FieldT> &cs,
+    qap_witness_workspace<FieldT> &workspace,
+    std::vector<FieldT> &coefficients_for_H);
+
+} // namespace libzeth
+
+#include "libzeth/core/qap_witness_map.tcc"
+
+#endif // __ZETH_CORE_QAP_WITNESS_MAP_HPP__
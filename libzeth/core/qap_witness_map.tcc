@@ -0,0 +1,135 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CORE_QAP_WITNESS_MAP_TCC__
+#define __ZETH_CORE_QAP_WITNESS_MAP_TCC__
+
+#include "libzeth/core/blocked_radix2_domain.hpp"
+#include "libzeth/core/field_batch.hpp"
+#include "libzeth/core/qap_witness_map.hpp"
+
+#include <stdexcept>
+
+namespace libzeth
+{
+
+template<typename FieldT>
+void qap_witness_workspace<FieldT>::reserve(
+    const size_t m, const size_t num_variables)
+{
+    // aA also holds the extra coefficient of H.
+    aA.reserve(m + 1);
+    aB.reserve(m);
+    aC.reserve(m);
+    fft_scratch.reserve(m);
+    variable_assignment.reserve(num_variables);
+}
+
+template<typename FieldT>
+size_t qap_domain_size(const libsnark::r1cs_constraint_system<FieldT> &cs)
+{
+    return 1ull << libff::log2(cs.num_constraints() + cs.num_inputs() + 1);
+}
+
+template<typename FieldT>
+std::unique_ptr<blocked_radix2_domain<FieldT>> qap_radix2_domain(
+    const size_t m)
+{
+    if (m < 2 || (m & (m - 1)) != 0) {
+        return nullptr;
+    }
+    return std::unique_ptr<blocked_radix2_domain<FieldT>>(
+        new blocked_radix2_domain<FieldT>(m));
+}
+
+template<typename FieldT>
+libsnark::qap_witness<FieldT> qap_witness_map(
+    const libsnark::r1cs_constraint_system<FieldT> &cs,
+    const libsnark::r1cs_primary_input<FieldT> &primary_input,
+    const libsnark::r1cs_auxiliary_input<FieldT> &auxiliary_input)
+{
+    const blocked_radix2_domain<FieldT> domain(qap_domain_size(cs));
+
+    qap_witness_workspace<FieldT> workspace;
+    workspace.variable_assignment = primary_input;
+    workspace.variable_assignment.insert(
+        workspace.variable_assignment.end(),
+        auxiliary_input.begin(),
+        auxiliary_input.end());
+
+    std::vector<FieldT> coefficients_for_H;
+    qap_witness_map_H(domain, cs, workspace, coefficients_for_H);
+
+    return libsnark::qap_witness<FieldT>(
+        cs.num_variables(),
+        domain.m,
+        cs.num_inputs(),
+        FieldT::zero(),
+        FieldT::zero(),
+        FieldT::zero(),
+        std::move(workspace.variable_assignment),
+        std::move(coefficients_for_H));
+}
+
+template<typename FieldT>
+void qap_witness_map_H(
+    const blocked_radix2_domain<FieldT> &domain,
+    const libsnark::r1cs_constraint_system<FieldT> &cs,
+    qap_witness_workspace<FieldT> &workspace,
+    std::vector<FieldT> &coefficients_for_H)
+{
+    const size_t num_constraints = cs.num_constraints();
+    const size_t num_inputs = cs.num_inputs();
+    const size_t m = domain.m;
+    if (m != qap_domain_size(cs)) {
+        throw std::invalid_argument("domain does not match constraint system");
+    }
+
+    const libsnark::r1cs_variable_assignment<FieldT> &full_variable_assignment =
+        workspace.variable_assignment;
+    std::vector<FieldT> &aA = workspace.aA;
+    std::vector<FieldT> &aB = workspace.aB;
+    std::vector<FieldT> &aC = workspace.aC;
+    std::vector<FieldT> &scratch = workspace.fft_scratch;
+
+    // Evaluations of A, B and C over the domain. The input consistency
+    // constraints input_i * 0 = 0 follow the constraints of cs.
+    aA.reserve(m + 1);
+    aA.assign(m, FieldT::zero());
+    aB.assign(m, FieldT::zero());
+    aC.assign(m, FieldT::zero());
+    for (size_t i = 0; i <= num_inputs; ++i) {
+        aA[i + num_constraints] =
+            (i > 0) ? full_variable_assignment[i - 1] : FieldT::one();
+    }
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < num_constraints; ++i) {
+        aA[i] = cs.constraints[i].a.evaluate(full_variable_assignment);
+        aB[i] = cs.constraints[i].b.evaluate(full_variable_assignment);
+        aC[i] = cs.constraints[i].c.evaluate(full_variable_assignment);
+    }
+
+    // Evaluations of A * B - C on the coset.
+    const FieldT &g = FieldT::multiplicative_generator;
+    for (std::vector<FieldT> *v : {&aA, &aB, &aC}) {
+        domain.iFFT(*v, scratch);
+        domain.cosetFFT(*v, g, scratch);
+    }
+    std::vector<FieldT> &H_tmp = aA;
+    field_batch_mul(H_tmp.data(), aA.data(), aB.data(), m);
+    field_batch_sub(H_tmp.data(), H_tmp.data(), aC.data(), m);
+
+    // H = (A * B - C) / Z, computed on the coset.
+    domain.divide_by_Z_on_coset(H_tmp);
+    domain.icosetFFT(H_tmp, g, scratch);
+
+    coefficients_for_H.swap(H_tmp);
+    coefficients_for_H.push_back(FieldT::zero());
+}
+
+} // namespace libzeth
+
+#endif // __ZETH_CORE_QAP_WITNESS_MAP_TCC__
@@ -0,0 +1,63 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CORE_R1CS_OPTIMIZER_HPP__
+#define __ZETH_CORE_R1CS_OPTIMIZER_HPP__
+
+#include "libzeth/core/include_libsnark.hpp"
+
+#include <vector>
+
+namespace libzeth
+{
+
+/// Result of r1cs_optimize: a constraint system equivalent to the original
+/// one, along with the origin of each of its variables. The primary inputs
+/// are unchanged, and each auxiliary variable is an auxiliary variable of the
+/// original system, so that an assignment for the optimized system is a
+/// projection of an assignment for the original system (e.g. as computed by
+/// the gadgets which generated it).
+template<typename FieldT> class r1cs_optimization
+{
+public:
+    libsnark::r1cs_constraint_system<FieldT> constraint_system;
+
+    /// Index, in the original system, of each auxiliary variable of
+    /// `constraint_system`.
+    std::vector<size_t> auxiliary_sources;
+
+    /// The auxiliary input of `constraint_system`, from the auxiliary input
+    /// of the original system.
+    libsnark::r1cs_auxiliary_input<FieldT> map_auxiliary_input(
+        const libsnark::r1cs_auxiliary_input<FieldT> &auxiliary_input) const;
+};
+
+/// Reduce the number of constraints and variables of a constraint system, by
+/// repeatedly:
+///
+/// - using linear constraints (in which A or B is constant) to express an
+///   auxiliary variable in terms of the other variables, substituting this
+///   expression for the variable in all other constraints, and removing the
+///   constraint and the variable. This includes constraints which alias one
+///   variable to another (e.g. those generated when copying variables).
+///
+/// - dropping constraints which are trivially satisfied (such as those in
+///   which all terms cancel after substitution).
+///
+/// Auxiliary variables which no longer appear in any constraint are then
+/// removed. Substitutions are only performed if they increase the total
+/// number of nonzero coefficients by at most `max_fill`, so that the density
+/// of the constraint system (which determines the cost of the witness map)
+/// does not grow. Throws std::invalid_argument if a constraint is found to be
+/// unsatisfiable.
+template<typename FieldT>
+r1cs_optimization<FieldT> r1cs_optimize(
+    const libsnark::r1cs_constraint_system<FieldT> &cs,
+    const size_t max_fill = 0);
+
+} // namespace libzeth
+
+#include "libzeth/core/r1cs_optimizer.tcc"
+
+#endif // __ZETH_CORE_R1CS_OPTIMIZER_HPP__
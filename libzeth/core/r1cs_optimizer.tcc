@@ -0,0 +1,420 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CORE_R1CS_OPTIMIZER_TCC__
+#define __ZETH_CORE_R1CS_OPTIMIZER_TCC__
+
+#include "libzeth/core/r1cs_optimizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <stdexcept>
+#include <string>
+
+namespace libzeth
+{
+
+namespace internal
+{
+
+template<typename FieldT>
+using r1cs_terms = std::vector<libsnark::linear_term<FieldT>>;
+
+// Sort terms by variable index, merging the terms of each variable and
+// removing those with a zero coefficient.
+template<typename FieldT>
+void r1cs_optimizer_normalize(r1cs_terms<FieldT> &terms)
+{
+    std::sort(
+        terms.begin(),
+        terms.end(),
+        [](const libsnark::linear_term<FieldT> &a,
+           const libsnark::linear_term<FieldT> &b) {
+            return a.index < b.index;
+        });
+
+    size_t out = 0;
+    size_t i = 0;
+    while (i < terms.size()) {
+        const size_t index = terms[i].index;
+        FieldT coeff = terms[i].coeff;
+        for (++i; i < terms.size() && terms[i].index == index; ++i) {
+            coeff += terms[i].coeff;
+        }
+        if (!coeff.is_zero()) {
+            terms[out].index = index;
+            terms[out].coeff = coeff;
+            ++out;
+        }
+    }
+    terms.erase(terms.begin() + out, terms.end());
+}
+
+// Position of the term for `index` in normalized terms, or terms.end().
+template<typename TermsT>
+auto r1cs_optimizer_find(TermsT &terms, const size_t index)
+    -> decltype(terms.begin())
+{
+    auto it = std::lower_bound(
+        terms.begin(),
+        terms.end(),
+        index,
+        [](const typename TermsT::value_type &term, const size_t value) {
+            return term.index < value;
+        });
+    return (it != terms.end() && it->index == index) ? it : terms.end();
+}
+
+// True if normalized terms only involve the constant variable.
+template<typename FieldT>
+bool r1cs_optimizer_is_constant(const r1cs_terms<FieldT> &terms)
+{
+    return terms.empty() || (terms.size() == 1 && terms[0].index == 0);
+}
+
+template<typename FieldT>
+FieldT r1cs_optimizer_constant(const r1cs_terms<FieldT> &terms)
+{
+    return (terms.empty() || terms[0].index != 0) ? FieldT::zero()
+                                                  : terms[0].coeff;
+}
+
+// State of r1cs_optimize. Constraints are held as normalized terms, and
+// removed constraints are marked rather than erased, so that constraints are
+// always referred to by their index in the original system.
+template<typename FieldT> class r1cs_optimizer
+{
+public:
+    r1cs_optimizer(
+        const libsnark::r1cs_constraint_system<FieldT> &cs,
+        const size_t max_fill);
+
+    r1cs_optimization<FieldT> run();
+
+private:
+    // The A, B and C terms of a constraint.
+    using constraint_terms = std::array<r1cs_terms<FieldT>, 3>;
+
+    // If constraint i is linear (A or B is constant), compute the terms of L
+    // such that the constraint is equivalent to L = 0.
+    bool linear_form(const size_t i, r1cs_terms<FieldT> &form) const;
+
+    // Drop constraint i if it is trivially satisfied, or use it to eliminate
+    // a variable, if it is linear.
+    void process(const size_t i);
+
+    // True if substituting an expression of `expression_size` terms for
+    // `var`, and removing constraint i, increases the number of terms by at
+    // most max_fill.
+    bool substitution_allowed(
+        const size_t var, const size_t expression_size, const size_t i) const;
+
+    // Substitute `expression` for `var` in all constraints except `exclude`.
+    void substitute(
+        const size_t var,
+        const r1cs_terms<FieldT> &expression,
+        const size_t exclude);
+
+    void add_occurrence(const size_t var, const size_t i);
+
+    const size_t num_primary;
+    const size_t num_variables;
+    const size_t max_fill;
+    std::vector<constraint_terms> constraints;
+    std::vector<bool> removed;
+    // Constraints in which each variable appears (possibly including
+    // constraints from which it has since been removed).
+    std::vector<std::vector<size_t>> occurrences;
+    // Constraints to be processed.
+    std::deque<size_t> queue;
+};
+
+template<typename FieldT>
+r1cs_optimizer<FieldT>::r1cs_optimizer(
+    const libsnark::r1cs_constraint_system<FieldT> &cs, const size_t max_fill)
+    : num_primary(cs.primary_input_size)
+    , num_variables(cs.num_variables())
+    , max_fill(max_fill)
+    , constraints(cs.num_constraints())
+    , removed(cs.num_constraints(), false)
+    , occurrences(cs.num_variables() + 1)
+{
+    for (size_t i = 0; i < cs.num_constraints(); ++i) {
+        constraint_terms &terms = constraints[i];
+        terms[0] = cs.constraints[i].a.terms;
+        terms[1] = cs.constraints[i].b.terms;
+        terms[2] = cs.constraints[i].c.terms;
+        for (r1cs_terms<FieldT> &lc_terms : terms) {
+            r1cs_optimizer_normalize(lc_terms);
+            for (const libsnark::linear_term<FieldT> &term : lc_terms) {
+                add_occurrence(term.index, i);
+            }
+        }
+        if (r1cs_optimizer_is_constant(terms[0]) ||
+            r1cs_optimizer_is_constant(terms[1])) {
+            queue.push_back(i);
+        }
+    }
+}
+
+template<typename FieldT>
+r1cs_optimization<FieldT> r1cs_optimizer<FieldT>::run()
+{
+    while (!queue.empty()) {
+        const size_t i = queue.front();
+        queue.pop_front();
+        process(i);
+    }
+
+    // Renumber the auxiliary variables which still appear in the remaining
+    // constraints, preserving their order. The constant and primary
+    // variables keep their indices.
+    std::vector<bool> used(num_variables + 1, false);
+    for (size_t i = 0; i < constraints.size(); ++i) {
+        if (removed[i]) {
+            continue;
+        }
+        for (const r1cs_terms<FieldT> &lc_terms : constraints[i]) {
+            for (const libsnark::linear_term<FieldT> &term : lc_terms) {
+                used[term.index] = true;
+            }
+        }
+    }
+
+    r1cs_optimization<FieldT> result;
+    std::vector<size_t> new_index(num_variables + 1);
+    for (size_t var = 0; var <= num_primary; ++var) {
+        new_index[var] = var;
+    }
+    for (size_t var = num_primary + 1; var <= num_variables; ++var) {
+        if (used[var]) {
+            result.auxiliary_sources.push_back(var);
+            new_index[var] = num_primary + result.auxiliary_sources.size();
+        }
+    }
+
+    libsnark::r1cs_constraint_system<FieldT> &cs = result.constraint_system;
+    cs.primary_input_size = num_primary;
+    cs.auxiliary_input_size = result.auxiliary_sources.size();
+    for (size_t i = 0; i < constraints.size(); ++i) {
+        if (removed[i]) {
+            continue;
+        }
+        std::array<libsnark::linear_combination<FieldT>, 3> lcs;
+        for (size_t j = 0; j < 3; ++j) {
+            // Renumbering preserves the order, so terms remain sorted.
+            lcs[j].terms.reserve(constraints[i][j].size());
+            for (const libsnark::linear_term<FieldT> &term :
+                 constraints[i][j]) {
+                lcs[j].terms.emplace_back(
+                    libsnark::variable<FieldT>(new_index[term.index]),
+                    term.coeff);
+            }
+        }
+        cs.add_constraint(
+            libsnark::r1cs_constraint<FieldT>(lcs[0], lcs[1], lcs[2]));
+    }
+
+    return result;
+}
+
+template<typename FieldT>
+bool r1cs_optimizer<FieldT>::linear_form(
+    const size_t i, r1cs_terms<FieldT> &form) const
+{
+    const constraint_terms &terms = constraints[i];
+    size_t variable_lc;
+    FieldT scalar;
+    if (r1cs_optimizer_is_constant(terms[0])) {
+        variable_lc = 1;
+        scalar = r1cs_optimizer_constant(terms[0]);
+    } else if (r1cs_optimizer_is_constant(terms[1])) {
+        variable_lc = 0;
+        scalar = r1cs_optimizer_constant(terms[1]);
+    } else {
+        return false;
+    }
+
+    // L = scalar * (A or B) - C
+    form.clear();
+    form.reserve(terms[variable_lc].size() + terms[2].size());
+    if (!scalar.is_zero()) {
+        for (const libsnark::linear_term<FieldT> &term : terms[variable_lc]) {
+            form.emplace_back(
+                libsnark::variable<FieldT>(term.index), scalar * term.coeff);
+        }
+    }
+    for (const libsnark::linear_term<FieldT> &term : terms[2]) {
+        form.emplace_back(libsnark::variable<FieldT>(term.index), -term.coeff);
+    }
+    r1cs_optimizer_normalize(form);
+    return true;
+}
+
+template<typename FieldT> void r1cs_optimizer<FieldT>::process(const size_t i)
+{
+    r1cs_terms<FieldT> form;
+    if (removed[i] || !linear_form(i, form)) {
+        return;
+    }
+
+    // Constraints of the form `constant = 0`.
+    if (r1cs_optimizer_is_constant(form)) {
+        if (!form.empty()) {
+            throw std::invalid_argument(
+                "unsatisfiable constraint " + std::to_string(i));
+        }
+        removed[i] = true;
+        return;
+    }
+
+    // Eliminate the auxiliary variable with the fewest occurrences, if this
+    // does not add too many terms to the other constraints.
+    size_t pivot = 0;
+    FieldT pivot_coeff;
+    for (const libsnark::linear_term<FieldT> &term : form) {
+        if (term.index > num_primary &&
+            (pivot == 0 ||
+             occurrences[term.index].size() < occurrences[pivot].size())) {
+            pivot = term.index;
+            pivot_coeff = term.coeff;
+        }
+    }
+    if (pivot == 0) {
+        return;
+    }
+
+    if (!substitution_allowed(pivot, form.size() - 1, i)) {
+        return;
+    }
+
+    // pivot = -(1 / pivot_coeff) * (L - pivot_coeff * pivot)
+    const FieldT scale = -pivot_coeff.inverse();
+    r1cs_terms<FieldT> expression;
+    expression.reserve(form.size() - 1);
+    for (const libsnark::linear_term<FieldT> &term : form) {
+        if (term.index != pivot) {
+            expression.emplace_back(
+                libsnark::variable<FieldT>(term.index), scale * term.coeff);
+        }
+    }
+
+    removed[i] = true;
+    substitute(pivot, expression, i);
+}
+
+template<typename FieldT>
+bool r1cs_optimizer<FieldT>::substitution_allowed(
+    const size_t var, const size_t expression_size, const size_t i) const
+{
+    // Each occurrence of `var` is replaced by `expression_size` terms.
+    size_t added = 0;
+    size_t removed_terms =
+        constraints[i][0].size() + constraints[i][1].size() +
+        constraints[i][2].size();
+    for (const size_t j : occurrences[var]) {
+        if (j == i || removed[j]) {
+            continue;
+        }
+        for (const r1cs_terms<FieldT> &lc_terms : constraints[j]) {
+            if (r1cs_optimizer_find(lc_terms, var) != lc_terms.end()) {
+                added += expression_size;
+                ++removed_terms;
+            }
+        }
+    }
+    return added <= removed_terms + max_fill;
+}
+
+template<typename FieldT>
+void r1cs_optimizer<FieldT>::substitute(
+    const size_t var,
+    const r1cs_terms<FieldT> &expression,
+    const size_t exclude)
+{
+    const std::vector<size_t> var_occurrences = std::move(occurrences[var]);
+    occurrences[var].clear();
+
+    for (const size_t i : var_occurrences) {
+        if (i == exclude || removed[i]) {
+            continue;
+        }
+
+        constraint_terms &terms = constraints[i];
+        bool changed = false;
+        for (r1cs_terms<FieldT> &lc_terms : terms) {
+            const auto it = r1cs_optimizer_find(lc_terms, var);
+            if (it == lc_terms.end()) {
+                continue;
+            }
+
+            const FieldT coeff = it->coeff;
+            lc_terms.erase(it);
+            for (const libsnark::linear_term<FieldT> &term : expression) {
+                lc_terms.emplace_back(
+                    libsnark::variable<FieldT>(term.index), coeff * term.coeff);
+            }
+            r1cs_optimizer_normalize(lc_terms);
+            changed = true;
+        }
+        if (!changed) {
+            continue;
+        }
+
+        for (const libsnark::linear_term<FieldT> &term : expression) {
+            add_occurrence(term.index, i);
+        }
+
+        // The constraint may have become linear, or trivial, or may give
+        // a substitution which was previously rejected.
+        if (r1cs_optimizer_is_constant(terms[0]) ||
+            r1cs_optimizer_is_constant(terms[1])) {
+            queue.push_back(i);
+        }
+    }
+}
+
+template<typename FieldT>
+void r1cs_optimizer<FieldT>::add_occurrence(const size_t var, const size_t i)
+{
+    // The constant variable is never eliminated.
+    if (var == 0) {
+        return;
+    }
+    std::vector<size_t> &var_occurrences = occurrences[var];
+    if (var_occurrences.empty() || var_occurrences.back() != i) {
+        var_occurrences.push_back(i);
+    }
+}
+
+} // namespace internal
+
+template<typename FieldT>
+libsnark::r1cs_auxiliary_input<FieldT> r1cs_optimization<
+    FieldT>::map_auxiliary_input(const libsnark::r1cs_auxiliary_input<FieldT>
+                                     &auxiliary_input) const
+{
+    // Auxiliary variable `var` of the original system is at position
+    // var - primary_input_size - 1 of its auxiliary input.
+    const size_t offset = constraint_system.primary_input_size + 1;
+    libsnark::r1cs_auxiliary_input<FieldT> result;
+    result.reserve(auxiliary_sources.size());
+    for (const size_t var : auxiliary_sources) {
+        result.push_back(auxiliary_input[var - offset]);
+    }
+    return result;
+}
+
+template<typename FieldT>
+r1cs_optimization<FieldT> r1cs_optimize(
+    const libsnark::r1cs_constraint_system<FieldT> &cs, const size_t max_fill)
+{
+    internal::r1cs_optimizer<FieldT> optimizer(cs, max_fill);
+    return optimizer.run();
+}
+
+} // namespace libzeth
+
+#endif // __ZETH_CORE_R1CS_OPTIMIZER_TCC__
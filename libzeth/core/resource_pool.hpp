@@ -0,0 +1,88 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CORE_RESOURCE_POOL_HPP__
+#define __ZETH_CORE_RESOURCE_POOL_HPP__
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace libzeth
+{
+
+/// A fixed-size pool of independent, expensive-to-construct objects (such as
+/// circuit_wrapper instances, each holding its own protoboard), which can be
+/// leased by concurrent callers. A caller holding a lease has exclusive
+/// access to the underlying object until the lease is destroyed, at which
+/// point the object is returned to the pool.
+template<typename ResourceT> class resource_pool
+{
+public:
+    /// RAII handle giving exclusive access to a pooled object. Move-only.
+    class lease
+    {
+    public:
+        lease();
+        lease(lease &&other);
+        lease &operator=(lease &&other);
+        lease(const lease &) = delete;
+        lease &operator=(const lease &) = delete;
+        ~lease();
+
+        /// True if this lease currently holds an object.
+        bool valid() const;
+
+        /// Return the object to the pool early (no-op if not valid).
+        void release();
+
+        ResourceT &operator*() const;
+        ResourceT *operator->() const;
+
+    private:
+        friend class resource_pool;
+        lease(resource_pool *pool, ResourceT *resource);
+
+        resource_pool *pool;
+        ResourceT *resource;
+    };
+
+    /// Take ownership of a (non-empty) set of objects.
+    explicit resource_pool(std::vector<std::unique_ptr<ResourceT>> &&objects);
+    resource_pool(const resource_pool &) = delete;
+    resource_pool &operator=(const resource_pool &) = delete;
+
+    /// Total number of objects in the pool.
+    size_t size() const;
+
+    /// Number of objects not currently leased.
+    size_t num_available() const;
+
+    /// Block until an object is available and return a lease on it.
+    lease acquire();
+
+    /// Return a lease on an available object, or an invalid lease if all
+    /// objects are currently in use.
+    lease try_acquire();
+
+    /// Direct access to the i-th object, bypassing the lease mechanism. Only
+    /// intended for use before the pool is shared between threads (e.g.
+    /// during setup).
+    ResourceT &get(size_t i);
+
+private:
+    void release(ResourceT *resource);
+
+    const std::vector<std::unique_ptr<ResourceT>> objects;
+    std::vector<ResourceT *> available;
+    mutable std::mutex mutex;
+    std::condition_variable cond;
+};
+
+} // namespace libzeth
+
+#include "libzeth/core/resource_pool.tcc"
+
+#endif // __ZETH_CORE_RESOURCE_POOL_HPP__
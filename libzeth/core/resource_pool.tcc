@@ -0,0 +1,152 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CORE_RESOURCE_POOL_TCC__
+#define __ZETH_CORE_RESOURCE_POOL_TCC__
+
+#include "libzeth/core/resource_pool.hpp"
+
+#include <cassert>
+#include <stdexcept>
+
+namespace libzeth
+{
+
+template<typename ResourceT>
+resource_pool<ResourceT>::lease::lease() : pool(nullptr), resource(nullptr)
+{
+}
+
+template<typename ResourceT>
+resource_pool<ResourceT>::lease::lease(
+    resource_pool<ResourceT> *pool, ResourceT *resource)
+    : pool(pool), resource(resource)
+{
+}
+
+template<typename ResourceT>
+resource_pool<ResourceT>::lease::lease(lease &&other)
+    : pool(other.pool), resource(other.resource)
+{
+    other.pool = nullptr;
+    other.resource = nullptr;
+}
+
+template<typename ResourceT>
+typename resource_pool<ResourceT>::lease &resource_pool<
+    ResourceT>::lease::operator=(lease &&other)
+{
+    if (this != &other) {
+        release();
+        pool = other.pool;
+        resource = other.resource;
+        other.pool = nullptr;
+        other.resource = nullptr;
+    }
+    return *this;
+}
+
+template<typename ResourceT> resource_pool<ResourceT>::lease::~lease()
+{
+    release();
+}
+
+template<typename ResourceT>
+bool resource_pool<ResourceT>::lease::valid() const
+{
+    return resource != nullptr;
+}
+
+template<typename ResourceT> void resource_pool<ResourceT>::lease::release()
+{
+    if (resource != nullptr) {
+        pool->release(resource);
+        pool = nullptr;
+        resource = nullptr;
+    }
+}
+
+template<typename ResourceT>
+ResourceT &resource_pool<ResourceT>::lease::operator*() const
+{
+    assert(resource != nullptr);
+    return *resource;
+}
+
+template<typename ResourceT>
+ResourceT *resource_pool<ResourceT>::lease::operator->() const
+{
+    assert(resource != nullptr);
+    return resource;
+}
+
+template<typename ResourceT>
+resource_pool<ResourceT>::resource_pool(
+    std::vector<std::unique_ptr<ResourceT>> &&objects)
+    : objects(std::move(objects))
+{
+    if (this->objects.empty()) {
+        throw std::invalid_argument("resource_pool requires >0 objects");
+    }
+
+    available.reserve(this->objects.size());
+    for (const std::unique_ptr<ResourceT> &object : this->objects) {
+        available.push_back(object.get());
+    }
+}
+
+template<typename ResourceT> size_t resource_pool<ResourceT>::size() const
+{
+    return objects.size();
+}
+
+template<typename ResourceT>
+size_t resource_pool<ResourceT>::num_available() const
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    return available.size();
+}
+
+template<typename ResourceT>
+typename resource_pool<ResourceT>::lease resource_pool<ResourceT>::acquire()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [this]() { return !available.empty(); });
+    ResourceT *resource = available.back();
+    available.pop_back();
+    return lease(this, resource);
+}
+
+template<typename ResourceT>
+typename resource_pool<ResourceT>::lease resource_pool<
+    ResourceT>::try_acquire()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (available.empty()) {
+        return lease();
+    }
+    ResourceT *resource = available.back();
+    available.pop_back();
+    return lease(this, resource);
+}
+
+template<typename ResourceT>
+ResourceT &resource_pool<ResourceT>::get(size_t i)
+{
+    return *objects[i];
+}
+
+template<typename ResourceT>
+void resource_pool<ResourceT>::release(ResourceT *resource)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        available.push_back(resource);
+    }
+    cond.notify_one();
+}
+
+} // namespace libzeth
+
+#endif // __ZETH_CORE_RESOURCE_POOL_TCC__
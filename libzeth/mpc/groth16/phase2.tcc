@@ -6,6 +6,8 @@
 #define __ZETH_MPC_GROTH16_PHASE2_TCC__
 
 #include "libzeth/core/chacha_rng.hpp"
+#include "libzeth/core/glv.hpp"
+#include "libzeth/core/group_element_utils.hpp"
 #include "libzeth/core/hash_stream.hpp"
 #include "libzeth/core/utils.hpp"
 #include "libzeth/mpc/groth16/mpc_utils.hpp"
@@ -433,8 +435,10 @@ srs_mpc_phase2_accumulator<ppT> srs_mpc_phase2_update_accumulator(
     const libff::Fr<ppT> delta_j_inverse = delta_j.inverse();
 
     // Step 3 (from [BoweGM17]): Update accumulated $\delta$
-    const libff::G1<ppT> new_delta_g1 = delta_j * last_accum.delta_g1;
-    const libff::G2<ppT> new_delta_g2 = delta_j * last_accum.delta_g2;
+    const libff::G1<ppT> new_delta_g1 =
+        scalar_mul(delta_j, last_accum.delta_g1);
+    const libff::G2<ppT> new_delta_g2 =
+        scalar_mul(delta_j, last_accum.delta_g2);
 
     // Step 3: Update $L_i$ by dividing by $\delta$ ('K' in the paper, but we
     // use L here to be consistent with the final keypair in libsnark).
@@ -449,8 +453,11 @@ srs_mpc_phase2_accumulator<ppT> srs_mpc_phase2_update_accumulator(
 #pragma omp parallel for
 #endif
     for (size_t i = 0; i < num_L_elements; ++i) {
-        L_g1[i] = delta_j_inverse * last_accum.L_g1[i];
+        L_g1[i] = scalar_mul(delta_j_inverse, last_accum.L_g1[i]);
     }
+    // Affine form is required for serialization, and makes the additions of
+    // later consistency checks cheaper.
+    batch_to_affine(L_g1);
     putchar('\n');
     libff::leave_block("updating L_g1");
 
@@ -466,8 +473,9 @@ srs_mpc_phase2_accumulator<ppT> srs_mpc_phase2_update_accumulator(
 #pragma omp parallel for
 #endif
     for (size_t i = 0; i < H_size; ++i) {
-        H_g1[i] = delta_j_inverse * last_accum.H_g1[i];
+        H_g1[i] = scalar_mul(delta_j_inverse, last_accum.H_g1[i]);
     }
+    batch_to_affine(H_g1);
     libff::leave_block("updating H_g1");
 
     libff::leave_block("call to srs_mpc_phase2_update_accumulator");
@@ -5,6 +5,8 @@
 #ifndef __ZETH_MPC_GROTH16_POWERSOFTAU_UTILS_TCC__
 #define __ZETH_MPC_GROTH16_POWERSOFTAU_UTILS_TCC__
 
+#include "libzeth/core/blocked_radix2_domain.hpp"
+#include "libzeth/core/multi_exp.hpp"
 #include "libzeth/core/utils.hpp"
 #include "libzeth/mpc/groth16/powersoftau_utils.hpp"
 
@@ -122,6 +124,9 @@ void write_powersoftau_fp2(
 // (https://eprint.iacr.org/2017/602.pdf)
 // to efficiently evaluate Lagrange polynomials ${L_i(x)}_i$ for the
 // $d=2^n$-roots of unity, given powers ${x^i}_i$ for $i=0..d-1$.
+//
+// The FFT operates on group elements, which blocked_radix2_domain (whose
+// transforms are specific to field elements) does not support.
 template<typename Fr, typename Gr>
 static void compute_lagrange_from_powers(
     std::vector<Gr> &powers, const Fr &omega_inv)
@@ -133,10 +138,26 @@ static void compute_lagrange_from_powers(
     }
 }
 
+// Random scalars r_0 ... r_{n-1}.
+template<typename ppT>
+std::vector<libff::Fr<ppT>> random_scalars(const size_t num_scalars)
+{
+    std::vector<libff::Fr<ppT>> scalars(num_scalars);
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < num_scalars; ++i) {
+        scalars[i] = libff::Fr<ppT>::random_element();
+    }
+    return scalars;
+}
+
 // Given two sequences `as` and `bs` of group elements, compute
 //   a_accum = as[0] * r_0 + ... + as[n] * r_n
 //   b_accum = bs[0] * r_0 + ... + bs[n] * r_n
-// for random scalars r_0 ... r_n.
+// for random scalars r_0 ... r_n. Each sum is computed as a single
+// multi-exponentiation (see multi_exp). These final sums are then used in
+// the final pairing check.
 template<typename ppT, typename G>
 void random_linear_combination(
     const std::vector<G> &as, const std::vector<G> &bs, G &a_accum, G &b_accum)
@@ -146,45 +167,9 @@ void random_linear_combination(
             "vector size mismatch (random_linear_comb)");
     }
 
-    a_accum = G::zero();
-    b_accum = G::zero();
-
-    // Split across threads, each one accumulating into its own thread-local
-    // variable, and then (atomically) adding that to the global a1_accum and
-    // b1_accum values. These final sums are then used in the final pairing
-    // check.
-#ifdef MULTICORE
-#pragma omp parallel shared(a_accum, b_accum)
-#endif
-    {
-        G a_thread_accum = G::zero();
-        G b_thread_accum = G::zero();
-
-        const size_t scalar_bits = libff::Fr<ppT>::num_bits;
-        const size_t window_size = libff::wnaf_opt_window_size<G>(scalar_bits);
-        std::vector<long> wnaf;
-
-#ifdef MULTICORE
-#pragma omp for
-#endif
-        for (size_t i = 0; i < as.size(); ++i) {
-            const libff::Fr<ppT> r = libff::Fr<ppT>::random_element();
-            update_wnaf(wnaf, window_size, r.as_bigint());
-            G r_ai = fixed_window_wnaf_exp(window_size, as[i], wnaf);
-            G r_bi = fixed_window_wnaf_exp(window_size, bs[i], wnaf);
-
-            a_thread_accum = a_thread_accum + r_ai;
-            b_thread_accum = b_thread_accum + r_bi;
-        }
-
-#ifdef MULTICORE
-#pragma omp critical
-#endif
-        {
-            a_accum = a_accum + a_thread_accum;
-            b_accum = b_accum + b_thread_accum;
-        }
-    }
+    const std::vector<libff::Fr<ppT>> rs = random_scalars<ppT>(as.size());
+    a_accum = multi_exp<libff::Fr<ppT>, G>(as.data(), rs.data(), rs.size());
+    b_accum = multi_exp<libff::Fr<ppT>, G>(bs.data(), rs.data(), rs.size());
 }
 
 // Similar to random_linear_combination, but compute:
@@ -195,43 +180,12 @@ template<typename ppT, typename G>
 void random_linear_combination_consecutive(
     const std::vector<G> &as, G &a_accum, G &b_accum)
 {
-    a_accum = G::zero();
-    b_accum = G::zero();
-
     const size_t num_entries = as.size() - 1;
 
-#ifdef MULTICORE
-#pragma omp parallel shared(a_accum, b_accum)
-#endif
-    {
-        G a_thread_accum = G::zero();
-        G b_thread_accum = G::zero();
-
-        const size_t scalar_bits = libff::Fr<ppT>::num_bits;
-        const size_t window_size = libff::wnaf_opt_window_size<G>(scalar_bits);
-        std::vector<long> wnaf;
-
-#ifdef MULTICORE
-#pragma omp for
-#endif
-        for (size_t i = 0; i < num_entries; ++i) {
-            const libff::Fr<ppT> r = libff::Fr<ppT>::random_element();
-            update_wnaf(wnaf, window_size, r.as_bigint());
-            G r_ai = fixed_window_wnaf_exp(window_size, as[i], wnaf);
-            G r_bi = fixed_window_wnaf_exp(window_size, as[i + 1], wnaf);
-
-            a_thread_accum = a_thread_accum + r_ai;
-            b_thread_accum = b_thread_accum + r_bi;
-        }
-
-#ifdef MULTICORE
-#pragma omp critical
-#endif
-        {
-            a_accum = a_accum + a_thread_accum;
-            b_accum = b_accum + b_thread_accum;
-        }
-    }
+    const std::vector<libff::Fr<ppT>> rs = random_scalars<ppT>(num_entries);
+    a_accum = multi_exp<libff::Fr<ppT>, G>(as.data(), rs.data(), num_entries);
+    b_accum =
+        multi_exp<libff::Fr<ppT>, G>(as.data() + 1, rs.data(), num_entries);
 }
 
 } // namespace
@@ -846,8 +800,9 @@ srs_lagrange_evaluations<ppT> powersoftau_compute_lagrange_evaluations(
     libff::print_indent();
     printf("n=%zu\n", n);
 
-    libfqfft::basic_radix2_domain<Fr> domain(n);
-    const Fr omega = domain.get_domain_element(1);
+    // Same domain (and hence the same omega) as used by the prover.
+    const blocked_radix2_domain<Fr> domain(n);
+    const Fr omega = domain.omega;
     const Fr omega_inv = omega.inverse();
 
     // Compute [ L_j(t) ]_1 from { [x^i] } i=0..n-1
@@ -0,0 +1,62 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_SERIALIZATION_R1CS_CACHE_HPP__
+#define __ZETH_SERIALIZATION_R1CS_CACHE_HPP__
+
+#include "libzeth/core/include_libsnark.hpp"
+
+#include <string>
+
+namespace libzeth
+{
+
+/// Returns a hex digest identifying the circuit built from the given joinsplit
+/// parameters (hash types, number of inputs and outputs, tree depth and
+/// curve), and from the current gadget implementations (via the
+/// ZETH_CIRCUITS_DIGEST build-time digest of their sources, see
+/// libzeth/zeth_circuits_digest.h.in). `circuit_name` distinguishes
+/// different circuits built from the same parameters (e.g. the joinsplit
+/// gadget alone, or the circuit_wrapper which adds the hash of the public
+/// inputs).
+template<
+    typename HashT,
+    typename HashTreeT,
+    typename ppT,
+    size_t NumInputs,
+    size_t NumOutputs,
+    size_t TreeDepth>
+std::string circuit_parameters_hash(const std::string &circuit_name);
+
+/// Read a constraint system from a cache file written by r1cs_cache_write.
+/// Returns false if the file does not exist, or was written for a different
+/// `parameters_hash` (in which case `r1cs` is unchanged). Throws
+/// std::runtime_error if the file cannot be read, or if the constraint system
+/// does not match the digest recorded when the file was written (e.g. if the
+/// file is truncated or corrupt).
+///
+/// The cached constraint system includes the number of primary and auxiliary
+/// variables, which callers should check against the variables allocated by
+/// the gadgets used to generate the witness.
+template<typename FieldT>
+bool r1cs_cache_read(
+    const std::string &cache_file,
+    const std::string &parameters_hash,
+    libsnark::r1cs_constraint_system<FieldT> &r1cs);
+
+/// Write a constraint system to a cache file, identified by
+/// `parameters_hash` (see circuit_parameters_hash). The file is replaced
+/// atomically, so that a concurrent reader (or a crash) never sees a
+/// partially written cache.
+template<typename FieldT>
+void r1cs_cache_write(
+    const std::string &cache_file,
+    const std::string &parameters_hash,
+    const libsnark::r1cs_constraint_system<FieldT> &r1cs);
+
+} // namespace libzeth
+
+#include "libzeth/serialization/r1cs_cache.tcc"
+
+#endif // __ZETH_SERIALIZATION_R1CS_CACHE_HPP__
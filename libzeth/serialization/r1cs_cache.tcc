@@ -0,0 +1,119 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_SERIALIZATION_R1CS_CACHE_TCC__
+#define __ZETH_SERIALIZATION_R1CS_CACHE_TCC__
+
+#include "libzeth/core/blake2s.hpp"
+#include "libzeth/core/durable_file.hpp"
+#include "libzeth/core/utils.hpp"
+#include "libzeth/serialization/proto_utils.hpp"
+#include "libzeth/serialization/r1cs_cache.hpp"
+#include "libzeth/serialization/r1cs_serialization.hpp"
+#include "zeth_circuits_digest.h"
+
+#include <sstream>
+#include <typeinfo>
+
+namespace libzeth
+{
+
+namespace internal
+{
+
+// Written at the start of each cache file, followed by the parameters hash
+// and the digest of the serialized constraint system. Must be changed
+// whenever the layout of the cache file changes. Changes to the circuits are
+// reflected in the parameters hash.
+static const std::string r1cs_cache_header("zeth-r1cs-cache-2");
+
+inline std::string r1cs_cache_digest(const std::string &data)
+{
+    uint8_t digest[32];
+    blake2s_256(data.data(), data.size(), digest);
+    return bytes_to_hex(digest, sizeof(digest));
+}
+
+} // namespace internal
+
+template<
+    typename HashT,
+    typename HashTreeT,
+    typename ppT,
+    size_t NumInputs,
+    size_t NumOutputs,
+    size_t TreeDepth>
+std::string circuit_parameters_hash(const std::string &circuit_name)
+{
+    std::stringstream ss;
+    ss << internal::r1cs_cache_header << ";" << ZETH_CIRCUITS_DIGEST << ";"
+       << circuit_name << ";" << typeid(HashT).name() << ";"
+       << typeid(HashTreeT).name() << ";" << NumInputs << ";" << NumOutputs
+       << ";" << TreeDepth << ";" << pp_name<ppT>();
+    return internal::r1cs_cache_digest(ss.str());
+}
+
+template<typename FieldT>
+bool r1cs_cache_read(
+    const std::string &cache_file,
+    const std::string &parameters_hash,
+    libsnark::r1cs_constraint_system<FieldT> &r1cs)
+{
+    if (!file_exists(cache_file)) {
+        return false;
+    }
+
+    std::istringstream in_s(read_file(cache_file));
+    std::string header;
+    std::string hash;
+    std::string digest;
+    std::getline(in_s, header);
+    std::getline(in_s, hash);
+    if (!in_s || header != internal::r1cs_cache_header ||
+        hash != parameters_hash) {
+        return false;
+    }
+
+    std::getline(in_s, digest);
+    const std::string contents = in_s.str();
+    const std::streamoff offset = in_s.tellg();
+    if (!in_s || offset < 0 ||
+        digest != internal::r1cs_cache_digest(contents.substr(offset))) {
+        throw std::runtime_error("corrupt r1cs cache file: " + cache_file);
+    }
+
+    in_s.exceptions(
+        std::ios_base::eofbit | std::ios_base::badbit | std::ios_base::failbit);
+    libsnark::r1cs_constraint_system<FieldT> cached;
+    try {
+        r1cs_read_bytes(cached, in_s);
+    } catch (std::ios_base::failure &) {
+        throw std::runtime_error("truncated r1cs cache file: " + cache_file);
+    }
+
+    r1cs = std::move(cached);
+    return true;
+}
+
+template<typename FieldT>
+void r1cs_cache_write(
+    const std::string &cache_file,
+    const std::string &parameters_hash,
+    const libsnark::r1cs_constraint_system<FieldT> &r1cs)
+{
+    std::ostringstream r1cs_s;
+    r1cs_write_bytes(r1cs, r1cs_s);
+    const std::string r1cs_bytes = r1cs_s.str();
+
+    std::ostringstream out_s;
+    out_s << internal::r1cs_cache_header << "\n"
+          << parameters_hash << "\n"
+          << internal::r1cs_cache_digest(r1cs_bytes) << "\n"
+          << r1cs_bytes;
+    write_file_atomic(cache_file, out_s.str());
+}
+
+} // namespace libzeth
+
+#endif // __ZETH_SERIALIZATION_R1CS_CACHE_TCC__
@@ -0,0 +1,112 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_SNARKS_GROTH16_GROTH16_MAPPED_PROVING_KEY_HPP__
+#define __ZETH_SNARKS_GROTH16_GROTH16_MAPPED_PROVING_KEY_HPP__
+
+#include "libzeth/core/mapped_file.hpp"
+#include "libzeth/snarks/groth16/groth16_snark.hpp"
+
+namespace libzeth
+{
+
+/// A Groth16 proving key (and the corresponding verification key) in a
+/// versioned on-disk layout intended to be memory-mapped. Group elements are
+/// stored as raw in-memory images of libff group elements (in affine form,
+/// i.e. with Z = 1, and with coordinates in Montgomery form), with a fixed
+/// stride equal to the size of the group element type. Each section is
+/// aligned to 64 bytes, so that the contents of a mapped file can be read
+/// directly as arrays of group elements, without parsing or conversion. The
+/// format is intended for fast loading: the prover still operates on a
+/// libsnark proving key, which `to_proving_key` populates by copying the
+/// mapped data, so the key occupies private memory in each process (in
+/// addition to the page cache).
+///
+/// The layout is specific to the host architecture and the libff build
+/// (limb size and count, coordinate representation), all of which are
+/// recorded in the header and checked when the file is opened. Files are
+/// created by converting an existing proving key (see `write`). Points are
+/// not checked for well-formedness when the file is opened (since the file
+/// can only be created from a key which has already been checked), but an
+/// explicit check is provided.
+template<typename ppT> class groth16_mapped_proving_key
+{
+public:
+    using snark = groth16_snark<ppT>;
+    using Field = libff::Fr<ppT>;
+    using G1 = libff::G1<ppT>;
+    using G2 = libff::G2<ppT>;
+
+    /// Map an existing file in the mapped proving key format.
+    explicit groth16_mapped_proving_key(const std::string &file_path);
+
+    /// Convert a proving key (and the corresponding verification key) to the
+    /// mapped format, writing the result to out_s.
+    static void write(
+        const typename snark::proving_key &pk,
+        const typename snark::verification_key &vk,
+        std::ostream &out_s);
+
+    const G1 &alpha_g1() const;
+    const G1 &beta_g1() const;
+    const G2 &beta_g2() const;
+    const G1 &delta_g1() const;
+    const G2 &delta_g2() const;
+
+    const G1 *A_query() const;
+    size_t A_query_size() const;
+
+    /// The B_query sparse vector of knowledge commitments, stored as three
+    /// parallel arrays.
+    const uint64_t *B_query_indices() const;
+    const G2 *B_query_g() const;
+    const G1 *B_query_h() const;
+    size_t B_query_size() const;
+    size_t B_query_domain_size() const;
+
+    const G1 *H_query() const;
+    size_t H_query_size() const;
+
+    const G1 *L_query() const;
+    size_t L_query_size() const;
+
+    /// Dimensions of the constraint system for which the key was generated.
+    size_t num_inputs() const;
+    size_t num_variables() const;
+    size_t num_constraints() const;
+
+    /// Read the verification key stored alongside the proving key.
+    void verification_key_read(typename snark::verification_key &vk) const;
+
+    /// Read the constraint system stored alongside the proving key.
+    void constraint_system_read(
+        libsnark::r1cs_constraint_system<Field> &cs) const;
+
+    /// Populate a libsnark proving key from the mapped data. The group
+    /// elements are copied (as raw memory), without any conversion. If
+    /// `cs` is not null, it is used as the constraint system of the key
+    /// (after checking its dimensions against the header), avoiding the cost
+    /// of parsing the stored constraint system.
+    void to_proving_key(
+        typename snark::proving_key &pk,
+        const libsnark::r1cs_constraint_system<Field> *cs = nullptr) const;
+
+    /// Check that all group elements in the file are well-formed.
+    bool is_well_formed() const;
+
+    /// Hint to the OS that the key data will be needed soon.
+    void prefetch() const;
+
+private:
+    template<typename T> const T *section_data(size_t section) const;
+    size_t section_count(size_t section) const;
+
+    mapped_file file;
+};
+
+} // namespace libzeth
+
+#include "libzeth/snarks/groth16/groth16_mapped_proving_key.tcc"
+
+#endif // __ZETH_SNARKS_GROTH16_GROTH16_MAPPED_PROVING_KEY_HPP__
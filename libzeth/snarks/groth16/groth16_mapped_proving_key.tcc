@@ -0,0 +1,561 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_SNARKS_GROTH16_GROTH16_MAPPED_PROVING_KEY_TCC__
+#define __ZETH_SNARKS_GROTH16_GROTH16_MAPPED_PROVING_KEY_TCC__
+
+#include "libzeth/core/group_element_utils.hpp"
+#include "libzeth/serialization/proto_utils.hpp"
+#include "libzeth/serialization/r1cs_serialization.hpp"
+#include "libzeth/snarks/groth16/groth16_mapped_proving_key.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <sstream>
+
+namespace libzeth
+{
+
+namespace internal
+{
+
+static const char groth16_mapped_magic[8] = {
+    'Z', 'E', 'T', 'H', 'G', '1', '6', 'M'};
+static const uint32_t groth16_mapped_version = 1;
+static const size_t groth16_mapped_alignment = 64;
+
+// Sections of the file, in the order in which they appear.
+enum groth16_mapped_section : size_t {
+    // alpha_g1, beta_g1, delta_g1
+    groth16_mapped_fixed_g1 = 0,
+    // beta_g2, delta_g2
+    groth16_mapped_fixed_g2,
+    groth16_mapped_A_query,
+    groth16_mapped_B_query_indices,
+    groth16_mapped_B_query_g,
+    groth16_mapped_B_query_h,
+    groth16_mapped_H_query,
+    groth16_mapped_L_query,
+    // Verification key, in the format of verification_key_write_bytes
+    groth16_mapped_verification_key,
+    // Constraint system, in the format of r1cs_write_bytes
+    groth16_mapped_constraint_system,
+    groth16_mapped_num_sections,
+};
+
+struct groth16_mapped_section_entry {
+    uint64_t offset;
+    uint64_t num_bytes;
+    uint64_t count;
+};
+
+struct groth16_mapped_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t limb_size;
+    uint32_t g1_size;
+    uint32_t g2_size;
+    uint32_t reserved;
+    char curve_name[32];
+    uint64_t num_inputs;
+    uint64_t num_variables;
+    uint64_t num_constraints;
+    uint64_t B_query_domain_size;
+    groth16_mapped_section_entry sections[groth16_mapped_num_sections];
+};
+
+static size_t groth16_mapped_align(const size_t offset)
+{
+    return (offset + groth16_mapped_alignment - 1) &
+           ~(groth16_mapped_alignment - 1);
+}
+
+static const groth16_mapped_header &groth16_mapped_get_header(
+    const mapped_file &file)
+{
+    return *(const groth16_mapped_header *)file.data();
+}
+
+// Copy of a group element, in affine form (Z = 1, or the canonical
+// representation of zero).
+template<typename GroupT> GroupT groth16_mapped_affine(const GroupT &point)
+{
+    GroupT affine = point;
+    if (!affine.is_special()) {
+        affine.to_affine_coordinates();
+    }
+    return affine;
+}
+
+template<typename GroupT>
+void groth16_mapped_write_group_element(
+    const GroupT &point, std::ostream &out_s)
+{
+    const GroupT affine = groth16_mapped_affine(point);
+    out_s.write((const char *)&affine, sizeof(GroupT));
+}
+
+// Write `num_points` group elements, where `get_point(i)` gives the i-th
+// element, in affine form. Elements are converted in chunks, using
+// batch_to_affine.
+template<typename GroupT, typename GetPointT>
+void groth16_mapped_write_group_elements(
+    const size_t num_points, const GetPointT &get_point, std::ostream &out_s)
+{
+    const size_t chunk_size = 1 << 16;
+    std::vector<GroupT> chunk;
+    chunk.reserve(std::min<size_t>(chunk_size, num_points));
+    for (size_t begin = 0; begin < num_points; begin += chunk_size) {
+        const size_t end = std::min(begin + chunk_size, num_points);
+        chunk.clear();
+        for (size_t i = begin; i < end; ++i) {
+            chunk.push_back(get_point(i));
+        }
+        batch_to_affine(chunk);
+        out_s.write((const char *)chunk.data(), chunk.size() * sizeof(GroupT));
+    }
+}
+
+template<typename GroupT>
+bool groth16_mapped_all_well_formed(const GroupT *points, const size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        if (!points[i].is_well_formed()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void groth16_mapped_write_padding(
+    const size_t current_offset,
+    const size_t target_offset,
+    std::ostream &out_s)
+{
+    assert(target_offset >= current_offset);
+    static const char zeroes[groth16_mapped_alignment] = {0};
+    out_s.write(zeroes, target_offset - current_offset);
+}
+
+} // namespace internal
+
+template<typename ppT>
+groth16_mapped_proving_key<ppT>::groth16_mapped_proving_key(
+    const std::string &file_path)
+    : file(file_path)
+{
+    using namespace internal;
+
+    if (file.size() < sizeof(groth16_mapped_header)) {
+        throw std::invalid_argument("mapped proving key: file too small");
+    }
+
+    const groth16_mapped_header &header = groth16_mapped_get_header(file);
+    if (0 != memcmp(
+                 header.magic,
+                 groth16_mapped_magic,
+                 sizeof(groth16_mapped_magic))) {
+        throw std::invalid_argument("mapped proving key: invalid magic");
+    }
+    if (header.version != groth16_mapped_version) {
+        throw std::invalid_argument("mapped proving key: unknown version");
+    }
+    if (header.header_size != sizeof(groth16_mapped_header) ||
+        header.limb_size != sizeof(mp_limb_t) ||
+        header.g1_size != sizeof(G1) || header.g2_size != sizeof(G2)) {
+        throw std::invalid_argument(
+            "mapped proving key: incompatible element layout");
+    }
+    const std::string curve_name = pp_name<ppT>();
+    if (0 != strncmp(
+                 header.curve_name,
+                 curve_name.c_str(),
+                 sizeof(header.curve_name))) {
+        throw std::invalid_argument("mapped proving key: curve mismatch");
+    }
+
+    const size_t element_sizes[groth16_mapped_num_sections] = {
+        sizeof(G1),
+        sizeof(G2),
+        sizeof(G1),
+        sizeof(uint64_t),
+        sizeof(G2),
+        sizeof(G1),
+        sizeof(G1),
+        sizeof(G1),
+        1,
+        1,
+    };
+    for (size_t i = 0; i < groth16_mapped_num_sections; ++i) {
+        const groth16_mapped_section_entry &section = header.sections[i];
+        if ((section.offset % groth16_mapped_alignment) != 0 ||
+            section.offset > file.size() ||
+            section.num_bytes > file.size() - section.offset ||
+            section.num_bytes != section.count * element_sizes[i]) {
+            throw std::invalid_argument("mapped proving key: invalid section");
+        }
+    }
+
+    if (header.sections[groth16_mapped_fixed_g1].count != 3 ||
+        header.sections[groth16_mapped_fixed_g2].count != 2 ||
+        header.sections[groth16_mapped_B_query_g].count !=
+            header.sections[groth16_mapped_B_query_indices].count ||
+        header.sections[groth16_mapped_B_query_h].count !=
+            header.sections[groth16_mapped_B_query_indices].count) {
+        throw std::invalid_argument("mapped proving key: invalid sizes");
+    }
+}
+
+template<typename ppT>
+void groth16_mapped_proving_key<ppT>::write(
+    const typename snark::proving_key &pk,
+    const typename snark::verification_key &vk,
+    std::ostream &out_s)
+{
+    using namespace internal;
+
+    // Serialize the variable-size, non-group-element data first, to compute
+    // the layout.
+    std::ostringstream vk_s;
+    snark::verification_key_write_bytes(vk, vk_s);
+    const std::string vk_bytes = vk_s.str();
+
+    std::ostringstream cs_s;
+    r1cs_write_bytes(pk.constraint_system, cs_s);
+    const std::string cs_bytes = cs_s.str();
+
+    const size_t B_query_size = pk.B_query.indices.size();
+    assert(B_query_size == pk.B_query.values.size());
+
+    groth16_mapped_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, groth16_mapped_magic, sizeof(groth16_mapped_magic));
+    header.version = groth16_mapped_version;
+    header.header_size = sizeof(groth16_mapped_header);
+    header.limb_size = sizeof(mp_limb_t);
+    header.g1_size = sizeof(G1);
+    header.g2_size = sizeof(G2);
+    const std::string curve_name = pp_name<ppT>();
+    strncpy(header.curve_name, curve_name.c_str(), sizeof(header.curve_name));
+    header.num_inputs = pk.constraint_system.num_inputs();
+    header.num_variables = pk.constraint_system.num_variables();
+    header.num_constraints = pk.constraint_system.num_constraints();
+    header.B_query_domain_size = pk.B_query.domain_size();
+
+    const size_t counts[groth16_mapped_num_sections] = {
+        3,
+        2,
+        pk.A_query.size(),
+        B_query_size,
+        B_query_size,
+        B_query_size,
+        pk.H_query.size(),
+        pk.L_query.size(),
+        vk_bytes.size(),
+        cs_bytes.size(),
+    };
+    const size_t element_sizes[groth16_mapped_num_sections] = {
+        sizeof(G1),
+        sizeof(G2),
+        sizeof(G1),
+        sizeof(uint64_t),
+        sizeof(G2),
+        sizeof(G1),
+        sizeof(G1),
+        sizeof(G1),
+        1,
+        1,
+    };
+
+    size_t offset = groth16_mapped_align(sizeof(groth16_mapped_header));
+    for (size_t i = 0; i < groth16_mapped_num_sections; ++i) {
+        header.sections[i].offset = offset;
+        header.sections[i].count = counts[i];
+        header.sections[i].num_bytes = counts[i] * element_sizes[i];
+        offset = groth16_mapped_align(offset + header.sections[i].num_bytes);
+    }
+
+    // Write header and sections, in order, padding to the start of each
+    // section.
+    out_s.write((const char *)&header, sizeof(header));
+    size_t current = sizeof(header);
+    const auto start_section = [&](const size_t section) {
+        groth16_mapped_write_padding(
+            current, header.sections[section].offset, out_s);
+        current = header.sections[section].offset +
+                  header.sections[section].num_bytes;
+    };
+
+    start_section(groth16_mapped_fixed_g1);
+    groth16_mapped_write_group_element(pk.alpha_g1, out_s);
+    groth16_mapped_write_group_element(pk.beta_g1, out_s);
+    groth16_mapped_write_group_element(pk.delta_g1, out_s);
+
+    start_section(groth16_mapped_fixed_g2);
+    groth16_mapped_write_group_element(pk.beta_g2, out_s);
+    groth16_mapped_write_group_element(pk.delta_g2, out_s);
+
+    start_section(groth16_mapped_A_query);
+    groth16_mapped_write_group_elements<G1>(
+        pk.A_query.size(),
+        [&pk](const size_t i) -> const G1 & { return pk.A_query[i]; },
+        out_s);
+
+    start_section(groth16_mapped_B_query_indices);
+    for (const size_t idx : pk.B_query.indices) {
+        const uint64_t idx64 = idx;
+        out_s.write((const char *)&idx64, sizeof(idx64));
+    }
+
+    start_section(groth16_mapped_B_query_g);
+    groth16_mapped_write_group_elements<G2>(
+        B_query_size,
+        [&pk](const size_t i) -> const G2 & { return pk.B_query.values[i].g; },
+        out_s);
+
+    start_section(groth16_mapped_B_query_h);
+    groth16_mapped_write_group_elements<G1>(
+        B_query_size,
+        [&pk](const size_t i) -> const G1 & { return pk.B_query.values[i].h; },
+        out_s);
+
+    start_section(groth16_mapped_H_query);
+    groth16_mapped_write_group_elements<G1>(
+        pk.H_query.size(),
+        [&pk](const size_t i) -> const G1 & { return pk.H_query[i]; },
+        out_s);
+
+    start_section(groth16_mapped_L_query);
+    groth16_mapped_write_group_elements<G1>(
+        pk.L_query.size(),
+        [&pk](const size_t i) -> const G1 & { return pk.L_query[i]; },
+        out_s);
+
+    start_section(groth16_mapped_verification_key);
+    out_s.write(vk_bytes.data(), vk_bytes.size());
+
+    start_section(groth16_mapped_constraint_system);
+    out_s.write(cs_bytes.data(), cs_bytes.size());
+}
+
+template<typename ppT>
+template<typename T>
+const T *groth16_mapped_proving_key<ppT>::section_data(size_t section) const
+{
+    const internal::groth16_mapped_header &header =
+        internal::groth16_mapped_get_header(file);
+    return (const T *)(file.data() + header.sections[section].offset);
+}
+
+template<typename ppT>
+size_t groth16_mapped_proving_key<ppT>::section_count(size_t section) const
+{
+    return internal::groth16_mapped_get_header(file).sections[section].count;
+}
+
+template<typename ppT>
+const libff::G1<ppT> &groth16_mapped_proving_key<ppT>::alpha_g1() const
+{
+    return section_data<G1>(internal::groth16_mapped_fixed_g1)[0];
+}
+
+template<typename ppT>
+const libff::G1<ppT> &groth16_mapped_proving_key<ppT>::beta_g1() const
+{
+    return section_data<G1>(internal::groth16_mapped_fixed_g1)[1];
+}
+
+template<typename ppT>
+const libff::G2<ppT> &groth16_mapped_proving_key<ppT>::beta_g2() const
+{
+    return section_data<G2>(internal::groth16_mapped_fixed_g2)[0];
+}
+
+template<typename ppT>
+const libff::G1<ppT> &groth16_mapped_proving_key<ppT>::delta_g1() const
+{
+    return section_data<G1>(internal::groth16_mapped_fixed_g1)[2];
+}
+
+template<typename ppT>
+const libff::G2<ppT> &groth16_mapped_proving_key<ppT>::delta_g2() const
+{
+    return section_data<G2>(internal::groth16_mapped_fixed_g2)[1];
+}
+
+template<typename ppT>
+const libff::G1<ppT> *groth16_mapped_proving_key<ppT>::A_query() const
+{
+    return section_data<G1>(internal::groth16_mapped_A_query);
+}
+
+template<typename ppT>
+size_t groth16_mapped_proving_key<ppT>::A_query_size() const
+{
+    return section_count(internal::groth16_mapped_A_query);
+}
+
+template<typename ppT>
+const uint64_t *groth16_mapped_proving_key<ppT>::B_query_indices() const
+{
+    return section_data<uint64_t>(internal::groth16_mapped_B_query_indices);
+}
+
+template<typename ppT>
+const libff::G2<ppT> *groth16_mapped_proving_key<ppT>::B_query_g() const
+{
+    return section_data<G2>(internal::groth16_mapped_B_query_g);
+}
+
+template<typename ppT>
+const libff::G1<ppT> *groth16_mapped_proving_key<ppT>::B_query_h() const
+{
+    return section_data<G1>(internal::groth16_mapped_B_query_h);
+}
+
+template<typename ppT>
+size_t groth16_mapped_proving_key<ppT>::B_query_size() const
+{
+    return section_count(internal::groth16_mapped_B_query_indices);
+}
+
+template<typename ppT>
+size_t groth16_mapped_proving_key<ppT>::B_query_domain_size() const
+{
+    return internal::groth16_mapped_get_header(file).B_query_domain_size;
+}
+
+template<typename ppT>
+const libff::G1<ppT> *groth16_mapped_proving_key<ppT>::H_query() const
+{
+    return section_data<G1>(internal::groth16_mapped_H_query);
+}
+
+template<typename ppT>
+size_t groth16_mapped_proving_key<ppT>::H_query_size() const
+{
+    return section_count(internal::groth16_mapped_H_query);
+}
+
+template<typename ppT>
+const libff::G1<ppT> *groth16_mapped_proving_key<ppT>::L_query() const
+{
+    return section_data<G1>(internal::groth16_mapped_L_query);
+}
+
+template<typename ppT>
+size_t groth16_mapped_proving_key<ppT>::L_query_size() const
+{
+    return section_count(internal::groth16_mapped_L_query);
+}
+
+template<typename ppT>
+size_t groth16_mapped_proving_key<ppT>::num_inputs() const
+{
+    return internal::groth16_mapped_get_header(file).num_inputs;
+}
+
+template<typename ppT>
+size_t groth16_mapped_proving_key<ppT>::num_variables() const
+{
+    return internal::groth16_mapped_get_header(file).num_variables;
+}
+
+template<typename ppT>
+size_t groth16_mapped_proving_key<ppT>::num_constraints() const
+{
+    return internal::groth16_mapped_get_header(file).num_constraints;
+}
+
+template<typename ppT>
+void groth16_mapped_proving_key<ppT>::verification_key_read(
+    typename snark::verification_key &vk) const
+{
+    const std::string vk_bytes(
+        section_data<char>(internal::groth16_mapped_verification_key),
+        section_count(internal::groth16_mapped_verification_key));
+    std::istringstream in_s(vk_bytes);
+    in_s.exceptions(
+        std::ios_base::eofbit | std::ios_base::badbit | std::ios_base::failbit);
+    snark::verification_key_read_bytes(vk, in_s);
+}
+
+template<typename ppT>
+void groth16_mapped_proving_key<ppT>::constraint_system_read(
+    libsnark::r1cs_constraint_system<Field> &cs) const
+{
+    const std::string cs_bytes(
+        section_data<char>(internal::groth16_mapped_constraint_system),
+        section_count(internal::groth16_mapped_constraint_system));
+    std::istringstream in_s(cs_bytes);
+    in_s.exceptions(
+        std::ios_base::eofbit | std::ios_base::badbit | std::ios_base::failbit);
+    r1cs_read_bytes(cs, in_s);
+}
+
+template<typename ppT>
+void groth16_mapped_proving_key<ppT>::to_proving_key(
+    typename snark::proving_key &pk,
+    const libsnark::r1cs_constraint_system<Field> *cs) const
+{
+    pk.alpha_g1 = alpha_g1();
+    pk.beta_g1 = beta_g1();
+    pk.beta_g2 = beta_g2();
+    pk.delta_g1 = delta_g1();
+    pk.delta_g2 = delta_g2();
+    pk.A_query.assign(A_query(), A_query() + A_query_size());
+
+    const size_t B_size = B_query_size();
+    const uint64_t *const B_indices = B_query_indices();
+    const G2 *const B_g = B_query_g();
+    const G1 *const B_h = B_query_h();
+    pk.B_query.domain_size_ = B_query_domain_size();
+    pk.B_query.indices.assign(B_indices, B_indices + B_size);
+    pk.B_query.values.clear();
+    pk.B_query.values.reserve(B_size);
+    for (size_t i = 0; i < B_size; ++i) {
+        pk.B_query.values.emplace_back(B_g[i], B_h[i]);
+    }
+
+    pk.H_query.assign(H_query(), H_query() + H_query_size());
+    pk.L_query.assign(L_query(), L_query() + L_query_size());
+
+    if (cs != nullptr) {
+        if (cs->num_inputs() != num_inputs() ||
+            cs->num_variables() != num_variables() ||
+            cs->num_constraints() != num_constraints()) {
+            throw std::invalid_argument(
+                "mapped proving key: constraint system mismatch");
+        }
+        pk.constraint_system = *cs;
+    } else {
+        constraint_system_read(pk.constraint_system);
+    }
+}
+
+template<typename ppT>
+bool groth16_mapped_proving_key<ppT>::is_well_formed() const
+{
+    using namespace internal;
+    return groth16_mapped_all_well_formed(
+               section_data<G1>(groth16_mapped_fixed_g1), 3) &&
+           groth16_mapped_all_well_formed(
+               section_data<G2>(groth16_mapped_fixed_g2), 2) &&
+           groth16_mapped_all_well_formed(A_query(), A_query_size()) &&
+           groth16_mapped_all_well_formed(B_query_g(), B_query_size()) &&
+           groth16_mapped_all_well_formed(B_query_h(), B_query_size()) &&
+           groth16_mapped_all_well_formed(H_query(), H_query_size()) &&
+           groth16_mapped_all_well_formed(L_query(), L_query_size());
+}
+
+template<typename ppT> void groth16_mapped_proving_key<ppT>::prefetch() const
+{
+    file.will_need(0, file.size());
+}
+
+} // namespace libzeth
+
+#endif // __ZETH_SNARKS_GROTH16_GROTH16_MAPPED_PROVING_KEY_TCC__
@@ -0,0 +1,78 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_SNARKS_GROTH16_GROTH16_PRECOMPUTED_BASES_HPP__
+#define __ZETH_SNARKS_GROTH16_GROTH16_PRECOMPUTED_BASES_HPP__
+
+#include "libzeth/core/mapped_file.hpp"
+#include "libzeth/snarks/groth16/groth16_snark.hpp"
+
+namespace libzeth
+{
+
+/// Precomputed multiples of the bases of a Groth16 proving key (A_query,
+/// both components of B_query, H_query and L_query), in a memory-mapped
+/// sidecar file, for use with multi_exp_precomputed. For each base P, the
+/// table holds 2^(j * window_size) * P for each window j, so that the
+/// multi-exponentiations of the prover require no doublings.
+///
+/// The file size is roughly num_windows times that of the mapped proving key
+/// (see groth16_mapped_proving_key, whose layout conventions are also used
+/// here), where num_windows is approximately 256 / window_size. Larger window
+/// sizes therefore reduce the size of the file, at the cost of more work
+/// per proof.
+template<typename ppT> class groth16_precomputed_bases
+{
+public:
+    using snark = groth16_snark<ppT>;
+    using Field = libff::Fr<ppT>;
+    using G1 = libff::G1<ppT>;
+    using G2 = libff::G2<ppT>;
+
+    /// Map an existing file of precomputed bases.
+    explicit groth16_precomputed_bases(const std::string &file_path);
+
+    /// Window size used by `write` if none is given, based on the sizes of
+    /// the queries of the proving key.
+    static size_t default_window_size(const typename snark::proving_key &pk);
+
+    /// Compute the tables for the given proving key, writing the result to
+    /// out_s. If window_size is 0, default_window_size is used.
+    static void write(
+        const typename snark::proving_key &pk,
+        const size_t window_size,
+        std::ostream &out_s);
+
+    size_t window_size() const;
+    size_t num_windows() const;
+
+    /// Tables for each query, with num_windows entries per base (see
+    /// multi_exp_precompute).
+    const G1 *A_query() const;
+    const G2 *B_query_g() const;
+    const G1 *B_query_h() const;
+    const G1 *H_query() const;
+    const G1 *L_query() const;
+
+    /// Check that the tables have the dimensions of the given proving key,
+    /// and that (a sample of) the bases match. The check is not exhaustive:
+    /// files are expected to be generated from the key with which they are
+    /// used.
+    bool matches(const typename snark::proving_key &pk) const;
+
+    /// Hint to the OS that the tables will be needed soon.
+    void prefetch() const;
+
+private:
+    template<typename T> const T *section_data(size_t section) const;
+    size_t section_count(size_t section) const;
+
+    mapped_file file;
+};
+
+} // namespace libzeth
+
+#include "libzeth/snarks/groth16/groth16_precomputed_bases.tcc"
+
+#endif // __ZETH_SNARKS_GROTH16_GROTH16_PRECOMPUTED_BASES_HPP__
@@ -0,0 +1,379 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_SNARKS_GROTH16_GROTH16_PRECOMPUTED_BASES_TCC__
+#define __ZETH_SNARKS_GROTH16_GROTH16_PRECOMPUTED_BASES_TCC__
+
+#include "libzeth/core/multi_exp.hpp"
+#include "libzeth/snarks/groth16/groth16_mapped_proving_key.hpp"
+#include "libzeth/snarks/groth16/groth16_precomputed_bases.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace libzeth
+{
+
+namespace internal
+{
+
+static const char groth16_precomputed_magic[8] = {
+    'Z', 'E', 'T', 'H', 'G', '1', '6', 'P'};
+static const uint32_t groth16_precomputed_version = 1;
+
+// Sections of the file, in the order in which they appear. Each section holds
+// num_windows entries for each base of the corresponding query.
+enum groth16_precomputed_section : size_t {
+    groth16_precomputed_A_query = 0,
+    groth16_precomputed_B_query_g,
+    groth16_precomputed_B_query_h,
+    groth16_precomputed_H_query,
+    groth16_precomputed_L_query,
+    groth16_precomputed_num_sections,
+};
+
+// As for the mapped proving key, `count` is the number of bases (rather than
+// the number of entries) in each section.
+struct groth16_precomputed_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t limb_size;
+    uint32_t g1_size;
+    uint32_t g2_size;
+    uint32_t window_size;
+    uint32_t num_windows;
+    uint32_t reserved;
+    char curve_name[32];
+    groth16_mapped_section_entry sections[groth16_precomputed_num_sections];
+};
+
+static const groth16_precomputed_header &groth16_precomputed_get_header(
+    const mapped_file &file)
+{
+    return *(const groth16_precomputed_header *)file.data();
+}
+
+// Write the tables for `num_bases` bases, where `get_base(i)` gives the i-th
+// base. Bases are processed in chunks, to bound the memory used.
+template<typename GroupT, typename GetBaseT>
+void groth16_precomputed_write_tables(
+    const size_t num_bases,
+    const GetBaseT &get_base,
+    const size_t window_size,
+    const size_t num_windows,
+    std::ostream &out_s)
+{
+    const size_t chunk_size = 1 << 12;
+    std::vector<GroupT> bases;
+    std::vector<GroupT> table;
+    bases.reserve(std::min(chunk_size, num_bases));
+    for (size_t begin = 0; begin < num_bases; begin += chunk_size) {
+        const size_t end = std::min(begin + chunk_size, num_bases);
+        bases.clear();
+        for (size_t i = begin; i < end; ++i) {
+            bases.push_back(get_base(i));
+        }
+        table.resize(bases.size() * num_windows);
+        multi_exp_precompute(
+            bases.data(), bases.size(), window_size, num_windows, table.data());
+        out_s.write((const char *)table.data(), table.size() * sizeof(GroupT));
+    }
+}
+
+// Compare the first and last bases in a table against the given bases.
+template<typename GroupT, typename GetBaseT>
+bool groth16_precomputed_bases_match(
+    const GroupT *table,
+    const size_t num_windows,
+    const size_t num_bases,
+    const GetBaseT &get_base)
+{
+    if (num_bases == 0) {
+        return true;
+    }
+    return table[0] == get_base(0) &&
+           table[(num_bases - 1) * num_windows] == get_base(num_bases - 1);
+}
+
+} // namespace internal
+
+template<typename ppT>
+groth16_precomputed_bases<ppT>::groth16_precomputed_bases(
+    const std::string &file_path)
+    : file(file_path)
+{
+    using namespace internal;
+
+    if (file.size() < sizeof(groth16_precomputed_header)) {
+        throw std::invalid_argument("precomputed bases: file too small");
+    }
+
+    const groth16_precomputed_header &header =
+        groth16_precomputed_get_header(file);
+    if (0 != memcmp(
+                 header.magic,
+                 groth16_precomputed_magic,
+                 sizeof(groth16_precomputed_magic))) {
+        throw std::invalid_argument("precomputed bases: invalid magic");
+    }
+    if (header.version != groth16_precomputed_version) {
+        throw std::invalid_argument("precomputed bases: unknown version");
+    }
+    if (header.header_size != sizeof(groth16_precomputed_header) ||
+        header.limb_size != sizeof(mp_limb_t) ||
+        header.g1_size != sizeof(G1) || header.g2_size != sizeof(G2)) {
+        throw std::invalid_argument(
+            "precomputed bases: incompatible element layout");
+    }
+    const std::string curve_name = pp_name<ppT>();
+    if (0 != strncmp(
+                 header.curve_name,
+                 curve_name.c_str(),
+                 sizeof(header.curve_name))) {
+        throw std::invalid_argument("precomputed bases: curve mismatch");
+    }
+    if (header.window_size < 2 || header.window_size > 30 ||
+        header.num_windows <
+            multi_exp_precomputed_num_windows<Field>(header.window_size)) {
+        throw std::invalid_argument("precomputed bases: invalid window size");
+    }
+
+    for (size_t i = 0; i < groth16_precomputed_num_sections; ++i) {
+        const groth16_mapped_section_entry &section = header.sections[i];
+        const size_t element_size =
+            (i == groth16_precomputed_B_query_g) ? sizeof(G2) : sizeof(G1);
+        if ((section.offset % groth16_mapped_alignment) != 0 ||
+            section.offset > file.size() ||
+            section.num_bytes > file.size() - section.offset ||
+            section.num_bytes !=
+                section.count * header.num_windows * element_size) {
+            throw std::invalid_argument("precomputed bases: invalid section");
+        }
+    }
+
+    if (header.sections[groth16_precomputed_B_query_g].count !=
+        header.sections[groth16_precomputed_B_query_h].count) {
+        throw std::invalid_argument("precomputed bases: invalid sizes");
+    }
+}
+
+template<typename ppT>
+size_t groth16_precomputed_bases<ppT>::default_window_size(
+    const typename snark::proving_key &pk)
+{
+    const size_t max_size = std::max(
+        std::max(pk.A_query.size(), pk.B_query.indices.size()),
+        std::max(pk.H_query.size(), pk.L_query.size()));
+    return std::min<size_t>(
+        30, std::max<size_t>(2, internal::multi_exp_window_size(max_size)));
+}
+
+template<typename ppT>
+void groth16_precomputed_bases<ppT>::write(
+    const typename snark::proving_key &pk,
+    const size_t window_size,
+    std::ostream &out_s)
+{
+    using namespace internal;
+
+    const size_t c = (window_size == 0) ? default_window_size(pk) : window_size;
+    if (c < 2 || c > 30) {
+        throw std::invalid_argument("precomputed bases: invalid window size");
+    }
+    const size_t num_windows = multi_exp_precomputed_num_windows<Field>(c);
+    const size_t B_query_size = pk.B_query.indices.size();
+
+    groth16_precomputed_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(
+        header.magic,
+        groth16_precomputed_magic,
+        sizeof(groth16_precomputed_magic));
+    header.version = groth16_precomputed_version;
+    header.header_size = sizeof(groth16_precomputed_header);
+    header.limb_size = sizeof(mp_limb_t);
+    header.g1_size = sizeof(G1);
+    header.g2_size = sizeof(G2);
+    header.window_size = c;
+    header.num_windows = num_windows;
+    const std::string curve_name = pp_name<ppT>();
+    strncpy(header.curve_name, curve_name.c_str(), sizeof(header.curve_name));
+
+    const size_t counts[groth16_precomputed_num_sections] = {
+        pk.A_query.size(),
+        B_query_size,
+        B_query_size,
+        pk.H_query.size(),
+        pk.L_query.size(),
+    };
+    size_t offset = groth16_mapped_align(sizeof(groth16_precomputed_header));
+    for (size_t i = 0; i < groth16_precomputed_num_sections; ++i) {
+        const size_t element_size =
+            (i == groth16_precomputed_B_query_g) ? sizeof(G2) : sizeof(G1);
+        header.sections[i].offset = offset;
+        header.sections[i].count = counts[i];
+        header.sections[i].num_bytes = counts[i] * num_windows * element_size;
+        offset = groth16_mapped_align(offset + header.sections[i].num_bytes);
+    }
+
+    out_s.write((const char *)&header, sizeof(header));
+    size_t current = sizeof(header);
+    const auto start_section = [&](const size_t section) {
+        groth16_mapped_write_padding(
+            current, header.sections[section].offset, out_s);
+        current = header.sections[section].offset +
+                  header.sections[section].num_bytes;
+    };
+
+    start_section(groth16_precomputed_A_query);
+    groth16_precomputed_write_tables<G1>(
+        pk.A_query.size(),
+        [&pk](const size_t i) -> const G1 & { return pk.A_query[i]; },
+        c,
+        num_windows,
+        out_s);
+
+    start_section(groth16_precomputed_B_query_g);
+    groth16_precomputed_write_tables<G2>(
+        B_query_size,
+        [&pk](const size_t i) -> const G2 & { return pk.B_query.values[i].g; },
+        c,
+        num_windows,
+        out_s);
+
+    start_section(groth16_precomputed_B_query_h);
+    groth16_precomputed_write_tables<G1>(
+        B_query_size,
+        [&pk](const size_t i) -> const G1 & { return pk.B_query.values[i].h; },
+        c,
+        num_windows,
+        out_s);
+
+    start_section(groth16_precomputed_H_query);
+    groth16_precomputed_write_tables<G1>(
+        pk.H_query.size(),
+        [&pk](const size_t i) -> const G1 & { return pk.H_query[i]; },
+        c,
+        num_windows,
+        out_s);
+
+    start_section(groth16_precomputed_L_query);
+    groth16_precomputed_write_tables<G1>(
+        pk.L_query.size(),
+        [&pk](const size_t i) -> const G1 & { return pk.L_query[i]; },
+        c,
+        num_windows,
+        out_s);
+}
+
+template<typename ppT>
+template<typename T>
+const T *groth16_precomputed_bases<ppT>::section_data(size_t section) const
+{
+    const internal::groth16_precomputed_header &header =
+        internal::groth16_precomputed_get_header(file);
+    return (const T *)(file.data() + header.sections[section].offset);
+}
+
+template<typename ppT>
+size_t groth16_precomputed_bases<ppT>::section_count(size_t section) const
+{
+    return internal::groth16_precomputed_get_header(file)
+        .sections[section]
+        .count;
+}
+
+template<typename ppT>
+size_t groth16_precomputed_bases<ppT>::window_size() const
+{
+    return internal::groth16_precomputed_get_header(file).window_size;
+}
+
+template<typename ppT>
+size_t groth16_precomputed_bases<ppT>::num_windows() const
+{
+    return internal::groth16_precomputed_get_header(file).num_windows;
+}
+
+template<typename ppT>
+const libff::G1<ppT> *groth16_precomputed_bases<ppT>::A_query() const
+{
+    return section_data<G1>(internal::groth16_precomputed_A_query);
+}
+
+template<typename ppT>
+const libff::G2<ppT> *groth16_precomputed_bases<ppT>::B_query_g() const
+{
+    return section_data<G2>(internal::groth16_precomputed_B_query_g);
+}
+
+template<typename ppT>
+const libff::G1<ppT> *groth16_precomputed_bases<ppT>::B_query_h() const
+{
+    return section_data<G1>(internal::groth16_precomputed_B_query_h);
+}
+
+template<typename ppT>
+const libff::G1<ppT> *groth16_precomputed_bases<ppT>::H_query() const
+{
+    return section_data<G1>(internal::groth16_precomputed_H_query);
+}
+
+template<typename ppT>
+const libff::G1<ppT> *groth16_precomputed_bases<ppT>::L_query() const
+{
+    return section_data<G1>(internal::groth16_precomputed_L_query);
+}
+
+template<typename ppT>
+bool groth16_precomputed_bases<ppT>::matches(
+    const typename snark::proving_key &pk) const
+{
+    using namespace internal;
+
+    const size_t B_query_size = pk.B_query.indices.size();
+    if (section_count(groth16_precomputed_A_query) != pk.A_query.size() ||
+        section_count(groth16_precomputed_B_query_g) != B_query_size ||
+        section_count(groth16_precomputed_H_query) != pk.H_query.size() ||
+        section_count(groth16_precomputed_L_query) != pk.L_query.size()) {
+        return false;
+    }
+
+    const size_t w = num_windows();
+    return groth16_precomputed_bases_match(
+               A_query(),
+               w,
+               pk.A_query.size(),
+               [&pk](const size_t i) { return pk.A_query[i]; }) &&
+           groth16_precomputed_bases_match(
+               B_query_g(),
+               w,
+               B_query_size,
+               [&pk](const size_t i) { return pk.B_query.values[i].g; }) &&
+           groth16_precomputed_bases_match(
+               B_query_h(),
+               w,
+               B_query_size,
+               [&pk](const size_t i) { return pk.B_query.values[i].h; }) &&
+           groth16_precomputed_bases_match(
+               H_query(),
+               w,
+               pk.H_query.size(),
+               [&pk](const size_t i) { return pk.H_query[i]; }) &&
+           groth16_precomputed_bases_match(
+               L_query(),
+               w,
+               pk.L_query.size(),
+               [&pk](const size_t i) { return pk.L_query[i]; });
+}
+
+template<typename ppT> void groth16_precomputed_bases<ppT>::prefetch() const
+{
+    file.will_need(0, file.size());
+}
+
+} // namespace libzeth
+
+#endif // __ZETH_SNARKS_GROTH16_GROTH16_PRECOMPUTED_BASES_TCC__
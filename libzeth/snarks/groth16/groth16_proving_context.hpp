@@ -0,0 +1,84 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_SNARKS_GROTH16_GROTH16_PROVING_CONTEXT_HPP__
+#define __ZETH_SNARKS_GROTH16_GROTH16_PROVING_CONTEXT_HPP__
+
+#include "libzeth/core/blocked_radix2_domain.hpp"
+#include "libzeth/core/qap_witness_map.hpp"
+#include "libzeth/core/resource_pool.hpp"
+#include "libzeth/snarks/groth16/groth16_snark.hpp"
+
+namespace libzeth
+{
+
+/// Buffers used by the Groth16 prover while generating a single proof. The
+/// capacity of each buffer is retained between proofs.
+template<typename ppT> class groth16_proving_workspace
+{
+public:
+    using Field = libff::Fr<ppT>;
+
+    qap_witness_workspace<Field> qap;
+    /// Full assignment, including the constant variable 1.
+    std::vector<Field> assignment;
+    std::vector<Field> H_coefficients;
+    std::vector<libff::bigint<Field::num_limbs>> B_scalars;
+};
+
+/// Data reused across all proofs for a given proving key: the QAP
+/// evaluation domain (with its precomputed twiddle factors and coset powers),
+/// optional precomputed bases, and a fixed set of workspaces. Intended to be
+/// created once (e.g. at server startup) and shared between threads. Each
+/// proof leases a workspace for its duration, so that the domain-sized
+/// buffers of the prover are allocated once rather than for every proof.
+template<typename ppT> class groth16_proving_context
+{
+public:
+    using snark = groth16_snark<ppT>;
+    using Field = libff::Fr<ppT>;
+    using workspace_pool = resource_pool<groth16_proving_workspace<ppT>>;
+
+    /// Create a context for `proving_key` with the given (non-zero) number
+    /// of workspaces, which bounds the number of proofs generated
+    /// concurrently. If given, `precomputed` must have been generated from
+    /// `proving_key` and must outlive the context.
+    groth16_proving_context(
+        const typename snark::proving_key &proving_key,
+        const size_t num_workspaces,
+        const groth16_precomputed_bases<ppT> *precomputed = nullptr);
+    groth16_proving_context(const groth16_proving_context &) = delete;
+    groth16_proving_context &operator=(const groth16_proving_context &) =
+        delete;
+
+    /// QAP domain of the proving key, or nullptr if its size is not a power
+    /// of 2 (see qap_radix2_domain).
+    const blocked_radix2_domain<Field> *domain() const;
+
+    /// Precomputed bases (or nullptr if none were given).
+    const groth16_precomputed_bases<ppT> *precomputed() const;
+
+    size_t num_workspaces() const;
+
+    /// Block until a workspace is available and return a lease on it.
+    typename workspace_pool::lease acquire_workspace() const;
+
+private:
+    static std::vector<std::unique_ptr<groth16_proving_workspace<ppT>>>
+    make_workspaces(
+        const typename snark::proving_key &proving_key,
+        const size_t domain_size,
+        const size_t num_workspaces);
+
+    std::unique_ptr<blocked_radix2_domain<Field>> qap_domain;
+    const groth16_precomputed_bases<ppT> *precomputed_bases;
+    // The pool is internally synchronized.
+    mutable workspace_pool workspaces;
+};
+
+} // namespace libzeth
+
+#include "libzeth/snarks/groth16/groth16_proving_context.tcc"
+
+#endif // __ZETH_SNARKS_GROTH16_GROTH16_PROVING_CONTEXT_HPP__
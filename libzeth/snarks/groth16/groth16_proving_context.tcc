@@ -0,0 +1,89 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_SNARKS_GROTH16_GROTH16_PROVING_CONTEXT_TCC__
+#define __ZETH_SNARKS_GROTH16_GROTH16_PROVING_CONTEXT_TCC__
+
+#include "libzeth/snarks/groth16/groth16_proving_context.hpp"
+
+#include <stdexcept>
+
+namespace libzeth
+{
+
+template<typename ppT>
+groth16_proving_context<ppT>::groth16_proving_context(
+    const typename snark::proving_key &proving_key,
+    const size_t num_workspaces,
+    const groth16_precomputed_bases<ppT> *precomputed)
+    : qap_domain(qap_radix2_domain<Field>(proving_key.H_query.size() + 1))
+    , precomputed_bases(precomputed)
+    , workspaces(make_workspaces(
+          proving_key, proving_key.H_query.size() + 1, num_workspaces))
+{
+    if (qap_domain) {
+        if (qap_domain->m != qap_domain_size(proving_key.constraint_system)) {
+            throw std::invalid_argument(
+                "proving key does not match constraint system");
+        }
+        qap_domain->precompute_coset(Field::multiplicative_generator);
+    }
+}
+
+template<typename ppT>
+const blocked_radix2_domain<libff::Fr<ppT>> *groth16_proving_context<
+    ppT>::domain() const
+{
+    return qap_domain.get();
+}
+
+template<typename ppT>
+const groth16_precomputed_bases<ppT> *groth16_proving_context<
+    ppT>::precomputed() const
+{
+    return precomputed_bases;
+}
+
+template<typename ppT>
+size_t groth16_proving_context<ppT>::num_workspaces() const
+{
+    return workspaces.size();
+}
+
+template<typename ppT>
+typename groth16_proving_context<ppT>::workspace_pool::lease
+groth16_proving_context<ppT>::acquire_workspace() const
+{
+    return workspaces.acquire();
+}
+
+template<typename ppT>
+std::vector<std::unique_ptr<groth16_proving_workspace<ppT>>>
+groth16_proving_context<ppT>::make_workspaces(
+    const typename snark::proving_key &proving_key,
+    const size_t domain_size,
+    const size_t num_workspaces)
+{
+    if (num_workspaces == 0) {
+        throw std::invalid_argument("at least one workspace is required");
+    }
+
+    const size_t num_variables = proving_key.A_query.size() - 1;
+    std::vector<std::unique_ptr<groth16_proving_workspace<ppT>>> result;
+    result.reserve(num_workspaces);
+    for (size_t i = 0; i < num_workspaces; ++i) {
+        result.emplace_back(new groth16_proving_workspace<ppT>());
+        groth16_proving_workspace<ppT> &workspace = *result.back();
+        workspace.qap.reserve(domain_size, num_variables);
+        workspace.assignment.reserve(num_variables + 1);
+        // H_coefficients may exchange its buffer with qap.aA.
+        workspace.H_coefficients.reserve(domain_size + 1);
+        workspace.B_scalars.reserve(proving_key.B_query.indices.size());
+    }
+    return result;
+}
+
+} // namespace libzeth
+
+#endif // __ZETH_SNARKS_GROTH16_GROTH16_PROVING_CONTEXT_TCC__
@@ -5,12 +5,18 @@
 #ifndef __ZETH_SNARKS_GROTH16_GROTH16_SNARK_HPP__
 #define __ZETH_SNARKS_GROTH16_GROTH16_SNARK_HPP__
 
+#include "libzeth/core/blocked_radix2_domain.hpp"
+
 #include <libsnark/gadgetlib1/protoboard.hpp>
 #include <libsnark/zk_proof_systems/ppzksnark/r1cs_gg_ppzksnark/r1cs_gg_ppzksnark.hpp>
 
 namespace libzeth
 {
 
+template<typename ppT> class groth16_precomputed_bases;
+template<typename ppT> class groth16_proving_context;
+template<typename ppT> class groth16_proving_workspace;
+
 /// Core types and operations for the GROTH16 snark
 template<typename ppT> class groth16_snark
 {
@@ -28,6 +34,11 @@ public:
     static keypair generate_setup(
         const libsnark::protoboard<libff::Fr<ppT>> &pb);
 
+    /// Run the trusted setup for the given constraint system (e.g. loaded
+    /// from a cache, see r1cs_cache_read)
+    static keypair generate_setup(
+        const libsnark::r1cs_constraint_system<libff::Fr<ppT>> &cs);
+
     /// Generate the proof (from the values set to the protoboard)
     static proof generate_proof(
         const proving_key &proving_key,
@@ -39,6 +50,66 @@ public:
         const libsnark::r1cs_primary_input<libff::Fr<ppT>> &primary_input,
         const libsnark::r1cs_auxiliary_input<libff::Fr<ppT>> auxiliary_input);
 
+    /// Generate the proof (from the values set to the protoboard), using
+    /// precomputed tables for the bases of the proving key (see
+    /// groth16_precomputed_bases), which must have been generated from
+    /// `proving_key`.
+    static proof generate_proof(
+        const proving_key &proving_key,
+        const groth16_precomputed_bases<ppT> &precomputed,
+        const libsnark::protoboard<libff::Fr<ppT>> &pb);
+
+    /// Generate the proof (from given primary and auxiliary values), using
+    /// precomputed tables for the bases of the proving key.
+    static proof generate_proof(
+        const proving_key &proving_key,
+        const groth16_precomputed_bases<ppT> &precomputed,
+        const libsnark::r1cs_primary_input<libff::Fr<ppT>> &primary_input,
+        const libsnark::r1cs_auxiliary_input<libff::Fr<ppT>> &auxiliary_input);
+
+    /// Generate the proof (from the values set to the protoboard), using the
+    /// QAP domain, the precomputed bases (if any) and a workspace (leased
+    /// for the duration of the proof) of `context`, which must have been
+    /// created for `proving_key`.
+    static proof generate_proof(
+        const proving_key &proving_key,
+        const groth16_proving_context<ppT> &context,
+        const libsnark::protoboard<libff::Fr<ppT>> &pb);
+
+    /// Generate the proof (from given primary and auxiliary values), using
+    /// a proving context created for `proving_key`.
+    static proof generate_proof(
+        const proving_key &proving_key,
+        const groth16_proving_context<ppT> &context,
+        const libsnark::r1cs_primary_input<libff::Fr<ppT>> &primary_input,
+        const libsnark::r1cs_auxiliary_input<libff::Fr<ppT>> &auxiliary_input);
+
+    /// Generate proofs for several assignments at once (from the given
+    /// primary and auxiliary values for each proof). Each
+    /// multi-exponentiation makes a single pass over the bases of the
+    /// proving key for all proofs (see multi_exp_batch), so that the bases
+    /// are read from memory once per batch rather than once per proof.
+    static std::vector<proof> generate_proofs(
+        const proving_key &proving_key,
+        const std::vector<libsnark::r1cs_primary_input<libff::Fr<ppT>>>
+            &primary_inputs,
+        const std::vector<libsnark::r1cs_auxiliary_input<libff::Fr<ppT>>>
+            &auxiliary_inputs);
+
+    /// Generate proofs for several assignments at once, using the QAP
+    /// domain, the precomputed bases (if any) and a workspace of `context`,
+    /// which must have been created for `proving_key`. When precomputed
+    /// bases are available, each proof uses them in turn (see
+    /// generate_proof), since the tables already remove the doublings which
+    /// batching amortizes.
+    static std::vector<proof> generate_proofs(
+        const proving_key &proving_key,
+        const groth16_proving_context<ppT> &context,
+        const std::vector<libsnark::r1cs_primary_input<libff::Fr<ppT>>>
+            &primary_inputs,
+        const std::vector<libsnark::r1cs_auxiliary_input<libff::Fr<ppT>>>
+            &auxiliary_inputs);
+
     /// Verify proof
     static bool verify(
         const libsnark::r1cs_primary_input<libff::Fr<ppT>> &primary_inputs,
@@ -76,6 +147,50 @@ public:
 
     /// Read a keypair from a stream.
     static void keypair_read_bytes(keypair &, std::istream &);
+
+private:
+    /// Compute the full assignment (including the constant variable 1) and
+    /// the coefficients of H used by the prover, in the assignment and
+    /// H_coefficients buffers of `workspace`. `domain` is null if the QAP
+    /// domain of the key is not a power of 2 (see qap_radix2_domain).
+    static void compute_witness(
+        const proving_key &proving_key,
+        const blocked_radix2_domain<libff::Fr<ppT>> *domain,
+        const libsnark::r1cs_primary_input<libff::Fr<ppT>> &primary_input,
+        const libsnark::r1cs_auxiliary_input<libff::Fr<ppT>> &auxiliary_input,
+        groth16_proving_workspace<ppT> &workspace);
+
+    /// Compute a (randomized) proof from the results of the
+    /// multi-exponentiations.
+    static proof compute_proof(
+        const proving_key &proving_key,
+        const libff::G1<ppT> &evaluation_At,
+        const libff::G2<ppT> &evaluation_Bt_g,
+        const libff::G1<ppT> &evaluation_Bt_h,
+        const libff::G1<ppT> &evaluation_Ht,
+        const libff::G1<ppT> &evaluation_Lt);
+
+    /// Implementation of generate_proof, where `precomputed` and `domain`
+    /// may be null.
+    static proof generate_proof_internal(
+        const proving_key &proving_key,
+        const groth16_precomputed_bases<ppT> *precomputed,
+        const blocked_radix2_domain<libff::Fr<ppT>> *domain,
+        groth16_proving_workspace<ppT> &workspace,
+        const libsnark::r1cs_primary_input<libff::Fr<ppT>> &primary_input,
+        const libsnark::r1cs_auxiliary_input<libff::Fr<ppT>> &auxiliary_input);
+
+    /// Implementation of generate_proofs, where `precomputed` and `domain`
+    /// may be null.
+    static std::vector<proof> generate_proofs_internal(
+        const proving_key &proving_key,
+        const groth16_precomputed_bases<ppT> *precomputed,
+        const blocked_radix2_domain<libff::Fr<ppT>> *domain,
+        groth16_proving_workspace<ppT> &workspace,
+        const std::vector<libsnark::r1cs_primary_input<libff::Fr<ppT>>>
+            &primary_inputs,
+        const std::vector<libsnark::r1cs_auxiliary_input<libff::Fr<ppT>>>
+            &auxiliary_inputs);
 };
 
 /// Check well-formedness of a proving key
@@ -5,23 +5,77 @@
 #ifndef __ZETH_SNARKS_GROTH16_GROTH16_SNARK_TCC__
 #define __ZETH_SNARKS_GROTH16_GROTH16_SNARK_TCC__
 
+#include "libzeth/core/glv.hpp"
 #include "libzeth/core/group_element_utils.hpp"
+#include "libzeth/core/multi_exp.hpp"
+#include "libzeth/core/qap_witness_map.hpp"
 #include "libzeth/core/utils.hpp"
 #include "libzeth/serialization/r1cs_serialization.hpp"
+#include "libzeth/snarks/groth16/groth16_precomputed_bases.hpp"
+#include "libzeth/snarks/groth16/groth16_proving_context.hpp"
 #include "libzeth/snarks/groth16/groth16_snark.hpp"
 
+#include <libsnark/reductions/r1cs_to_qap/r1cs_to_qap.hpp>
+#include <memory>
+#include <stdexcept>
+
 namespace libzeth
 {
 
+namespace internal
+{
+
+// Accessors for the G2 and G1 components of the entries of B_query, allowing
+// them to be used directly in multi_exp_bucket.
+template<typename ppT> class groth16_B_query_g
+{
+public:
+    using values_type = std::vector<
+        libsnark::knowledge_commitment<libff::G2<ppT>, libff::G1<ppT>>>;
+
+    explicit groth16_B_query_g(const values_type &values) : values(values) {}
+    const libff::G2<ppT> &operator[](const size_t i) const
+    {
+        return values[i].g;
+    }
+
+private:
+    const values_type &values;
+};
+
+template<typename ppT> class groth16_B_query_h
+{
+public:
+    using values_type = std::vector<
+        libsnark::knowledge_commitment<libff::G2<ppT>, libff::G1<ppT>>>;
+
+    explicit groth16_B_query_h(const values_type &values) : values(values) {}
+    const libff::G1<ppT> &operator[](const size_t i) const
+    {
+        return values[i].h;
+    }
+
+private:
+    const values_type &values;
+};
+
+} // namespace internal
+
 template<typename ppT> const std::string groth16_snark<ppT>::name("GROTH16");
 
 template<typename ppT>
 typename groth16_snark<ppT>::keypair groth16_snark<ppT>::generate_setup(
     const libsnark::protoboard<libff::Fr<ppT>> &pb)
+{
+    return generate_setup(pb.get_constraint_system());
+}
+
+template<typename ppT>
+typename groth16_snark<ppT>::keypair groth16_snark<ppT>::generate_setup(
+    const libsnark::r1cs_constraint_system<libff::Fr<ppT>> &cs)
 {
     // Generate verification and proving key from the R1CS
-    return libsnark::r1cs_gg_ppzksnark_generator<ppT>(
-        pb.get_constraint_system(), true);
+    return libsnark::r1cs_gg_ppzksnark_generator<ppT>(cs, true);
 }
 
 template<typename ppT>
@@ -39,10 +93,426 @@ typename groth16_snark<ppT>::proof groth16_snark<ppT>::generate_proof(
     const libsnark::r1cs_primary_input<libff::Fr<ppT>> &primary_input,
     const libsnark::r1cs_auxiliary_input<libff::Fr<ppT>> auxiliary_input)
 {
-    // Generate proof from public input, auxiliary input and proving key.
-    // For now, force a pow2 domain, in case the key came from the MPC.
-    return libsnark::r1cs_gg_ppzksnark_prover(
-        proving_key, primary_input, auxiliary_input, true);
+    const std::unique_ptr<blocked_radix2_domain<libff::Fr<ppT>>> domain =
+        qap_radix2_domain<libff::Fr<ppT>>(proving_key.H_query.size() + 1);
+    groth16_proving_workspace<ppT> workspace;
+    return generate_proof_internal(
+        proving_key,
+        nullptr,
+        domain.get(),
+        workspace,
+        primary_input,
+        auxiliary_input);
+}
+
+template<typename ppT>
+typename groth16_snark<ppT>::proof groth16_snark<ppT>::generate_proof(
+    const proving_key &proving_key,
+    const groth16_precomputed_bases<ppT> &precomputed,
+    const libsnark::protoboard<libff::Fr<ppT>> &pb)
+{
+    return generate_proof(
+        proving_key, precomputed, pb.primary_input(), pb.auxiliary_input());
+}
+
+template<typename ppT>
+typename groth16_snark<ppT>::proof groth16_snark<ppT>::generate_proof(
+    const proving_key &proving_key,
+    const groth16_precomputed_bases<ppT> &precomputed,
+    const libsnark::r1cs_primary_input<libff::Fr<ppT>> &primary_input,
+    const libsnark::r1cs_auxiliary_input<libff::Fr<ppT>> &auxiliary_input)
+{
+    const std::unique_ptr<blocked_radix2_domain<libff::Fr<ppT>>> domain =
+        qap_radix2_domain<libff::Fr<ppT>>(proving_key.H_query.size() + 1);
+    groth16_proving_workspace<ppT> workspace;
+    return generate_proof_internal(
+        proving_key,
+        &precomputed,
+        domain.get(),
+        workspace,
+        primary_input,
+        auxiliary_input);
+}
+
+template<typename ppT>
+typename groth16_snark<ppT>::proof groth16_snark<ppT>::generate_proof(
+    const proving_key &proving_key,
+    const groth16_proving_context<ppT> &context,
+    const libsnark::protoboard<libff::Fr<ppT>> &pb)
+{
+    return generate_proof(
+        proving_key, context, pb.primary_input(), pb.auxiliary_input());
+}
+
+template<typename ppT>
+typename groth16_snark<ppT>::proof groth16_snark<ppT>::generate_proof(
+    const proving_key &proving_key,
+    const groth16_proving_context<ppT> &context,
+    const libsnark::r1cs_primary_input<libff::Fr<ppT>> &primary_input,
+    const libsnark::r1cs_auxiliary_input<libff::Fr<ppT>> &auxiliary_input)
+{
+    typename groth16_proving_context<ppT>::workspace_pool::lease workspace =
+        context.acquire_workspace();
+    return generate_proof_internal(
+        proving_key,
+        context.precomputed(),
+        context.domain(),
+        *workspace,
+        primary_input,
+        auxiliary_input);
+}
+
+template<typename ppT>
+std::vector<typename groth16_snark<ppT>::proof> groth16_snark<ppT>::
+    generate_proofs(
+        const proving_key &proving_key,
+        const std::vector<libsnark::r1cs_primary_input<libff::Fr<ppT>>>
+            &primary_inputs,
+        const std::vector<libsnark::r1cs_auxiliary_input<libff::Fr<ppT>>>
+            &auxiliary_inputs)
+{
+    const std::unique_ptr<blocked_radix2_domain<libff::Fr<ppT>>> domain =
+        qap_radix2_domain<libff::Fr<ppT>>(proving_key.H_query.size() + 1);
+    groth16_proving_workspace<ppT> workspace;
+    return generate_proofs_internal(
+        proving_key,
+        nullptr,
+        domain.get(),
+        workspace,
+        primary_inputs,
+        auxiliary_inputs);
+}
+
+template<typename ppT>
+std::vector<typename groth16_snark<ppT>::proof> groth16_snark<ppT>::
+    generate_proofs(
+        const proving_key &proving_key,
+        const groth16_proving_context<ppT> &context,
+        const std::vector<libsnark::r1cs_primary_input<libff::Fr<ppT>>>
+            &primary_inputs,
+        const std::vector<libsnark::r1cs_auxiliary_input<libff::Fr<ppT>>>
+            &auxiliary_inputs)
+{
+    typename groth16_proving_context<ppT>::workspace_pool::lease workspace =
+        context.acquire_workspace();
+    return generate_proofs_internal(
+        proving_key,
+        context.precomputed(),
+        context.domain(),
+        *workspace,
+        primary_inputs,
+        auxiliary_inputs);
+}
+
+template<typename ppT>
+std::vector<typename groth16_snark<ppT>::proof> groth16_snark<ppT>::
+    generate_proofs_internal(
+        const proving_key &proving_key,
+        const groth16_precomputed_bases<ppT> *precomputed,
+        const blocked_radix2_domain<libff::Fr<ppT>> *domain,
+        groth16_proving_workspace<ppT> &workspace,
+        const std::vector<libsnark::r1cs_primary_input<libff::Fr<ppT>>>
+            &primary_inputs,
+        const std::vector<libsnark::r1cs_auxiliary_input<libff::Fr<ppT>>>
+            &auxiliary_inputs)
+{
+    using Field = libff::Fr<ppT>;
+    using G1 = libff::G1<ppT>;
+    using G2 = libff::G2<ppT>;
+    using bigint_type = libff::bigint<Field::num_limbs>;
+
+    const size_t num_proofs = primary_inputs.size();
+    if (auxiliary_inputs.size() != num_proofs) {
+        throw std::invalid_argument("mismatched number of inputs");
+    }
+
+    std::vector<proof> proofs;
+    proofs.reserve(num_proofs);
+    if (precomputed != nullptr) {
+        for (size_t k = 0; k < num_proofs; ++k) {
+            proofs.push_back(generate_proof_internal(
+                proving_key,
+                precomputed,
+                domain,
+                workspace,
+                primary_inputs[k],
+                auxiliary_inputs[k]));
+        }
+        return proofs;
+    }
+    if (num_proofs == 0) {
+        return proofs;
+    }
+
+    // The domain and the intermediate buffers of the witness map are shared
+    // by all proofs of the batch. Results are copied out, so that the
+    // workspace keeps its (preallocated) buffers.
+    std::vector<std::vector<Field>> assignments(num_proofs);
+    std::vector<std::vector<Field>> H_coefficients(num_proofs);
+    for (size_t k = 0; k < num_proofs; ++k) {
+        compute_witness(
+            proving_key,
+            domain,
+            primary_inputs[k],
+            auxiliary_inputs[k],
+            workspace);
+        assignments[k] = workspace.assignment;
+        H_coefficients[k] = workspace.H_coefficients;
+    }
+
+    const size_t num_variables = proving_key.A_query.size() - 1;
+    const size_t num_inputs = num_variables - proving_key.L_query.size();
+    std::vector<const Field *> A_scalars(num_proofs);
+    std::vector<const Field *> H_scalars(num_proofs);
+    std::vector<const Field *> L_scalars(num_proofs);
+    for (size_t k = 0; k < num_proofs; ++k) {
+        A_scalars[k] = assignments[k].data();
+        H_scalars[k] = H_coefficients[k].data();
+        L_scalars[k] = assignments[k].data() + num_inputs + 1;
+    }
+
+    // Each MSM makes a single pass over the corresponding bases for all
+    // proofs.
+    const std::vector<G1> evaluations_At = multi_exp_batch<Field, G1>(
+        proving_key.A_query.data(), A_scalars, proving_key.A_query.size());
+    const std::vector<G1> evaluations_Ht = multi_exp_batch<Field, G1>(
+        proving_key.H_query.data(), H_scalars, proving_key.H_query.size());
+    const std::vector<G1> evaluations_Lt = multi_exp_batch<Field, G1>(
+        proving_key.L_query.data(), L_scalars, proving_key.L_query.size());
+
+    const size_t B_query_size = proving_key.B_query.indices.size();
+    std::vector<std::vector<bigint_type>> B_scalars(
+        num_proofs, std::vector<bigint_type>(B_query_size));
+    std::vector<const bigint_type *> B_scalar_ptrs(num_proofs);
+    for (size_t k = 0; k < num_proofs; ++k) {
+        for (size_t i = 0; i < B_query_size; ++i) {
+            B_scalars[k][i] =
+                assignments[k][proving_key.B_query.indices[i]].as_bigint();
+        }
+        B_scalar_ptrs[k] = B_scalars[k].data();
+    }
+    std::vector<G2> evaluations_Bt_g(num_proofs);
+    std::vector<G1> evaluations_Bt_h(num_proofs);
+    internal::multi_exp_bucket_full_sets<G2>(
+        internal::groth16_B_query_g<ppT>(proving_key.B_query.values),
+        B_scalar_ptrs.data(),
+        num_proofs,
+        B_query_size,
+        Field::num_bits,
+        multi_exp_accumulation_auto,
+        evaluations_Bt_g.data());
+    internal::multi_exp_bucket_full_sets<G1>(
+        internal::groth16_B_query_h<ppT>(proving_key.B_query.values),
+        B_scalar_ptrs.data(),
+        num_proofs,
+        B_query_size,
+        Field::num_bits,
+        multi_exp_accumulation_auto,
+        evaluations_Bt_h.data());
+
+    for (size_t k = 0; k < num_proofs; ++k) {
+        proofs.push_back(compute_proof(
+            proving_key,
+            evaluations_At[k],
+            evaluations_Bt_g[k],
+            evaluations_Bt_h[k],
+            evaluations_Ht[k],
+            evaluations_Lt[k]));
+    }
+    return proofs;
+}
+
+template<typename ppT>
+void groth16_snark<ppT>::compute_witness(
+    const proving_key &proving_key,
+    const blocked_radix2_domain<libff::Fr<ppT>> *domain,
+    const libsnark::r1cs_primary_input<libff::Fr<ppT>> &primary_input,
+    const libsnark::r1cs_auxiliary_input<libff::Fr<ppT>> &auxiliary_input,
+    groth16_proving_workspace<ppT> &workspace)
+{
+    using Field = libff::Fr<ppT>;
+
+    const libsnark::r1cs_constraint_system<Field> &cs =
+        proving_key.constraint_system;
+    libsnark::r1cs_variable_assignment<Field> &variables =
+        workspace.qap.variable_assignment;
+    variables.assign(primary_input.begin(), primary_input.end());
+    variables.insert(
+        variables.end(), auxiliary_input.begin(), auxiliary_input.end());
+    const size_t num_variables = variables.size();
+    const size_t num_inputs = primary_input.size();
+
+    if (num_variables != cs.num_variables() ||
+        num_inputs != cs.num_inputs()) {
+        throw std::invalid_argument(
+            "assignment does not match constraint system");
+    }
+    if (proving_key.A_query.size() != num_variables + 1 ||
+        proving_key.L_query.size() != num_variables - num_inputs) {
+        throw std::invalid_argument(
+            "proving key does not match constraint system");
+    }
+
+    // Compute the coefficients of H from the assignment, using the domain
+    // of the key. As in libsnark, no zero-knowledge randomization is added
+    // to the QAP witness (the proof is randomized by r and s in
+    // compute_proof). Only the first degree - 1 coefficients of H are used.
+    std::vector<Field> &H_coefficients = workspace.H_coefficients;
+    if (domain != nullptr) {
+        qap_witness_map_H(*domain, cs, workspace.qap, H_coefficients);
+    } else {
+        // libsnark selects the same (non radix-2) domain as the generator.
+        libsnark::qap_witness<Field> witness =
+            libsnark::r1cs_to_qap_witness_map(
+                cs,
+                primary_input,
+                auxiliary_input,
+                Field::zero(),
+                Field::zero(),
+                Field::zero(),
+                false);
+        H_coefficients.swap(witness.coefficients_for_H);
+    }
+    if (H_coefficients.size() != proving_key.H_query.size() + 2) {
+        throw std::invalid_argument(
+            "proving key does not match constraint system");
+    }
+    H_coefficients.resize(proving_key.H_query.size());
+
+    // Full assignment, including the constant variable 1.
+    std::vector<Field> &assignment = workspace.assignment;
+    assignment.clear();
+    assignment.reserve(num_variables + 1);
+    assignment.push_back(Field::one());
+    assignment.insert(assignment.end(), variables.begin(), variables.end());
+}
+
+template<typename ppT>
+typename groth16_snark<ppT>::proof groth16_snark<ppT>::compute_proof(
+    const proving_key &proving_key,
+    const libff::G1<ppT> &evaluation_At,
+    const libff::G2<ppT> &evaluation_Bt_g,
+    const libff::G1<ppT> &evaluation_Bt_h,
+    const libff::G1<ppT> &evaluation_Ht,
+    const libff::G1<ppT> &evaluation_Lt)
+{
+    using Field = libff::Fr<ppT>;
+    using G1 = libff::G1<ppT>;
+    using G2 = libff::G2<ppT>;
+
+    const Field r = Field::random_element();
+    const Field s = Field::random_element();
+
+    // A = alpha + sum_i(a_i*A_i(t)) + r*delta
+    G1 g1_A = proving_key.alpha_g1 + evaluation_At +
+              scalar_mul(r, proving_key.delta_g1);
+
+    // B = beta + sum_i(a_i*B_i(t)) + s*delta
+    const G1 g1_B = proving_key.beta_g1 + evaluation_Bt_h +
+                    scalar_mul(s, proving_key.delta_g1);
+    G2 g2_B = proving_key.beta_g2 + evaluation_Bt_g + s * proving_key.delta_g2;
+
+    // C = sum_i(a_i*((beta*A_i(t) + alpha*B_i(t) + C_i(t)) + H(t)*Z(t))/delta)
+    //     + A*s + r*b - r*s*delta
+    G1 g1_C = evaluation_Ht + evaluation_Lt + scalar_mul(s, g1_A) +
+              scalar_mul(r, g1_B) - scalar_mul(r * s, proving_key.delta_g1);
+
+    return proof(std::move(g1_A), std::move(g2_B), std::move(g1_C));
+}
+
+template<typename ppT>
+typename groth16_snark<ppT>::proof groth16_snark<ppT>::generate_proof_internal(
+    const proving_key &proving_key,
+    const groth16_precomputed_bases<ppT> *precomputed,
+    const blocked_radix2_domain<libff::Fr<ppT>> *domain,
+    groth16_proving_workspace<ppT> &workspace,
+    const libsnark::r1cs_primary_input<libff::Fr<ppT>> &primary_input,
+    const libsnark::r1cs_auxiliary_input<libff::Fr<ppT>> &auxiliary_input)
+{
+    using Field = libff::Fr<ppT>;
+    using G1 = libff::G1<ppT>;
+    using G2 = libff::G2<ppT>;
+
+    compute_witness(
+        proving_key, domain, primary_input, auxiliary_input, workspace);
+    const std::vector<Field> &assignment = workspace.assignment;
+    const std::vector<Field> &H_coefficients = workspace.H_coefficients;
+    const size_t num_variables = assignment.size() - 1;
+    const size_t num_inputs = num_variables - proving_key.L_query.size();
+
+    // B_query is a sparse vector of knowledge commitments (with G2 and G1
+    // components), each corresponding to the variable at the given index.
+    const size_t B_query_size = proving_key.B_query.indices.size();
+    std::vector<libff::bigint<Field::num_limbs>> &B_scalars =
+        workspace.B_scalars;
+    B_scalars.resize(B_query_size);
+    for (size_t i = 0; i < B_query_size; ++i) {
+        B_scalars[i] = assignment[proving_key.B_query.indices[i]].as_bigint();
+    }
+
+    G1 evaluation_At;
+    G1 evaluation_Ht;
+    G1 evaluation_Lt;
+    G2 evaluation_Bt_g;
+    G1 evaluation_Bt_h;
+    if (precomputed != nullptr) {
+        // With precomputed tables, no doublings are required, and scalars
+        // which are bits or small values contribute only a few (non-zero)
+        // digits, so that no classification is required.
+        const size_t c = precomputed->window_size();
+        const size_t w = precomputed->num_windows();
+        evaluation_At = multi_exp_precomputed<Field, G1>(
+            precomputed->A_query(), c, w, assignment.data(), num_variables + 1);
+        evaluation_Ht = multi_exp_precomputed<Field, G1>(
+            precomputed->H_query(),
+            c,
+            w,
+            H_coefficients.data(),
+            H_coefficients.size());
+        evaluation_Lt = multi_exp_precomputed<Field, G1>(
+            precomputed->L_query(),
+            c,
+            w,
+            assignment.data() + num_inputs + 1,
+            num_variables - num_inputs);
+        evaluation_Bt_g = internal::multi_exp_bucket_precomputed<G2>(
+            precomputed->B_query_g(), B_scalars.data(), B_query_size, c, w);
+        evaluation_Bt_h = internal::multi_exp_bucket_precomputed<G1>(
+            precomputed->B_query_h(), B_scalars.data(), B_query_size, c, w);
+    } else {
+        // Many variables in the assignment are bits or small values, so
+        // products with A_query, B_query and L_query use
+        // multi_exp_classified. The coefficients of H are (in general)
+        // full-size.
+        evaluation_At = multi_exp_classified<Field, G1>(
+            proving_key.A_query.data(), assignment.data(), num_variables + 1);
+        evaluation_Ht = multi_exp<Field, G1>(
+            proving_key.H_query.data(),
+            H_coefficients.data(),
+            H_coefficients.size());
+        evaluation_Lt = multi_exp_classified<Field, G1>(
+            proving_key.L_query.data(),
+            assignment.data() + num_inputs + 1,
+            num_variables - num_inputs);
+        evaluation_Bt_g = internal::multi_exp_bucket_classified<G2>(
+            internal::groth16_B_query_g<ppT>(proving_key.B_query.values),
+            B_scalars.data(),
+            B_query_size,
+            Field::num_bits);
+        evaluation_Bt_h = internal::multi_exp_bucket_classified<G1>(
+            internal::groth16_B_query_h<ppT>(proving_key.B_query.values),
+            B_scalars.data(),
+            B_query_size,
+            Field::num_bits);
+    }
+
+    return compute_proof(
+        proving_key,
+        evaluation_At,
+        evaluation_Bt_g,
+        evaluation_Bt_h,
+        evaluation_Ht,
+        evaluation_Lt);
 }
 
 template<typename ppT>
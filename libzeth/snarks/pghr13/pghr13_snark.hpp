@@ -28,6 +28,11 @@ public:
     static keypair generate_setup(
         const libsnark::protoboard<libff::Fr<ppT>> &pb);
 
+    /// Run the trusted setup for the given constraint system (e.g. loaded
+    /// from a cache, see r1cs_cache_read)
+    static keypair generate_setup(
+        const libsnark::r1cs_constraint_system<libff::Fr<ppT>> &cs);
+
     /// Generate the proof (from the values set to the protoboard)
     static proof generate_proof(
         const proving_key &proving_key,
@@ -18,7 +18,14 @@ template<typename ppT>
 typename pghr13_snark<ppT>::keypair pghr13_snark<ppT>::generate_setup(
     const libsnark::protoboard<libff::Fr<ppT>> &pb)
 {
-    return libsnark::r1cs_ppzksnark_generator<ppT>(pb.get_constraint_system());
+    return generate_setup(pb.get_constraint_system());
+}
+
+template<typename ppT>
+typename pghr13_snark<ppT>::keypair pghr13_snark<ppT>::generate_setup(
+    const libsnark::r1cs_constraint_system<libff::Fr<ppT>> &cs)
+{
+    return libsnark::r1cs_ppzksnark_generator<ppT>(cs);
 }
 
 template<typename ppT>
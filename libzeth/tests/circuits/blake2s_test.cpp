@@ -152,6 +152,54 @@ TEST(TestG, TestTrue)
     ASSERT_EQ(d2_expected.get_bits(pb), d2.get_bits(pb));
 }
 
+// Same test vector as above, with the witness computed on native words.
+TEST(TestG, TestWords)
+{
+    libsnark::protoboard<Field> pb;
+
+    std::array<libsnark::pb_variable_array<Field>, 10> words;
+    for (libsnark::pb_variable_array<Field> &word : words) {
+        word.allocate(pb, BLAKE2s_word_size, "word");
+    }
+    uint32_t a = 0x6B08E647;
+    uint32_t b = 0x510E527F;
+    uint32_t c = 0x6A09E667;
+    uint32_t d = 0x510E5274;
+    const uint32_t x = 0x6C6C6568;
+    const uint32_t y = 0x6F77206F;
+    fill_variable_array_from_uint32(pb, words[0], a);
+    fill_variable_array_from_uint32(pb, words[1], b);
+    fill_variable_array_from_uint32(pb, words[2], c);
+    fill_variable_array_from_uint32(pb, words[3], d);
+    fill_variable_array_from_uint32(pb, words[4], x);
+    fill_variable_array_from_uint32(pb, words[5], y);
+
+    g_primitive<Field> g_gadget(
+        pb,
+        words[0],
+        words[1],
+        words[2],
+        words[3],
+        words[4],
+        words[5],
+        words[6],
+        words[7],
+        words[8],
+        words[9]);
+    g_gadget.generate_r1cs_constraints();
+    g_gadget.generate_r1cs_witness_words(a, b, c, d, x, y);
+
+    ASSERT_EQ(0x70B1353Du, a);
+    ASSERT_EQ(0xC07F2E7Bu, b);
+    ASSERT_EQ(0xE7214B40u, c);
+    ASSERT_EQ(0xB0BCEB4Cu, d);
+    ASSERT_EQ(a, uint32_from_variable_array(pb, words[6]));
+    ASSERT_EQ(b, uint32_from_variable_array(pb, words[7]));
+    ASSERT_EQ(c, uint32_from_variable_array(pb, words[8]));
+    ASSERT_EQ(d, uint32_from_variable_array(pb, words[9]));
+    ASSERT_TRUE(pb.is_satisfied());
+}
+
 // The test correponds to blake2s(b"hello world")
 // The test vectors were computed with hashlib's blake2s function
 TEST(TestBlake2sComp, TestTrue)
@@ -499,6 +547,57 @@ TEST(TestBlake2s, TestTrue2)
     ASSERT_EQ(expected.to_vector(), output.bits.get_bits(pb));
 }
 
+// Compute the hash of `input` using the gadget.
+static libff::bit_vector blake2s_gadget_hash(const libff::bit_vector &input)
+{
+    libsnark::protoboard<Field> pb;
+    libsnark::block_variable<Field> input_block(pb, input.size(), "input");
+    libsnark::digest_variable<Field> output(pb, BLAKE2s_digest_size, "output");
+    BLAKE2s_256<Field> blake2s_gadget(pb, input_block, output);
+    blake2s_gadget.generate_r1cs_constraints();
+    input_block.generate_r1cs_witness(input);
+    blake2s_gadget.generate_r1cs_witness();
+    return output.get_digest();
+}
+
+// The native implementation used by get_hash and get_hash_batch must follow
+// the bit-order conventions of the gadget, including for inputs which are not
+// a whole number of bytes or span several blocks.
+TEST(TestBlake2s, NativeMatchesGadget)
+{
+    const size_t input_sizes[] = {8, 253, 256, 512, 513, 1088};
+    std::vector<libff::bit_vector> inputs;
+    for (const size_t input_size : input_sizes) {
+        for (size_t i = 0; i < 9; ++i) {
+            libff::bit_vector input(input_size);
+            for (size_t j = 0; j < input_size; ++j) {
+                input[j] = ((j * 7 + i * 3 + input_size) % 5) < 2;
+            }
+            inputs.push_back(input);
+        }
+    }
+
+    const std::vector<libff::bit_vector> batch_hashes =
+        BLAKE2s_256<Field>::get_hash_batch(inputs);
+    ASSERT_EQ(inputs.size(), batch_hashes.size());
+
+    // The gadget is only evaluated for the first input of each size.
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        const libff::bit_vector hash = BLAKE2s_256<Field>::get_hash(inputs[i]);
+        ASSERT_EQ(hash, batch_hashes[i]);
+        if (i % 9 == 0) {
+            ASSERT_EQ(blake2s_gadget_hash(inputs[i]), hash);
+        }
+    }
+
+    // blake2s(b"zeth"), computed with hashlib's blake2s function
+    bits256 expected = bits256::from_hex(
+        "4ca5d36358d05c1108a53539e6bad6580ccdf337e6f35d6b66e9a2b7866a4d49");
+    ASSERT_EQ(
+        expected.to_vector(),
+        BLAKE2s_256<Field>::get_hash(bit_vector_from_hex("7a657468")));
+}
+
 } // namespace
 
 int main(int argc, char **argv)
@@ -361,6 +361,111 @@ TEST(TestMiMC, MiMC17_BLS12_377_MP)
     ASSERT_EQ(h_val, pb.val(h));
 }
 
+template<typename FieldT, typename PermutationT>
+void native_mimc_mp_matches_gadget_test()
+{
+    using MiMC_mp = MiMC_mp_gadget<FieldT, PermutationT>;
+
+    const size_t num_pairs = 9;
+    std::vector<FieldT> x_vals;
+    std::vector<FieldT> y_vals;
+    for (size_t i = 0; i < num_pairs; ++i) {
+        x_vals.push_back(FieldT::random_element());
+        y_vals.push_back(FieldT::random_element());
+    }
+    // Include zero inputs
+    x_vals[0] = FieldT::zero();
+    y_vals[1] = FieldT::zero();
+
+    std::vector<FieldT> batch_hashes;
+    MiMC_mp::get_hash_batch(x_vals, y_vals, batch_hashes);
+    ASSERT_EQ(num_pairs, batch_hashes.size());
+
+    for (size_t i = 0; i < num_pairs; ++i) {
+        libsnark::protoboard<FieldT> pb;
+        libsnark::pb_variable<FieldT> x;
+        libsnark::pb_variable<FieldT> y;
+        libsnark::pb_variable<FieldT> h;
+        x.allocate(pb, "x");
+        y.allocate(pb, "y");
+        h.allocate(pb, "h");
+        pb.val(x) = x_vals[i];
+        pb.val(y) = y_vals[i];
+
+        MiMC_mp gadget(pb, x, y, h, "mimc_mp");
+        gadget.generate_r1cs_constraints();
+        gadget.generate_r1cs_witness();
+        ASSERT_TRUE(pb.is_satisfied());
+
+        ASSERT_EQ(pb.val(h), MiMC_mp::get_hash(x_vals[i], y_vals[i]));
+        ASSERT_EQ(pb.val(h), batch_hashes[i]);
+    }
+
+    // Mismatched batch inputs are rejected.
+    y_vals.pop_back();
+    ASSERT_THROW(
+        MiMC_mp::get_hash_batch(x_vals, y_vals, batch_hashes),
+        std::invalid_argument);
+}
+
+TEST(TestMiMC, MiMC17_ALT_BN128_Permutation_Native)
+{
+    using Field = libff::alt_bn128_Fr;
+
+    // Test data as for MiMC17_ALT_BN128_Permutation
+    const Field x("3703141493535563179657531719960160174296085208671919316200"
+                  "479060314459804651");
+    const Field k("1568395149631190174933950911896067630329022481212975289070"
+                  "6581988986633412003");
+    const Field expected_out("29507693699332038974753503437924076368401047819"
+                             "47445379481145971915829708697");
+    ASSERT_EQ(
+        expected_out,
+        MiMCe17_ALT_BN128_permutation_gadget<Field>::get_permutation(x, k));
+}
+
+TEST(TestMiMC, MiMC17_ALT_BN128_MP_Native)
+{
+    using Field = libff::alt_bn128_Fr;
+    using MiMC_mp =
+        MiMC_mp_gadget<Field, MiMCe17_ALT_BN128_permutation_gadget<Field>>;
+
+    // Test data as for MiMC17_ALT_BN128_MP
+    const Field m_val("340282366920938463463374607431768211456");
+    const Field k_val("28948022309329048855892746252171976963317496166410141009"
+                      "864396001978282409983");
+    const Field h_val("14599678357063082723814206975733222579132256174923645170"
+                      "354481857040188426666");
+    ASSERT_EQ(h_val, MiMC_mp::get_hash(m_val, k_val));
+
+    native_mimc_mp_matches_gadget_test<
+        Field,
+        MiMCe17_ALT_BN128_permutation_gadget<Field>>();
+}
+
+TEST(TestMiMC, MiMC17_BLS12_377_MP_Native)
+{
+    using Field = libff::bls12_377_Fr;
+    using MiMC_mp =
+        MiMC_mp_gadget<Field, MiMCe17_BLS12_377_permutation_gadget<Field>>;
+
+    // Test data as for MiMC17_BLS12_377_MP
+    const Field m_val(
+        "361463706104393758314627143582733736918979816094794952605869"
+        "5634226054692860");
+    const Field k_val(
+        "577560616941962560685931949698212627967485873079130048105101"
+        "9590436651369410");
+    const Field h_val(
+        "580310635483157120553405751259383795319189070903739068091192"
+        "5249983717812220");
+    ASSERT_EQ(h_val, MiMC_mp::get_hash(m_val, k_val));
+
+    native_mimc_mp_matches_gadget_test<
+        Field,
+        MiMCe17_BLS12_377_permutation_gadget<Field>>();
+}
+
 } // namespace
 
 int main(int argc, char **argv)
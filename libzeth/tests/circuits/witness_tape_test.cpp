@@ -0,0 +1,150 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "libzeth/circuits/blake2s/blake2s.hpp"
+#include "libzeth/circuits/circuit_types.hpp"
+#include "libzeth/circuits/merkle_tree/merkle_path_authenticator.hpp"
+#include "libzeth/circuits/mimc/mimc_input_hasher.hpp"
+#include "libzeth/circuits/witness_tape.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace libzeth;
+using pp = defaults::pp;
+using Field = defaults::Field;
+using HashTree = tree_hash_selector<Field>::tree_hash;
+
+namespace
+{
+
+// Check that replaying the tape recorded by `gadget`, starting from an
+// assignment in which only the first `num_inputs` variables are set, gives
+// the assignment computed by the gadget itself.
+template<typename GadgetT>
+void check_witness_tape(
+    const libsnark::protoboard<Field> &pb,
+    GadgetT &gadget,
+    const size_t num_inputs)
+{
+    witness_tape<Field> tape;
+    gadget.record_witness(tape);
+    ASSERT_LT(0, tape.num_instructions());
+
+    std::vector<Field> expect{Field::one()};
+    const libsnark::r1cs_variable_assignment<Field> &values =
+        pb.full_variable_assignment();
+    expect.insert(expect.end(), values.begin(), values.end());
+
+    std::vector<Field> actual(expect.size(), Field::zero());
+    std::copy(
+        expect.begin(), expect.begin() + num_inputs + 1, actual.begin());
+    tape.execute(actual);
+    ASSERT_EQ(expect, actual);
+
+    // Replaying over the protoboard leaves the assignment unchanged.
+    libsnark::protoboard<Field> pb_copy = pb;
+    std::vector<Field> buffer;
+    tape.execute(pb_copy, buffer);
+    ASSERT_EQ(values, pb_copy.full_variable_assignment());
+    ASSERT_TRUE(pb_copy.is_satisfied());
+}
+
+TEST(WitnessTapeTest, BLAKE2s)
+{
+    // Inputs which are not a whole number of bytes or words, and which span
+    // several blocks.
+    for (const size_t input_size : {8, 253, 256, 512, 513, 1088}) {
+        libsnark::protoboard<Field> pb;
+        libsnark::block_variable<Field> input(pb, input_size, "input");
+        libsnark::digest_variable<Field> output(
+            pb, BLAKE2s_digest_size, "output");
+        BLAKE2s_256<Field> blake2s_gadget(pb, input, output);
+        blake2s_gadget.generate_r1cs_constraints();
+
+        libff::bit_vector input_bits(input_size);
+        for (size_t j = 0; j < input_size; ++j) {
+            input_bits[j] = ((j * 7 + input_size) % 5) < 2;
+        }
+        input.generate_r1cs_witness(input_bits);
+        blake2s_gadget.generate_r1cs_witness();
+
+        check_witness_tape(pb, blake2s_gadget, input_size);
+    }
+}
+
+TEST(WitnessTapeTest, MiMCInputHasher)
+{
+    using input_hasher = mimc_input_hasher<Field, HashTree>;
+    const size_t num_values = 5;
+
+    libsnark::protoboard<Field> pb;
+    libsnark::pb_variable_array<Field> values;
+    values.allocate(pb, num_values, "values");
+    libsnark::pb_variable<Field> hashed_values;
+    hashed_values.allocate(pb, "hashed_values");
+
+    input_hasher hasher(pb, values, hashed_values, "hasher");
+    hasher.generate_r1cs_constraints();
+    for (size_t i = 0; i < num_values; ++i) {
+        pb.val(values[i]) = Field::random_element();
+    }
+    hasher.generate_r1cs_witness();
+
+    check_witness_tape(pb, hasher, num_values);
+}
+
+TEST(WitnessTapeTest, MerklePathAuthenticator)
+{
+    const size_t tree_depth = 4;
+
+    libsnark::protoboard<Field> pb;
+    libsnark::pb_variable_array<Field> address_bits;
+    address_bits.allocate(pb, tree_depth, "address_bits");
+    libsnark::pb_variable_array<Field> path;
+    path.allocate(pb, tree_depth, "path");
+    libsnark::pb_variable<Field> leaf;
+    leaf.allocate(pb, "leaf");
+    libsnark::pb_variable<Field> expected_root;
+    expected_root.allocate(pb, "expected_root");
+    libsnark::pb_variable<Field> enforce_bit;
+    enforce_bit.allocate(pb, "enforce_bit");
+    const size_t num_inputs = 2 * tree_depth + 3;
+
+    merkle_path_authenticator<Field, HashTree> auth(
+        pb,
+        tree_depth,
+        address_bits,
+        leaf,
+        expected_root,
+        path,
+        enforce_bit,
+        "authenticator");
+    auth.generate_r1cs_constraints();
+
+    // The expected root is computed natively from the same path.
+    Field root = Field::random_element();
+    pb.val(leaf) = root;
+    for (size_t i = 0; i < tree_depth; ++i) {
+        const bool is_right = (i % 3) == 0;
+        pb.val(address_bits[i]) = is_right ? Field::one() : Field::zero();
+        pb.val(path[i]) = Field::random_element();
+        root = is_right ? HashTree::get_hash(pb.val(path[i]), root)
+                        : HashTree::get_hash(root, pb.val(path[i]));
+    }
+    pb.val(expected_root) = root;
+    pb.val(enforce_bit) = Field::one();
+    auth.generate_r1cs_witness();
+    ASSERT_TRUE(auth.is_valid());
+
+    check_witness_tape(pb, auth, num_inputs);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    pp::init_public_params();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "libzeth/core/blake2s.hpp"
+#include "libzeth/core/utils.hpp"
+
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace libzeth;
+
+namespace
+{
+
+static std::string test_message(size_t size, size_t seed)
+{
+    std::string message(size, 0);
+    for (size_t i = 0; i < size; ++i) {
+        message[i] = (char)(i * 13 + seed);
+    }
+    return message;
+}
+
+static std::string blake2s_256_hex(const std::string &message)
+{
+    uint8_t digest[BLAKE2S_256_DIGEST_SIZE_BYTES];
+    blake2s_256(message.data(), message.size(), digest);
+    return bytes_to_hex(digest, sizeof(digest));
+}
+
+// Test vectors were computed with hashlib's blake2s function
+TEST(Blake2sTest, TestVectors)
+{
+    ASSERT_EQ(
+        "69217a3079908094e11121d042354a7c1f55b6482ca1a51e1b250dfd1ed0eef9",
+        blake2s_256_hex(""));
+    ASSERT_EQ(
+        "508c5e8c327c14e2e1a72ba34eeb452f37458b209ed63a294d999b4c86675982",
+        blake2s_256_hex("abc"));
+    ASSERT_EQ(
+        "9aec6806794561107e594b1f6a8a6b0c92a0cba9acf5e5e93cca06f781813b0b",
+        blake2s_256_hex("hello world"));
+
+    std::string zeth_136;
+    for (size_t i = 0; i < 34; ++i) {
+        zeth_136 += "zeth";
+    }
+    ASSERT_EQ(
+        "97ed65a363448b9965f96cbb4c1d6c432ef1216d93c1b88a2ca7d46900bfe92a",
+        blake2s_256_hex(zeth_136));
+
+    // Exactly one and just over one block
+    std::string bytes_64;
+    for (size_t i = 0; i < 65; ++i) {
+        bytes_64.push_back((char)i);
+    }
+    ASSERT_EQ(
+        "1b53ee94aaf34e4b159d48de352c7f0661d0a40edff95a0b1639b4090e974472",
+        blake2s_256_hex(bytes_64));
+    bytes_64.pop_back();
+    ASSERT_EQ(
+        "56f34e8b96557e90c1f24b52d0c89d51086acf1b00f634cf1dde9233b8eaaa3e",
+        blake2s_256_hex(bytes_64));
+}
+
+TEST(Blake2sTest, BatchMatchesSingle)
+{
+    // Mix of lengths, with some lengths occuring more than
+    // BLAKE2S_256_BATCH_LANES times (to exercise the multi-buffer path) and
+    // some occuring fewer times.
+    std::vector<std::string> messages;
+    const size_t sizes[] = {0, 1, 32, 63, 64, 65, 136};
+    for (size_t seed = 0; seed < 2 * BLAKE2S_256_BATCH_LANES + 3; ++seed) {
+        for (const size_t size : sizes) {
+            if (size == 63 && seed > 2) {
+                continue;
+            }
+            messages.push_back(test_message(size, seed));
+        }
+    }
+
+    std::vector<const uint8_t *> message_ptrs;
+    std::vector<size_t> message_sizes;
+    for (const std::string &message : messages) {
+        message_ptrs.push_back((const uint8_t *)message.data());
+        message_sizes.push_back(message.size());
+    }
+
+    std::vector<uint8_t> digests(
+        messages.size() * BLAKE2S_256_DIGEST_SIZE_BYTES);
+    blake2s_256_batch(
+        message_ptrs.data(),
+        message_sizes.data(),
+        messages.size(),
+        digests.data());
+
+    for (size_t i = 0; i < messages.size(); ++i) {
+        ASSERT_EQ(
+            blake2s_256_hex(messages[i]),
+            bytes_to_hex(
+                digests.data() + i * BLAKE2S_256_DIGEST_SIZE_BYTES,
+                BLAKE2S_256_DIGEST_SIZE_BYTES));
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,178 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "libzeth/core/blocked_radix2_domain.hpp"
+#include "libzeth/core/qap_witness_map.hpp"
+
+#include <gtest/gtest.h>
+#include <libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp>
+#include <libff/algebra/curves/bls12_377/bls12_377_pp.hpp>
+#include <libfqfft/evaluation_domain/domains/basic_radix2_domain.hpp>
+#include <libsnark/reductions/r1cs_to_qap/r1cs_to_qap.hpp>
+
+namespace
+{
+
+template<typename FieldT> std::vector<FieldT> random_vector(const size_t n)
+{
+    std::vector<FieldT> values(n);
+    for (FieldT &v : values) {
+        v = FieldT::random_element();
+    }
+    return values;
+}
+
+template<typename FieldT> void blocked_radix2_domain_test(const size_t m)
+{
+    libfqfft::basic_radix2_domain<FieldT> basic(m);
+    libzeth::blocked_radix2_domain<FieldT> blocked(m);
+    ASSERT_EQ(basic.omega, blocked.omega);
+
+    const FieldT g = FieldT::multiplicative_generator;
+    const std::vector<FieldT> a = random_vector<FieldT>(m);
+    std::vector<FieldT> expect = a;
+    std::vector<FieldT> actual = a;
+
+    basic.FFT(expect);
+    blocked.FFT(actual);
+    ASSERT_EQ(expect, actual);
+
+    basic.iFFT(expect);
+    blocked.iFFT(actual);
+    ASSERT_EQ(expect, actual);
+    ASSERT_EQ(a, actual);
+
+    basic.cosetFFT(expect, g);
+    blocked.cosetFFT(actual, g);
+    ASSERT_EQ(expect, actual);
+
+    basic.icosetFFT(expect, g);
+    blocked.icosetFFT(actual, g);
+    ASSERT_EQ(expect, actual);
+
+    basic.divide_by_Z_on_coset(expect);
+    blocked.divide_by_Z_on_coset(actual);
+    ASSERT_EQ(expect, actual);
+
+    const FieldT t = FieldT::random_element();
+    ASSERT_EQ(
+        basic.compute_vanishing_polynomial(t),
+        blocked.compute_vanishing_polynomial(t));
+    ASSERT_EQ(
+        basic.evaluate_all_lagrange_polynomials(t),
+        blocked.evaluate_all_lagrange_polynomials(t));
+    ASSERT_EQ(
+        basic.get_domain_element(m - 1), blocked.get_domain_element(m - 1));
+
+    // Transforms of a const domain with a precomputed coset, reusing a
+    // scratch buffer.
+    libzeth::blocked_radix2_domain<FieldT> coset_domain(m);
+    coset_domain.precompute_coset(g);
+    const libzeth::blocked_radix2_domain<FieldT> &const_domain = coset_domain;
+    std::vector<FieldT> scratch;
+    actual = a;
+    expect = a;
+    const_domain.cosetFFT(actual, g, scratch);
+    basic.cosetFFT(expect, g);
+    ASSERT_EQ(expect, actual);
+    const_domain.divide_by_Z_on_coset(actual);
+    basic.divide_by_Z_on_coset(expect);
+    ASSERT_EQ(expect, actual);
+    const_domain.icosetFFT(actual, g, scratch);
+    basic.icosetFFT(expect, g);
+    ASSERT_EQ(expect, actual);
+    const_domain.FFT(actual, scratch);
+    const_domain.iFFT(actual, scratch);
+    ASSERT_EQ(expect, actual);
+
+    std::vector<FieldT> H_expect = random_vector<FieldT>(m + 1);
+    std::vector<FieldT> H_actual = H_expect;
+    basic.add_poly_Z(t, H_expect);
+    blocked.add_poly_Z(t, H_actual);
+    ASSERT_EQ(H_expect, H_actual);
+}
+
+template<typename FieldT>
+void qap_witness_map_test(const size_t num_constraints)
+{
+    // Random constraints (which need not be satisfied by the assignment,
+    // since both witness maps perform the same computation).
+    const size_t num_inputs = 3;
+    const size_t num_variables = 20;
+    libsnark::r1cs_constraint_system<FieldT> cs;
+    cs.primary_input_size = num_inputs;
+    cs.auxiliary_input_size = num_variables - num_inputs;
+    for (size_t i = 0; i < num_constraints; ++i) {
+        libsnark::linear_combination<FieldT> lc[3];
+        for (libsnark::linear_combination<FieldT> &l : lc) {
+            for (size_t j = 0; j < 3; ++j) {
+                const size_t var = (i * 7 + j * 5 + 1) % (num_variables + 1);
+                l.add_term(libsnark::linear_term<FieldT>(
+                    libsnark::variable<FieldT>(var), FieldT::random_element()));
+            }
+        }
+        cs.add_constraint(
+            libsnark::r1cs_constraint<FieldT>(lc[0], lc[1], lc[2]));
+    }
+
+    const std::vector<FieldT> primary = random_vector<FieldT>(num_inputs);
+    const std::vector<FieldT> auxiliary =
+        random_vector<FieldT>(num_variables - num_inputs);
+
+    const libsnark::qap_witness<FieldT> expect =
+        libsnark::r1cs_to_qap_witness_map(
+            cs,
+            primary,
+            auxiliary,
+            FieldT::zero(),
+            FieldT::zero(),
+            FieldT::zero(),
+            true);
+    const libsnark::qap_witness<FieldT> actual =
+        libzeth::qap_witness_map(cs, primary, auxiliary);
+
+    ASSERT_EQ(expect.num_variables(), actual.num_variables());
+    ASSERT_EQ(expect.degree(), actual.degree());
+    ASSERT_EQ(expect.num_inputs(), actual.num_inputs());
+    ASSERT_EQ(expect.coefficients_for_ABCs, actual.coefficients_for_ABCs);
+    ASSERT_EQ(expect.coefficients_for_H, actual.coefficients_for_H);
+}
+
+TEST(BlockedRadix2DomainTest, CompareToBasicRadix2Domain)
+{
+    // Sizes using the single radix-2 FFT, and the four-step algorithm with
+    // square and non-square matrices.
+    const size_t direct_log_size =
+        libzeth::blocked_radix2_domain<libff::alt_bn128_Fr>::direct_log_size;
+    for (const size_t log_m : {1ul, 2ul, 5ul, direct_log_size, 13ul, 14ul}) {
+        blocked_radix2_domain_test<libff::alt_bn128_Fr>(1ul << log_m);
+        blocked_radix2_domain_test<libff::bls12_377_Fr>(1ul << log_m);
+    }
+}
+
+TEST(BlockedRadix2DomainTest, InvalidSize)
+{
+    using Field = libff::alt_bn128_Fr;
+    ASSERT_THROW(
+        libzeth::blocked_radix2_domain<Field>(1), std::invalid_argument);
+    ASSERT_THROW(
+        libzeth::blocked_radix2_domain<Field>(6), std::invalid_argument);
+}
+
+TEST(BlockedRadix2DomainTest, QapWitnessMap)
+{
+    qap_witness_map_test<libff::alt_bn128_Fr>(10);
+    qap_witness_map_test<libff::alt_bn128_Fr>(5000);
+    qap_witness_map_test<libff::bls12_377_Fr>(10);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    libff::alt_bn128_pp::init_public_params();
+    libff::bls12_377_pp::init_public_params();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: LGPL-3.0+
 
 #include "libzeth/circuits/circuit_types.hpp"
+#include "libzeth/core/blocked_radix2_domain.hpp"
 #include "libzeth/core/evaluator_from_lagrange.hpp"
 #include "libzeth/mpc/groth16/powersoftau_utils.hpp"
 #include "zeth_config.h"
@@ -33,7 +34,7 @@ TEST(EvaluationFromLagrangeTest, ComputeLagrangeEvaluation)
 
     // Compare to the naive evaluations obtained using iFFT in Fr, and
     // evaluating the polynomial.
-    libfqfft::basic_radix2_domain<Fr> domain(n);
+    blocked_radix2_domain<Fr> domain(n);
     evaluator_from_lagrange<pp, G1> eval_g1(pot.tau_powers_g1, domain);
     evaluator_from_lagrange<pp, G2> eval_g2(pot.tau_powers_g2, domain);
     evaluator_from_lagrange<pp, G1> eval_alpha_g1(
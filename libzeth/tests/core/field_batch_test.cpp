@@ -0,0 +1,134 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "libzeth/core/field_batch.hpp"
+
+#include <gtest/gtest.h>
+#include <libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp>
+#include <libff/algebra/curves/bls12_377/bls12_377_pp.hpp>
+
+namespace
+{
+
+// Instruction sets to test (those not supported by the CPU are skipped).
+static const std::vector<std::string> isas{"none", "avx512"};
+
+// Sizes which exercise both the vectorized kernels and the remainders, and
+// the serial and interleaved inversions.
+static const std::vector<size_t> sizes{0, 1, 3, 4, 5, 8, 17, 100};
+
+template<typename FieldT> std::vector<FieldT> test_values(const size_t n)
+{
+    std::vector<FieldT> values(n);
+    for (size_t i = 0; i < n; ++i) {
+        switch (i % 7) {
+        case 0:
+            values[i] = FieldT::one();
+            break;
+        case 1:
+            values[i] = -FieldT::one();
+            break;
+        default:
+            values[i] = FieldT::random_element();
+        }
+    }
+    return values;
+}
+
+template<typename FieldT> void field_batch_test()
+{
+    for (const size_t n : sizes) {
+        const std::vector<FieldT> a = test_values<FieldT>(n);
+        std::vector<FieldT> b = test_values<FieldT>(n);
+        if (n > 2) {
+            b[2] = FieldT::zero();
+        }
+        std::vector<FieldT> out(n);
+
+        field_batch_mul(out.data(), a.data(), b.data(), n);
+        for (size_t i = 0; i < n; ++i) {
+            ASSERT_EQ(a[i] * b[i], out[i]);
+        }
+
+        field_batch_square(out.data(), a.data(), n);
+        for (size_t i = 0; i < n; ++i) {
+            ASSERT_EQ(a[i].squared(), out[i]);
+        }
+
+        const FieldT scalar = FieldT::random_element();
+        field_batch_mul_scalar(out.data(), a.data(), scalar, n);
+        for (size_t i = 0; i < n; ++i) {
+            ASSERT_EQ(a[i] * scalar, out[i]);
+        }
+
+        field_batch_add(out.data(), a.data(), b.data(), n);
+        for (size_t i = 0; i < n; ++i) {
+            ASSERT_EQ(a[i] + b[i], out[i]);
+        }
+
+        field_batch_sub(out.data(), a.data(), b.data(), n);
+        for (size_t i = 0; i < n; ++i) {
+            ASSERT_EQ(a[i] - b[i], out[i]);
+        }
+
+        // In-place
+        out = a;
+        field_batch_mul(out.data(), out.data(), b.data(), n);
+        for (size_t i = 0; i < n; ++i) {
+            ASSERT_EQ(a[i] * b[i], out[i]);
+        }
+
+        out = a;
+        field_batch_inverse(out.data(), n);
+        for (size_t i = 0; i < n; ++i) {
+            ASSERT_EQ(a[i].inverse(), out[i]);
+        }
+    }
+}
+
+template<typename ppT> void field_batch_test_curve()
+{
+    field_batch_test<libff::Fr<ppT>>();
+    field_batch_test<libff::Fq<ppT>>();
+    field_batch_test<libff::Fqe<ppT>>();
+}
+
+TEST(FieldBatchTest, AllInstructionSets)
+{
+    const std::string default_isa = libzeth::field_batch_isa();
+    const bool default_mulx = libzeth::field_batch_mulx();
+    for (const bool mulx : {false, true}) {
+        if (!libzeth::internal::field_batch_select_mulx(mulx)) {
+            std::cout << "skipping unsupported scalar kernel" << std::endl;
+            continue;
+        }
+        for (const std::string &isa : isas) {
+            if (!libzeth::internal::field_batch_select_isa(isa)) {
+                std::cout << "skipping unsupported instruction set: " << isa
+                          << std::endl;
+                continue;
+            }
+            ASSERT_EQ(isa, libzeth::field_batch_isa());
+            field_batch_test_curve<libff::alt_bn128_pp>();
+            field_batch_test_curve<libff::bls12_377_pp>();
+        }
+    }
+    ASSERT_TRUE(libzeth::internal::field_batch_select_isa(default_isa));
+    ASSERT_TRUE(libzeth::internal::field_batch_select_mulx(default_mulx));
+}
+
+TEST(FieldBatchTest, UnknownInstructionSet)
+{
+    ASSERT_FALSE(libzeth::internal::field_batch_select_isa("sse"));
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    libff::alt_bn128_pp::init_public_params();
+    libff::bls12_377_pp::init_public_params();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "libzeth/core/glv.hpp"
+
+#include <gtest/gtest.h>
+#include <libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp>
+#include <libff/algebra/curves/bls12_377/bls12_377_pp.hpp>
+
+namespace
+{
+
+template<typename ppT> void glv_decompose_test()
+{
+    using Field = libff::Fr<ppT>;
+    using G1 = libff::G1<ppT>;
+
+    const Field lambda = libzeth::internal::glv_constants<G1>::get().lambda;
+    const G1 point = Field::random_element() * G1::one();
+    ASSERT_EQ(lambda * point, libzeth::glv_endomorphism(point));
+
+    const std::vector<Field> scalars{
+        Field::zero(),
+        Field::one(),
+        -Field::one(),
+        lambda,
+        Field::random_element(),
+        Field::random_element(),
+        Field::random_element()};
+    for (const Field &scalar : scalars) {
+        const libzeth::glv_scalar<G1> decomposed =
+            libzeth::glv_decompose<G1>(scalar.as_bigint());
+        ASSERT_GE(Field::num_bits / 2 + 1, decomposed.k1.num_bits());
+        ASSERT_GE(Field::num_bits / 2 + 1, decomposed.k2.num_bits());
+
+        const Field k1 = decomposed.k1_negative ? -Field(decomposed.k1)
+                                                : Field(decomposed.k1);
+        const Field k2 = decomposed.k2_negative ? -Field(decomposed.k2)
+                                                : Field(decomposed.k2);
+        ASSERT_EQ(scalar, k1 + lambda * k2);
+    }
+}
+
+template<typename ppT, typename GroupT> void scalar_mul_test()
+{
+    using Field = libff::Fr<ppT>;
+
+    std::vector<Field> scalars{Field::zero(), -Field::one()};
+    for (size_t i = 0; i < 14; ++i) {
+        scalars.push_back(Field::random_element());
+    }
+
+    for (size_t i = 0; i < scalars.size(); ++i) {
+        GroupT point = Field::random_element() * GroupT::one();
+        if (i % 2 == 0) {
+            point.to_affine_coordinates();
+        }
+        ASSERT_EQ(scalars[i] * point, libzeth::scalar_mul(scalars[i], point));
+    }
+}
+
+TEST(GLVTest, ALT_BN128)
+{
+    using pp = libff::alt_bn128_pp;
+    glv_decompose_test<pp>();
+    scalar_mul_test<pp, libff::G1<pp>>();
+    scalar_mul_test<pp, libff::G2<pp>>();
+}
+
+TEST(GLVTest, BLS12_377)
+{
+    using pp = libff::bls12_377_pp;
+    glv_decompose_test<pp>();
+    scalar_mul_test<pp, libff::G1<pp>>();
+    scalar_mul_test<pp, libff::G2<pp>>();
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    libff::alt_bn128_pp::init_public_params();
+    libff::bls12_377_pp::init_public_params();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -178,6 +178,45 @@ TEST(GroupElementUtilsTest, G2CollectionEncodeDecodeBytes)
     group_elements_encode_decode_bytes_test<libff::G2<libff::bw6_761_pp>>();
 }
 
+template<typename GroupT> void batch_to_affine_test()
+{
+    // Elements in Jacobian and affine form, and zero in both forms.
+    std::vector<GroupT> points;
+    for (size_t i = 0; i < 2100; ++i) {
+        GroupT point = GroupT::random_element() + GroupT::random_element();
+        if (i % 3 == 0) {
+            point.to_affine_coordinates();
+        } else if (i % 7 == 0) {
+            point = point - point;
+        } else if (i % 11 == 0) {
+            point = GroupT::zero();
+        }
+        points.push_back(point);
+    }
+
+    std::vector<GroupT> affine_points = points;
+    libzeth::batch_to_affine(affine_points);
+    for (size_t i = 0; i < points.size(); ++i) {
+        GroupT expect = points[i];
+        expect.to_affine_coordinates();
+        ASSERT_EQ(expect.X, affine_points[i].X);
+        ASSERT_EQ(expect.Y, affine_points[i].Y);
+        ASSERT_EQ(expect.Z, affine_points[i].Z);
+    }
+}
+
+TEST(GroupElementUtilsTest, BatchToAffine)
+{
+    batch_to_affine_test<libff::G1<libff::alt_bn128_pp>>();
+    batch_to_affine_test<libff::G2<libff::alt_bn128_pp>>();
+    batch_to_affine_test<libff::G1<libff::bls12_377_pp>>();
+    batch_to_affine_test<libff::G2<libff::bls12_377_pp>>();
+    // Projective coordinates, converted individually.
+    batch_to_affine_test<libff::G1<libff::mnt4_pp>>();
+    batch_to_affine_test<libff::G2<libff::mnt4_pp>>();
+    batch_to_affine_test<libff::G1<libff::mnt6_pp>>();
+}
+
 } // namespace
 
 int main(int argc, char **argv)
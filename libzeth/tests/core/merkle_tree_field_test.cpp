@@ -0,0 +1,156 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "libzeth/circuits/circuit_types.hpp"
+#include "libzeth/core/merkle_tree_field.hpp"
+
+#include <gtest/gtest.h>
+#include <libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp>
+
+using namespace libzeth;
+
+using pp = libff::alt_bn128_pp;
+using Field = libff::Fr<pp>;
+using HashTree = HashTreeT<Field>;
+using layered_tree = merkle_tree_field<Field, HashTree>;
+using map_tree =
+    merkle_tree_field<Field, HashTree, merkle_tree_map_storage<Field>>;
+
+namespace
+{
+
+static const size_t TreeDepth = 5;
+
+// Compute the node at (layer, index) directly from the leaves.
+static Field reference_node(
+    const std::vector<Field> &leaves, size_t layer, size_t index)
+{
+    if (layer == TreeDepth) {
+        return (index < leaves.size()) ? leaves[index] : Field::zero();
+    }
+    return HashTree::get_hash(
+        reference_node(leaves, layer + 1, 2 * index),
+        reference_node(leaves, layer + 1, 2 * index + 1));
+}
+
+static std::vector<Field> reference_path(
+    const std::vector<Field> &leaves, size_t address)
+{
+    std::vector<Field> path;
+    for (size_t layer = TreeDepth; layer > 0; --layer) {
+        path.push_back(reference_node(leaves, layer, address ^ 1));
+        address = address / 2;
+    }
+    return path;
+}
+
+template<typename TreeT>
+void check_tree(const TreeT &tree, const std::vector<Field> &leaves)
+{
+    ASSERT_EQ(reference_node(leaves, 0, 0), tree.get_root());
+    for (size_t address = 0; address < (1ul << TreeDepth); ++address) {
+        const Field expect_value =
+            (address < leaves.size()) ? leaves[address] : Field::zero();
+        ASSERT_EQ(expect_value, tree.get_value(address));
+        ASSERT_EQ(reference_path(leaves, address), tree.get_path(address));
+    }
+}
+
+TEST(MerkleTreeFieldTest, EmptyTree)
+{
+    const layered_tree tree(TreeDepth);
+    ASSERT_EQ(tree.hash_defaults[0], tree.get_root());
+    check_tree(tree, {});
+    check_tree(map_tree(TreeDepth), {});
+}
+
+TEST(MerkleTreeFieldTest, SetValue)
+{
+    layered_tree tree(TreeDepth);
+    map_tree sparse_tree(TreeDepth);
+    std::vector<Field> leaves;
+    for (size_t i = 0; i < 7; ++i) {
+        leaves.push_back(Field::random_element());
+        tree.set_value(i, leaves.back());
+        sparse_tree.set_value(i, leaves.back());
+        check_tree(tree, leaves);
+        check_tree(sparse_tree, leaves);
+    }
+
+    // Overwrite an existing leaf
+    leaves[3] = Field::random_element();
+    tree.set_value(3, leaves[3]);
+    check_tree(tree, leaves);
+
+    // Set a leaf beyond the current frontier, leaving a gap of zero leaves.
+    leaves.resize(19, Field::zero());
+    leaves[18] = Field::random_element();
+    tree.set_value(18, leaves[18]);
+    sparse_tree.set_value(18, leaves[18]);
+    check_tree(tree, leaves);
+    check_tree(sparse_tree, leaves);
+}
+
+TEST(MerkleTreeFieldTest, ConstructFromContents)
+{
+    std::vector<Field> leaves;
+    for (size_t i = 0; i < 13; ++i) {
+        leaves.push_back(Field::random_element());
+    }
+    check_tree(layered_tree(TreeDepth, leaves), leaves);
+    check_tree(map_tree(TreeDepth, leaves), leaves);
+
+    // Sparse contents
+    std::map<size_t, Field> contents;
+    std::vector<Field> sparse_leaves(1ul << TreeDepth, Field::zero());
+    for (const size_t address : {1, 2, 9, 30}) {
+        sparse_leaves[address] = Field::random_element();
+        contents[address] = sparse_leaves[address];
+    }
+    check_tree(layered_tree(TreeDepth, contents), sparse_leaves);
+    check_tree(map_tree(TreeDepth, contents), sparse_leaves);
+}
+
+TEST(MerkleTreeFieldTest, SetValues)
+{
+    // Existing leaves, some of which are overwritten by the batch.
+    std::vector<Field> leaves(3 * 7, Field::zero());
+    layered_tree tree(TreeDepth);
+    map_tree sparse_tree(TreeDepth);
+    for (size_t i = 0; i < 7; ++i) {
+        leaves[3 * i] = Field::random_element();
+        tree.set_value(3 * i, leaves[3 * i]);
+        sparse_tree.set_value(3 * i, leaves[3 * i]);
+    }
+
+    const size_t first_address = 5;
+    std::vector<Field> values;
+    for (size_t i = 0; i < 22; ++i) {
+        values.push_back(Field::random_element());
+    }
+    leaves.resize(first_address + values.size(), Field::zero());
+    std::copy(values.begin(), values.end(), leaves.begin() + first_address);
+
+    tree.set_values(first_address, values);
+    sparse_tree.set_values(first_address, values);
+    check_tree(tree, leaves);
+    check_tree(sparse_tree, leaves);
+
+    // Empty and single-element batches
+    tree.set_values(2, {});
+    check_tree(tree, leaves);
+    leaves.resize(1ul << TreeDepth, Field::zero());
+    leaves.back() = Field::random_element();
+    tree.set_values(leaves.size() - 1, {leaves.back()});
+    check_tree(tree, leaves);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    pp::init_public_params();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,156 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "libzeth/circuits/circuit_types.hpp"
+#include "libzeth/core/merkle_tree_file.hpp"
+#include "libzeth/tests/temp_path.hpp"
+
+#include <fstream>
+#include <gtest/gtest.h>
+#include <libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp>
+
+using namespace libzeth;
+
+using pp = libff::alt_bn128_pp;
+using Field = libff::Fr<pp>;
+using HashTree = HashTreeT<Field>;
+using tree = merkle_tree_field<Field, HashTree>;
+using tree_file = merkle_tree_file<Field, HashTree>;
+
+namespace
+{
+
+static const size_t TreeDepth = 5;
+
+static std::vector<Field> random_leaves(const size_t num_leaves)
+{
+    std::vector<Field> leaves;
+    for (size_t i = 0; i < num_leaves; ++i) {
+        leaves.push_back(Field::random_element());
+    }
+    return leaves;
+}
+
+template<typename TreeT>
+void check_tree(const TreeT &persistent, const std::vector<Field> &leaves)
+{
+    const tree expect(TreeDepth, leaves);
+    ASSERT_EQ(expect.get_root(), persistent.get_root());
+    for (size_t address = 0; address < (1ul << TreeDepth); ++address) {
+        ASSERT_EQ(expect.get_path(address), persistent.get_path(address));
+    }
+}
+
+TEST(MerkleTreeFileTest, MatchesMerkleTreeField)
+{
+    const tests::temp_dir dir("merkle-tree");
+    tree_file persistent(dir.path.string(), TreeDepth);
+    std::vector<Field> leaves;
+    check_tree(persistent, leaves);
+
+    for (const size_t batch_size : {1, 4, 3, 9}) {
+        const std::vector<Field> batch = random_leaves(batch_size);
+        persistent.append(batch);
+        leaves.insert(leaves.end(), batch.begin(), batch.end());
+        ASSERT_EQ(leaves.size(), persistent.num_leaves());
+        ASSERT_EQ(leaves.back(), persistent.get_value(leaves.size() - 1));
+        check_tree(persistent, leaves);
+    }
+
+    // Appending beyond the capacity of the tree is rejected
+    const size_t num_free = (1ul << TreeDepth) - leaves.size();
+    ASSERT_THROW(
+        persistent.append(random_leaves(num_free + 1)), std::runtime_error);
+    check_tree(persistent, leaves);
+}
+
+TEST(MerkleTreeFileTest, Reopen)
+{
+    const tests::temp_dir dir("merkle-tree");
+    std::vector<Field> leaves = random_leaves(7);
+    {
+        tree_file persistent(dir.path.string(), TreeDepth);
+        persistent.append(leaves);
+        persistent.checkpoint();
+
+        // Not checkpointed, so must be recovered from the log.
+        const std::vector<Field> batch = random_leaves(6);
+        persistent.append(batch);
+        leaves.insert(leaves.end(), batch.begin(), batch.end());
+    }
+
+    {
+        tree_file persistent(dir.path.string(), TreeDepth);
+        ASSERT_EQ(leaves.size(), persistent.num_leaves());
+        check_tree(persistent, leaves);
+    }
+
+    // A partially written log entry (e.g. if the process stopped during an
+    // append) is discarded.
+    {
+        std::ofstream log_file(
+            (dir.path / "leaves.log").string(),
+            std::ios_base::app | std::ios_base::binary);
+        log_file << std::string(100, 'x');
+    }
+    {
+        tree_file persistent(dir.path.string(), TreeDepth);
+        check_tree(persistent, leaves);
+    }
+
+    // Parameters must match
+    ASSERT_THROW(
+        tree_file(dir.path.string(), TreeDepth + 1), std::invalid_argument);
+}
+
+TEST(MerkleTreeFileTest, Snapshots)
+{
+    const tests::temp_dir dir("merkle-tree");
+    std::vector<Field> leaves;
+    std::vector<Field> batch_roots;
+    std::vector<size_t> batch_num_leaves{0};
+    {
+        tree_file persistent(dir.path.string(), TreeDepth);
+        batch_roots.push_back(persistent.get_root());
+        for (const size_t batch_size : {3, 5, 2, 8}) {
+            const std::vector<Field> batch = random_leaves(batch_size);
+            persistent.append(batch);
+            leaves.insert(leaves.end(), batch.begin(), batch.end());
+            batch_roots.push_back(persistent.get_root());
+            batch_num_leaves.push_back(leaves.size());
+        }
+        persistent.checkpoint();
+    }
+
+    // The tree at any earlier number of leaves
+    const tree_file persistent(dir.path.string(), TreeDepth);
+    for (size_t num_leaves = 0; num_leaves <= leaves.size(); ++num_leaves) {
+        const std::vector<Field> prefix(
+            leaves.begin(), leaves.begin() + num_leaves);
+        const tree_file::snapshot view = persistent.get_snapshot(num_leaves);
+        ASSERT_EQ(num_leaves, view.num_leaves());
+        check_tree(view, prefix);
+    }
+    ASSERT_THROW(
+        persistent.get_snapshot(leaves.size() + 1), std::invalid_argument);
+
+    // The tree at the root after each batch
+    for (size_t i = 0; i < batch_roots.size(); ++i) {
+        ASSERT_EQ(
+            batch_num_leaves[i],
+            persistent.find_snapshot(batch_roots[i]).num_leaves());
+    }
+    ASSERT_THROW(
+        persistent.find_snapshot(Field::random_element()),
+        std::invalid_argument);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    pp::init_public_params();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,70 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "libzeth/circuits/circuit_types.hpp"
+#include "libzeth/core/merkle_tree_frontier.hpp"
+
+#include <gtest/gtest.h>
+#include <libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp>
+
+using namespace libzeth;
+
+using pp = libff::alt_bn128_pp;
+using Field = libff::Fr<pp>;
+using HashTree = HashTreeT<Field>;
+using tree = merkle_tree_field<Field, HashTree>;
+using frontier = merkle_tree_frontier<Field, HashTree>;
+
+namespace
+{
+
+static const size_t TreeDepth = 5;
+
+TEST(MerkleTreeFrontierTest, MatchesMerkleTreeField)
+{
+    tree full_tree(TreeDepth);
+    frontier tree_frontier(TreeDepth);
+    ASSERT_EQ(0, tree_frontier.num_leaves());
+    ASSERT_EQ(full_tree.get_root(), tree_frontier.get_root());
+
+    for (size_t address = 0; address < (1ul << TreeDepth); ++address) {
+        const Field value = Field::random_element();
+        const bool track = (address % 3 == 0);
+        ASSERT_EQ(address, tree_frontier.append(value, track));
+        full_tree.set_value(address, value);
+
+        ASSERT_EQ(address + 1, tree_frontier.num_leaves());
+        ASSERT_EQ(full_tree.get_root(), tree_frontier.get_root());
+
+        // All tracked witnesses are up to date
+        for (size_t tracked = 0; tracked <= address; ++tracked) {
+            const bool expect_tracked =
+                (tracked % 3 == 0) && !(tracked == 9 && address > 10);
+            ASSERT_EQ(expect_tracked, tree_frontier.is_tracked(tracked));
+            if (tree_frontier.is_tracked(tracked)) {
+                ASSERT_EQ(
+                    full_tree.get_path(tracked),
+                    tree_frontier.get_path(tracked));
+            }
+        }
+
+        if (address == 10) {
+            tree_frontier.untrack(9);
+            ASSERT_FALSE(tree_frontier.is_tracked(9));
+        }
+    }
+
+    // Untracked paths and appending to a full tree are rejected
+    ASSERT_THROW(tree_frontier.get_path(1), std::invalid_argument);
+    ASSERT_THROW(tree_frontier.append(Field::one()), std::runtime_error);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    pp::init_public_params();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
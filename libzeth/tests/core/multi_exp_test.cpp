@@ -0,0 +1,193 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "libzeth/core/multi_exp.hpp"
+
+#include <gtest/gtest.h>
+#include <libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp>
+#include <libff/algebra/curves/bls12_377/bls12_377_pp.hpp>
+#include <libff/algebra/curves/mnt/mnt4/mnt4_pp.hpp>
+
+namespace
+{
+
+// Random group elements and scalars, including the special cases 0, 1, -1
+// and small scalars, and (for every other element) group elements not in
+// affine form.
+template<typename FieldT, typename GroupT>
+void random_elements(
+    const size_t num_elements,
+    std::vector<GroupT> &gs,
+    std::vector<FieldT> &fs)
+{
+    gs.clear();
+    fs.clear();
+    for (size_t i = 0; i < num_elements; ++i) {
+        GroupT g = FieldT::random_element() * GroupT::one();
+        if (i % 2 == 0) {
+            g.to_affine_coordinates();
+        }
+        gs.push_back(g);
+
+        switch (i % 6) {
+        case 0:
+            fs.push_back(FieldT::zero());
+            break;
+        case 1:
+            fs.push_back(FieldT::one());
+            break;
+        case 2:
+            fs.push_back(-FieldT::one());
+            break;
+        case 3:
+            fs.push_back(FieldT((long)(i * 7919)));
+            break;
+        default:
+            fs.push_back(FieldT::random_element());
+            break;
+        }
+    }
+}
+
+template<typename FieldT, typename GroupT>
+GroupT naive_multi_exp(
+    const std::vector<GroupT> &gs, const std::vector<FieldT> &fs)
+{
+    GroupT result = GroupT::zero();
+    for (size_t i = 0; i < fs.size(); ++i) {
+        result = result + fs[i] * gs[i];
+    }
+    return result;
+}
+
+template<typename ppT, typename GroupT> void multi_exp_test()
+{
+    using Field = libff::Fr<ppT>;
+
+    // Sizes spanning several window sizes
+    for (const size_t num_elements : {0, 1, 2, 7, 31, 32, 100, 1000}) {
+        std::vector<GroupT> gs;
+        std::vector<Field> fs;
+        random_elements(num_elements, gs, fs);
+
+        const GroupT expect = naive_multi_exp(gs, fs);
+        ASSERT_EQ(
+            expect,
+            libzeth::multi_exp<Field, GroupT>(
+                gs.data(), fs.data(), num_elements));
+        ASSERT_EQ(
+            expect,
+            libzeth::multi_exp<Field, GroupT>(
+                gs.begin(), gs.end(), fs.begin(), fs.end()));
+        if (num_elements > 0) {
+            ASSERT_EQ(expect, libzeth::multi_exp<ppT, GroupT>(gs, fs));
+        }
+        ASSERT_EQ(
+            expect,
+            libzeth::multi_exp_classified<Field, GroupT>(
+                gs.data(), fs.data(), num_elements));
+    }
+}
+
+template<typename ppT, typename GroupT> void multi_exp_accumulation_test()
+{
+    using Field = libff::Fr<ppT>;
+
+    // Repeated elements and their negations lead to additions of doublings
+    // and inverses within a bucket.
+    const size_t num_elements = 5000;
+    std::vector<GroupT> gs;
+    std::vector<Field> fs;
+    random_elements(num_elements, gs, fs);
+    for (size_t i = 1; i < num_elements; i += 10) {
+        gs[i] = gs[i - 1];
+        gs[i + 1] = -gs[i - 1];
+        fs[i] = fs[i - 1];
+        fs[i + 1] = fs[i - 1];
+    }
+
+    const GroupT expect = naive_multi_exp(gs, fs);
+    for (const libzeth::multi_exp_accumulation accumulation :
+         {libzeth::multi_exp_accumulation_jacobian,
+          libzeth::multi_exp_accumulation_batch_affine}) {
+        ASSERT_EQ(
+            expect,
+            libzeth::multi_exp<Field, GroupT>(
+                gs.data(), fs.data(), num_elements, accumulation));
+        ASSERT_EQ(
+            expect,
+            libzeth::multi_exp_classified<Field, GroupT>(
+                gs.data(), fs.data(), num_elements, accumulation));
+    }
+}
+
+template<typename ppT, typename GroupT> void multi_exp_batch_test()
+{
+    using Field = libff::Fr<ppT>;
+
+    for (const size_t num_elements : {0, 1, 100, 1000}) {
+        for (const size_t num_sets : {1, 3}) {
+            std::vector<GroupT> gs;
+            std::vector<std::vector<Field>> fs(num_sets);
+            std::vector<const Field *> fs_ptrs;
+            for (std::vector<Field> &set_fs : fs) {
+                random_elements(num_elements, gs, set_fs);
+                fs_ptrs.push_back(set_fs.data());
+            }
+
+            const std::vector<GroupT> results =
+                libzeth::multi_exp_batch<Field, GroupT>(
+                    gs.data(), fs_ptrs, num_elements);
+            ASSERT_EQ(num_sets, results.size());
+            for (size_t set = 0; set < num_sets; ++set) {
+                ASSERT_EQ(naive_multi_exp(gs, fs[set]), results[set]);
+            }
+        }
+    }
+}
+
+TEST(MultiExpTest, ALT_BN128)
+{
+    using pp = libff::alt_bn128_pp;
+    multi_exp_test<pp, libff::G1<pp>>();
+    multi_exp_test<pp, libff::G2<pp>>();
+    multi_exp_accumulation_test<pp, libff::G1<pp>>();
+    multi_exp_accumulation_test<pp, libff::G2<pp>>();
+    multi_exp_batch_test<pp, libff::G1<pp>>();
+    multi_exp_batch_test<pp, libff::G2<pp>>();
+}
+
+TEST(MultiExpTest, BLS12_377)
+{
+    using pp = libff::bls12_377_pp;
+    multi_exp_test<pp, libff::G1<pp>>();
+    multi_exp_test<pp, libff::G2<pp>>();
+    multi_exp_accumulation_test<pp, libff::G1<pp>>();
+    multi_exp_accumulation_test<pp, libff::G2<pp>>();
+    multi_exp_batch_test<pp, libff::G1<pp>>();
+    multi_exp_batch_test<pp, libff::G2<pp>>();
+}
+
+TEST(MultiExpTest, MNT4)
+{
+    // Projective coordinates on a curve with a != 0, for which batch affine
+    // accumulation (whether requested or automatic) is not used.
+    using pp = libff::mnt4_pp;
+    multi_exp_test<pp, libff::G1<pp>>();
+    multi_exp_test<pp, libff::G2<pp>>();
+    multi_exp_accumulation_test<pp, libff::G1<pp>>();
+    multi_exp_accumulation_test<pp, libff::G2<pp>>();
+    multi_exp_batch_test<pp, libff::G1<pp>>();
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    libff::alt_bn128_pp::init_public_params();
+    libff::bls12_377_pp::init_public_params();
+    libff::mnt4_pp::init_public_params();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
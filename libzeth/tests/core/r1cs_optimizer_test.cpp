@@ -0,0 +1,162 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "libzeth/circuits/blake2s/blake2s.hpp"
+#include "libzeth/circuits/circuit_types.hpp"
+#include "libzeth/circuits/mimc/mimc_input_hasher.hpp"
+#include "libzeth/core/r1cs_optimizer.hpp"
+#include "libzeth/snarks/groth16/groth16_snark.hpp"
+#include "libzeth/tests/circuits/simple_test.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace libzeth;
+using pp = defaults::pp;
+using Field = defaults::Field;
+using HashTree = tree_hash_selector<Field>::tree_hash;
+
+namespace
+{
+
+// Check that the optimized constraint system of `pb` is satisfied by the
+// mapped assignment, and is no larger than the original.
+void check_optimized_assignment(const libsnark::protoboard<Field> &pb)
+{
+    const libsnark::r1cs_constraint_system<Field> &cs =
+        pb.get_constraint_system();
+    ASSERT_TRUE(cs.is_satisfied(pb.primary_input(), pb.auxiliary_input()));
+
+    const r1cs_optimization<Field> optimization = r1cs_optimize(cs);
+    const libsnark::r1cs_constraint_system<Field> &optimized_cs =
+        optimization.constraint_system;
+    ASSERT_EQ(cs.primary_input_size, optimized_cs.primary_input_size);
+    ASSERT_LE(optimized_cs.num_constraints(), cs.num_constraints());
+    ASSERT_LE(optimized_cs.num_variables(), cs.num_variables());
+    ASSERT_TRUE(optimized_cs.is_satisfied(
+        pb.primary_input(),
+        optimization.map_auxiliary_input(pb.auxiliary_input())));
+}
+
+TEST(R1CSOptimizerTest, EliminateLinearConstraints)
+{
+    // Primary input x, and auxiliary inputs a, b, c, d.
+    const libsnark::variable<Field> x(1);
+    const libsnark::variable<Field> a(2);
+    const libsnark::variable<Field> b(3);
+    const libsnark::variable<Field> c(4);
+    const libsnark::variable<Field> d(5);
+    const libsnark::linear_combination<Field> one(Field::one());
+
+    libsnark::r1cs_constraint_system<Field> cs;
+    cs.primary_input_size = 1;
+    cs.auxiliary_input_size = 4;
+    // b is an alias of a
+    cs.add_constraint(libsnark::r1cs_constraint<Field>(one, a, b));
+    // c = a * a
+    cs.add_constraint(libsnark::r1cs_constraint<Field>(a, a, c));
+    // x = b + c
+    cs.add_constraint(libsnark::r1cs_constraint<Field>(one, b + c, x));
+    // Trivially satisfied, leaving d unconstrained
+    cs.add_constraint(libsnark::r1cs_constraint<Field>(one, one, one));
+    cs.add_constraint(
+        libsnark::r1cs_constraint<Field>(d, Field::zero(), Field::zero()));
+
+    const r1cs_optimization<Field> optimization = r1cs_optimize(cs);
+    const libsnark::r1cs_constraint_system<Field> &optimized_cs =
+        optimization.constraint_system;
+
+    // a and c are eliminated, leaving the single constraint b * b = x - b.
+    ASSERT_EQ(1, optimized_cs.num_constraints());
+    ASSERT_EQ(1, optimized_cs.primary_input_size);
+    ASSERT_EQ(1, optimized_cs.auxiliary_input_size);
+    ASSERT_EQ(std::vector<size_t>{3}, optimization.auxiliary_sources);
+
+    const std::vector<Field> primary{Field(12)};
+    const std::vector<Field> auxiliary{Field(3), Field(3), Field(9), Field(5)};
+    ASSERT_TRUE(cs.is_satisfied(primary, auxiliary));
+    ASSERT_TRUE(optimized_cs.is_satisfied(
+        primary, optimization.map_auxiliary_input(auxiliary)));
+
+    const std::vector<Field> invalid_primary{Field(13)};
+    ASSERT_FALSE(optimized_cs.is_satisfied(
+        invalid_primary, optimization.map_auxiliary_input(auxiliary)));
+}
+
+TEST(R1CSOptimizerTest, Unsatisfiable)
+{
+    const libsnark::linear_combination<Field> one(Field::one());
+    libsnark::r1cs_constraint_system<Field> cs;
+    cs.primary_input_size = 0;
+    cs.auxiliary_input_size = 0;
+    cs.add_constraint(libsnark::r1cs_constraint<Field>(one, one, one + one));
+    ASSERT_THROW(r1cs_optimize(cs), std::invalid_argument);
+}
+
+TEST(R1CSOptimizerTest, ProveAndVerify)
+{
+    using snark = groth16_snark<pp>;
+
+    libsnark::protoboard<Field> pb;
+    tests::simple_circuit(pb);
+    const r1cs_optimization<Field> optimization =
+        r1cs_optimize(pb.get_constraint_system());
+    ASSERT_EQ(2, optimization.constraint_system.num_constraints());
+
+    const snark::keypair keypair =
+        snark::generate_setup(optimization.constraint_system);
+    std::vector<Field> primary;
+    std::vector<Field> auxiliary;
+    tests::simple_circuit_assignment(Field(3), primary, auxiliary);
+    const snark::proof proof = snark::generate_proof(
+        keypair.pk, primary, optimization.map_auxiliary_input(auxiliary));
+    ASSERT_TRUE(snark::verify(primary, proof, keypair.vk));
+}
+
+TEST(R1CSOptimizerTest, BLAKE2s)
+{
+    libsnark::protoboard<Field> pb;
+    libsnark::block_variable<Field> input(pb, 512, "input");
+    libsnark::digest_variable<Field> output(pb, BLAKE2s_digest_size, "output");
+    BLAKE2s_256<Field> blake2s_gadget(pb, input, output);
+    blake2s_gadget.generate_r1cs_constraints();
+
+    libff::bit_vector input_bits(512);
+    for (size_t i = 0; i < input_bits.size(); ++i) {
+        input_bits[i] = (i % 3) == 0;
+    }
+    input.generate_r1cs_witness(input_bits);
+    blake2s_gadget.generate_r1cs_witness();
+
+    check_optimized_assignment(pb);
+}
+
+TEST(R1CSOptimizerTest, MiMCInputHasher)
+{
+    const size_t num_values = 5;
+
+    libsnark::protoboard<Field> pb;
+    libsnark::pb_variable_array<Field> values;
+    values.allocate(pb, num_values, "values");
+    libsnark::pb_variable<Field> hashed_values;
+    hashed_values.allocate(pb, "hashed_values");
+
+    mimc_input_hasher<Field, HashTree> hasher(
+        pb, values, hashed_values, "hasher");
+    hasher.generate_r1cs_constraints();
+    for (size_t i = 0; i < num_values; ++i) {
+        pb.val(values[i]) = Field::random_element();
+    }
+    hasher.generate_r1cs_witness();
+
+    check_optimized_assignment(pb);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    pp::init_public_params();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,117 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "libzeth/core/resource_pool.hpp"
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace libzeth;
+
+namespace
+{
+
+struct counter_resource {
+    std::atomic<size_t> num_users;
+    size_t num_uses;
+
+    counter_resource() : num_users(0), num_uses(0) {}
+};
+
+using counter_pool = resource_pool<counter_resource>;
+
+static std::vector<std::unique_ptr<counter_resource>> make_counters(size_t n)
+{
+    std::vector<std::unique_ptr<counter_resource>> counters;
+    for (size_t i = 0; i < n; ++i) {
+        counters.emplace_back(new counter_resource());
+    }
+    return counters;
+}
+
+TEST(ResourcePoolTest, LeaseAndRelease)
+{
+    counter_pool pool(make_counters(2));
+    ASSERT_EQ(2, pool.size());
+    ASSERT_EQ(2, pool.num_available());
+
+    counter_pool::lease l1 = pool.acquire();
+    ASSERT_TRUE(l1.valid());
+    ASSERT_EQ(1, pool.num_available());
+
+    {
+        counter_pool::lease l2 = pool.try_acquire();
+        ASSERT_TRUE(l2.valid());
+        ASSERT_NE(&*l1, &*l2);
+        ASSERT_EQ(0, pool.num_available());
+
+        // Pool exhausted
+        counter_pool::lease l3 = pool.try_acquire();
+        ASSERT_FALSE(l3.valid());
+    }
+
+    // l2 returned on destruction
+    ASSERT_EQ(1, pool.num_available());
+
+    // Move transfers ownership without releasing
+    counter_pool::lease l4(std::move(l1));
+    ASSERT_FALSE(l1.valid());
+    ASSERT_TRUE(l4.valid());
+    ASSERT_EQ(1, pool.num_available());
+
+    l4.release();
+    ASSERT_FALSE(l4.valid());
+    ASSERT_EQ(2, pool.num_available());
+}
+
+TEST(ResourcePoolTest, ExclusiveAccessUnderContention)
+{
+    const size_t num_resources = 3;
+    const size_t num_threads = 8;
+    const size_t iterations = 200;
+
+    counter_pool pool(make_counters(num_resources));
+    std::atomic<bool> violation(false);
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&pool, &violation, iterations]() {
+            for (size_t i = 0; i < iterations; ++i) {
+                counter_pool::lease l = pool.acquire();
+                if (l->num_users.fetch_add(1) != 0) {
+                    violation = true;
+                }
+                ++l->num_uses;
+                std::this_thread::yield();
+                l->num_users.fetch_sub(1);
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_FALSE(violation);
+    ASSERT_EQ(num_resources, pool.num_available());
+
+    size_t total_uses = 0;
+    for (size_t i = 0; i < num_resources; ++i) {
+        total_uses += pool.get(i).num_uses;
+    }
+    ASSERT_EQ(num_threads * iterations, total_uses);
+}
+
+TEST(ResourcePoolTest, EmptyPoolRejected)
+{
+    ASSERT_THROW(counter_pool(make_counters(0)), std::invalid_argument);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
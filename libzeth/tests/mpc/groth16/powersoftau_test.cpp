@@ -2,6 +2,7 @@
 //
 // SPDX-License-Identifier: LGPL-3.0+
 
+#include "libzeth/core/blocked_radix2_domain.hpp"
 #include "libzeth/core/evaluator_from_lagrange.hpp"
 #include "libzeth/core/utils.hpp"
 #include "libzeth/mpc/groth16/powersoftau_utils.hpp"
@@ -457,7 +458,7 @@ TEST(PowersOfTauTests, ComputeLagrangeEvaluation)
 
     // Compare to the naive evaluations obtained using iFFT in Fr, and
     // evaluating the polynomial.
-    libfqfft::basic_radix2_domain<Fr> domain(n);
+    blocked_radix2_domain<Fr> domain(n);
     evaluator_from_lagrange<ppT, G1> eval_g1(pot.tau_powers_g1, domain);
     evaluator_from_lagrange<ppT, G2> eval_g2(pot.tau_powers_g2, domain);
     evaluator_from_lagrange<ppT, G1> eval_alpha_g1(
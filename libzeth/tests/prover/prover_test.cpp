@@ -730,6 +730,24 @@ template<typename snarkT> static void run_prover_tests()
 
     TestValidJS2In2Deposit(proverJS2to2, keypair);
 
+    // Witnesses for the notes generated concurrently also give valid proofs.
+    proverJS2to2.set_parallel_witness(true);
+    TestValidJS2In2Case1(proverJS2to2, keypair);
+    TestValidJS2In2Deposit(proverJS2to2, keypair);
+    proverJS2to2.set_parallel_witness(false);
+
+    // Witnesses generated by replaying the witness tape are identical to
+    // those generated by the gadgets (the Deposit case is run in between, so
+    // that no variable keeps its value from the previous Case1 witness).
+    TestValidJS2In2Case1(proverJS2to2, keypair);
+    const std::vector<Field> gadget_assignment =
+        proverJS2to2.get_last_assignment();
+    proverJS2to2.set_witness_tape(true);
+    TestValidJS2In2Deposit(proverJS2to2, keypair);
+    TestValidJS2In2Case1(proverJS2to2, keypair);
+    ASSERT_EQ(gadget_assignment, proverJS2to2.get_last_assignment());
+    proverJS2to2.set_witness_tape(false);
+
     // The following is expected to throw an exception because LHS =/= RHS.
     // Ensure that the exception is thrown.
     ASSERT_THROW(
@@ -0,0 +1,123 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "libzeth/circuits/circuit_types.hpp"
+#include "libzeth/circuits/circuit_wrapper.hpp"
+#include "libzeth/core/durable_file.hpp"
+#include "libzeth/serialization/r1cs_cache.hpp"
+#include "libzeth/snarks/groth16/groth16_snark.hpp"
+#include "libzeth/tests/circuits/simple_test.hpp"
+#include "libzeth/tests/temp_path.hpp"
+
+#include <gtest/gtest.h>
+
+using pp = libzeth::defaults::pp;
+using Field = libzeth::defaults::Field;
+
+namespace
+{
+
+template<size_t NumInputs, size_t NumOutputs, size_t TreeDepth>
+std::string parameters_hash(const std::string &circuit_name)
+{
+    return libzeth::circuit_parameters_hash<
+        libzeth::HashT<Field>,
+        libzeth::HashTreeT<Field>,
+        pp,
+        NumInputs,
+        NumOutputs,
+        TreeDepth>(circuit_name);
+}
+
+TEST(R1CSCacheTest, ParametersHash)
+{
+    const std::string hash = parameters_hash<2, 2, 32>("joinsplit");
+    ASSERT_EQ(hash, (parameters_hash<2, 2, 32>("joinsplit")));
+    ASSERT_NE(hash, (parameters_hash<2, 2, 32>("circuit_wrapper")));
+    ASSERT_NE(hash, (parameters_hash<1, 2, 32>("joinsplit")));
+    ASSERT_NE(hash, (parameters_hash<2, 1, 32>("joinsplit")));
+    ASSERT_NE(hash, (parameters_hash<2, 2, 16>("joinsplit")));
+}
+
+TEST(R1CSCacheTest, ReadWrite)
+{
+    libsnark::protoboard<Field> pb;
+    libzeth::tests::simple_circuit(pb);
+    const libsnark::r1cs_constraint_system<Field> &cs =
+        pb.get_constraint_system();
+    const std::string hash = parameters_hash<2, 2, 32>("simple");
+    const std::string other_hash = parameters_hash<2, 2, 16>("simple");
+
+    libzeth::tests::temp_file file("r1cs-cache");
+    libsnark::r1cs_constraint_system<Field> cs_read;
+    ASSERT_FALSE(libzeth::r1cs_cache_read(file.path.string(), hash, cs_read));
+
+    libzeth::r1cs_cache_write(file.path.string(), hash, cs);
+    ASSERT_TRUE(libzeth::r1cs_cache_read(file.path.string(), hash, cs_read));
+    ASSERT_EQ(cs, cs_read);
+
+    // A cache written for other parameters is ignored.
+    libsnark::r1cs_constraint_system<Field> cs_other;
+    ASSERT_FALSE(
+        libzeth::r1cs_cache_read(file.path.string(), other_hash, cs_other));
+    ASSERT_EQ(0, cs_other.num_constraints());
+
+    // Modified or truncated constraint systems are detected.
+    std::string contents = libzeth::read_file(file.path.string());
+    contents.back() ^= 1;
+    libzeth::write_file_atomic(file.path.string(), contents);
+    ASSERT_THROW(
+        libzeth::r1cs_cache_read(file.path.string(), hash, cs_other),
+        std::runtime_error);
+    contents.pop_back();
+    libzeth::write_file_atomic(file.path.string(), contents);
+    ASSERT_THROW(
+        libzeth::r1cs_cache_read(file.path.string(), hash, cs_other),
+        std::runtime_error);
+}
+
+TEST(R1CSCacheTest, CircuitWrapperFromCache)
+{
+    using circuit_wrapper = libzeth::circuit_wrapper<
+        libzeth::HashT<Field>,
+        libzeth::HashTreeT<Field>,
+        pp,
+        libzeth::groth16_snark<pp>,
+        2,
+        2,
+        4>;
+
+    libzeth::tests::temp_file file("r1cs-cache");
+    {
+        const circuit_wrapper circuit;
+        libzeth::r1cs_cache_write(
+            file.path.string(),
+            circuit_wrapper::parameters_hash(),
+            circuit.get_constraint_system());
+    }
+
+    std::shared_ptr<libsnark::r1cs_constraint_system<Field>> cs =
+        std::make_shared<libsnark::r1cs_constraint_system<Field>>();
+    ASSERT_TRUE(libzeth::r1cs_cache_read(
+        file.path.string(), circuit_wrapper::parameters_hash(), *cs));
+    const circuit_wrapper cached_circuit(cs);
+    ASSERT_EQ(*cs, cached_circuit.get_constraint_system());
+
+    // Constraint systems with different variables are rejected.
+    libsnark::protoboard<Field> pb;
+    libzeth::tests::simple_circuit(pb);
+    std::shared_ptr<libsnark::r1cs_constraint_system<Field>> simple_cs =
+        std::make_shared<libsnark::r1cs_constraint_system<Field>>(
+            pb.get_constraint_system());
+    ASSERT_THROW(circuit_wrapper{simple_cs}, std::invalid_argument);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    pp::init_public_params();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,112 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "libzeth/snarks/groth16/groth16_mapped_proving_key.hpp"
+#include "libzeth/tests/circuits/simple_test.hpp"
+#include "libzeth/tests/temp_path.hpp"
+
+#include <fstream>
+#include <gtest/gtest.h>
+#include <libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp>
+#include <libff/algebra/curves/bls12_377/bls12_377_pp.hpp>
+
+namespace
+{
+
+template<typename ppT> void mapped_proving_key_round_trip_test()
+{
+    using Field = libff::Fr<ppT>;
+    using snark = libzeth::groth16_snark<ppT>;
+    using mapped_proving_key = libzeth::groth16_mapped_proving_key<ppT>;
+
+    libsnark::protoboard<Field> pb;
+    libzeth::tests::simple_circuit(pb);
+    libzeth::tests::simple_circuit(pb);
+    const typename snark::keypair keypair = snark::generate_setup(pb);
+
+    libzeth::tests::temp_file file("mapped-pk");
+    {
+        std::ofstream out_s(
+            file.path.c_str(), std::ios_base::out | std::ios_base::binary);
+        mapped_proving_key::write(keypair.pk, keypair.vk, out_s);
+    }
+
+    const mapped_proving_key mapped_pk(file.path.string());
+    ASSERT_TRUE(mapped_pk.is_well_formed());
+    ASSERT_EQ(keypair.pk.A_query.size(), mapped_pk.A_query_size());
+    ASSERT_EQ(keypair.pk.B_query.size(), mapped_pk.B_query_size());
+    ASSERT_EQ(keypair.pk.H_query.size(), mapped_pk.H_query_size());
+    ASSERT_EQ(keypair.pk.L_query.size(), mapped_pk.L_query_size());
+
+    // Mapped points are usable in place.
+    for (size_t i = 0; i < mapped_pk.A_query_size(); ++i) {
+        ASSERT_EQ(keypair.pk.A_query[i], mapped_pk.A_query()[i]);
+    }
+    for (size_t i = 0; i < mapped_pk.B_query_size(); ++i) {
+        ASSERT_EQ(
+            keypair.pk.B_query.indices[i], mapped_pk.B_query_indices()[i]);
+        ASSERT_EQ(keypair.pk.B_query.values[i].g, mapped_pk.B_query_g()[i]);
+        ASSERT_EQ(keypair.pk.B_query.values[i].h, mapped_pk.B_query_h()[i]);
+    }
+
+    // Materialized keys, using the stored and an external constraint system.
+    typename snark::proving_key pk;
+    mapped_pk.to_proving_key(pk);
+    ASSERT_EQ(keypair.pk, pk);
+
+    typename snark::proving_key pk_external_cs;
+    mapped_pk.to_proving_key(pk_external_cs, &pb.get_constraint_system());
+    ASSERT_EQ(keypair.pk, pk_external_cs);
+
+    typename snark::verification_key vk;
+    mapped_pk.verification_key_read(vk);
+    ASSERT_EQ(keypair.vk, vk);
+
+    // Proofs generated with the materialized key are valid.
+    std::vector<Field> primary;
+    std::vector<Field> auxiliary;
+    libzeth::tests::simple_circuit_assignment(Field("7"), primary, auxiliary);
+    libzeth::tests::simple_circuit_assignment(
+        Field("9"), auxiliary, auxiliary);
+    const typename snark::proof proof =
+        snark::generate_proof(pk, primary, auxiliary);
+    ASSERT_TRUE(snark::verify(primary, proof, vk));
+}
+
+template<typename ppT> void mapped_proving_key_rejects_invalid_test()
+{
+    using mapped_proving_key = libzeth::groth16_mapped_proving_key<ppT>;
+
+    libzeth::tests::temp_file file("mapped-pk");
+    {
+        std::ofstream out_s(
+            file.path.c_str(), std::ios_base::out | std::ios_base::binary);
+        const std::string junk(4096, 'x');
+        out_s.write(junk.data(), junk.size());
+    }
+
+    ASSERT_THROW(mapped_proving_key(file.path.string()), std::invalid_argument);
+}
+
+TEST(Groth16MappedProvingKeyTest, RoundTrip)
+{
+    mapped_proving_key_round_trip_test<libff::alt_bn128_pp>();
+    mapped_proving_key_round_trip_test<libff::bls12_377_pp>();
+}
+
+TEST(Groth16MappedProvingKeyTest, RejectsInvalidFile)
+{
+    mapped_proving_key_rejects_invalid_test<libff::alt_bn128_pp>();
+    mapped_proving_key_rejects_invalid_test<libff::bls12_377_pp>();
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    libff::alt_bn128_pp::init_public_params();
+    libff::bls12_377_pp::init_public_params();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
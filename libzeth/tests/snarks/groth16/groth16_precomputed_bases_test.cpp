@@ -0,0 +1,109 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "libzeth/snarks/groth16/groth16_precomputed_bases.hpp"
+#include "libzeth/tests/circuits/simple_test.hpp"
+#include "libzeth/tests/temp_path.hpp"
+
+#include <fstream>
+#include <gtest/gtest.h>
+#include <libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp>
+#include <libff/algebra/curves/bls12_377/bls12_377_pp.hpp>
+
+namespace
+{
+
+template<typename ppT> void precomputed_bases_test(const size_t window_size)
+{
+    using Field = libff::Fr<ppT>;
+    using G1 = libff::G1<ppT>;
+    using snark = libzeth::groth16_snark<ppT>;
+    using precomputed_bases = libzeth::groth16_precomputed_bases<ppT>;
+
+    libsnark::protoboard<Field> pb;
+    libzeth::tests::simple_circuit(pb);
+    libzeth::tests::simple_circuit(pb);
+    const typename snark::keypair keypair = snark::generate_setup(pb);
+
+    libzeth::tests::temp_file file("precomputed");
+    {
+        std::ofstream out_s(
+            file.path.c_str(), std::ios_base::out | std::ios_base::binary);
+        precomputed_bases::write(keypair.pk, window_size, out_s);
+    }
+
+    const precomputed_bases precomputed(file.path.string());
+    ASSERT_TRUE(precomputed.matches(keypair.pk));
+    if (window_size != 0) {
+        ASSERT_EQ(window_size, precomputed.window_size());
+    }
+
+    // MSMs over the tables match those over the keys.
+    const size_t A_size = keypair.pk.A_query.size();
+    std::vector<Field> scalars(A_size);
+    for (Field &scalar : scalars) {
+        scalar = Field::random_element();
+    }
+    ASSERT_EQ(
+        libzeth::multi_exp<Field, G1>(
+            keypair.pk.A_query.data(), scalars.data(), A_size),
+        libzeth::multi_exp_precomputed<Field, G1>(
+            precomputed.A_query(),
+            precomputed.window_size(),
+            precomputed.num_windows(),
+            scalars.data(),
+            A_size));
+
+    // Proofs generated with the tables are valid.
+    std::vector<Field> primary;
+    std::vector<Field> auxiliary;
+    libzeth::tests::simple_circuit_assignment(Field("7"), primary, auxiliary);
+    libzeth::tests::simple_circuit_assignment(
+        Field("9"), auxiliary, auxiliary);
+    const typename snark::proof proof =
+        snark::generate_proof(keypair.pk, precomputed, primary, auxiliary);
+    ASSERT_TRUE(snark::verify(primary, proof, keypair.vk));
+
+    // Tables for another key are rejected.
+    const typename snark::keypair other_keypair = snark::generate_setup(pb);
+    ASSERT_FALSE(precomputed.matches(other_keypair.pk));
+}
+
+template<typename ppT> void precomputed_bases_rejects_invalid_test()
+{
+    using precomputed_bases = libzeth::groth16_precomputed_bases<ppT>;
+
+    libzeth::tests::temp_file file("precomputed");
+    {
+        std::ofstream out_s(
+            file.path.c_str(), std::ios_base::out | std::ios_base::binary);
+        const std::string junk(4096, 'x');
+        out_s.write(junk.data(), junk.size());
+    }
+
+    ASSERT_THROW(precomputed_bases(file.path.string()), std::invalid_argument);
+}
+
+TEST(Groth16PrecomputedBasesTest, ProofWithPrecomputedBases)
+{
+    precomputed_bases_test<libff::alt_bn128_pp>(0);
+    precomputed_bases_test<libff::alt_bn128_pp>(9);
+    precomputed_bases_test<libff::bls12_377_pp>(0);
+}
+
+TEST(Groth16PrecomputedBasesTest, RejectsInvalidFile)
+{
+    precomputed_bases_rejects_invalid_test<libff::alt_bn128_pp>();
+    precomputed_bases_rejects_invalid_test<libff::bls12_377_pp>();
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    libff::alt_bn128_pp::init_public_params();
+    libff::bls12_377_pp::init_public_params();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -4,6 +4,7 @@
 
 #include "libzeth/serialization/proto_utils.hpp"
 #include "libzeth/serialization/r1cs_variable_assignment_serialization.hpp"
+#include "libzeth/snarks/groth16/groth16_proving_context.hpp"
 #include "libzeth/snarks/groth16/groth16_snark.hpp"
 #include "libzeth/tests/snarks/common_snark_tests.tcc"
 
@@ -170,6 +171,126 @@ template<typename ppT> void generate_test_data()
     }
 }
 
+template<typename ppT> void generate_proofs_test()
+{
+    using snark = libzeth::groth16_snark<ppT>;
+    using Field = libff::Fr<ppT>;
+
+    libsnark::protoboard<Field> pb;
+    libzeth::tests::simple_circuit(pb);
+    libzeth::tests::simple_circuit(pb);
+    const typename snark::keypair keypair = snark::generate_setup(pb);
+
+    const size_t num_proofs = 3;
+    std::vector<libsnark::r1cs_primary_input<Field>> primary(num_proofs);
+    std::vector<libsnark::r1cs_auxiliary_input<Field>> auxiliary(num_proofs);
+    for (size_t i = 0; i < num_proofs; ++i) {
+        libzeth::tests::simple_circuit_assignment(
+            Field((long)(10 + i)), primary[i], auxiliary[i]);
+        libzeth::tests::simple_circuit_assignment(
+            Field((long)(20 + i)), auxiliary[i], auxiliary[i]);
+    }
+
+    const std::vector<typename snark::proof> proofs =
+        snark::generate_proofs(keypair.pk, primary, auxiliary);
+    ASSERT_EQ(num_proofs, proofs.size());
+    for (size_t i = 0; i < num_proofs; ++i) {
+        ASSERT_TRUE(snark::verify(primary[i], proofs[i], keypair.vk));
+    }
+
+    // Proofs do not verify against the inputs of other proofs.
+    ASSERT_FALSE(snark::verify(primary[1], proofs[0], keypair.vk));
+}
+
+template<typename ppT> void proving_context_test()
+{
+    using snark = libzeth::groth16_snark<ppT>;
+    using Field = libff::Fr<ppT>;
+
+    libsnark::protoboard<Field> pb;
+    libzeth::tests::simple_circuit(pb);
+    libzeth::tests::simple_circuit(pb);
+    const typename snark::keypair keypair = snark::generate_setup(pb);
+    const libzeth::groth16_proving_context<ppT> context(keypair.pk, 2);
+    ASSERT_EQ(2, context.num_workspaces());
+
+    // Workspaces are reused across proofs with different assignments.
+    for (size_t i = 0; i < 3; ++i) {
+        libsnark::r1cs_primary_input<Field> primary;
+        libsnark::r1cs_auxiliary_input<Field> auxiliary;
+        libzeth::tests::simple_circuit_assignment(
+            Field((long)(10 + i)), primary, auxiliary);
+        libzeth::tests::simple_circuit_assignment(
+            Field((long)(20 + i)), auxiliary, auxiliary);
+        const typename snark::proof proof =
+            snark::generate_proof(keypair.pk, context, primary, auxiliary);
+        ASSERT_TRUE(snark::verify(primary, proof, keypair.vk));
+    }
+
+    // Batches of proofs use the same context.
+    const size_t num_proofs = 3;
+    std::vector<libsnark::r1cs_primary_input<Field>> primary(num_proofs);
+    std::vector<libsnark::r1cs_auxiliary_input<Field>> auxiliary(num_proofs);
+    for (size_t i = 0; i < num_proofs; ++i) {
+        libzeth::tests::simple_circuit_assignment(
+            Field((long)(30 + i)), primary[i], auxiliary[i]);
+        libzeth::tests::simple_circuit_assignment(
+            Field((long)(40 + i)), auxiliary[i], auxiliary[i]);
+    }
+    const std::vector<typename snark::proof> proofs =
+        snark::generate_proofs(keypair.pk, context, primary, auxiliary);
+    ASSERT_EQ(num_proofs, proofs.size());
+    for (size_t i = 0; i < num_proofs; ++i) {
+        ASSERT_TRUE(snark::verify(primary[i], proofs[i], keypair.vk));
+    }
+
+    ASSERT_THROW(
+        libzeth::groth16_proving_context<ppT>(keypair.pk, 0),
+        std::invalid_argument);
+}
+
+template<typename ppT> void non_radix2_domain_test()
+{
+    using snark = libzeth::groth16_snark<ppT>;
+    using Field = libff::Fr<ppT>;
+
+    // With 9 constraints and 1 input, and without forcing a power of 2
+    // domain, libsnark uses a step_radix2_domain of size 8 + 4.
+    libsnark::protoboard<Field> pb;
+    libzeth::tests::simple_circuit(pb);
+    libzeth::tests::simple_circuit(pb);
+    libzeth::tests::simple_circuit(pb);
+    const typename snark::keypair keypair =
+        libsnark::r1cs_gg_ppzksnark_generator<ppT>(
+            pb.get_constraint_system(), false);
+    ASSERT_EQ(12, keypair.pk.H_query.size() + 1);
+
+    libsnark::r1cs_primary_input<Field> primary;
+    libsnark::r1cs_auxiliary_input<Field> auxiliary;
+    libzeth::tests::simple_circuit_assignment(Field("10"), primary, auxiliary);
+    libzeth::tests::simple_circuit_assignment(
+        Field("20"), auxiliary, auxiliary);
+    libzeth::tests::simple_circuit_assignment(
+        Field("30"), auxiliary, auxiliary);
+
+    const typename snark::proof proof =
+        snark::generate_proof(keypair.pk, primary, auxiliary);
+    ASSERT_TRUE(snark::verify(primary, proof, keypair.vk));
+
+    const libzeth::groth16_proving_context<ppT> context(keypair.pk, 1);
+    ASSERT_TRUE(context.domain() == nullptr);
+    const typename snark::proof context_proof =
+        snark::generate_proof(keypair.pk, context, primary, auxiliary);
+    ASSERT_TRUE(snark::verify(primary, context_proof, keypair.vk));
+
+    const std::vector<typename snark::proof> proofs = snark::generate_proofs(
+        keypair.pk, context, {primary, primary}, {auxiliary, auxiliary});
+    ASSERT_EQ(2, proofs.size());
+    for (const typename snark::proof &p : proofs) {
+        ASSERT_TRUE(snark::verify(primary, p, keypair.vk));
+    }
+}
+
 TEST(Groth16SnarkTest, Groth16TestData)
 {
     generate_test_data<libff::alt_bn128_pp>();
@@ -217,6 +338,24 @@ TEST(Groth16SnarkTest, TestProofReadWriteBytes)
     ASSERT_TRUE(test_bls12_377);
 }
 
+TEST(Groth16SnarkTest, TestGenerateProofs)
+{
+    generate_proofs_test<libff::alt_bn128_pp>();
+    generate_proofs_test<libff::bls12_377_pp>();
+}
+
+TEST(Groth16SnarkTest, TestProvingContext)
+{
+    proving_context_test<libff::alt_bn128_pp>();
+    proving_context_test<libff::bls12_377_pp>();
+}
+
+TEST(Groth16SnarkTest, TestNonRadix2Domain)
+{
+    non_radix2_domain_test<libff::alt_bn128_pp>();
+    non_radix2_domain_test<libff::bls12_377_pp>();
+}
+
 } // namespace
 
 int main(int argc, char **argv)
@@ -0,0 +1,58 @@
+// Copyright (c) 2015-2021 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_TEST_TEMP_PATH_HPP__
+#define __ZETH_TEST_TEMP_PATH_HPP__
+
+#include <boost/filesystem.hpp>
+#include <string>
+
+namespace libzeth
+{
+namespace tests
+{
+
+/// A unique path in the temporary directory, of the form
+/// zeth-<name>-XXXX-XXXX. Nothing is created at the path.
+inline boost::filesystem::path unique_temp_path(const std::string &name)
+{
+    return boost::filesystem::temp_directory_path() /
+           boost::filesystem::unique_path("zeth-" + name + "-%%%%-%%%%");
+}
+
+/// A temporary file path (see unique_temp_path), removed on destruction.
+class temp_file
+{
+public:
+    explicit temp_file(const std::string &name) : path(unique_temp_path(name))
+    {
+    }
+    ~temp_file() { boost::filesystem::remove(path); }
+
+    temp_file(const temp_file &) = delete;
+    temp_file &operator=(const temp_file &) = delete;
+
+    const boost::filesystem::path path;
+};
+
+/// A temporary directory path (see unique_temp_path), removed along with its
+/// contents on destruction.
+class temp_dir
+{
+public:
+    explicit temp_dir(const std::string &name) : path(unique_temp_path(name))
+    {
+    }
+    ~temp_dir() { boost::filesystem::remove_all(path); }
+
+    temp_dir(const temp_dir &) = delete;
+    temp_dir &operator=(const temp_dir &) = delete;
+
+    const boost::filesystem::path path;
+};
+
+} // namespace tests
+} // namespace libzeth
+
+#endif // __ZETH_TEST_TEMP_PATH_HPP__
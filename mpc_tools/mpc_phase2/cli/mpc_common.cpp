@@ -4,6 +4,8 @@
 
 #include "mpc_common.hpp"
 
+#include "libzeth/serialization/r1cs_cache.hpp"
+
 #include <iostream>
 
 namespace po = boost::program_options;
@@ -18,10 +20,15 @@ subcommand::subcommand(
 }
 
 void subcommand::set_global_options(
-    bool verbose, const ProtoboardInitFn &pb_init)
+    bool verbose,
+    const ProtoboardInitFn &pb_init,
+    const std::string &r1cs_cache_file,
+    const std::string &r1cs_cache_key)
 {
     this->verbose = verbose;
     this->protoboard_init = pb_init;
+    this->r1cs_cache_file = r1cs_cache_file;
+    this->r1cs_cache_key = r1cs_cache_key;
 }
 
 int subcommand::execute(const std::vector<std::string> &args)
@@ -75,6 +82,24 @@ void subcommand::init_protoboard(libsnark::protoboard<Field> &pb) const
     protoboard_init(pb);
 }
 
+libsnark::r1cs_constraint_system<subcommand::Field> subcommand::
+    constraint_system() const
+{
+    libsnark::r1cs_constraint_system<Field> cs;
+    if (!r1cs_cache_file.empty() &&
+        libzeth::r1cs_cache_read(r1cs_cache_file, r1cs_cache_key, cs)) {
+        return cs;
+    }
+
+    libsnark::protoboard<Field> pb;
+    init_protoboard(pb);
+    if (!r1cs_cache_file.empty()) {
+        libzeth::r1cs_cache_write(
+            r1cs_cache_file, r1cs_cache_key, pb.get_constraint_system());
+    }
+    return pb.get_constraint_system();
+}
+
 void subcommand::usage(const po::options_description &options)
 {
     subcommand_usage();
@@ -105,11 +130,19 @@ int mpc_main(
     int argc,
     char **argv,
     const std::map<std::string, subcommand *> &commands,
-    const ProtoboardInitFn &pb_init)
+    const ProtoboardInitFn &pb_init,
+    const std::string &r1cs_cache_key)
 {
     libzeth::defaults::pp::init_public_params();
     po::options_description global("Global options");
     global.add_options()("help,h", "This help")("verbose,v", "Verbose output");
+    if (!r1cs_cache_key.empty()) {
+        global.add_options()(
+            "r1cs-cache",
+            po::value<std::string>(),
+            "File caching the circuit constraint system (loaded if valid, "
+            "otherwise written)");
+    }
 
     po::options_description all("");
     all.add(global).add_options()(
@@ -168,7 +201,11 @@ int mpc_main(
             throw po::error("invalid command");
         }
 
-        sub->set_global_options(verbose, pb_init);
+        const std::string r1cs_cache_file =
+            vm.count("r1cs-cache") ? vm["r1cs-cache"].as<std::string>() : "";
+
+        sub->set_global_options(
+            verbose, pb_init, r1cs_cache_file, r1cs_cache_key);
         return sub->execute(subargs);
     } catch (po::error &error) {
         std::cerr << " ERROR: " << error.what() << std::endl;
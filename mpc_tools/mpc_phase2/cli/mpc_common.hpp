@@ -25,6 +25,8 @@ protected:
     std::string subcommand_description;
     bool verbose;
     ProtoboardInitFn protoboard_init;
+    std::string r1cs_cache_file;
+    std::string r1cs_cache_key;
 
 private:
     bool help;
@@ -34,13 +36,22 @@ public:
 
     subcommand(
         const std::string &subcommand_name, const std::string &description);
-    void set_global_options(bool verbose, const ProtoboardInitFn &pb_init);
+    void set_global_options(
+        bool verbose,
+        const ProtoboardInitFn &pb_init,
+        const std::string &r1cs_cache_file,
+        const std::string &r1cs_cache_key);
     int execute(const std::vector<std::string> &args);
     const std::string &description() const;
 
 protected:
     void init_protoboard(libsnark::protoboard<Field> &pb) const;
 
+    /// The constraint system of the circuit, loaded from the r1cs cache file
+    /// if given and valid. Otherwise the constraint system is generated (see
+    /// init_protoboard) and, if a cache file was given, written to it.
+    libsnark::r1cs_constraint_system<Field> constraint_system() const;
+
 private:
     void usage(const boost::program_options::options_description &all_options);
 
@@ -94,11 +105,15 @@ extern subcommand *mpc_phase2_verify_contribution_cmd;
 extern subcommand *mpc_phase2_verify_transcript_cmd;
 extern subcommand *mpc_create_keypair_cmd;
 
-/// Main entry point into the mpc command for a given circuit.
+/// Main entry point into the mpc command for a given circuit. If
+/// `r1cs_cache_key` is non-empty (see libzeth::circuit_parameters_hash), the
+/// constraint system can be cached in a file, specified by the global
+/// `--r1cs-cache` option.
 int mpc_main(
     int argc,
     char **argv,
     const std::map<std::string, subcommand *> &commands,
-    const ProtoboardInitFn &pb_init);
+    const ProtoboardInitFn &pb_init,
+    const std::string &r1cs_cache_key = "");
 
 #endif // __ZETH_MPC_CLI_COMMON_HPP__
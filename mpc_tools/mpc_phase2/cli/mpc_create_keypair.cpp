@@ -147,9 +147,7 @@ private:
 
         // Compute circuit
         libff::enter_block("Generate QAP");
-        libsnark::protoboard<Field> pb;
-        init_protoboard(pb);
-        libsnark::r1cs_constraint_system<Field> cs = pb.get_constraint_system();
+        libsnark::r1cs_constraint_system<Field> cs = constraint_system();
         const libsnark::qap_instance<Field> qap =
             libsnark::r1cs_to_qap_instance_map(cs, true);
         libff::leave_block("Generate QAP");
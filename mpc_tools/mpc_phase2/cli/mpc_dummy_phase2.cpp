@@ -83,13 +83,10 @@ private:
             read_from_file<srs_mpc_layer_L1<pp>>(linear_combination_file);
         libff::leave_block("reading linear combination data");
 
-        // Generate the zeth circuit (to determine the number of inputs)
+        // Load or generate the constraint system (to determine the number of
+        // inputs)
         libff::enter_block("computing num_inputs");
-        const size_t num_inputs = [this]() {
-            libsnark::protoboard<Field> pb;
-            init_protoboard(pb);
-            return pb.num_inputs();
-        }();
+        const size_t num_inputs = constraint_system().primary_input_size;
         libff::print_indent();
         std::cout << std::to_string(num_inputs) << std::endl;
         libff::leave_block("computing num_inputs");
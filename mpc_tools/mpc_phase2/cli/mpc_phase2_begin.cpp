@@ -84,11 +84,7 @@ private:
 
         // Compute circuit
         libff::enter_block("Computing num inputs");
-        const size_t num_inputs = [this]() {
-            libsnark::protoboard<Field> pb;
-            init_protoboard(pb);
-            return pb.num_inputs();
-        }();
+        const size_t num_inputs = constraint_system().primary_input_size;
         libff::print_indent();
         std::cout << std::to_string(num_inputs) << std::endl;
         libff::leave_block("Computing num inputs");
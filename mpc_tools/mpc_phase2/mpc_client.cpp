@@ -33,5 +33,12 @@ int main(int argc, char **argv)
         {"phase2-verify-transcript", mpc_phase2_verify_transcript_cmd},
         {"create-keypair", mpc_create_keypair_cmd},
     };
-    return mpc_main(argc, argv, commands, zeth_protoboard);
+    const std::string r1cs_cache_key = libzeth::circuit_parameters_hash<
+        libzeth::HashT<Field>,
+        libzeth::HashTreeT<Field>,
+        libzeth::defaults::pp,
+        libzeth::ZETH_NUM_JS_INPUTS,
+        libzeth::ZETH_NUM_JS_OUTPUTS,
+        libzeth::ZETH_MERKLE_TREE_DEPTH>("joinsplit");
+    return mpc_main(argc, argv, commands, zeth_protoboard, r1cs_cache_key);
 }
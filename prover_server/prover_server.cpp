@@ -4,15 +4,32 @@
 
 #include "libzeth/circuits/circuit_types.hpp"
 #include "libzeth/core/extended_proof.hpp"
+#include "libzeth/core/r1cs_optimizer.hpp"
+#include "libzeth/core/resource_pool.hpp"
 #include "libzeth/core/utils.hpp"
 #include "libzeth/serialization/proto_utils.hpp"
+#include "libzeth/serialization/r1cs_cache.hpp"
 #include "libzeth/serialization/r1cs_serialization.hpp"
 #include "libzeth/serialization/r1cs_variable_assignment_serialization.hpp"
 #include "libzeth/zeth_constants.hpp"
 #include "zeth_config.h"
 
+#if defined(ZETH_SNARK_GROTH16)
+#include "libzeth/snarks/groth16/groth16_mapped_proving_key.hpp"
+#include "libzeth/snarks/groth16/groth16_precomputed_bases.hpp"
+#include "libzeth/snarks/groth16/groth16_proving_context.hpp"
+#endif
+
+#include <algorithm>
+#include <atomic>
 #include <boost/program_options.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <deque>
 #include <fstream>
+#include <functional>
 #include <grpc/grpc.h>
 #include <grpcpp/security/server_credentials.h>
 #include <grpcpp/server.h>
@@ -20,8 +37,13 @@
 #include <grpcpp/server_context.h>
 #include <libsnark/common/data_structures/merkle_tree.hpp>
 #include <memory>
+#include <mutex>
+#include <pthread.h>
+#include <sstream>
+#include <stdexcept>
 #include <stdio.h>
 #include <string>
+#include <thread>
 #include <zeth/api/prover.grpc.pb.h>
 
 using pp = libzeth::defaults::pp;
@@ -38,6 +60,7 @@ using circuit_wrapper = libzeth::circuit_wrapper<
     libzeth::ZETH_NUM_JS_INPUTS,
     libzeth::ZETH_NUM_JS_OUTPUTS,
     libzeth::ZETH_MERKLE_TREE_DEPTH>;
+using circuit_wrapper_pool = libzeth::resource_pool<circuit_wrapper>;
 
 namespace proto = google::protobuf;
 namespace po = boost::program_options;
@@ -62,6 +85,123 @@ static snark::keypair load_keypair(const boost::filesystem::path &keypair_file)
     return keypair;
 }
 
+// Throw if the proving key was not generated for the constraint system used
+// by `prover` for proofs, which would otherwise cause the prover to read out
+// of bounds of the key. This is the case, for example, for keys generated
+// with and used without --optimize-r1cs (or vice versa), or for keys
+// generated by the MPC for the unoptimized circuit.
+static void check_keypair(
+    const snark::keypair &keypair, const circuit_wrapper &prover)
+{
+    const libsnark::r1cs_constraint_system<Field> &key_cs =
+        keypair.pk.constraint_system;
+    const libsnark::r1cs_constraint_system<Field> &cs =
+        prover.get_proving_constraint_system();
+    if (key_cs.num_variables() != cs.num_variables() ||
+        key_cs.num_inputs() != cs.num_inputs() ||
+        key_cs.num_constraints() != cs.num_constraints()) {
+        std::stringstream ss;
+        ss << "keypair does not match the constraint system (variables: "
+           << key_cs.num_variables() << " vs " << cs.num_variables()
+           << ", inputs: " << key_cs.num_inputs() << " vs "
+           << cs.num_inputs() << ", constraints: "
+           << key_cs.num_constraints() << " vs " << cs.num_constraints()
+           << "). Check the use of --optimize-r1cs.";
+        throw std::invalid_argument(ss.str());
+    }
+}
+
+#if defined(ZETH_SNARK_GROTH16)
+
+using mapped_proving_key = libzeth::groth16_mapped_proving_key<pp>;
+
+// Load a keypair from a file in the mapped proving key format. The
+// constraint system is taken from the circuit, rather than parsed from the
+// file.
+static snark::keypair load_mapped_keypair(
+    const boost::filesystem::path &mapped_pk_file,
+    const circuit_wrapper &prover)
+{
+    const mapped_proving_key mapped_pk(mapped_pk_file.string());
+    mapped_pk.prefetch();
+
+    snark::keypair keypair;
+    mapped_pk.to_proving_key(
+        keypair.pk, &prover.get_proving_constraint_system());
+    mapped_pk.verification_key_read(keypair.vk);
+    return keypair;
+}
+
+// Write a keypair in the mapped proving key format. The file is written
+// under a temporary name and then renamed, so that other processes never
+// map a partially written file.
+static void write_mapped_keypair(
+    const snark::keypair &keypair,
+    const boost::filesystem::path &mapped_pk_file)
+{
+    const boost::filesystem::path tmp_file =
+        mapped_pk_file.string() + ".tmp";
+    {
+        std::ofstream out_s(
+            tmp_file.c_str(), std::ios_base::out | std::ios_base::binary);
+        out_s.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+        mapped_proving_key::write(keypair.pk, keypair.vk, out_s);
+    }
+    boost::filesystem::rename(tmp_file, mapped_pk_file);
+}
+
+using precomputed_bases = libzeth::groth16_precomputed_bases<pp>;
+using proving_context = libzeth::groth16_proving_context<pp>;
+
+// Write the precomputed bases for a proving key, using a temporary file as
+// for write_mapped_keypair.
+static void write_precomputed_bases(
+    const snark::proving_key &pk,
+    const size_t window_size,
+    const boost::filesystem::path &precomputed_file)
+{
+    const boost::filesystem::path tmp_file =
+        precomputed_file.string() + ".tmp";
+    {
+        std::ofstream out_s(
+            tmp_file.c_str(), std::ios_base::out | std::ios_base::binary);
+        out_s.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+        precomputed_bases::write(pk, window_size, out_s);
+    }
+    boost::filesystem::rename(tmp_file, precomputed_file);
+}
+
+// Load (generating if necessary) the precomputed bases for a proving key.
+static std::unique_ptr<precomputed_bases> load_precomputed_bases(
+    const snark::proving_key &pk,
+    const size_t window_size,
+    const boost::filesystem::path &precomputed_file)
+{
+    if (!boost::filesystem::exists(precomputed_file)) {
+        std::cout << "[INFO] Writing precomputed bases to "
+                  << precomputed_file << "\n";
+        write_precomputed_bases(pk, window_size, precomputed_file);
+    }
+
+    std::cout << "[INFO] Loading precomputed bases: " << precomputed_file
+              << "\n";
+    std::unique_ptr<precomputed_bases> precomputed(
+        new precomputed_bases(precomputed_file.string()));
+    if (!precomputed->matches(pk)) {
+        throw std::invalid_argument(
+            "precomputed bases do not match the proving key");
+    }
+    if (window_size != 0 && window_size != precomputed->window_size()) {
+        std::cout << "[WARNING] Precomputed bases have window size "
+                  << precomputed->window_size() << " (requested "
+                  << window_size << ")\n";
+    }
+    precomputed->prefetch();
+    return precomputed;
+}
+
+#endif // defined(ZETH_SNARK_GROTH16)
+
 static void write_keypair(
     const typename snark::keypair &keypair,
     const boost::filesystem::path &keypair_file)
@@ -89,11 +229,44 @@ static void write_verification_key(
     snark::verification_key_write_bytes(vk, out_s);
 }
 
+// Load the constraint system from the cache file, if given and valid.
+// Otherwise generate it (and write it to the cache file, if given). The
+// constraint system is shared by all circuit instances.
+static std::shared_ptr<const libsnark::r1cs_constraint_system<Field>>
+load_constraint_system(const boost::filesystem::path &r1cs_cache_file)
+{
+    const std::string parameters_hash = circuit_wrapper::parameters_hash();
+    std::shared_ptr<libsnark::r1cs_constraint_system<Field>> cs =
+        std::make_shared<libsnark::r1cs_constraint_system<Field>>();
+    if (!r1cs_cache_file.empty() &&
+        libzeth::r1cs_cache_read(
+            r1cs_cache_file.string(), parameters_hash, *cs)) {
+        std::cout << "[INFO] Loaded constraint system from "
+                  << r1cs_cache_file << "\n";
+        return cs;
+    }
+
+    {
+        // The temporary circuit, and its own copy of the constraints, are
+        // released once the constraints have been copied.
+        const circuit_wrapper circuit;
+        *cs = circuit.get_constraint_system();
+    }
+    if (!r1cs_cache_file.empty()) {
+        std::cout << "[INFO] Writing constraint system to " << r1cs_cache_file
+                  << "\n";
+        libzeth::r1cs_cache_write(
+            r1cs_cache_file.string(), parameters_hash, *cs);
+    }
+    return cs;
+}
+
 static void write_constraint_system(
     const circuit_wrapper &prover, const boost::filesystem::path &r1cs_file)
 {
     std::ofstream r1cs_stream(r1cs_file.c_str());
-    libzeth::r1cs_write_json(prover.get_constraint_system(), r1cs_stream);
+    libzeth::r1cs_write_json(
+        prover.get_proving_constraint_system(), r1cs_stream);
 }
 
 static void write_extproof_to_json_file(
@@ -122,16 +295,99 @@ static void write_assignment_to_file(
     libzeth::r1cs_variable_assignment_write_bytes(assignment, out_s);
 }
 
-/// The prover_server class inherits from the Prover service
-/// defined in the proto files, and provides an implementation
-/// of the service.
-class prover_server final : public zeth_proto::Prover::Service
+std::string get_server_version()
 {
-private:
-    circuit_wrapper &prover;
+    char buffer[100];
+    int n;
+    // Defined in the zethConfig file
+    n = snprintf(
+        buffer, 100, "Version %d.%d", ZETH_VERSION_MAJOR, ZETH_VERSION_MINOR);
+    if (n < 0) {
+        return "Version <Not specified>";
+    }
+    std::string version(buffer);
+    return version;
+}
 
-    // The keypair is the result of the setup. Store a copy internally.
-    snark::keypair keypair;
+void display_server_start_message()
+{
+    std::string copyright =
+        "Copyright (c) 2015-2021 Clearmatics Technologies Ltd";
+    std::string license = "SPDX-License-Identifier: LGPL-3.0+";
+    std::string project =
+        "R&D Department: PoC for Zerocash on Ethereum/Autonity";
+    std::string version = get_server_version();
+    std::string warning = "**WARNING:** This code is a research-quality proof "
+                          "of concept, DO NOT use in production!";
+
+    std::cout << "\n=====================================================\n";
+    std::cout << copyright << "\n";
+    std::cout << license << "\n";
+    std::cout << project << "\n";
+    std::cout << version << "\n";
+    std::cout << warning << "\n";
+    std::cout << "=====================================================\n"
+              << std::endl;
+}
+
+/// Parsed form of a zeth_proto::ProofInputs message.
+struct proof_inputs {
+    Field root;
+    std::array<
+        libzeth::joinsplit_input<Field, libzeth::ZETH_MERKLE_TREE_DEPTH>,
+        libzeth::ZETH_NUM_JS_INPUTS>
+        joinsplit_inputs;
+    std::array<libzeth::zeth_note, libzeth::ZETH_NUM_JS_OUTPUTS>
+        joinsplit_outputs;
+    libzeth::bits64 vpub_in;
+    libzeth::bits64 vpub_out;
+    libzeth::bits256 h_sig_in;
+    libzeth::bits256 phi_in;
+};
+
+static void proof_inputs_from_proto(
+    const zeth_proto::ProofInputs &proof_inputs_proto, proof_inputs &out)
+{
+    out.root = libzeth::base_field_element_from_hex<Field>(
+        proof_inputs_proto.mk_root());
+    out.vpub_in = libzeth::bits64::from_hex(proof_inputs_proto.pub_in_value());
+    out.vpub_out =
+        libzeth::bits64::from_hex(proof_inputs_proto.pub_out_value());
+    out.h_sig_in = libzeth::bits256::from_hex(proof_inputs_proto.h_sig());
+    out.phi_in = libzeth::bits256::from_hex(proof_inputs_proto.phi());
+
+    if (libzeth::ZETH_NUM_JS_INPUTS != proof_inputs_proto.js_inputs_size()) {
+        throw std::invalid_argument("Invalid number of JS inputs");
+    }
+    if (libzeth::ZETH_NUM_JS_OUTPUTS != proof_inputs_proto.js_outputs_size()) {
+        throw std::invalid_argument("Invalid number of JS outputs");
+    }
+
+    for (size_t i = 0; i < libzeth::ZETH_NUM_JS_INPUTS; i++) {
+        const zeth_proto::JoinsplitInput &received_input =
+            proof_inputs_proto.js_inputs(i);
+        out.joinsplit_inputs[i] = libzeth::
+            joinsplit_input_from_proto<Field, libzeth::ZETH_MERKLE_TREE_DEPTH>(
+                received_input);
+    }
+
+    for (size_t i = 0; i < libzeth::ZETH_NUM_JS_OUTPUTS; i++) {
+        const zeth_proto::ZethNote &received_output =
+            proof_inputs_proto.js_outputs(i);
+        out.joinsplit_outputs[i] =
+            libzeth::zeth_note_from_proto(received_output);
+    }
+}
+
+/// Request handling logic common to the synchronous and asynchronous
+/// servers. Holds the (shared, read-only) keypair and the debug output
+/// configuration. All methods may be called concurrently.
+class prover_backend
+{
+private:
+    // The keypair is the result of the setup. It is shared (read-only) by all
+    // circuit_wrapper instances in the pool.
+    const snark::keypair &keypair;
 
     // Optional file to write proofs into (for debugging).
     boost::filesystem::path extproof_json_output_file;
@@ -145,16 +401,25 @@ private:
     // Optional file to write full assignments into (for debugging).
     boost::filesystem::path assignment_output_file;
 
+#if defined(ZETH_SNARK_GROTH16)
+    // Optional precomputed tables for the bases of the proving key.
+    std::unique_ptr<precomputed_bases> precomputed;
+
+    // Domain, precomputed data and buffers shared by all proofs.
+    std::unique_ptr<proving_context> context;
+#endif
+
+    // Serializes writes to the debug output files.
+    std::mutex debug_output_mutex;
+
 public:
-    explicit prover_server(
-        circuit_wrapper &prover,
+    prover_backend(
         const snark::keypair &keypair,
         const boost::filesystem::path &extproof_json_output_file,
         const boost::filesystem::path &proof_output_file,
         const boost::filesystem::path &primary_output_file,
         const boost::filesystem::path &assignment_output_file)
-        : prover(prover)
-        , keypair(keypair)
+        : keypair(keypair)
         , extproof_json_output_file(extproof_json_output_file)
         , proof_output_file(proof_output_file)
         , primary_output_file(primary_output_file)
@@ -162,20 +427,33 @@ public:
     {
     }
 
-    grpc::Status GetConfiguration(
-        grpc::ServerContext *,
-        const proto::Empty *,
-        zeth_proto::ProverConfiguration *response) override
+#if defined(ZETH_SNARK_GROTH16)
+    /// Use the given precomputed bases (which must match the proving key)
+    /// for all subsequent proofs. Must be called before any requests are
+    /// served.
+    void set_precomputed_bases(std::unique_ptr<precomputed_bases> bases)
+    {
+        precomputed = std::move(bases);
+    }
+
+    /// Create the proving context (including any precomputed bases), with
+    /// one workspace per concurrent proof. Must be called after
+    /// set_precomputed_bases and before any requests are served.
+    void init_proving_context(const size_t num_workspaces)
+    {
+        context.reset(new proving_context(
+            keypair.pk, num_workspaces, precomputed.get()));
+    }
+#endif
+
+    grpc::Status get_configuration(zeth_proto::ProverConfiguration *response)
     {
         std::cout << "[ACK] Received the request for configuration\n";
         prover_configuration_to_proto(*response);
         return grpc::Status::OK;
     }
 
-    grpc::Status GetVerificationKey(
-        grpc::ServerContext *,
-        const proto::Empty *,
-        zeth_proto::VerificationKey *response) override
+    grpc::Status get_verification_key(zeth_proto::VerificationKey *response)
     {
         std::cout << "[ACK] Received the request to get the verification key"
                   << std::endl;
@@ -195,192 +473,930 @@ public:
         return grpc::Status::OK;
     }
 
-    grpc::Status Prove(
-        grpc::ServerContext *,
-        const zeth_proto::ProofInputs *proof_inputs,
-        zeth_proto::ExtendedProofAndPublicData *proof_and_public_data) override
+    /// Generate a proof for the given inputs, using a circuit leased from
+    /// `provers` (blocking until one is available).
+    grpc::Status prove(
+        circuit_wrapper_pool &provers,
+        const zeth_proto::ProofInputs &proof_inputs_proto,
+        zeth_proto::ExtendedProofAndPublicData *proof_and_public_data)
     {
         std::cout << "[ACK] Received the request to generate a proof"
                   << std::endl;
         std::cout << "[DEBUG] Parse received message to compute proof..."
                   << std::endl;
 
-        // Parse received message to feed to the prover
         try {
-            // TODO: Factor this into more maintainable smaller functions
-
-            Field root = libzeth::base_field_element_from_hex<Field>(
-                proof_inputs->mk_root());
-            libzeth::bits64 vpub_in =
-                libzeth::bits64::from_hex(proof_inputs->pub_in_value());
-            libzeth::bits64 vpub_out =
-                libzeth::bits64::from_hex(proof_inputs->pub_out_value());
-            libzeth::bits256 h_sig_in =
-                libzeth::bits256::from_hex(proof_inputs->h_sig());
-            libzeth::bits256 phi_in =
-                libzeth::bits256::from_hex(proof_inputs->phi());
-
-            if (libzeth::ZETH_NUM_JS_INPUTS != proof_inputs->js_inputs_size()) {
-                throw std::invalid_argument("Invalid number of JS inputs");
-            }
-            if (libzeth::ZETH_NUM_JS_OUTPUTS !=
-                proof_inputs->js_outputs_size()) {
-                throw std::invalid_argument("Invalid number of JS outputs");
-            }
+            proof_inputs inputs;
+            proof_inputs_from_proto(proof_inputs_proto, inputs);
+            std::cout << "[DEBUG] Data parsed successfully" << std::endl;
+
+            // Wait for a free circuit instance.
+            circuit_wrapper_pool::lease prover = provers.acquire();
+            generate_proof(*prover, inputs, proof_and_public_data);
+        } catch (const std::exception &e) {
+            std::cout << "[ERROR] " << e.what() << std::endl;
+            return grpc::Status(
+                grpc::StatusCode::INVALID_ARGUMENT, grpc::string(e.what()));
+        } catch (...) {
+            std::cout << "[ERROR] In catch all" << std::endl;
+            return grpc::Status(grpc::StatusCode::UNKNOWN, "");
+        }
+
+        return grpc::Status::OK;
+    }
+
+    /// Generate proofs for all entries of a batch. All inputs are parsed up
+    /// front, and the witnesses are generated concurrently using the circuit
+    /// instances of `provers` (see for_each_batch_entry). For Groth16, the
+    /// proofs are then generated together (see
+    /// groth16_snark::generate_proofs), so that the bases of the proving key
+    /// are traversed once for the whole batch, using the same threads as a
+    /// single proof. Results are passed to `writer` once all proofs have been
+    /// generated. Failures of individual entries are reported in the
+    /// corresponding result, and do not abort the batch.
+    grpc::Status prove_batch(
+        circuit_wrapper_pool &provers,
+        grpc::ServerContext *context,
+        const zeth_proto::ProofInputsBatch &batch,
+        grpc::ServerWriter<zeth_proto::ProofBatchResult> *writer)
+    {
+        const size_t batch_size = batch.proof_inputs_size();
+        std::cout << "[ACK] Received the request to generate a batch of "
+                  << batch_size << " proofs" << std::endl;
 
-            std::cout << "[DEBUG] Process all inputs of the JoinSplit"
-                      << std::endl;
-            std::array<
-                libzeth::
-                    joinsplit_input<Field, libzeth::ZETH_MERKLE_TREE_DEPTH>,
-                libzeth::ZETH_NUM_JS_INPUTS>
-                joinsplit_inputs;
-            for (size_t i = 0; i < libzeth::ZETH_NUM_JS_INPUTS; i++) {
-                printf(
-                    "\r  input (%zu / %zu)\n", i, libzeth::ZETH_NUM_JS_INPUTS);
-                const zeth_proto::JoinsplitInput &received_input =
-                    proof_inputs->js_inputs(i);
-                joinsplit_inputs[i] = libzeth::joinsplit_input_from_proto<
-                    Field,
-                    libzeth::ZETH_MERKLE_TREE_DEPTH>(received_input);
+        std::vector<proof_inputs> inputs(batch_size);
+        std::vector<std::string> errors(batch_size);
+        for (size_t i = 0; i < batch_size; ++i) {
+            try {
+                proof_inputs_from_proto(batch.proof_inputs(i), inputs[i]);
+            } catch (const std::exception &e) {
+                errors[i] = e.what();
             }
+        }
 
-            std::cout << "[DEBUG] Process all outputs of the JoinSplit"
-                      << std::endl;
-            std::array<libzeth::zeth_note, libzeth::ZETH_NUM_JS_OUTPUTS>
-                joinsplit_outputs;
-            for (size_t i = 0; i < libzeth::ZETH_NUM_JS_OUTPUTS; i++) {
-                printf(
-                    "\r  output (%zu / %zu)\n",
-                    i,
-                    libzeth::ZETH_NUM_JS_OUTPUTS);
-                const zeth_proto::ZethNote &received_output =
-                    proof_inputs->js_outputs(i);
-                libzeth::zeth_note parsed_output =
-                    libzeth::zeth_note_from_proto(received_output);
-                joinsplit_outputs[i] = parsed_output;
+        std::vector<zeth_proto::ProofBatchResult> results(batch_size);
+        generate_batch_proofs(provers, context, inputs, errors, results);
+
+        for (size_t i = 0; i < batch_size; ++i) {
+            zeth_proto::ProofBatchResult &result = results[i];
+            result.set_index(i);
+            if (!errors[i].empty()) {
+                std::cout << "[ERROR] batch entry " << i << ": " << errors[i]
+                          << std::endl;
+                result.clear_extended_proof_and_public_data();
+                result.set_error(errors[i]);
+            }
+            if (!writer->Write(result)) {
+                break;
             }
+        }
 
-            std::cout << "[DEBUG] Data parsed successfully" << std::endl;
-            std::cout << "[DEBUG] Generating the proof..." << std::endl;
-
-            std::vector<Field> public_data;
-            libzeth::extended_proof<pp, snark> ext_proof = this->prover.prove(
-                root,
-                joinsplit_inputs,
-                joinsplit_outputs,
-                vpub_in,
-                vpub_out,
-                h_sig_in,
-                phi_in,
+        if (context->IsCancelled()) {
+            return grpc::Status(
+                grpc::StatusCode::CANCELLED, "batch cancelled by client");
+        }
+        return grpc::Status::OK;
+    }
+
+private:
+    // Generate a single proof using the given (leased) circuit, and fill in
+    // the response. Throws on error.
+    void generate_proof(
+        circuit_wrapper &prover,
+        const proof_inputs &inputs,
+        zeth_proto::ExtendedProofAndPublicData *proof_and_public_data)
+    {
+        std::cout << "[DEBUG] Generating the proof..." << std::endl;
+
+        std::vector<Field> public_data;
+        libzeth::extended_proof<pp, snark> ext_proof = [&]() {
+#if defined(ZETH_SNARK_GROTH16)
+            if (context) {
+                return prover.prove(
+                    inputs.root,
+                    inputs.joinsplit_inputs,
+                    inputs.joinsplit_outputs,
+                    inputs.vpub_in,
+                    inputs.vpub_out,
+                    inputs.h_sig_in,
+                    inputs.phi_in,
+                    this->keypair.pk,
+                    *context,
+                    public_data);
+            }
+#endif
+            return prover.prove(
+                inputs.root,
+                inputs.joinsplit_inputs,
+                inputs.joinsplit_outputs,
+                inputs.vpub_in,
+                inputs.vpub_out,
+                inputs.h_sig_in,
+                inputs.phi_in,
                 this->keypair.pk,
                 public_data);
+        }();
+
+        write_debug_output(
+            ext_proof, public_data, prover.get_last_assignment());
+        proof_to_proto(ext_proof, public_data, proof_and_public_data);
+    }
+
+    // Call `f` for each entry of a batch which has no error, using up to one
+    // thread per circuit instance in `provers`. Each thread leases an
+    // instance for its duration, and takes entries in turn until none are
+    // left. Errors thrown by `f` are recorded in `errors`. Entries are
+    // skipped if the call is cancelled.
+    static void for_each_batch_entry(
+        circuit_wrapper_pool &provers,
+        grpc::ServerContext *server_context,
+        std::vector<std::string> &errors,
+        const std::function<void(circuit_wrapper &, size_t)> &f)
+    {
+        const size_t num_entries = errors.size();
+        std::atomic<size_t> next_entry(0);
+        const auto worker = [&]() {
+            if (next_entry.load() >= num_entries) {
+                return;
+            }
+            circuit_wrapper_pool::lease prover = provers.acquire();
+            for (size_t i = next_entry++; i < num_entries; i = next_entry++) {
+                if (!errors[i].empty() || server_context->IsCancelled()) {
+                    continue;
+                }
+                try {
+                    f(*prover, i);
+                } catch (const std::exception &e) {
+                    errors[i] = e.what();
+                }
+            }
+        };
+
+        const size_t num_threads = std::min(provers.size(), num_entries);
+        std::vector<std::thread> threads;
+        for (size_t t = 1; t < num_threads; ++t) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+    }
+
+    // Generate proofs for the entries of a batch which have no error, using
+    // the circuit instances of `provers`. Errors are recorded in `errors`,
+    // and proofs in `results`. Entries are skipped if the call is cancelled.
+    void generate_batch_proofs(
+        circuit_wrapper_pool &provers,
+        grpc::ServerContext *server_context,
+        const std::vector<proof_inputs> &inputs,
+        std::vector<std::string> &errors,
+        std::vector<zeth_proto::ProofBatchResult> &results)
+    {
+#if defined(ZETH_SNARK_GROTH16)
+        // Generate all witnesses, and then all proofs at once.
+        const size_t batch_size = inputs.size();
+        std::vector<char> generated(batch_size, 0);
+        std::vector<std::vector<Field>> entry_public_data(batch_size);
+        std::vector<libsnark::r1cs_primary_input<Field>> entry_primary(
+            batch_size);
+        std::vector<libsnark::r1cs_auxiliary_input<Field>> entry_auxiliary(
+            batch_size);
+        std::vector<std::vector<Field>> entry_assignments(batch_size);
+        for_each_batch_entry(
+            provers,
+            server_context,
+            errors,
+            [&](circuit_wrapper &prover, const size_t i) {
+                prover.generate_assignment(
+                    inputs[i].root,
+                    inputs[i].joinsplit_inputs,
+                    inputs[i].joinsplit_outputs,
+                    inputs[i].vpub_in,
+                    inputs[i].vpub_out,
+                    inputs[i].h_sig_in,
+                    inputs[i].phi_in,
+                    entry_public_data[i],
+                    entry_primary[i],
+                    entry_auxiliary[i]);
+                if (!assignment_output_file.empty()) {
+                    entry_assignments[i] = prover.get_last_assignment();
+                }
+                generated[i] = 1;
+            });
+        if (server_context->IsCancelled()) {
+            return;
+        }
+
+        std::vector<size_t> indices;
+        std::vector<libsnark::r1cs_primary_input<Field>> primary_inputs;
+        std::vector<libsnark::r1cs_auxiliary_input<Field>> auxiliary_inputs;
+        for (size_t i = 0; i < batch_size; ++i) {
+            if (generated[i]) {
+                indices.push_back(i);
+                primary_inputs.push_back(std::move(entry_primary[i]));
+                auxiliary_inputs.push_back(std::move(entry_auxiliary[i]));
+            }
+        }
+        if (indices.empty()) {
+            return;
+        }
+
+        std::cout << "[DEBUG] Generating " << indices.size() << " proofs..."
+                  << std::endl;
+        std::vector<snark::proof> proofs;
+        try {
+            if (context) {
+                proofs = snark::generate_proofs(
+                    this->keypair.pk,
+                    *context,
+                    primary_inputs,
+                    auxiliary_inputs);
+            } else {
+                proofs = snark::generate_proofs(
+                    this->keypair.pk, primary_inputs, auxiliary_inputs);
+            }
+        } catch (const std::exception &e) {
+            for (const size_t i : indices) {
+                errors[i] = e.what();
+            }
+            return;
+        }
+
+        for (size_t j = 0; j < indices.size(); ++j) {
+            const size_t i = indices[j];
+            const libzeth::extended_proof<pp, snark> ext_proof(
+                std::move(proofs[j]), std::move(primary_inputs[j]));
+            write_debug_output(
+                ext_proof, entry_public_data[i], entry_assignments[i]);
+            proof_to_proto(
+                ext_proof,
+                entry_public_data[i],
+                results[i].mutable_extended_proof_and_public_data());
+        }
+#else
+        // Batched proof generation is not supported by this snark, so each
+        // thread generates complete proofs in turn.
+        for_each_batch_entry(
+            provers,
+            server_context,
+            errors,
+            [&](circuit_wrapper &prover, const size_t i) {
+                generate_proof(
+                    prover,
+                    inputs[i],
+                    results[i].mutable_extended_proof_and_public_data());
+            });
+#endif
+    }
+
+    void proof_to_proto(
+        const libzeth::extended_proof<pp, snark> &ext_proof,
+        const std::vector<Field> &public_data,
+        zeth_proto::ExtendedProofAndPublicData *proof_and_public_data)
+    {
+        std::cout << "[DEBUG] Preparing response..." << std::endl;
+        api_handler::extended_proof_to_proto(
+            ext_proof, proof_and_public_data->mutable_extended_proof());
+        for (size_t i = 0; i < public_data.size(); ++i) {
+            proof_and_public_data->add_public_data(
+                libzeth::base_field_element_to_hex(public_data[i]));
+        }
+    }
+
+    void write_debug_output(
+        const libzeth::extended_proof<pp, snark> &ext_proof,
+        const std::vector<Field> &public_data,
+        const std::vector<Field> &assignment)
+    {
+        std::unique_lock<std::mutex> lock(debug_output_mutex);
+
+        std::cout << "[DEBUG] Displaying extended proof and public data\n";
+        ext_proof.write_json(std::cout);
+        for (const Field &f : public_data) {
+            std::cout << libzeth::base_field_element_to_hex(f) << "\n";
+        }
+
+        // Write a copy of the proof for debugging.
+        if (!extproof_json_output_file.empty()) {
+            std::cout << "[DEBUG] Writing extended proof (JSON) to "
+                      << extproof_json_output_file << "\n";
+            write_extproof_to_json_file(ext_proof, extproof_json_output_file);
+        }
+        if (!proof_output_file.empty()) {
+            std::cout << "[DEBUG] Writing proof to " << proof_output_file
+                      << "\n";
+            write_proof_to_file(ext_proof.get_proof(), proof_output_file);
+        }
+        if (!primary_output_file.empty()) {
+            std::cout << "[DEBUG] Writing primary input to "
+                      << primary_output_file << "\n";
+            write_assignment_to_file(
+                ext_proof.get_primary_inputs(), primary_output_file);
+        }
+        if (!assignment_output_file.empty()) {
+            std::cout << "[DEBUG] WARNING! Writing assignment to "
+                      << assignment_output_file << "\n";
+            write_assignment_to_file(assignment, assignment_output_file);
+        }
+    }
+};
+
+/// The prover_server class inherits from the Prover service
+/// defined in the proto files, and provides an implementation
+/// of the service. Proof requests are served concurrently, each leasing one
+/// of the independent circuit_wrapper instances from the pool for the
+/// duration of witness and proof generation.
+class prover_server final : public zeth_proto::Prover::Service
+{
+private:
+    circuit_wrapper_pool &provers;
+    prover_backend &backend;
+
+public:
+    explicit prover_server(
+        circuit_wrapper_pool &provers, prover_backend &backend)
+        : provers(provers), backend(backend)
+    {
+    }
+
+    grpc::Status GetConfiguration(
+        grpc::ServerContext *,
+        const proto::Empty *,
+        zeth_proto::ProverConfiguration *response) override
+    {
+        return backend.get_configuration(response);
+    }
+
+    grpc::Status GetVerificationKey(
+        grpc::ServerContext *,
+        const proto::Empty *,
+        zeth_proto::VerificationKey *response) override
+    {
+        return backend.get_verification_key(response);
+    }
+
+    grpc::Status Prove(
+        grpc::ServerContext *,
+        const zeth_proto::ProofInputs *proof_inputs,
+        zeth_proto::ExtendedProofAndPublicData *proof_and_public_data) override
+    {
+        return backend.prove(provers, *proof_inputs, proof_and_public_data);
+    }
+
+    grpc::Status ProveBatch(
+        grpc::ServerContext *context,
+        const zeth_proto::ProofInputsBatch *batch,
+        grpc::ServerWriter<zeth_proto::ProofBatchResult> *writer) override
+    {
+        return backend.prove_batch(provers, context, *batch, writer);
+    }
+};
+
+/// Asynchronous (completion-queue based) implementation of the Prover
+/// service. A single thread drives the completion queue. Prove requests are
+/// placed on a bounded queue, consumed by a fixed set of worker threads (one
+/// per circuit instance). When the queue is full, requests are rejected
+/// immediately with RESOURCE_EXHAUSTED, and a retry hint (based on the
+/// current backlog and the observed proving time) is attached as trailing
+/// metadata, rather than letting latency grow without bound. Batches are
+/// counted against the same queue: each admitted batch occupies one queue
+/// slot per entry until it completes.
+class async_prover_server
+{
+public:
+    async_prover_server(
+        circuit_wrapper_pool &provers,
+        prover_backend &backend,
+        size_t max_queue_depth)
+        : provers(provers)
+        , backend(backend)
+        , max_queue_depth(max_queue_depth)
+        , service(*this)
+        , stop_requested(false)
+        , active_batch_entries(0)
+        , shutting_down(false)
+        , average_proof_time_ms(0)
+    {
+    }
+
+    async_prover_server(const async_prover_server &) = delete;
+    async_prover_server &operator=(const async_prover_server &) = delete;
 
-            std::cout << "[DEBUG] Displaying extended proof and public data\n";
-            ext_proof.write_json(std::cout);
-            for (const Field &f : public_data) {
-                std::cout << libzeth::base_field_element_to_hex(f) << "\n";
+    ~async_prover_server()
+    {
+        // Cancel all outstanding RPCs, stop the workers (after any proof in
+        // progress), then drain the completion queue.
+        if (server) {
+            server->Shutdown(std::chrono::system_clock::now());
+        }
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            shutting_down = true;
+        }
+        queue_cond.notify_all();
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+        if (cq) {
+            cq->Shutdown();
+            void *tag;
+            bool ok;
+            while (cq->Next(&tag, &ok)) {
+                static_cast<call *>(tag)->destroy();
             }
+        }
+
+        // Calls still in the queue have no pending operation.
+        for (prove_call *c : pending) {
+            c->destroy();
+        }
+    }
+
+    /// Start listening on the given address, and process requests until
+    /// `stop` is called. Outstanding requests are cancelled when the object
+    /// is destroyed.
+    void run(const std::string &server_address)
+    {
+        grpc::ServerBuilder builder;
+        builder.AddListeningPort(
+            server_address, grpc::InsecureServerCredentials());
+        builder.RegisterService(&service);
+        cq = builder.AddCompletionQueue();
+        server = builder.BuildAndStart();
+        std::cout << "[INFO] Async server listening on " << server_address
+                  << " (workers: " << provers.size()
+                  << ", queue depth: " << max_queue_depth << ")\n";
 
-            // Write a copy of the proof for debugging.
-            if (!extproof_json_output_file.empty()) {
-                std::cout << "[DEBUG] Writing extended proof (JSON) to "
-                          << extproof_json_output_file << "\n";
-                write_extproof_to_json_file(
-                    ext_proof, extproof_json_output_file);
+        for (size_t i = 0; i < provers.size(); ++i) {
+            workers.emplace_back([this]() { this->worker_loop(); });
+        }
+
+        // One outstanding call object per RPC type. Each spawns its
+        // successor as soon as a request arrives.
+        new get_configuration_call(*this);
+        new get_verification_key_call(*this);
+        new prove_call(*this);
+
+        display_server_start_message();
+        // Wake up periodically to check for a stop request.
+        const std::chrono::milliseconds stop_poll_interval(500);
+        void *tag;
+        bool ok;
+        while (!stop_requested) {
+            const grpc::CompletionQueue::NextStatus status = cq->AsyncNext(
+                &tag,
+                &ok,
+                std::chrono::system_clock::now() + stop_poll_interval);
+            if (status == grpc::CompletionQueue::SHUTDOWN) {
+                break;
             }
-            if (!proof_output_file.empty()) {
-                std::cout << "[DEBUG] Writing proof to " << proof_output_file
-                          << "\n";
-                write_proof_to_file(ext_proof.get_proof(), proof_output_file);
+            if (status == grpc::CompletionQueue::GOT_EVENT) {
+                static_cast<call *>(tag)->proceed(ok);
             }
-            if (!primary_output_file.empty()) {
-                std::cout << "[DEBUG] Writing primary input to "
-                          << primary_output_file << "\n";
-                write_assignment_to_file(
-                    ext_proof.get_primary_inputs(), primary_output_file);
+        }
+    }
+
+    /// Request that `run` return. May be called from any thread.
+    void stop() { stop_requested = true; }
+
+private:
+    // GetConfiguration, GetVerificationKey and Prove are handled
+    // asynchronously. ProveBatch is a long-running streaming call which
+    // occupies circuit instances for its whole duration. It is handled
+    // synchronously (on gRPC's own thread pool), and is only admitted if the
+    // Prove queue is not full, in which case its entries are counted against
+    // the queue until it completes.
+    class service_type
+        : public zeth_proto::Prover::WithAsyncMethod_GetConfiguration<
+              zeth_proto::Prover::WithAsyncMethod_GetVerificationKey<
+                  zeth_proto::Prover::WithAsyncMethod_Prove<
+                      zeth_proto::Prover::Service>>>
+    {
+    public:
+        explicit service_type(async_prover_server &server) : server(server)
+        {
+        }
+
+        grpc::Status ProveBatch(
+            grpc::ServerContext *context,
+            const zeth_proto::ProofInputsBatch *batch,
+            grpc::ServerWriter<zeth_proto::ProofBatchResult> *writer) override
+        {
+            const size_t batch_size = batch->proof_inputs_size();
+            size_t retry_after_ms = 0;
+            if (!server.admit_batch(batch_size, retry_after_ms)) {
+                std::cout << "[WARN] Prove queue full, rejecting batch "
+                          << "(retry in " << retry_after_ms << "ms)"
+                          << std::endl;
+                context->AddTrailingMetadata(
+                    "grpc-retry-pushback-ms", std::to_string(retry_after_ms));
+                return grpc::Status(
+                    grpc::StatusCode::RESOURCE_EXHAUSTED,
+                    "prover queue full, retry after " +
+                        std::to_string(retry_after_ms) + "ms");
             }
-            if (!assignment_output_file.empty()) {
-                std::cout << "[DEBUG] WARNING! Writing assignment to "
-                          << assignment_output_file << "\n";
-                write_assignment_to_file(
-                    prover.get_last_assignment(), assignment_output_file);
+            batch_admission admission(server, batch_size);
+            return server.backend.prove_batch(
+                server.provers, context, *batch, writer);
+        }
+
+    private:
+        async_prover_server &server;
+    };
+
+    /// Releases the queue slots of an admitted batch when destroyed.
+    class batch_admission
+    {
+    public:
+        batch_admission(async_prover_server &server, size_t batch_size)
+            : server(server), batch_size(batch_size)
+        {
+        }
+        ~batch_admission() { server.release_batch(batch_size); }
+
+        batch_admission(const batch_admission &) = delete;
+        batch_admission &operator=(const batch_admission &) = delete;
+
+    private:
+        async_prover_server &server;
+        const size_t batch_size;
+    };
+
+    /// Base class of the per-RPC state machines. The address of the object is
+    /// used as the completion queue tag.
+    class call
+    {
+    public:
+        virtual ~call() {}
+
+        // Called by the completion queue thread when an operation tagged
+        // with this object completes.
+        virtual void proceed(bool ok) = 0;
+
+        // Called on shutdown, for outstanding calls.
+        void destroy() { delete this; }
+
+        // The tag to use for completion queue operations. Always the address
+        // of the `call` base, since that is how tags are interpreted.
+        void *as_tag() { return static_cast<call *>(this); }
+    };
+
+    // Simple unary calls, handled inline on the completion queue thread.
+    template<typename RequestT, typename ResponseT, typename DerivedT>
+    class unary_call : public call
+    {
+    public:
+        explicit unary_call(async_prover_server &server)
+            : server(server), responder(&context), finished(false)
+        {
+        }
+
+        void proceed(bool ok) override
+        {
+            if (finished || !ok) {
+                delete this;
+                return;
             }
 
-            std::cout << "[DEBUG] Preparing response..." << std::endl;
-            api_handler::extended_proof_to_proto(
-                ext_proof, proof_and_public_data->mutable_extended_proof());
-            for (size_t i = 0; i < public_data.size(); ++i) {
-                proof_and_public_data->add_public_data(
-                    libzeth::base_field_element_to_hex(public_data[i]));
+            new DerivedT(server);
+            finished = true;
+            const grpc::Status status =
+                static_cast<DerivedT *>(this)->handle(request, &response);
+            responder.Finish(response, status, as_tag());
+        }
+
+    protected:
+        async_prover_server &server;
+        grpc::ServerContext context;
+        RequestT request;
+        ResponseT response;
+        grpc::ServerAsyncResponseWriter<ResponseT> responder;
+        bool finished;
+    };
+
+    class get_configuration_call
+        : public unary_call<
+              proto::Empty,
+              zeth_proto::ProverConfiguration,
+              get_configuration_call>
+    {
+    public:
+        explicit get_configuration_call(async_prover_server &server)
+            : unary_call(server)
+        {
+            server.service.RequestGetConfiguration(
+                &context,
+                &request,
+                &responder,
+                server.cq.get(),
+                server.cq.get(),
+                as_tag());
+        }
+
+        grpc::Status handle(
+            const proto::Empty &, zeth_proto::ProverConfiguration *response)
+        {
+            return server.backend.get_configuration(response);
+        }
+    };
+
+    class get_verification_key_call
+        : public unary_call<
+              proto::Empty,
+              zeth_proto::VerificationKey,
+              get_verification_key_call>
+    {
+    public:
+        explicit get_verification_key_call(async_prover_server &server)
+            : unary_call(server)
+        {
+            server.service.RequestGetVerificationKey(
+                &context,
+                &request,
+                &responder,
+                server.cq.get(),
+                server.cq.get(),
+                as_tag());
+        }
+
+        grpc::Status handle(
+            const proto::Empty &, zeth_proto::VerificationKey *response)
+        {
+            return server.backend.get_verification_key(response);
+        }
+    };
+
+    // Prove calls are handed over to the worker threads, which call Finish
+    // once the proof has been generated.
+    class prove_call : public call
+    {
+    public:
+        explicit prove_call(async_prover_server &server)
+            : server(server), responder(&context), finished(false)
+        {
+            server.service.RequestProve(
+                &context,
+                &request,
+                &responder,
+                server.cq.get(),
+                server.cq.get(),
+                as_tag());
+        }
+
+        void proceed(bool ok) override
+        {
+            if (finished || !ok) {
+                delete this;
+                return;
             }
 
-        } catch (const std::exception &e) {
-            std::cout << "[ERROR] " << e.what() << std::endl;
-            return grpc::Status(
-                grpc::StatusCode::INVALID_ARGUMENT, grpc::string(e.what()));
-        } catch (...) {
-            std::cout << "[ERROR] In catch all" << std::endl;
-            return grpc::Status(grpc::StatusCode::UNKNOWN, "");
+            new prove_call(server);
+            size_t retry_after_ms = 0;
+            if (!server.enqueue(this, retry_after_ms)) {
+                std::cout << "[WARN] Prove queue full, rejecting request "
+                          << "(retry in " << retry_after_ms << "ms)"
+                          << std::endl;
+                context.AddTrailingMetadata(
+                    "grpc-retry-pushback-ms", std::to_string(retry_after_ms));
+                finish(grpc::Status(
+                    grpc::StatusCode::RESOURCE_EXHAUSTED,
+                    "prover queue full, retry after " +
+                        std::to_string(retry_after_ms) + "ms"));
+            }
         }
 
-        return grpc::Status::OK;
+        // Called by a worker thread.
+        void execute()
+        {
+            finish(server.backend.prove(server.provers, request, &response));
+        }
+
+    private:
+        void finish(const grpc::Status &status)
+        {
+            finished = true;
+            responder.Finish(response, status, as_tag());
+        }
+
+        async_prover_server &server;
+        grpc::ServerContext context;
+        zeth_proto::ProofInputs request;
+        zeth_proto::ExtendedProofAndPublicData response;
+        grpc::ServerAsyncResponseWriter<zeth_proto::ExtendedProofAndPublicData>
+            responder;
+        bool finished;
+    };
+
+    // Admit a call to the queue if there is space, otherwise compute a retry
+    // hint and return false.
+    bool enqueue(prove_call *c, size_t &retry_after_ms)
+    {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            if (queue_size() >= max_queue_depth) {
+                retry_after_ms = retry_hint_ms();
+                return false;
+            }
+            pending.push_back(c);
+        }
+        queue_cond.notify_one();
+        return true;
+    }
+
+    // Admit a batch if the queue is not full, reserving one slot per entry
+    // (released by release_batch). Otherwise compute a retry hint and return
+    // false. A batch may take the queue over its maximum depth, so that
+    // batches larger than the queue can still be admitted when it is empty.
+    bool admit_batch(size_t batch_size, size_t &retry_after_ms)
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        if (queue_size() >= max_queue_depth) {
+            retry_after_ms = retry_hint_ms();
+            return false;
+        }
+        active_batch_entries += batch_size;
+        return true;
+    }
+
+    void release_batch(size_t batch_size)
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        active_batch_entries -= batch_size;
     }
+
+    // Number of queued Prove calls, plus entries of batches in progress. Must
+    // be called with queue_mutex held.
+    size_t queue_size() const { return pending.size() + active_batch_entries; }
+
+    // Estimate the time to drain the backlog (plus the proofs currently in
+    // progress) across all workers. Must be called with queue_mutex held.
+    size_t retry_hint_ms() const
+    {
+        const size_t backlog = queue_size() + provers.size();
+        const size_t proof_time_ms =
+            std::max<size_t>(average_proof_time_ms, 1000);
+        return proof_time_ms *
+               ((backlog + provers.size() - 1) / provers.size());
+    }
+
+    void worker_loop()
+    {
+        for (;;) {
+            prove_call *c = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                queue_cond.wait(lock, [this]() {
+                    return shutting_down || !pending.empty();
+                });
+                if (shutting_down) {
+                    return;
+                }
+                c = pending.front();
+                pending.pop_front();
+            }
+
+            const std::chrono::steady_clock::time_point start =
+                std::chrono::steady_clock::now();
+            c->execute();
+            const size_t elapsed_ms =
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+
+            // Exponential moving average of the proving time, used for retry
+            // hints.
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            average_proof_time_ms =
+                (average_proof_time_ms == 0)
+                    ? elapsed_ms
+                    : (3 * average_proof_time_ms + elapsed_ms) / 4;
+        }
+    }
+
+    circuit_wrapper_pool &provers;
+    prover_backend &backend;
+    const size_t max_queue_depth;
+
+    service_type service;
+    std::unique_ptr<grpc::ServerCompletionQueue> cq;
+    std::unique_ptr<grpc::Server> server;
+    std::atomic<bool> stop_requested;
+
+    std::vector<std::thread> workers;
+    std::deque<prove_call *> pending;
+    size_t active_batch_entries;
+    std::mutex queue_mutex;
+    std::condition_variable queue_cond;
+    bool shutting_down;
+    size_t average_proof_time_ms;
 };
 
-std::string get_server_version()
+/// Handles SIGINT and SIGTERM on a dedicated thread. The signals must be
+/// blocked in every other thread, so the object must be created before any
+/// other thread is started. Once `enable` has been called, the first signal
+/// requests a graceful shutdown, which is carried out by a thread blocked in
+/// `wait`, so that the signal thread remains free to handle further signals.
+/// Before `enable` is called, or on a second signal, the process exits
+/// immediately.
+class shutdown_signal_handler
 {
-    char buffer[100];
-    int n;
-    // Defined in the zethConfig file
-    n = snprintf(
-        buffer, 100, "Version %d.%d", ZETH_VERSION_MAJOR, ZETH_VERSION_MINOR);
-    if (n < 0) {
-        return "Version <Not specified>";
+public:
+    shutdown_signal_handler()
+        : stopping(false), enabled(false), shutdown_requested(false)
+    {
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+        thread = std::thread([this]() { this->wait_loop(); });
     }
-    std::string version(buffer);
-    return version;
-}
 
-void display_server_start_message()
-{
-    std::string copyright =
-        "Copyright (c) 2015-2021 Clearmatics Technologies Ltd";
-    std::string license = "SPDX-License-Identifier: LGPL-3.0+";
-    std::string project =
-        "R&D Department: PoC for Zerocash on Ethereum/Autonity";
-    std::string version = get_server_version();
-    std::string warning = "**WARNING:** This code is a research-quality proof "
-                          "of concept, DO NOT use in production!";
+    shutdown_signal_handler(const shutdown_signal_handler &) = delete;
+    shutdown_signal_handler &operator=(const shutdown_signal_handler &) =
+        delete;
 
-    std::cout << "\n=====================================================\n";
-    std::cout << copyright << "\n";
-    std::cout << license << "\n";
-    std::cout << project << "\n";
-    std::cout << version << "\n";
-    std::cout << warning << "\n";
-    std::cout << "=====================================================\n"
-              << std::endl;
-}
+    ~shutdown_signal_handler()
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        pthread_kill(thread.native_handle(), SIGTERM);
+        thread.join();
+    }
+
+    /// Handle subsequent signals by requesting a graceful shutdown.
+    void enable()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        enabled = true;
+    }
+
+    /// Block until a graceful shutdown is requested.
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [this]() { return shutdown_requested; });
+    }
+
+private:
+    void wait_loop()
+    {
+        for (;;) {
+            int signal_number = 0;
+            sigwait(&signals, &signal_number);
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (stopping) {
+                    return;
+                }
+                if (!enabled || shutdown_requested) {
+                    std::cout << "[INFO] Interrupted (signal "
+                              << signal_number << ")" << std::endl;
+                    std::_Exit(1);
+                }
+                std::cout << "[INFO] Shutting down (signal " << signal_number
+                          << ")" << std::endl;
+                shutdown_requested = true;
+            }
+            cond.notify_all();
+        }
+    }
+
+    sigset_t signals;
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool stopping;
+    bool enabled;
+    bool shutdown_requested;
+    std::thread thread;
+};
 
 static void RunServer(
-    circuit_wrapper &prover,
-    const typename snark::keypair &keypair,
-    const boost::filesystem::path &extproof_json_output_file,
-    const boost::filesystem::path &proof_output_file,
-    const boost::filesystem::path &primary_output_file,
-    const boost::filesystem::path &assignment_output_file)
+    circuit_wrapper_pool &provers,
+    prover_backend &backend,
+    shutdown_signal_handler &signal_handler,
+    const std::string &server_address,
+    const bool async_mode,
+    const size_t max_queue_depth)
 {
-    // Listen for incoming connections on 0.0.0.0:50051
-    std::string server_address("0.0.0.0:50051");
+    signal_handler.enable();
 
-    prover_server service(
-        prover,
-        keypair,
-        extproof_json_output_file,
-        proof_output_file,
-        primary_output_file,
-        assignment_output_file);
+    if (async_mode) {
+        async_prover_server server(provers, backend, max_queue_depth);
+        std::thread stopper([&signal_handler, &server]() {
+            signal_handler.wait();
+            server.stop();
+        });
+        server.run(server_address);
+        stopper.join();
+        std::cout << "[INFO] Server stopped" << std::endl;
+        return;
+    }
+
+    prover_server service(provers, backend);
 
     grpc::ServerBuilder builder;
 
@@ -395,10 +1411,17 @@ static void RunServer(
     std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
     std::cout << "[INFO] Server listening on " << server_address << "\n";
 
-    // Wait for the server to shutdown. Note that some other thread must be
-    // responsible for shutting down the server for this call to ever return.
+    // Wait for the server to shutdown, which is initiated (on a separate
+    // thread) when a signal is received. Shutdown waits for the RPCs in
+    // progress to complete.
+    std::thread stopper([&signal_handler, &server]() {
+        signal_handler.wait();
+        server->Shutdown();
+    });
     display_server_start_message();
     server->Wait();
+    stopper.join();
+    std::cout << "[INFO] Server stopped" << std::endl;
 }
 
 int main(int argc, char **argv)
@@ -411,10 +1434,50 @@ int main(int argc, char **argv)
         "file to load keypair from. If it doesn't exist, a new keypair will be "
         "generated and written to this file. (default: "
         "~/zeth_setup/keypair.bin)");
+#if defined(ZETH_SNARK_GROTH16)
+    options.add_options()(
+        "mapped-proving-key,m",
+        po::value<boost::filesystem::path>(),
+        "file to load the keypair from, in the memory-mapped format. If it "
+        "doesn't exist, the keypair is loaded (or generated) as usual and "
+        "converted to this file. When it exists, --keypair is ignored.");
+    options.add_options()(
+        "precomputed-bases,p",
+        po::value<boost::filesystem::path>(),
+        "file containing precomputed multiples of the proving key bases, used "
+        "to speed up proof generation at the cost of memory. If it doesn't "
+        "exist, it is generated from the keypair and written to this file.");
+    options.add_options()(
+        "precomputed-window-size",
+        po::value<size_t>(),
+        "window size (2-30) used when generating --precomputed-bases. Larger "
+        "values give smaller files (roughly 256 / window-size times the size "
+        "of the proving key) but slower proofs. (default: based on the "
+        "circuit size)");
+#endif
     options.add_options()(
         "r1cs,r",
         po::value<boost::filesystem::path>(),
         "file in which to export the r1cs (in json format)");
+    options.add_options()(
+        "r1cs-cache",
+        po::value<boost::filesystem::path>(),
+        "file caching the compiled constraint system. If it exists and matches "
+        "the circuit parameters, constraints are loaded from it instead of "
+        "being generated. Otherwise, it is (re)written after the constraints "
+        "are generated.");
+    options.add_options()(
+        "optimize-r1cs",
+        "eliminate linear constraints and aliased variables from the "
+        "constraint system before the trusted setup and proofs. Keypairs "
+        "must be generated (and used) consistently with or without this "
+        "option. Keypairs produced by the MPC, which uses the unoptimized "
+        "constraint system, cannot be used with this option.");
+    options.add_options()(
+        "witness-tape",
+        "generate witnesses by replaying a tape of operations, recorded once "
+        "per circuit instance, instead of traversing the gadgets for each "
+        "proof. Increases the memory used by each instance.");
     options.add_options()(
         "proving-key-output",
         po::value<boost::filesystem::path>(),
@@ -423,6 +1486,25 @@ int main(int argc, char **argv)
         "verification-key-output",
         po::value<boost::filesystem::path>(),
         "write verification key to file (if generated)");
+    options.add_options()(
+        "num-provers,j",
+        po::value<size_t>(),
+        "number of independent circuit instances, and therefore of proofs "
+        "which can be generated concurrently (default: 1). In async mode, "
+        "this is also the number of proving workers.");
+    options.add_options()(
+        "address,a",
+        po::value<std::string>(),
+        "address on which to listen for requests (default: 0.0.0.0:50051)");
+    options.add_options()(
+        "async",
+        "use the asynchronous server, with a bounded queue of Prove requests "
+        "(see --queue-depth)");
+    options.add_options()(
+        "queue-depth",
+        po::value<size_t>(),
+        "(async mode) maximum number of Prove requests waiting for a worker. "
+        "Further requests are rejected with RESOURCE_EXHAUSTED. (default: 16)");
     options.add_options()(
         "extproof-json-output",
         po::value<boost::filesystem::path>(),
@@ -450,13 +1532,23 @@ int main(int argc, char **argv)
     };
 
     boost::filesystem::path keypair_file;
+    boost::filesystem::path mapped_pk_file;
+    boost::filesystem::path precomputed_file;
+    size_t precomputed_window_size = 0;
     boost::filesystem::path r1cs_file;
+    boost::filesystem::path r1cs_cache_file;
+    bool optimize_r1cs = false;
+    bool witness_tape = false;
     boost::filesystem::path proving_key_output_file;
     boost::filesystem::path verification_key_output_file;
     boost::filesystem::path extproof_json_output_file;
     boost::filesystem::path proof_output_file;
     boost::filesystem::path primary_output_file;
     boost::filesystem::path assignment_output_file;
+    size_t num_provers = 1;
+    std::string server_address("0.0.0.0:50051");
+    bool async_mode = false;
+    size_t max_queue_depth = 16;
     try {
         po::variables_map vm;
         po::store(
@@ -468,9 +1560,33 @@ int main(int argc, char **argv)
         if (vm.count("keypair")) {
             keypair_file = vm["keypair"].as<boost::filesystem::path>();
         }
+        if (vm.count("mapped-proving-key")) {
+            mapped_pk_file =
+                vm["mapped-proving-key"].as<boost::filesystem::path>();
+        }
+        if (vm.count("precomputed-bases")) {
+            precomputed_file =
+                vm["precomputed-bases"].as<boost::filesystem::path>();
+        }
+        if (vm.count("precomputed-window-size")) {
+            precomputed_window_size =
+                vm["precomputed-window-size"].as<size_t>();
+            if (precomputed_window_size < 2 || precomputed_window_size > 30) {
+                throw po::error("precomputed-window-size must be in [2, 30]");
+            }
+        }
         if (vm.count("r1cs")) {
             r1cs_file = vm["r1cs"].as<boost::filesystem::path>();
         }
+        if (vm.count("r1cs-cache")) {
+            r1cs_cache_file = vm["r1cs-cache"].as<boost::filesystem::path>();
+        }
+        if (vm.count("optimize-r1cs")) {
+            optimize_r1cs = true;
+        }
+        if (vm.count("witness-tape")) {
+            witness_tape = true;
+        }
         if (vm.count("proving-key-output")) {
             proving_key_output_file =
                 vm["proving-key-output"].as<boost::filesystem::path>();
@@ -479,6 +1595,24 @@ int main(int argc, char **argv)
             verification_key_output_file =
                 vm["verification-key-output"].as<boost::filesystem::path>();
         }
+        if (vm.count("num-provers")) {
+            num_provers = vm["num-provers"].as<size_t>();
+            if (num_provers == 0) {
+                throw po::error("num-provers must be at least 1");
+            }
+        }
+        if (vm.count("address")) {
+            server_address = vm["address"].as<std::string>();
+        }
+        if (vm.count("async")) {
+            async_mode = true;
+        }
+        if (vm.count("queue-depth")) {
+            max_queue_depth = vm["queue-depth"].as<size_t>();
+            if (max_queue_depth == 0) {
+                throw po::error("queue-depth must be at least 1");
+            }
+        }
         if (vm.count("extproof-json-output")) {
             extproof_json_output_file =
                 vm["extproof-json-output"].as<boost::filesystem::path>();
@@ -501,6 +1635,10 @@ int main(int argc, char **argv)
         return 1;
     }
 
+    // Must precede the creation of any other thread (including OpenMP
+    // threads used during setup).
+    shutdown_signal_handler signal_handler;
+
     // Default keypair_file if none given
     if (keypair_file.empty()) {
         boost::filesystem::path setup_dir =
@@ -515,13 +1653,75 @@ int main(int argc, char **argv)
     std::cout << "[INFO] Init params (" << libzeth::pp_name<pp>() << ")\n";
     pp::init_public_params();
 
+    // The libff profiling counters are global and not thread-safe. Disable
+    // them when proofs may be generated concurrently.
+    if (num_provers > 1) {
+        libff::inhibit_profiling_info = true;
+        libff::inhibit_profiling_counters = true;
+    }
+
+    // Each circuit_wrapper owns its own protoboard, so that witness
+    // generation for concurrent requests does not interfere, while the
+    // (read-only) constraint system is shared. Instances are created
+    // sequentially, before any request is received.
+    std::cout << "[INFO] Creating " << num_provers << " circuit instance(s)\n";
+    std::vector<std::unique_ptr<circuit_wrapper>> circuits;
+    circuits.reserve(num_provers);
+    const std::shared_ptr<const libsnark::r1cs_constraint_system<Field>> cs =
+        load_constraint_system(r1cs_cache_file);
+    for (size_t i = 0; i < num_provers; ++i) {
+        circuits.emplace_back(new circuit_wrapper(cs));
+    }
+    // With a single instance, proofs are not generated concurrently, so the
+    // witnesses of the individual notes are generated in parallel instead.
+    if (num_provers == 1) {
+        circuits[0]->set_parallel_witness(true);
+    }
+    // If requested, witnesses are generated by replaying a tape recorded once
+    // per instance, which takes precedence over the parallel generation
+    // above.
+    if (witness_tape) {
+        for (const std::unique_ptr<circuit_wrapper> &circuit : circuits) {
+            circuit->set_witness_tape(true);
+        }
+    }
+    // The optimized constraint system is computed once and shared by all
+    // instances.
+    if (optimize_r1cs) {
+        std::cout << "[INFO] Optimizing constraint system\n";
+        std::shared_ptr<const libzeth::r1cs_optimization<Field>> optimization =
+            std::make_shared<libzeth::r1cs_optimization<Field>>(
+                libzeth::r1cs_optimize(*cs));
+        std::cout << "[INFO] Constraints: " << cs->num_constraints() << " -> "
+                  << optimization->constraint_system.num_constraints()
+                  << ", variables: " << cs->num_variables() << " -> "
+                  << optimization->constraint_system.num_variables() << "\n";
+        for (const std::unique_ptr<circuit_wrapper> &circuit : circuits) {
+            circuit->set_r1cs_optimization(optimization);
+        }
+    }
+    circuit_wrapper_pool provers(std::move(circuits));
+    circuit_wrapper &prover = provers.get(0);
+
     // If the keypair file exists, load and use it, otherwise generate a new
-    // keypair and write it to the file.
-    circuit_wrapper prover;
+    // keypair and write it to the file. A keypair in the mapped format, if
+    // given and present, takes precedence.
     snark::keypair keypair = [&keypair_file,
+                              &mapped_pk_file,
                               &proving_key_output_file,
                               &verification_key_output_file,
                               &prover]() {
+#if defined(ZETH_SNARK_GROTH16)
+        if (!mapped_pk_file.empty() &&
+            boost::filesystem::exists(mapped_pk_file)) {
+            std::cout << "[INFO] Loading mapped keypair: " << mapped_pk_file
+                      << "\n";
+            return load_mapped_keypair(mapped_pk_file, prover);
+        }
+#else
+        (void)mapped_pk_file;
+#endif
+
         if (boost::filesystem::exists(keypair_file)) {
             std::cout << "[INFO] Loading keypair: " << keypair_file << "\n";
             return load_keypair(keypair_file);
@@ -547,6 +1747,22 @@ int main(int argc, char **argv)
         return keypair;
     }();
 
+    try {
+        check_keypair(keypair, prover);
+    } catch (const std::invalid_argument &error) {
+        std::cerr << " ERROR: " << error.what() << std::endl;
+        return 1;
+    }
+
+#if defined(ZETH_SNARK_GROTH16)
+    // Convert to the mapped format, for faster loading on restart.
+    if (!mapped_pk_file.empty() && !boost::filesystem::exists(mapped_pk_file)) {
+        std::cout << "[INFO] Writing mapped keypair to " << mapped_pk_file
+                  << "\n";
+        write_mapped_keypair(keypair, mapped_pk_file);
+    }
+#endif
+
     // If a file is given, export the JSON representation of the constraint
     // system.
     if (!r1cs_file.empty()) {
@@ -554,13 +1770,31 @@ int main(int argc, char **argv)
         write_constraint_system(prover, r1cs_file);
     }
 
-    std::cout << "[INFO] Setup successful, starting the server..." << std::endl;
-    RunServer(
-        prover,
+    prover_backend backend(
         keypair,
         extproof_json_output_file,
         proof_output_file,
         primary_output_file,
         assignment_output_file);
+#if defined(ZETH_SNARK_GROTH16)
+    if (!precomputed_file.empty()) {
+        backend.set_precomputed_bases(load_precomputed_bases(
+            keypair.pk, precomputed_window_size, precomputed_file));
+    }
+    std::cout << "[INFO] Creating proving context\n";
+    backend.init_proving_context(num_provers);
+#else
+    (void)precomputed_file;
+    (void)precomputed_window_size;
+#endif
+
+    std::cout << "[INFO] Setup successful, starting the server..." << std::endl;
+    RunServer(
+        provers,
+        backend,
+        signal_handler,
+        server_address,
+        async_mode,
+        max_queue_depth);
     return 0;
 }